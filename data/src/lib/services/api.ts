@@ -1,4 +1,4 @@
-import { type CertificatesStatus, type CertificateType, type MqttConfig, type MiscConfig, type ApiResponse, type ActionsConfig, type ApiError, type ApiSuccess, type CaptivePortalConfig, type WiFiNetwork, CertTypeString } from '../types/api';
+import { type CertificatesStatus, type CertificateType, type MqttConfig, type MiscConfig, type ApiResponse, type ActionsConfig, type ApiError, type ApiSuccess, type CaptivePortalConfig, type WiFiNetwork, type TaskStats, type HeapStats, CertTypeString } from '../types/api';
 import { notifications } from '../stores/notifications.svelte.js';
 
 export async function rebootDevice() {
@@ -227,3 +227,37 @@ export async function scanWiFi(): Promise<ApiResponse<WiFiNetwork[]>> {
     return { success: false, error: message };
   }
 }
+
+export async function getTaskStats(): Promise<ApiResponse<TaskStats>> {
+  try {
+    const response = await fetch(`/metrics/tasks`);
+
+    if (!response.ok) {
+      const errorData: ApiError = await response.json();
+      return errorData;
+    }
+
+    const result: ApiResponse<TaskStats> = await response.json();
+    return result;
+  } catch (error) {
+    const message = error instanceof Error ? error.message : 'Unknown error occurred';
+    return { success: false, error: message };
+  }
+}
+
+export async function getHeapStats(): Promise<ApiResponse<HeapStats>> {
+  try {
+    const response = await fetch(`/metrics/heap`);
+
+    if (!response.ok) {
+      const errorData: ApiError = await response.json();
+      return errorData;
+    }
+
+    const result: ApiResponse<HeapStats> = await response.json();
+    return result;
+  } catch (error) {
+    const message = error instanceof Error ? error.message : 'Unknown error occurred';
+    return { success: false, error: message };
+  }
+}
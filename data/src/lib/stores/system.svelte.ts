@@ -31,13 +31,28 @@ export const systemInfo : SystemInfo = $state({
   backlog_max_size: 0
 });
 
+// Local time at which `systemInfo.uptime` was last reported. The device only sends uptime
+// in full metric snapshots, so it is advanced locally in between.
+let uptimeReceivedAt = 0;
+
 /**
- * Update system information from API response
+ * Update system information from API response.
+ * Metric pushes only carry the fields that changed, so they are merged into the current state.
  */
 export function updateSystemInfo(newInfo : Partial<SystemInfo>) {
+  if (newInfo.uptime !== undefined) {
+    uptimeReceivedAt = performance.now();
+  }
   Object.assign(systemInfo, newInfo);
 }
 
+/**
+ * Device uptime in milliseconds as of `now` (a `performance.now()` timestamp).
+ */
+export function currentUptime(now : number) {
+  return systemInfo.uptime ? Math.floor(systemInfo.uptime + now - uptimeReceivedAt) : 0;
+}
+
 
 let loadingState = $state(false);
 
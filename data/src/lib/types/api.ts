@@ -130,6 +130,102 @@ export interface WiFiNetwork {
   auth: string;
 }
 
+/**
+ * One FreeRTOS task as of the device's last task sample
+ * @type {TaskInfo}
+ */
+export interface TaskInfo {
+  /** Task name; numbered (e.g. "IDLE#2") when several tasks share one */
+  name: string;
+  /** Core the task is pinned to, -1 if unpinned or not created by the firmware */
+  core: number;
+  /** Current FreeRTOS priority */
+  priority: number;
+  /** Configured stack size in bytes, 0 if not created by the firmware */
+  stack_size: number;
+  /** Least free stack seen so far, in bytes */
+  stack_free: number;
+  /** Share of total CPU time over the last sample interval, in percent */
+  cpu: number;
+  /** Whether the task still existed at the last sample */
+  running: boolean;
+  /** Whether the firmware created the task itself */
+  firmware: boolean;
+}
+
+/**
+ * Task table returned by /metrics/tasks
+ * @type {TaskStats}
+ */
+export interface TaskStats {
+  /** How often the device samples its tasks, in milliseconds */
+  interval_ms: number;
+  tasks: TaskInfo[];
+}
+
+/**
+ * Heap allocations attributed to one subsystem by the heap profiler
+ * @type {HeapTagStats}
+ */
+export interface HeapTagStats {
+  /** Subsystem: nfc, web, mqtt, homespan, network, logging or other */
+  tag: string;
+  /** Allocations since the profiler started */
+  allocs: number;
+  /** Bytes allocated since the profiler started; wraps at 4 GiB */
+  alloc_bytes: number;
+  /** Estimated bytes still allocated, from sampling */
+  live_bytes: number;
+  /** Highest live_bytes estimate */
+  high_water_bytes: number;
+}
+
+/**
+ * A sampled allocation call stack
+ * @type {HeapSite}
+ */
+export interface HeapSite {
+  tag: string;
+  /** Return addresses, innermost first; empty on RISC-V chips */
+  frames: string[];
+  /** Estimated bytes allocated here and not yet freed */
+  live_bytes: number;
+  /** Estimated bytes allocated here since the profiler started */
+  total_bytes: number;
+}
+
+/**
+ * Heap allocations by the NFC task per tap, for taps with or without the NFC arena
+ * @type {HeapTapArm}
+ */
+export interface HeapTapArm {
+  taps: number;
+  allocs: number;
+  alloc_bytes: number;
+}
+
+/**
+ * Heap state, plus the profiler's results when the firmware is built with it
+ * @type {HeapStats}
+ */
+export interface HeapStats {
+  /** Whether the firmware was built with CONFIG_HK_HEAP_PROFILER */
+  enabled: boolean;
+  uptime_ms: number;
+  free: number;
+  largest_block: number;
+  min_free: number;
+  sample_bytes?: number;
+  tags?: HeapTagStats[];
+  sites?: HeapSite[];
+  taps?: {
+    /** Whether alternate taps bypass the NFC arena */
+    ab_mode: boolean;
+    arena: HeapTapArm;
+    heap: HeapTapArm;
+  };
+}
+
 export interface MiscConfig {
   /** Device name displayed in HomeKit and web interface */
   deviceName: string;
@@ -254,6 +350,8 @@ export interface ActionsConfig {
   hkAltActionTimeout: number;
   /** GPIO state for HomeKey alternate action */
   hkAltActionGpioState: number;
+  /** Custom feedback patterns overriding the per-event colors and timings; empty for the built-in ones */
+  feedbackPatterns: string;
 }
 
 /**
@@ -354,6 +452,22 @@ export interface OTAStatus {
   progress_percent?: number;
   /** Total bytes to be written */
   total_bytes?: number;
+  /** Compression of the uploaded image, if any */
+  compression?: "heatshrink";
+  /** Upload progress (0-100) when the upload and flashed image differ in size */
+  upload_percent?: number;
+  /** Size of the image written to flash, once known */
+  image_bytes?: number;
+  /** Number of bytes received so far */
+  bytes_received?: number;
+  /** Average upload rate in KiB/s */
+  throughput_kbps?: number;
+  /** Estimated seconds until the upload completes */
+  eta_seconds?: number;
+  /** Time the receiver waited for flash writes, in milliseconds */
+  receive_stall_ms?: number;
+  /** Time the flash writer waited for network data, in milliseconds */
+  write_stall_ms?: number;
 }
 
 /**
@@ -1,4 +1,6 @@
 #include "ConfigManager.hpp"
+#include "ConfigFields.hpp"
+#include "ConfigPatch.hpp"
 #include "MbedtlsHelpers.hpp"
 #include "cJSON.h"
 #include "config.hpp"
@@ -32,126 +34,13 @@ using crypto::ScopedPk;
 using crypto::ScopedX509Crt;
 
 /**
- * @brief Initialize ConfigManager and build the configuration key-to-field map.
+ * @brief Construct an uninitialized ConfigManager.
  *
- * Constructs a ConfigManager instance, marks it uninitialized, and populates
- * the internal m_configMap with mappings from configuration keys (for the
- * "mqtt" and "misc" sections) to pointers of their corresponding in-memory
- * fields. The map enables unified serialization/deserialization and JSON
- * handling for both MQTT and miscellaneous settings.
+ * Every configuration struct starts at its defaults until begin() loads the saved blobs. The
+ * key-to-member mapping used by serialization is the constexpr table in ConfigFields.hpp, so
+ * nothing is built or allocated here.
  */
-ConfigManager::ConfigManager() : m_isInitialized(false) {
-  m_configMap = { 
-    {"mqtt",{ 
-      // MQTT Config
-      {"mqttBroker", &m_mqttConfig.mqttBroker},
-      {"mqttPort", &m_mqttConfig.mqttPort},
-      {"mqttClientId", &m_mqttConfig.mqttClientId},
-      {"mqttUsername", &m_mqttConfig.mqttUsername},
-      {"mqttPassword", &m_mqttConfig.mqttPassword},
-      {"hassMqttDiscoveryEnabled",
-        &m_mqttConfig.hassMqttDiscoveryEnabled},
-      {"lwtTopic", &m_mqttConfig.lwtTopic},
-      {"hkTopic", &m_mqttConfig.hkTopic},
-      {"lockStateTopic", &m_mqttConfig.lockStateTopic},
-      {"lockStateCmd", &m_mqttConfig.lockStateCmd},
-      {"lockCStateCmd", &m_mqttConfig.lockCStateCmd},
-      {"lockTStateCmd", &m_mqttConfig.lockTStateCmd},
-      {"btrLvlCmdTopic", &m_mqttConfig.btrLvlCmdTopic},
-      {"hkAltActionTopic", &m_mqttConfig.hkAltActionTopic},
-      {"lockCustomStateTopic", &m_mqttConfig.lockCustomStateTopic},
-      {"lockCustomStateCmd", &m_mqttConfig.lockCustomStateCmd},
-      {"lockEnableCustomState", &m_mqttConfig.lockEnableCustomState},
-      {"nfcTagNoPublish", &m_mqttConfig.nfcTagNoPublish},
-      {"useSSL", &m_mqttConfig.useSSL},
-      {"allowInsecure", &m_mqttConfig.allowInsecure},
-      {"customLockStates", &m_mqttConfig.customLockStates},
-      {"customLockActions", &m_mqttConfig.customLockActions}
-      }
-    },
-{
-      "ssl", {
-        {"caCert", &m_mqttSslConfig.caCert},
-        {"clientCert", &m_mqttSslConfig.clientCert},
-        {"clientKey", &m_mqttSslConfig.clientKey},
-      }
-    },
-    {
-      "https", {
-        {"serverCert", &m_httpsCertsConfig.serverCert},
-        {"privateKey", &m_httpsCertsConfig.privateKey},
-        {"caCert", &m_httpsCertsConfig.caCert},
-      }
-    },
-    {"misc",{
-      // Miscellaneous Config
-      {"deviceName", &m_miscConfig.deviceName},
-      {"otaPasswd", &m_miscConfig.otaPasswd},
-      {"hk_key_color", &m_miscConfig.hk_key_color},
-      {"setupCode", &m_miscConfig.setupCode},
-      {"lockAlwaysUnlock", &m_miscConfig.lockAlwaysUnlock},
-      {"lockAlwaysLock", &m_miscConfig.lockAlwaysLock},
-      {"hkAuthPrecomputeEnabled", &m_miscConfig.hkAuthPrecomputeEnabled},
-      {"nfcFastPollingEnabled", &m_miscConfig.nfcFastPollingEnabled},
-      {"nfcReaderType", &m_miscConfig.nfcReaderType},
-      {"nfcIrqPin", &m_miscConfig.nfcIrqPin},
-      {"nfcVenPin", &m_miscConfig.nfcVenPin},
-      {"controlPin", &m_miscConfig.controlPin},
-      {"hsStatusPin", &m_miscConfig.hsStatusPin},
-      {"webAuthEnabled", &m_miscConfig.webAuthEnabled},
-      {"webUsername", &m_miscConfig.webUsername},
-      {"webPassword", &m_miscConfig.webPassword},
-      {"webHttpsEnabled", &m_miscConfig.webHttpsEnabled},
-      {"nfcGpioPins", &m_miscConfig.nfcGpioPins},
-      {"nfcPinsPreset", &m_miscConfig.nfcPinsPreset},
-      {"btrLowStatusThreshold", &m_miscConfig.btrLowStatusThreshold},
-      {"proxBatEnabled", &m_miscConfig.proxBatEnabled},
-      {"ethernetEnabled", &m_miscConfig.ethernetEnabled},
-      {"ethActivePreset", &m_miscConfig.ethActivePreset},
-      {"ethPhyType", &m_miscConfig.ethPhyType},
-      {"ethSpiBus", &m_miscConfig.ethSpiBus},
-      {"ethRmiiConfig", &m_miscConfig.ethRmiiConfig},
-      {"ethSpiConfig", &m_miscConfig.ethSpiConfig},
-      {"overrideStrappingRestriction", &m_miscConfig.overrideStrappingRestriction},
-      {"accessPointPassword", &m_miscConfig.accessPointPassword}
-    }
-    },
-    {
-      "actions", {
-        {"nfcNeopixelPin", &m_actionsConfig.nfcNeopixelPin},
-        {"neoPixelType", &m_actionsConfig.neoPixelType},
-        {"neopixelSuccessColor", &m_actionsConfig.neopixelSuccessColor},
-        {"neopixelFailureColor", &m_actionsConfig.neopixelFailureColor},
-        {"neopixelSuccessTime", &m_actionsConfig.neopixelSuccessTime},
-        {"neopixelFailTime", &m_actionsConfig.neopixelFailTime},
-        {"neopixelTagEventTime", &m_actionsConfig.neopixelTagEventTime},
-        {"neopixelTagEventColor", &m_actionsConfig.neopixelTagEventColor},
-        {"nfcSuccessPin", &m_actionsConfig.nfcSuccessPin},
-        {"nfcSuccessTime", &m_actionsConfig.nfcSuccessTime},
-        {"nfcSuccessHL", &m_actionsConfig.nfcSuccessHL},
-        {"nfcFailPin", &m_actionsConfig.nfcFailPin},
-        {"nfcFailTime", &m_actionsConfig.nfcFailTime},
-        {"nfcFailHL", &m_actionsConfig.nfcFailHL},
-        {"tagEventPin", &m_actionsConfig.tagEventPin},
-        {"tagEventTimeout", &m_actionsConfig.tagEventTimeout},
-        {"tagEventHL", &m_actionsConfig.tagEventHL},
-        {"gpioActionPin", &m_actionsConfig.gpioActionPin},
-        {"gpioActionLockState", &m_actionsConfig.gpioActionLockState},
-        {"gpioActionUnlockState", &m_actionsConfig.gpioActionUnlockState},
-        {"gpioActionMomentaryEnabled", &m_actionsConfig.gpioActionMomentaryEnabled},
-        {"hkGpioControlledState", &m_actionsConfig.hkGpioControlledState},
-        {"gpioActionMomentaryTimeout", &m_actionsConfig.gpioActionMomentaryTimeout},
-        {"hkDumbSwitchMode", &m_actionsConfig.hkDumbSwitchMode},
-        {"hkAltActionPin", &m_actionsConfig.hkAltActionPin},
-        {"hkAltActionTimeout", &m_actionsConfig.hkAltActionTimeout},
-        {"hkAltActionGpioState", &m_actionsConfig.hkAltActionGpioState},
-        {"hkAltActionInitPin", &m_actionsConfig.hkAltActionInitPin},
-        {"hkAltActionInitLedPin", &m_actionsConfig.hkAltActionInitLedPin},
-        {"hkAltActionInitTimeout", &m_actionsConfig.hkAltActionInitTimeout},
-      }
-    }
-  };
-}
+ConfigManager::ConfigManager() : m_isInitialized(false) {}
 
 /**
  * @brief Releases resources held by ConfigManager.
@@ -385,7 +274,7 @@ void ConfigManager::loadConfigFromNvs(const char *key) {
     return;
   }
 
-  std::vector<uint8_t> buffer(required_size);
+  BulkVector<uint8_t> buffer(required_size);
   err = nvs_get_blob(m_nvsHandle, key, buffer.data(), &required_size);
 
   if (err != ESP_OK) {
@@ -407,14 +296,14 @@ void ConfigManager::loadConfigFromNvs(const char *key) {
   if(success) {
     msgpack_object obj = unpacked.data;
     if(!strcmp(key, "MQTTDATA")){
-      deserialize(obj, "mqtt");
+      deserialize(obj, m_mqttConfig);
     } else if(!strcmp(key, "MQTTSSLDATA")){
-      deserialize(obj, "ssl");
+      deserialize(obj, m_mqttSslConfig);
     } else if(!strcmp(key, "MISCDATA")){
-      deserialize(obj, "misc");
-      deserialize(obj, "actions");
+      deserialize(obj, m_miscConfig);
+      deserialize(obj, m_actionsConfig);
     } else if(!strcmp(key, "HTTPSDATA")){
-      deserialize(obj, "https");
+      deserialize(obj, m_httpsCertsConfig);
     } else {ESP_LOGE(TAG, "Key '%s' not valid", key);return;}
   } else {
     ESP_LOGE(TAG, "Failed to parse msgpack for key '%s'. Using defaults.", key);
@@ -436,7 +325,7 @@ bool ConfigManager::saveConfigToNvs(const char *key) {
     return false;
   }
 
-  std::vector<uint8_t> buf;
+  BulkVector<uint8_t> buf;
   if (!strcmp(key, "MISCDATA")){
     buf = serialize<espConfig::misc_config_t>();
   } else if (!strcmp(key, "MQTTSSLDATA")){
@@ -462,134 +351,133 @@ bool ConfigManager::saveConfigToNvs(const char *key) {
   return true;
 }
 
+template <typename ConfigType>
+/**
+ * @brief The in-memory instance of the configuration selected by the template parameter.
+ */
+ConfigType& ConfigManager::configFor() {
+  if constexpr (std::is_same_v<ConfigType, espConfig::mqttConfig_t>) {
+    return m_mqttConfig;
+  } else if constexpr (std::is_same_v<ConfigType, espConfig::mqtt_ssl_t>) {
+    return m_mqttSslConfig;
+  } else if constexpr (std::is_same_v<ConfigType, espConfig::misc_config_t>) {
+    return m_miscConfig;
+  } else if constexpr (std::is_same_v<ConfigType, espConfig::actions_config_t>) {
+    return m_actionsConfig;
+  } else if constexpr (std::is_same_v<ConfigType, espConfig::https_certs_t>) {
+    return m_httpsCertsConfig;
+  } else {
+    static_assert(std::is_void_v<ConfigType> && false, "Unsupported ConfigType for configFor");
+  }
+}
+
+template <typename ConfigType>
 /**
  * @brief Populates in-memory configuration fields from a MessagePack map.
  *
- * Deserializes a MessagePack map object into the ConfigManager's in-memory configuration
- * entries identified by the provided section name (`type`). For each string key found
- * in the MessagePack map that exists in the internal `m_configMap[type]`, the matching
- * in-memory field is updated. Supported value types:
+ * Deserializes a MessagePack map object into `config`. Each string key is looked up in
+ * `espConfig::fields::Schema<ConfigType>::fields`, and the matching member is updated.
+ * Supported value types:
  * - string -> std::string
  * - boolean -> bool
  * - positive integer -> uint8_t / uint16_t
  * - array of integers -> std::array<uint8_t, N> (N = 4, 5, 7)
- * - array of [enum, value] pairs -> std::map<espConfig::misc_config_t::colorMap, uint8_t>
- * - array of [string, value] pairs -> std::map<std::string, uint8_t>
+ * - array of [enum, value] pairs -> std::map<espConfig::actions_config_t::colorMap, uint8_t>
+ * - array of [string, value] pairs, or a map -> std::map<std::string, uint8_t>
  *
- * Unknown keys are ignored. If `obj` is not a MessagePack map, an error is logged and
- * no assignments are performed.
+ * Keys that are not fields of `ConfigType` are ignored, so a blob holding several structs
+ * (MISCDATA) is deserialized once per struct. If `obj` is not a MessagePack map, an error is
+ * logged and no assignments are performed.
  *
  * @param obj MessagePack object expected to be a map of configuration keys to values.
- * @param type Configuration section name (e.g., "mqtt" or "misc") used to look up the
- *             corresponding key → field mapping in `m_configMap`.
+ * @param config The configuration struct to update.
  */
-void ConfigManager::deserialize(msgpack_object obj, std::string type) {
-  if (obj.type == MSGPACK_OBJECT_MAP) {
-    msgpack_object_kv *map = obj.via.map.ptr;
-    msgpack_object_kv *const end = obj.via.map.ptr + obj.via.map.size;
-    std::span range(map, end);
-    for (auto v : range) {
-      if (v.key.type == MSGPACK_OBJECT_STR) {
-        std::string key(v.key.via.str.ptr, v.key.via.str.size);
-        if (!m_configMap.contains(type) || !m_configMap[type].contains(key))
-          continue;
-
-        std::visit([&](auto&& arg) {
-          using T = std::decay_t<decltype(arg)>;
-          if constexpr (std::is_pointer_v<T>) {
-            using PointeeType = std::remove_pointer_t<T>;
-
-            switch (v.val.type) {
-            case MSGPACK_OBJECT_STR: {
-              if constexpr (std::is_same_v<PointeeType, std::string>) {
-                arg->assign(std::string(v.val.via.str.ptr, v.val.via.str.size));
-              }
-              break;
-            }
-            case MSGPACK_OBJECT_BOOLEAN: {
-              if constexpr (std::is_same_v<PointeeType, bool>) {
-                *arg = v.val.via.boolean;
-              }
-              break;
-            }
-            case MSGPACK_OBJECT_POSITIVE_INTEGER: {
-              if constexpr (std::is_same_v<PointeeType, uint8_t> || std::is_same_v<PointeeType, uint16_t>) {
-                if (v.val.via.u64 > std::numeric_limits<PointeeType>::max()) {
-                  ESP_LOGW(TAG, "Value overflow for '%s': %llu exceeds max %u", 
-                           key.c_str(), v.val.via.u64, std::numeric_limits<PointeeType>::max());
-                  break;
-                }
-                *arg = static_cast<PointeeType>(v.val.via.u64);
-              }
-              break;
-            }
-            case MSGPACK_OBJECT_ARRAY: {
-              auto msgpack_elements = std::ranges::subrange(v.val.via.array.ptr, v.val.via.array.ptr + v.val.via.array.size);
-              auto integer_view = msgpack_elements | std::ranges::views::transform([](const msgpack_object& o){return o.via.u64;});
-
-              if constexpr (std::is_same_v<PointeeType, std::array<uint8_t, 4>>) {
-                if (msgpack_elements.size() != 4) {
-                  ESP_LOGW(TAG, "Validation failed for '%s': array size is not 4.", key.c_str());
-                  break;
-                }
-                std::ranges::copy(integer_view, arg->begin());
-              } else if constexpr (std::is_same_v<PointeeType, std::array<uint8_t, 5>>) {
-                if (msgpack_elements.size() != 5) {
-                  ESP_LOGW(TAG, "Validation failed for '%s': array size is not 5.", key.c_str());
-                  break;
-                }
-                std::ranges::copy(integer_view, arg->begin());
-              } else if constexpr (std::is_same_v<PointeeType, std::array<uint8_t, 7>>) {
-                if (msgpack_elements.size() != 7) {
-                  ESP_LOGW(TAG, "Validation failed for '%s': array size is not 7.", key.c_str());
-                  break;
-                }
-                std::ranges::copy(integer_view, arg->begin());
-              } else if constexpr (std::is_same_v<PointeeType, std::map<espConfig::actions_config_t::colorMap, uint8_t>>) {
-                std::ranges::for_each(msgpack_elements, [&](const msgpack_object& o) {
-                    if (o.type == MSGPACK_OBJECT_ARRAY && o.via.array.size == 2) {
-                        const msgpack_object* inner_array_ptr = o.via.array.ptr;
-                        uint8_t key_val = inner_array_ptr[0].via.u64;
-                        uint8_t value_val = inner_array_ptr[1].via.u64;
-                        (*arg)[static_cast<espConfig::actions_config_t::colorMap>(key_val)] = static_cast<uint8_t>(value_val);
-                    }
-                });
-              } else if constexpr (std::is_same_v<PointeeType, std::map<std::string, uint8_t>>) {
-                std::ranges::for_each(msgpack_elements, [&](const msgpack_object& o) {
-                    if (o.type == MSGPACK_OBJECT_ARRAY && o.via.array.size >= 2) {
-                        const msgpack_object* inner_array_ptr = o.via.array.ptr;
-                        std::string key_str(inner_array_ptr[0].via.str.ptr, inner_array_ptr[0].via.str.size);
-                        uint64_t value_val = inner_array_ptr[1].via.u64;
-                        (*arg)[key_str] = static_cast<uint8_t>(value_val);
-                    }
-                });
+void ConfigManager::deserialize(msgpack_object obj, ConfigType& config) {
+  if (obj.type != MSGPACK_OBJECT_MAP) {
+    ESP_LOGE(TAG, "Error: Expected a MessagePack map object for deserialization.");
+    return;
+  }
+  for (const msgpack_object_kv& v : std::span(obj.via.map.ptr, obj.via.map.size)) {
+    if (v.key.type != MSGPACK_OBJECT_STR) continue;
+    const auto* field = espConfig::fields::find<ConfigType>(std::string_view(v.key.via.str.ptr, v.key.via.str.size));
+    if (!field) continue;
+    const char* key = field->name.data();
+
+    std::visit([&](auto member) {
+      using T = espConfig::fields::member_value_t<decltype(member)>;
+      T& value = config.*member;
+
+      switch (v.val.type) {
+      case MSGPACK_OBJECT_STR: {
+        if constexpr (std::is_same_v<T, std::string>) {
+          value.assign(v.val.via.str.ptr, v.val.via.str.size);
+        }
+        break;
+      }
+      case MSGPACK_OBJECT_BOOLEAN: {
+        if constexpr (std::is_same_v<T, bool>) {
+          value = v.val.via.boolean;
+        }
+        break;
+      }
+      case MSGPACK_OBJECT_POSITIVE_INTEGER: {
+        if constexpr (std::is_same_v<T, uint8_t> || std::is_same_v<T, uint16_t>) {
+          if (v.val.via.u64 > std::numeric_limits<T>::max()) {
+            ESP_LOGW(TAG, "Value overflow for '%s': %llu exceeds max %u",
+                     key, v.val.via.u64, std::numeric_limits<T>::max());
+            break;
+          }
+          value = static_cast<T>(v.val.via.u64);
+        }
+        break;
+      }
+      case MSGPACK_OBJECT_ARRAY: {
+        auto msgpack_elements = std::ranges::subrange(v.val.via.array.ptr, v.val.via.array.ptr + v.val.via.array.size);
+        auto integer_view = msgpack_elements | std::ranges::views::transform([](const msgpack_object& o){return o.via.u64;});
+
+        if constexpr (std::is_same_v<T, std::array<uint8_t, 4>> || std::is_same_v<T, std::array<uint8_t, 5>> ||
+                      std::is_same_v<T, std::array<uint8_t, 7>>) {
+          if (msgpack_elements.size() != value.size()) {
+            ESP_LOGW(TAG, "Validation failed for '%s': array size is not %zu.", key, value.size());
+            break;
+          }
+          std::ranges::copy(integer_view, value.begin());
+        } else if constexpr (std::is_same_v<T, espConfig::fields::ColorMap>) {
+          std::ranges::for_each(msgpack_elements, [&](const msgpack_object& o) {
+              if (o.type == MSGPACK_OBJECT_ARRAY && o.via.array.size == 2) {
+                  const msgpack_object* inner_array_ptr = o.via.array.ptr;
+                  uint8_t key_val = inner_array_ptr[0].via.u64;
+                  uint8_t value_val = inner_array_ptr[1].via.u64;
+                  value[static_cast<espConfig::actions_config_t::colorMap>(key_val)] = static_cast<uint8_t>(value_val);
               }
-              break;
-            }
-            case MSGPACK_OBJECT_MAP: {
-              if constexpr (std::is_same_v<PointeeType, std::map<std::string, uint8_t>>) {
-                arg->clear();
-                msgpack_object_kv *sub_map = v.val.via.map.ptr;
-                msgpack_object_kv *const sub_end = v.val.via.map.ptr + v.val.via.map.size;
-                for (; sub_map != sub_end; ++sub_map) {
-                  if (sub_map->key.type == MSGPACK_OBJECT_STR && sub_map->val.type == MSGPACK_OBJECT_POSITIVE_INTEGER) {
-                    std::string sub_key(sub_map->key.via.str.ptr, sub_map->key.via.str.size);
-                    uint8_t sub_value = static_cast<uint8_t>(sub_map->val.via.u64);
-                    arg->emplace(sub_key, sub_value);
-                  }
-                }
+          });
+        } else if constexpr (std::is_same_v<T, espConfig::fields::StateMap>) {
+          std::ranges::for_each(msgpack_elements, [&](const msgpack_object& o) {
+              if (o.type == MSGPACK_OBJECT_ARRAY && o.via.array.size >= 2) {
+                  const msgpack_object* inner_array_ptr = o.via.array.ptr;
+                  std::string key_str(inner_array_ptr[0].via.str.ptr, inner_array_ptr[0].via.str.size);
+                  uint64_t value_val = inner_array_ptr[1].via.u64;
+                  value[key_str] = static_cast<uint8_t>(value_val);
               }
-              break;
-            }
-            default:
-              ESP_LOGW(TAG, "DON'T KNOW THIS ONE! - %s (%d) = %d", key.c_str(), v.val.type, v.val.via.u64);
+          });
+        }
+        break;
+      }
+      case MSGPACK_OBJECT_MAP: {
+        if constexpr (std::is_same_v<T, espConfig::fields::StateMap>) {
+          value.clear();
+          for (const msgpack_object_kv& sub : std::span(v.val.via.map.ptr, v.val.via.map.size)) {
+            if (sub.key.type == MSGPACK_OBJECT_STR && sub.val.type == MSGPACK_OBJECT_POSITIVE_INTEGER) {
+              value.emplace(std::string(sub.key.via.str.ptr, sub.key.via.str.size), static_cast<uint8_t>(sub.val.via.u64));
             }
           }
-        }, m_configMap[type][key]);
+        }
+        break;
       }
-    }
-  } else {
-    ESP_LOGE(TAG, "Error: Expected a MessagePack map object for deserialization.");
+      default:
+        ESP_LOGW(TAG, "DON'T KNOW THIS ONE! - %s (%d) = %d", key, v.val.type, v.val.via.u64);
+      }
+    }, field->member);
   }
 }
 
@@ -597,231 +485,106 @@ template <typename ConfigType>
 /**
  * @brief Serializes the selected configuration type into a MessagePack binary blob.
  *
- * Produces a MessagePack representation of the in-memory configuration for either the misc or mqtt config type,
- * encoding strings, booleans, unsigned integers, fixed-size byte arrays, and map entries. Map entries are encoded
- * as arrays of key/value pairs; enum-keyed color maps are encoded as [enum, value] pairs and string-keyed maps as
- * [string, value] pairs.
+ * Walks `espConfig::fields::Schema<ConfigType>::fields` and packs each member under its key,
+ * encoding strings, booleans, unsigned integers, fixed-size byte arrays, and map entries.
+ * Enum-keyed color maps are encoded as an array of [enum, value] pairs and string-keyed maps
+ * as a map of string to value. The misc and actions configurations share the MISCDATA blob,
+ * so either type packs the fields of both.
  *
- * @return std::vector<uint8_t> Byte vector containing the MessagePack-encoded configuration. 
+ * @return BulkVector<uint8_t> Byte vector containing the MessagePack-encoded configuration.
  */
-std::vector<uint8_t> ConfigManager::serialize() {
-  msgpack_sbuffer sbuf;
-  msgpack_sbuffer_init(&sbuf);
+BulkVector<uint8_t> ConfigManager::serialize() {
+  BulkVector<uint8_t> serialized_data;
   msgpack_packer pk;
-  msgpack_packer_init(&pk, &sbuf, msgpack_sbuffer_write);
-  ConfigMapType configMap;
-  if constexpr (std::is_same_v<espConfig::misc_config_t, ConfigType>){
-    configMap = m_configMap["misc"];
-    configMap.insert(m_configMap["actions"].begin(), m_configMap["actions"].end());
-  } else if constexpr (std::is_same_v<espConfig::actions_config_t, ConfigType>){
-    configMap = m_configMap["actions"];
-    configMap.insert(m_configMap["misc"].begin(), m_configMap["misc"].end());
-  } else if constexpr (std::is_same_v<espConfig::mqtt_ssl_t, ConfigType>){
-    configMap = m_configMap["ssl"];
-  } else if constexpr (std::is_same_v<espConfig::mqttConfig_t, ConfigType>){
-    configMap = m_configMap["mqtt"];
-  } else if constexpr (std::is_same_v<espConfig::https_certs_t, ConfigType>){
-    configMap = m_configMap["https"];
-  }
-  msgpack_pack_map(&pk, configMap.size()); // Pack the map size
-
-  for (const auto &pair : configMap) {
-    msgpack_pack_str(&pk, pair.first.size()); // Pack the key (string) size
-    msgpack_pack_str_body(&pk, pair.first.data(), pair.first.size()); // Pack the key (string) body
-
-    std::visit([&](auto&& arg) {
-      using T = std::decay_t<decltype(arg)>;
-      if constexpr (std::is_pointer_v<T>) {
-        using PointeeType = std::remove_pointer_t<T>;
-
-        if constexpr (std::is_same_v<PointeeType, std::string>) {
-          msgpack_pack_str(&pk, arg->size());
-          msgpack_pack_str_body(&pk, arg->data(), arg->size());
-        } else if constexpr (std::is_same_v<PointeeType, bool>) {
-          if (*arg) {
+  msgpack_packer_init(&pk, &serialized_data, MemoryPlacement::appendToBulk);
+
+  auto pack = [&pk](const auto& config) {
+    using Config = std::decay_t<decltype(config)>;
+    for (const auto& field : espConfig::fields::Schema<Config>::fields) {
+      msgpack_pack_str(&pk, field.name.size());
+      msgpack_pack_str_body(&pk, field.name.data(), field.name.size());
+
+      std::visit([&](auto member) {
+        using T = espConfig::fields::member_value_t<decltype(member)>;
+        const T& value = config.*member;
+
+        if constexpr (std::is_same_v<T, std::string>) {
+          msgpack_pack_str(&pk, value.size());
+          msgpack_pack_str_body(&pk, value.data(), value.size());
+        } else if constexpr (std::is_same_v<T, bool>) {
+          if (value) {
             msgpack_pack_true(&pk);
           } else {
             msgpack_pack_false(&pk);
           }
-        } else if constexpr (std::is_same_v<PointeeType, uint8_t>) {
-          msgpack_pack_unsigned_char(&pk, *arg);
-        } else if constexpr (std::is_same_v<PointeeType, uint16_t>) {
-          msgpack_pack_unsigned_short(&pk, *arg);
-        } else if constexpr (std::is_same_v<PointeeType, std::array<uint8_t, 4>>) {
-          msgpack_pack_array(&pk, arg->size());
-          for (const auto& val : *arg) {
-            msgpack_pack_unsigned_char(&pk, val);
-          }
-        } else if constexpr (std::is_same_v<PointeeType, std::array<uint8_t, 5>>) {
-          msgpack_pack_array(&pk, arg->size());
-          for (const auto& val : *arg) {
+        } else if constexpr (std::is_same_v<T, uint8_t>) {
+          msgpack_pack_unsigned_char(&pk, value);
+        } else if constexpr (std::is_same_v<T, uint16_t>) {
+          msgpack_pack_unsigned_short(&pk, value);
+        } else if constexpr (std::is_same_v<T, std::array<uint8_t, 4>> || std::is_same_v<T, std::array<uint8_t, 5>> ||
+                             std::is_same_v<T, std::array<uint8_t, 7>>) {
+          msgpack_pack_array(&pk, value.size());
+          for (const auto& val : value) {
             msgpack_pack_unsigned_char(&pk, val);
           }
-        } else if constexpr (std::is_same_v<PointeeType, std::array<uint8_t, 7>>) {
-          msgpack_pack_array(&pk, arg->size());
-          for (const auto& val : *arg) {
-            msgpack_pack_unsigned_char(&pk, val);
-          }
-        } else if constexpr (std::is_same_v<PointeeType, std::map<espConfig::actions_config_t::colorMap, uint8_t>>) {
-          msgpack_pack_array(&pk, arg->size());
-          for (const auto& map_pair : *arg) {
+        } else if constexpr (std::is_same_v<T, espConfig::fields::ColorMap>) {
+          msgpack_pack_array(&pk, value.size());
+          for (const auto& map_pair : value) {
             msgpack_pack_array(&pk, 2);
             msgpack_pack_unsigned_char(&pk, static_cast<uint8_t>(map_pair.first));
             msgpack_pack_unsigned_char(&pk, map_pair.second);
           }
-        } else if constexpr (std::is_same_v<PointeeType, std::map<std::string, uint8_t>>) {
-          msgpack_pack_map(&pk, arg->size());
-          for (const auto& map_pair : *arg) {
+        } else if constexpr (std::is_same_v<T, espConfig::fields::StateMap>) {
+          msgpack_pack_map(&pk, value.size());
+          for (const auto& map_pair : value) {
             msgpack_pack_str(&pk, map_pair.first.size());
             msgpack_pack_str_body(&pk, map_pair.first.data(), map_pair.first.size());
             msgpack_pack_unsigned_char(&pk, map_pair.second);
-          }     }
-      }
-    }, pair.second);
+          }
+        }
+      }, field.member);
+    }
+  };
+
+  if constexpr (std::is_same_v<espConfig::misc_config_t, ConfigType> ||
+                std::is_same_v<espConfig::actions_config_t, ConfigType>) {
+    msgpack_pack_map(&pk, espConfig::fields::Schema<espConfig::misc_config_t>::fields.size() +
+                              espConfig::fields::Schema<espConfig::actions_config_t>::fields.size());
+    pack(m_miscConfig);
+    pack(m_actionsConfig);
+  } else {
+    msgpack_pack_map(&pk, espConfig::fields::Schema<ConfigType>::fields.size());
+    pack(configFor<ConfigType>());
   }
 
-  std::vector<uint8_t> serialized_data(reinterpret_cast<uint8_t*>(sbuf.data), reinterpret_cast<uint8_t*>(sbuf.data) + sbuf.size);
-  msgpack_sbuffer_destroy(&sbuf);
   return serialized_data;
 }
 
 template <typename ConfigType>
-std::string ConfigManager::updateFromJson(const std::string& json_string) {
-  // RAII guard for cJSON cleanup
-  struct cJSONGuard {
-    cJSON* ptr;
-    cJSONGuard(cJSON* p) : ptr(p) {}
-    ~cJSONGuard() { if(ptr) cJSON_Delete(ptr); }
-    cJSON* get() { return ptr; }
-    operator bool() const { return ptr != nullptr; }
-  };
-  
-  cJSONGuard root(cJSON_Parse(json_string.c_str()));
-  if (!root) {
-    ESP_LOGE(TAG, "Failed to parse JSON: invalid format.");
-    return "";
-  }
-
-  if (!cJSON_IsObject(root.get())) {
-    ESP_LOGE(TAG, "JSON root is not an object.");
-    return "";
-  }
-
-  ConfigMapType* configMapPtr = nullptr;
+/**
+ * @brief Apply a validated set of field changes to the in-memory configuration.
+ *
+ * The patch was produced by streaming a request through ConfigPatchBuilder, so every
+ * value already matches the type and bounds of its field; this only assigns them.
+ *
+ * @param patch Staged field values for the configuration selected by the template parameter.
+ * @return std::string JSON representation of the configuration after the update.
+ */
+std::string ConfigManager::applyPatch(const espConfig::fields::ConfigPatch<ConfigType>& patch) {
   if constexpr (std::is_same_v<ConfigType, espConfig::misc_config_t>) {
-    configMapPtr = &m_configMap["misc"];
+    patch.apply(m_miscConfig);
   } else if constexpr (std::is_same_v<ConfigType, espConfig::actions_config_t>) {
-    configMapPtr = &m_configMap["actions"];
+    patch.apply(m_actionsConfig);
   } else if constexpr (std::is_same_v<ConfigType, espConfig::mqttConfig_t>) {
-    configMapPtr = &m_configMap["mqtt"];
+    patch.apply(m_mqttConfig);
   } else {
-    ESP_LOGE(TAG, "Invalid configuration type specified.");
-    return "";
-  }
-  
-  for (cJSON *it = root.get()->child; it != NULL; it = it->next) {
-    std::string keyStr = it->string;
-    auto config_entry = configMapPtr->find(keyStr);
-
-    if (config_entry != configMapPtr->end()) {
-      std::visit([&](auto&& arg) {
-        using T = std::decay_t<decltype(arg)>;
-        if constexpr (std::is_pointer_v<T>) {
-          using PointeeType = std::remove_pointer_t<T>;
-
-          if constexpr (std::is_same_v<PointeeType, std::string>) {
-            if (cJSON_IsString(it)) {
-              arg->assign(it->valuestring);
-            } else {
-              ESP_LOGW(TAG, "Validation failed for '%s': type mismatch, expected string.", keyStr.c_str());
-            }
-          } else if constexpr (std::is_same_v<PointeeType, bool>) {
-            if (cJSON_IsBool(it)) {
-              *arg = cJSON_IsTrue(it);
-            } else if (cJSON_IsNumber(it)) {
-              *arg = (it->valueint != 0);
-            } else {
-              ESP_LOGW(TAG, "Validation failed for '%s': type mismatch, expected boolean.", keyStr.c_str());
-            }
-          } else if constexpr (std::is_integral_v<PointeeType>) {
-            if (cJSON_IsNumber(it)) {
-              if (it->valueint < 0 || it->valueint > std::numeric_limits<PointeeType>::max()) {
-                ESP_LOGW(TAG, "Value out of range for '%s': %d", keyStr.c_str(), it->valueint);
-              } else {
-                *arg = static_cast<PointeeType>(it->valueint);
-              }
-            } else {
-              ESP_LOGW(TAG, "Validation failed for '%s': type mismatch, expected number.", keyStr.c_str());
-            }
-          } else if constexpr (std::is_same_v<PointeeType, std::array<uint8_t, 4>> ||
-                               std::is_same_v<PointeeType, std::array<uint8_t, 5>> ||
-                               std::is_same_v<PointeeType, std::array<uint8_t, 7>>) {
-            if (cJSON_IsArray(it)) {
-              int array_size = cJSON_GetArraySize(it);
-              if (array_size == arg->size()) {
-                bool array_success = true;
-                for (int i = 0; i < array_size; ++i) {
-                  cJSON *sub_item = cJSON_GetArrayItem(it, i);
-                  if (cJSON_IsNumber(sub_item)) {
-                    (*arg)[i] = static_cast<uint8_t>(sub_item->valueint);
-                  } else {
-                    array_success = false;
-                    break;
-                  }
-                }
-                if (!array_success) {
-                  ESP_LOGW(TAG, "Validation failed for '%s': array contains non-numeric elements.", keyStr.c_str());
-                }
-              } else {
-                ESP_LOGW(TAG, "Validation failed for '%s': incorrect array size. Expected %zu, got %d.", keyStr.c_str(), arg->size(), array_size);
-              }
-            } else {
-              ESP_LOGW(TAG, "Validation failed for '%s': type mismatch, expected array.", keyStr.c_str());
-            }
-          } else if constexpr (std::is_same_v<PointeeType, std::map<espConfig::actions_config_t::colorMap, uint8_t>>) {
-            if (cJSON_IsArray(it)) {
-              arg->clear();
-              cJSON *inner_array;
-              cJSON_ArrayForEach(inner_array, it) {
-                if (cJSON_IsArray(inner_array) && cJSON_GetArraySize(inner_array) == 2) {
-                  cJSON *key_json = cJSON_GetArrayItem(inner_array, 0);
-                  cJSON *value_json = cJSON_GetArrayItem(inner_array, 1);
-                  if (cJSON_IsNumber(key_json) && cJSON_IsNumber(value_json)) {
-                    arg->emplace(
-                        static_cast<espConfig::actions_config_t::colorMap>(key_json->valueint),
-                        static_cast<uint8_t>(value_json->valueint)
-                    );
-                  }
-                }
-              }
-            } else {
-              ESP_LOGW(TAG, "Validation failed for '%s': type mismatch, expected an array of [key, value] pairs.", keyStr.c_str());
-            }
-          } else if constexpr (std::is_same_v<PointeeType, std::map<std::string, uint8_t>>) {
-            if (cJSON_IsObject(it)) {
-              arg->clear();
-              cJSON* sub_obj_item;
-              cJSON_ArrayForEach(sub_obj_item, it) {
-                if (cJSON_IsNumber(sub_obj_item)) {
-                  (*arg)[sub_obj_item->string] = static_cast<uint8_t>(sub_obj_item->valueint);
-                }
-              }
-            } else {
-              ESP_LOGW(TAG, "Validation failed for '%s': type mismatch, expected an object.", keyStr.c_str());
-            }
-          }
-        }
-      }, config_entry->second);
-    } else {
-      ESP_LOGW(TAG, "'%s' is not a valid configuration key and will be ignored.", keyStr.c_str());
-    }
+    static_assert(std::is_void_v<ConfigType> && false, "Unsupported ConfigType for applyPatch");
   }
-
   return serializeToJson<ConfigType>();
 }
-template std::string ConfigManager::updateFromJson<espConfig::misc_config_t>(const std::string& json_string);
-template std::string ConfigManager::updateFromJson<espConfig::actions_config_t>(const std::string& json_string);
-template std::string ConfigManager::updateFromJson<espConfig::mqttConfig_t>(const std::string& json_string);
+template std::string ConfigManager::applyPatch<espConfig::misc_config_t>(const espConfig::fields::ConfigPatch<espConfig::misc_config_t>& patch);
+template std::string ConfigManager::applyPatch<espConfig::actions_config_t>(const espConfig::fields::ConfigPatch<espConfig::actions_config_t>& patch);
+template std::string ConfigManager::applyPatch<espConfig::mqttConfig_t>(const espConfig::fields::ConfigPatch<espConfig::mqttConfig_t>& patch);
 
 template <typename ConfigType>
 /**
@@ -852,63 +615,50 @@ std::string ConfigManager::serializeToJson() {
       return ""; // Error creating JSON object
   }
 
-  ConfigMapType configMap;
-  if constexpr (std::is_same_v<espConfig::misc_config_t, ConfigType>){
-    configMap = m_configMap["misc"];
-  } else if constexpr (std::is_same_v<espConfig::actions_config_t, ConfigType>){
-    configMap = m_configMap["actions"];
-  } else if constexpr (std::is_same_v<espConfig::mqttConfig_t, ConfigType>){
-    configMap = m_configMap["mqtt"];
-  }
-    for (const auto &pair : configMap) {
-        const std::string& key = pair.first;
-        std::visit([&](auto&& arg) {
-            using T = std::decay_t<decltype(arg)>;
-            if constexpr (std::is_pointer_v<T>) {
-                using PointeeType = std::remove_pointer_t<T>;
-
-                if constexpr (std::is_same_v<PointeeType, std::string>) {
-                    if(key.contains("Password") || key.contains("Passwd")){
-                        cJSON_AddStringToObject(root.get(), key.c_str(), "********");
-                    } else {
-                        cJSON_AddStringToObject(root.get(), key.c_str(), arg->c_str());
+    const auto& config = configFor<ConfigType>();
+    for (const auto& field : espConfig::fields::Schema<ConfigType>::fields) {
+        const char* key = field.name.data();
+        std::visit([&](auto member) {
+            using T = espConfig::fields::member_value_t<decltype(member)>;
+            const T& value = config.*member;
+
+            if constexpr (std::is_same_v<T, std::string>) {
+                cJSON_AddStringToObject(root.get(), key, field.has(espConfig::fields::F_SECRET) ? "********" : value.c_str());
+            } else if constexpr (std::is_same_v<T, bool>) {
+                cJSON_AddBoolToObject(root.get(), key, value);
+            } else if constexpr (std::is_same_v<T, uint8_t> || std::is_same_v<T, uint16_t>) {
+                cJSON_AddNumberToObject(root.get(), key, static_cast<double>(value));
+            } else if constexpr (std::is_same_v<T, std::array<uint8_t, 4>> ||
+                                 std::is_same_v<T, std::array<uint8_t, 5>> ||
+                                 std::is_same_v<T, std::array<uint8_t, 7>>) {
+                cJSON *array = cJSON_CreateArray();
+                if (array) {
+                    for (const auto& val : value) {
+                        cJSON_AddItemToArray(array, cJSON_CreateNumber(static_cast<double>(val)));
                     }
-                } else if constexpr (std::is_same_v<PointeeType, bool>) {
-                    cJSON_AddBoolToObject(root.get(), key.c_str(), *arg);
-                } else if constexpr (std::is_same_v<PointeeType, uint8_t> || std::is_same_v<PointeeType, uint16_t>) {
-                    cJSON_AddNumberToObject(root.get(), key.c_str(), static_cast<double>(*arg));
-                } else if constexpr (std::is_same_v<PointeeType, std::array<uint8_t, 4>> ||
-                                     std::is_same_v<PointeeType, std::array<uint8_t, 5>> ||
-                                     std::is_same_v<PointeeType, std::array<uint8_t, 7>>) {
-                    cJSON *array = cJSON_CreateArray();
-                    if (array) {
-                        for (const auto& val : *arg) {
-                            cJSON_AddItemToArray(array, cJSON_CreateNumber(static_cast<double>(val)));
-                        }
-                        cJSON_AddItemToObject(root.get(), key.c_str(), array);
-                    }
-                } else if constexpr (std::is_same_v<PointeeType, std::map<espConfig::actions_config_t::colorMap, uint8_t>>) {
-                    cJSON *array_of_arrays = cJSON_CreateArray();
-                    if (array_of_arrays) {
-                        for (const auto& map_pair : *arg) {
-                            cJSON *inner_array = cJSON_CreateArray();
-                            cJSON_AddItemToArray(inner_array, cJSON_CreateNumber(static_cast<double>(map_pair.first))); // Enum key as integer
-                            cJSON_AddItemToArray(inner_array, cJSON_CreateNumber(static_cast<double>(map_pair.second)));
-                            cJSON_AddItemToArray(array_of_arrays, inner_array);
-                        }
-                        cJSON_AddItemToObject(root.get(), key.c_str(), array_of_arrays);
+                    cJSON_AddItemToObject(root.get(), key, array);
+                }
+            } else if constexpr (std::is_same_v<T, espConfig::fields::ColorMap>) {
+                cJSON *array_of_arrays = cJSON_CreateArray();
+                if (array_of_arrays) {
+                    for (const auto& map_pair : value) {
+                        cJSON *inner_array = cJSON_CreateArray();
+                        cJSON_AddItemToArray(inner_array, cJSON_CreateNumber(static_cast<double>(map_pair.first))); // Enum key as integer
+                        cJSON_AddItemToArray(inner_array, cJSON_CreateNumber(static_cast<double>(map_pair.second)));
+                        cJSON_AddItemToArray(array_of_arrays, inner_array);
                     }
-                } else if constexpr (std::is_same_v<PointeeType, std::map<std::string, uint8_t>>) {
-                    cJSON *map_obj = cJSON_CreateObject();
-                    if (map_obj) {
-                        for (const auto& map_pair : *arg) {
-                            cJSON_AddNumberToObject(map_obj, map_pair.first.c_str(), static_cast<double>(map_pair.second));
-                        }
-                        cJSON_AddItemToObject(root.get(), key.c_str(), map_obj);
+                    cJSON_AddItemToObject(root.get(), key, array_of_arrays);
+                }
+            } else if constexpr (std::is_same_v<T, espConfig::fields::StateMap>) {
+                cJSON *map_obj = cJSON_CreateObject();
+                if (map_obj) {
+                    for (const auto& map_pair : value) {
+                        cJSON_AddNumberToObject(map_obj, map_pair.first.c_str(), static_cast<double>(map_pair.second));
                     }
+                    cJSON_AddItemToObject(root.get(), key, map_obj);
                 }
             }
-        }, pair.second);
+        }, field.member);
     }
 
     char *json_string = cJSON_PrintUnformatted(root.get());
@@ -929,7 +679,7 @@ template <typename ConfigType>
  *
  * Parses `json_string`, validates types and shapes of present fields, and updates the corresponding
  * configuration members (either the "misc" or "mqtt" config selected by the template parameter).
- * Only keys that exist in the manager's config map are processed; keys with type/shape mismatches
+ * Only keys listed in `espConfig::fields::Schema<ConfigType>::fields` are processed; keys with type/shape mismatches
  * are ignored and cause the function to report failure.
  *
  * @param json_string JSON object string containing configuration keys and values.
@@ -956,140 +706,129 @@ bool ConfigManager::deserializeFromJson(const std::string& json_string) {
         return false;
     }
 
-    ConfigMapType configMap;
-    if constexpr (std::is_same_v<ConfigType, espConfig::misc_config_t>){
-      configMap = m_configMap["misc"];
-    } else if constexpr (std::is_same_v<ConfigType, espConfig::actions_config_t>){
-      configMap = m_configMap["actions"];
-    } else if constexpr (std::is_same_v<ConfigType, espConfig::mqttConfig_t>){
-      configMap = m_configMap["mqtt"];
-    } else {
-      static_assert(std::is_void_v<ConfigType> && false, "Unsupported ConfigType for deserializeFromJson");
-    }
+    auto& config = configFor<ConfigType>();
     bool success = true;
     cJSON *item = root.get()->child;
     while (item) {
-        std::string key = item->string;
-        if (configMap.contains(key)) {
-            std::visit([&](auto&& arg) {
-                using T = std::decay_t<decltype(arg)>;
-                if constexpr (std::is_pointer_v<T>) {
-                    using PointeeType = std::remove_pointer_t<T>;
-
-                    if constexpr (std::is_same_v<PointeeType, std::string>) {
-                        if (cJSON_IsString(item)) {
-                            arg->assign(item->valuestring);
-                        } else {
-                            ESP_LOGW(TAG, "Validation failed for '%s': type mismatch, expected string.", key.c_str());
-                            success = false;
-                        }
-                    } else if constexpr (std::is_same_v<PointeeType, bool>) {
-                        if (cJSON_IsBool(item)) {
-                            *arg = cJSON_IsTrue(item);
-                        } else if(cJSON_IsNumber(item)) {
-                            *arg = static_cast<PointeeType>(item->valueint);
-                        } else {
-                            ESP_LOGW(TAG, "Validation failed for '%s': type mismatch, expected boolean.", key.c_str());
-                            success = false;
-                        }
-                    } else if constexpr (std::is_same_v<PointeeType, uint8_t> || std::is_same_v<PointeeType, uint16_t>) {
-                        if (cJSON_IsNumber(item)) {
-                            if (item->valuedouble < 0 || item->valuedouble > std::numeric_limits<PointeeType>::max()) {
-                                ESP_LOGW(TAG, "Value out of range for '%s': %f", key.c_str(), item->valuedouble);
-                                success = false;
-                            } else {
-                                *arg = static_cast<PointeeType>(item->valuedouble);
-                            }
-                        } else {
-                            ESP_LOGW(TAG, "Validation failed for '%s': type mismatch, expected number.", key.c_str());
+        const char* key = item->string;
+        if (const auto* field = espConfig::fields::find<ConfigType>(key)) {
+            std::visit([&](auto member) {
+                using PointeeType = espConfig::fields::member_value_t<decltype(member)>;
+                PointeeType* arg = &(config.*member);
+
+                if constexpr (std::is_same_v<PointeeType, std::string>) {
+                    if (cJSON_IsString(item)) {
+                        arg->assign(item->valuestring);
+                    } else {
+                        ESP_LOGW(TAG, "Validation failed for '%s': type mismatch, expected string.", key);
+                        success = false;
+                    }
+                } else if constexpr (std::is_same_v<PointeeType, bool>) {
+                    if (cJSON_IsBool(item)) {
+                        *arg = cJSON_IsTrue(item);
+                    } else if(cJSON_IsNumber(item)) {
+                        *arg = static_cast<PointeeType>(item->valueint);
+                    } else {
+                        ESP_LOGW(TAG, "Validation failed for '%s': type mismatch, expected boolean.", key);
+                        success = false;
+                    }
+                } else if constexpr (std::is_same_v<PointeeType, uint8_t> || std::is_same_v<PointeeType, uint16_t>) {
+                    if (cJSON_IsNumber(item)) {
+                        if (item->valuedouble < 0 || item->valuedouble > std::numeric_limits<PointeeType>::max()) {
+                            ESP_LOGW(TAG, "Value out of range for '%s': %f", key, item->valuedouble);
                             success = false;
-                        }
-                    } else if constexpr (std::is_same_v<PointeeType, std::array<uint8_t, 4>> ||
-                                      std::is_same_v<PointeeType, std::array<uint8_t, 5>> ||
-                                      std::is_same_v<PointeeType, std::array<uint8_t, 7>>) {
-                        if (cJSON_IsArray(item)) {
-                            int array_size = cJSON_GetArraySize(item);
-                            if (array_size == arg->size()) {
-                                bool array_success = true;
-                                for (int i = 0; i < array_size; ++i) {
-                                    cJSON *sub_item = cJSON_GetArrayItem(item, i);
-                                    if (cJSON_IsNumber(sub_item)) {
-                                        (*arg)[i] = static_cast<uint8_t>(sub_item->valuedouble);
-                                    } else {
-                                        array_success = false;
-                                        break;
-                                    }
-                                }
-                                if (!array_success) {
-                                    ESP_LOGW(TAG, "Validation failed for '%s': array contains non-numeric elements.", key.c_str());
-                                    success = false;
-                                }
-                            } else {
-                                ESP_LOGW(TAG, "Validation failed for '%s': incorrect array size. Expected %zu, got %d.", key.c_str(), arg->size(), array_size);
-                                success = false;
-                            }
                         } else {
-                            ESP_LOGW(TAG, "Validation failed for '%s': type mismatch, expected array.", key.c_str());
-                            success = false;
+                            *arg = static_cast<PointeeType>(item->valuedouble);
                         }
-                    } else if constexpr (std::is_same_v<PointeeType, std::map<espConfig::actions_config_t::colorMap, uint8_t>>) {
-                        if (cJSON_IsArray(item)) {
-                            arg->clear();
-                            int array_size = cJSON_GetArraySize(item);
-                            bool map_success = true;
+                    } else {
+                        ESP_LOGW(TAG, "Validation failed for '%s': type mismatch, expected number.", key);
+                        success = false;
+                    }
+                } else if constexpr (std::is_same_v<PointeeType, std::array<uint8_t, 4>> ||
+                                  std::is_same_v<PointeeType, std::array<uint8_t, 5>> ||
+                                  std::is_same_v<PointeeType, std::array<uint8_t, 7>>) {
+                    if (cJSON_IsArray(item)) {
+                        int array_size = cJSON_GetArraySize(item);
+                        if (array_size == arg->size()) {
+                            bool array_success = true;
                             for (int i = 0; i < array_size; ++i) {
-                                cJSON *inner_array = cJSON_GetArrayItem(item, i);
-                                if (cJSON_IsArray(inner_array) && cJSON_GetArraySize(inner_array) == 2) {
-                                    cJSON *key_json = cJSON_GetArrayItem(inner_array, 0);
-                                    cJSON *value_json = cJSON_GetArrayItem(inner_array, 1);
-                                    if (cJSON_IsNumber(key_json) && cJSON_IsNumber(value_json)) {
-                                        uint64_t key_val = static_cast<uint64_t>(key_json->valuedouble);
-                                        uint64_t value_val = static_cast<uint64_t>(value_json->valuedouble);
-                                        arg->try_emplace(
-                                            static_cast<espConfig::actions_config_t::colorMap>(key_val),
-                                            static_cast<uint8_t>(value_val)
-                                        );
-                                    } else {
-                                        map_success = false; break;
-                                    }
+                                cJSON *sub_item = cJSON_GetArrayItem(item, i);
+                                if (cJSON_IsNumber(sub_item)) {
+                                    (*arg)[i] = static_cast<uint8_t>(sub_item->valuedouble);
                                 } else {
-                                    map_success = false; break;
+                                    array_success = false;
+                                    break;
                                 }
                             }
-                            if (!map_success) {
-                                ESP_LOGW(TAG, "Validation failed for '%s': invalid map format.", key.c_str());
+                            if (!array_success) {
+                                ESP_LOGW(TAG, "Validation failed for '%s': array contains non-numeric elements.", key);
                                 success = false;
                             }
                         } else {
-                            ESP_LOGW(TAG, "Validation failed for '%s': type mismatch, expected array for map.", key.c_str());
+                            ESP_LOGW(TAG, "Validation failed for '%s': incorrect array size. Expected %zu, got %d.", key, arg->size(), array_size);
                             success = false;
                         }
-                    } else if constexpr (std::is_same_v<PointeeType, std::map<std::string, uint8_t>>) {
-                        if (cJSON_IsObject(item)) {
-                            arg->clear();
-                            cJSON *sub_obj_item = item->child;
-                            bool map_success = true;
-                            while(sub_obj_item) {
-                                if (cJSON_IsNumber(sub_obj_item)) {
-                                    arg->operator[](sub_obj_item->string) = static_cast<uint8_t>(sub_obj_item->valuedouble);
+                    } else {
+                        ESP_LOGW(TAG, "Validation failed for '%s': type mismatch, expected array.", key);
+                        success = false;
+                    }
+                } else if constexpr (std::is_same_v<PointeeType, std::map<espConfig::actions_config_t::colorMap, uint8_t>>) {
+                    if (cJSON_IsArray(item)) {
+                        arg->clear();
+                        int array_size = cJSON_GetArraySize(item);
+                        bool map_success = true;
+                        for (int i = 0; i < array_size; ++i) {
+                            cJSON *inner_array = cJSON_GetArrayItem(item, i);
+                            if (cJSON_IsArray(inner_array) && cJSON_GetArraySize(inner_array) == 2) {
+                                cJSON *key_json = cJSON_GetArrayItem(inner_array, 0);
+                                cJSON *value_json = cJSON_GetArrayItem(inner_array, 1);
+                                if (cJSON_IsNumber(key_json) && cJSON_IsNumber(value_json)) {
+                                    uint64_t key_val = static_cast<uint64_t>(key_json->valuedouble);
+                                    uint64_t value_val = static_cast<uint64_t>(value_json->valuedouble);
+                                    arg->try_emplace(
+                                        static_cast<espConfig::actions_config_t::colorMap>(key_val),
+                                        static_cast<uint8_t>(value_val)
+                                    );
                                 } else {
-                                    map_success = false;
-                                    break;
+                                    map_success = false; break;
                                 }
-                                sub_obj_item = sub_obj_item->next;
+                            } else {
+                                map_success = false; break;
                             }
-                            if (!map_success) {
-                                ESP_LOGW(TAG, "Validation failed for '%s': map contains non-numeric values.", key.c_str());
-                                success = false;
+                        }
+                        if (!map_success) {
+                            ESP_LOGW(TAG, "Validation failed for '%s': invalid map format.", key);
+                            success = false;
+                        }
+                    } else {
+                        ESP_LOGW(TAG, "Validation failed for '%s': type mismatch, expected array for map.", key);
+                        success = false;
+                    }
+                } else if constexpr (std::is_same_v<PointeeType, std::map<std::string, uint8_t>>) {
+                    if (cJSON_IsObject(item)) {
+                        arg->clear();
+                        cJSON *sub_obj_item = item->child;
+                        bool map_success = true;
+                        while(sub_obj_item) {
+                            if (cJSON_IsNumber(sub_obj_item)) {
+                                arg->operator[](sub_obj_item->string) = static_cast<uint8_t>(sub_obj_item->valuedouble);
+                            } else {
+                                map_success = false;
+                                break;
                             }
-                        } else {
-                            ESP_LOGW(TAG, "Validation failed for '%s': type mismatch, expected object for map.", key.c_str());
+                            sub_obj_item = sub_obj_item->next;
+                        }
+                        if (!map_success) {
+                            ESP_LOGW(TAG, "Validation failed for '%s': map contains non-numeric values.", key);
                             success = false;
                         }
+                    } else {
+                        ESP_LOGW(TAG, "Validation failed for '%s': type mismatch, expected object for map.", key);
+                        success = false;
                     }
                 }
-            }, configMap.at(key));
-        } else ESP_LOGW(TAG, "Key '%s' could not be found!", key.c_str());
+            }, field->member);
+        } else ESP_LOGW(TAG, "Key '%s' could not be found!", key);
         item = item->next;
     }
 
@@ -1106,7 +845,7 @@ bool ConfigManager::saveCertificate(espConfig::CertType certType, const std::str
         return false;
     }
 
-    const size_t MAX_CERT_SIZE = 16384;
+    const size_t MAX_CERT_SIZE = espConfig::fields::MAX_CERT_LENGTH;
     if (certContent.length() > MAX_CERT_SIZE) {
         ESP_LOGE(TAG, "Certificate too large: %zu bytes (max: %zu)", 
                  certContent.length(), MAX_CERT_SIZE);
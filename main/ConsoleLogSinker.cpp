@@ -1,10 +1,12 @@
 #include "ConsoleLogSinker.h"
 #include "fmt/color.h"
+#include "HeapProfiler.hpp"
 #include <ctime>
 
 namespace loggable {
 
 void ConsoleLogSinker::consume(const LogMessage& message) {
+    HeapProfiler::Scope heapTag(HeapProfiler::Tag::Logging);
     fmt::detail::color_type c = fmt::color::white;
     std::string level = "NONE";
     switch (message.get_level()) {
@@ -0,0 +1,155 @@
+#include "DeltaPatcher.hpp"
+#include <algorithm>
+#include <cstring>
+
+static uint32_t readLe32(const uint8_t *p) {
+  return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+bool DeltaPatcher::write(const uint8_t *data, size_t len) {
+  while (len > 0) {
+    switch (m_state) {
+      case State::Header: {
+        // The header is staged in the work buffer until it is complete.
+        size_t take = std::min(len, HEADER_SIZE - m_headerFill);
+        memcpy(m_buffer.data() + m_headerFill, data, take);
+        m_headerFill += take;
+        data += take;
+        len -= take;
+        if (m_headerFill == HEADER_SIZE && !parseHeader()) return false;
+        break;
+      }
+
+      case State::Opcode:
+        m_op = *data++;
+        len--;
+        if (m_op == OP_END) {
+          m_state = State::End;
+        } else if (m_op == OP_COPY || m_op == OP_ADD) {
+          m_state = State::Offset;
+        } else if (m_op == OP_INSERT) {
+          m_state = State::Length;
+        } else {
+          return fail("Unknown patch opcode");
+        }
+        break;
+
+      case State::Offset:
+        len--;
+        if (readVarint(*data++, m_offset)) m_state = State::Length;
+        break;
+
+      case State::Length:
+        len--;
+        if (readVarint(*data++, m_length) && !beginOp()) return false;
+        break;
+
+      case State::Insert:
+      case State::Add: {
+        size_t take = std::min<size_t>(len, m_length);
+        if (m_state == State::Insert ? !emit(data, take) : !add(data, take)) return false;
+        data += take;
+        len -= take;
+        m_length -= take;
+        if (m_length == 0) m_state = State::Opcode;
+        break;
+      }
+
+      case State::End:
+        return fail("Trailing data after end of patch");
+
+      case State::Failed:
+        return false;
+    }
+  }
+  return m_state != State::Failed;
+}
+
+bool DeltaPatcher::finish() {
+  if (m_state == State::Failed) return false;
+  if (m_state != State::End) return fail("Patch is truncated");
+  if (m_output != m_header.targetSize) return fail("Patch produced the wrong image size");
+  return m_target.finish();
+}
+
+bool DeltaPatcher::parseHeader() {
+  const uint8_t *h = m_buffer.data();
+  if (memcmp(h, "HKDP", 4) != 0) return fail("Not a delta patch");
+  if (h[4] != VERSION) return fail("Unsupported delta patch version");
+  m_header.sourceSize = readLe32(h + 8);
+  m_header.targetSize = readLe32(h + 12);
+  memcpy(m_header.sourceSha256.data(), h + 16, 32);
+  memcpy(m_header.targetSha256.data(), h + 48, 32);
+  m_state = State::Opcode;
+  if (!m_source.accept(m_header)) return fail("Patch does not match the running firmware");
+  return true;
+}
+
+/**
+ * @brief Feed one byte of an unsigned LEB128 value.
+ * @return true once @p out holds the complete value.
+ */
+bool DeltaPatcher::readVarint(uint8_t byte, uint32_t &out) {
+  if (m_varintShift > 28 || (m_varintShift == 28 && byte > 0x0f)) return fail("Malformed varint");
+  m_varint |= uint32_t(byte & 0x7f) << m_varintShift;
+  if (byte & 0x80) {
+    m_varintShift += 7;
+    return false;
+  }
+  out = m_varint;
+  m_varint = 0;
+  m_varintShift = 0;
+  return true;
+}
+
+bool DeltaPatcher::beginOp() {
+  if (m_length > m_header.targetSize - m_output) return fail("Patch exceeds the target size");
+  if (m_op != OP_INSERT && (m_offset > m_header.sourceSize || m_length > m_header.sourceSize - m_offset)) {
+    return fail("Patch reads outside the source image");
+  }
+  if (m_op == OP_COPY) {
+    if (!copy()) return false;
+    m_state = State::Opcode;
+  } else if (m_length == 0) {
+    m_state = State::Opcode;
+  } else {
+    m_state = m_op == OP_INSERT ? State::Insert : State::Add;
+  }
+  return true;
+}
+
+bool DeltaPatcher::copy() {
+  while (m_length > 0) {
+    size_t chunk = std::min<size_t>(m_length, m_buffer.size());
+    if (!m_source.read(m_offset, m_buffer.data(), chunk)) return fail("Source read failed");
+    if (!emit(m_buffer.data(), chunk)) return false;
+    m_offset += chunk;
+    m_length -= chunk;
+  }
+  return true;
+}
+
+bool DeltaPatcher::add(const uint8_t *data, size_t len) {
+  while (len > 0) {
+    size_t chunk = std::min(len, m_buffer.size());
+    if (!m_source.read(m_offset, m_buffer.data(), chunk)) return fail("Source read failed");
+    for (size_t i = 0; i < chunk; i++) m_buffer[i] += data[i];
+    if (!emit(m_buffer.data(), chunk)) return false;
+    m_offset += chunk;
+    data += chunk;
+    len -= chunk;
+  }
+  return true;
+}
+
+bool DeltaPatcher::emit(const uint8_t *data, size_t len) {
+  if (!m_target.write(data, len)) return fail("Writing the patched image failed");
+  m_output += len;
+  return true;
+}
+
+bool DeltaPatcher::fail(const char *reason) {
+  if (!m_error) m_error = reason;
+  m_state = State::Failed;
+  return false;
+}
@@ -0,0 +1,124 @@
+#include "Executor.hpp"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "TaskRegistry.hpp"
+
+static const char *TAG = "Executor";
+
+// Per-run job time, in microseconds.
+static constexpr uint32_t JOB_RUN_BUCKETS_US[] = { 50, 100, 250, 500, 1000, 2500, 5000, 10000, 50000 };
+
+bool Executor::begin() {
+  if (m_task) return true;
+  if (TaskRegistry::instance().create(taskEntry, "executor", STACK_SIZE, this, PRIORITY, &m_task) != pdPASS) {
+    ESP_LOGE(TAG, "Failed to start the executor task");
+    m_task = nullptr;
+    return false;
+  }
+  return true;
+}
+
+Executor::JobId Executor::add(const char *labels, Callback fn) {
+  std::lock_guard lock(m_mutex);
+  for (size_t i = 0; i < m_jobs.size(); i++) {
+    Job &job = m_jobs[i];
+    if (job.fn) continue;
+    job.labels = labels;
+    job.fn = std::move(fn);
+    job.deadline = 0;
+    job.runTime = &MetricsRegistry::instance().histogram(
+        "hk_executor_job_run_us", "Run time of each executor job invocation", JOB_RUN_BUCKETS_US, labels);
+    return static_cast<JobId>(i);
+  }
+  ESP_LOGE(TAG, "No free job slot for %s", labels);
+  return INVALID_JOB;
+}
+
+void Executor::remove(JobId job) {
+  if (job >= MAX_JOBS) return;
+  std::lock_guard lock(m_mutex);
+  m_jobs[job] = {};
+}
+
+void Executor::post(JobId job) {
+  if (job >= MAX_JOBS || !m_task) return;
+  xTaskNotify(m_task, 1UL << job, eSetBits);
+}
+
+void IRAM_ATTR Executor::postFromISR(JobId job) {
+  if (job >= MAX_JOBS || !m_task) return;
+  BaseType_t woken = pdFALSE;
+  xTaskNotifyFromISR(m_task, 1UL << job, eSetBits, &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+void Executor::schedule(JobId job, uint32_t delayMs) {
+  if (job >= MAX_JOBS) return;
+  {
+    std::lock_guard lock(m_mutex);
+    m_jobs[job].deadline = esp_timer_get_time() + int64_t(delayMs) * 1000;
+  }
+  // Wake the worker so it recomputes how long to sleep.
+  if (m_task) xTaskNotify(m_task, WAKE_BIT, eSetBits);
+}
+
+void Executor::cancel(JobId job) {
+  if (job >= MAX_JOBS) return;
+  std::lock_guard lock(m_mutex);
+  m_jobs[job].deadline = 0;
+}
+
+bool Executor::scheduled(JobId job) {
+  if (job >= MAX_JOBS) return false;
+  std::lock_guard lock(m_mutex);
+  return m_jobs[job].deadline != 0;
+}
+
+void Executor::taskEntry(void *instance) {
+  static_cast<Executor *>(instance)->run();
+}
+
+TickType_t Executor::collectDue(uint32_t &ready) {
+  std::lock_guard lock(m_mutex);
+  const int64_t now = esp_timer_get_time();
+  int64_t next = 0;
+  for (size_t i = 0; i < m_jobs.size(); i++) {
+    int64_t &deadline = m_jobs[i].deadline;
+    if (deadline == 0) continue;
+    if (deadline <= now) {
+      deadline = 0;
+      ready |= 1UL << i;
+    } else if (next == 0 || deadline < next) {
+      next = deadline;
+    }
+  }
+  if (next == 0) return portMAX_DELAY;
+  // Round up, so the worker never wakes just before a deadline and spins.
+  const int64_t tickUs = int64_t(portTICK_PERIOD_MS) * 1000;
+  return static_cast<TickType_t>((next - now + tickUs - 1) / tickUs);
+}
+
+void Executor::run() {
+  while (true) {
+    uint32_t ready = 0;
+    const TickType_t wait = collectDue(ready);
+    uint32_t posted = 0;
+    xTaskNotifyWait(0, UINT32_MAX, &posted, ready ? 0 : wait);
+    ready |= posted & JOB_BITS;
+
+    for (size_t i = 0; i < MAX_JOBS; i++) {
+      if (!(ready & (1UL << i))) continue;
+      Callback fn;
+      MetricsRegistry::Histogram *runTime;
+      {
+        std::lock_guard lock(m_mutex);
+        fn = m_jobs[i].fn;
+        runTime = m_jobs[i].runTime;
+      }
+      if (!fn) continue;
+      const int64_t start = esp_timer_get_time();
+      fn();
+      runTime->observe(static_cast<uint32_t>(esp_timer_get_time() - start));
+    }
+  }
+}
@@ -0,0 +1,208 @@
+#include "FeedbackPattern.hpp"
+#include "config.hpp"
+#include <charconv>
+
+namespace feedback {
+
+bool Pattern::uses(Channel channel) const { return next(channel, 0) != count; }
+
+uint8_t Pattern::next(Channel channel, uint8_t from) const {
+  for (uint8_t i = from; i < count; i++) {
+    if (steps[i].channel == channel) return i;
+  }
+  return count;
+}
+
+uint8_t defaultPriority(Event event) { return event == Event::TagEvent ? 1 : 2; }
+
+Pattern builtin(Event event, const espConfig::actions_config_t &config) {
+  using C = espConfig::actions_config_t;
+  const std::map<C::colorMap, uint8_t> *color = nullptr;
+  uint16_t pixelMs = 0, gpioMs = 0;
+  Channel gpio = Channel::SuccessGpio;
+  switch (event) {
+    case Event::Success:
+      color = &config.neopixelSuccessColor;
+      pixelMs = config.neopixelSuccessTime;
+      gpioMs = config.nfcSuccessTime;
+      gpio = Channel::SuccessGpio;
+      break;
+    case Event::Failure:
+      color = &config.neopixelFailureColor;
+      pixelMs = config.neopixelFailTime;
+      gpioMs = config.nfcFailTime;
+      gpio = Channel::FailGpio;
+      break;
+    default:
+      color = &config.neopixelTagEventColor;
+      pixelMs = config.neopixelTagEventTime;
+      gpioMs = config.tagEventTimeout;
+      gpio = Channel::TagEventGpio;
+      break;
+  }
+  auto component = [&](C::colorMap c) {
+    auto it = color->find(c);
+    return it != color->end() ? it->second : uint8_t(0);
+  };
+
+  Pattern p;
+  p.priority = defaultPriority(event);
+  p.add({Channel::Pixel, true, component(C::R), component(C::G), component(C::B), pixelMs});
+  p.add({gpio, true, 0, 0, 0, gpioMs});
+  return p;
+}
+
+// ============================================================================
+// Parser
+// ============================================================================
+
+namespace {
+
+std::string_view trim(std::string_view s) {
+  while (!s.empty() && (s.front() == ' ' || s.front() == '\t' || s.front() == '\r' || s.front() == '\n')) {
+    s.remove_prefix(1);
+  }
+  while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r' || s.back() == '\n')) {
+    s.remove_suffix(1);
+  }
+  return s;
+}
+
+/** @brief Split off the text before the first @p sep; the rest is left in @p s (empty if none). */
+std::string_view take(std::string_view &s, char sep) {
+  size_t pos = s.find(sep);
+  std::string_view head = s.substr(0, pos);
+  s = pos == std::string_view::npos ? std::string_view{} : s.substr(pos + 1);
+  return trim(head);
+}
+
+template <typename T>
+bool number(std::string_view text, T min, T max, T &out) {
+  unsigned v = 0;
+  auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), v);
+  if (ec != std::errc() || end != text.data() + text.size() || v < min || v > max) return false;
+  out = static_cast<T>(v);
+  return true;
+}
+
+bool hexByte(std::string_view text, uint8_t &out) {
+  unsigned v = 0;
+  auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), v, 16);
+  if (ec != std::errc() || end != text.data() + text.size()) return false;
+  out = static_cast<uint8_t>(v);
+  return true;
+}
+
+struct Name {
+  std::string_view text;
+  uint8_t value;
+};
+
+constexpr Name EVENTS[] = {
+    {"success", uint8_t(Event::Success)},
+    {"failure", uint8_t(Event::Failure)},
+    {"tag", uint8_t(Event::TagEvent)},
+};
+
+constexpr Name CHANNELS[] = {
+    {"pixel", uint8_t(Channel::Pixel)},
+    {"successPin", uint8_t(Channel::SuccessGpio)},
+    {"failPin", uint8_t(Channel::FailGpio)},
+    {"tagPin", uint8_t(Channel::TagEventGpio)},
+};
+
+template <size_t N>
+bool lookup(const Name (&names)[N], std::string_view text, uint8_t &out) {
+  for (const auto &n : names) {
+    if (n.text == text) {
+      out = n.value;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool parseStep(std::string_view text, Step &step, std::string &error) {
+  std::string_view channel = take(text, ':');
+  std::string_view value = take(text, '/');
+  std::string_view duration = trim(text);
+  uint8_t c;
+  if (!lookup(CHANNELS, channel, c)) {
+    error = "unknown channel \"" + std::string(channel) + "\"";
+    return false;
+  }
+  step.channel = static_cast<Channel>(c);
+  if (!number<uint16_t>(duration, 1, UINT16_MAX, step.durationMs)) {
+    error = "invalid duration \"" + std::string(duration) + "\" (1-65535 ms)";
+    return false;
+  }
+  if (value == "on" || value == "off") {
+    step.on = value == "on";
+    if (step.on && step.channel == Channel::Pixel) {
+      error = "pixel needs a RRGGBB color or off";
+      return false;
+    }
+    return true;
+  }
+  if (step.channel != Channel::Pixel || value.size() != 6 || !hexByte(value.substr(0, 2), step.r) ||
+      !hexByte(value.substr(2, 2), step.g) || !hexByte(value.substr(4, 2), step.b)) {
+    error = "invalid value \"" + std::string(value) + "\"";
+    return false;
+  }
+  step.on = true;
+  return true;
+}
+
+bool parseEntry(std::string_view entry, Overrides &out, std::string &error) {
+  std::string_view head = take(entry, '=');
+  if (entry.empty()) {
+    error = "\"" + std::string(head) + "\" has no steps";
+    return false;
+  }
+  Pattern p;
+  std::string_view repeat = head;
+  std::string_view name = take(repeat, '*');
+  std::string_view priority = name;
+  name = take(priority, '!');
+  uint8_t e;
+  if (!lookup(EVENTS, name, e)) {
+    error = "unknown event \"" + std::string(name) + "\"";
+    return false;
+  }
+  p.priority = defaultPriority(static_cast<Event>(e));
+  if (!priority.empty() && !number<uint8_t>(priority, 0, 9, p.priority)) {
+    error = "invalid priority \"" + std::string(priority) + "\" (0-9)";
+    return false;
+  }
+  if (!repeat.empty() && !number<uint8_t>(repeat, 1, 50, p.repeat)) {
+    error = "invalid repeat \"" + std::string(repeat) + "\" (1-50)";
+    return false;
+  }
+  while (!entry.empty()) {
+    Step step;
+    if (!parseStep(take(entry, ','), step, error)) return false;
+    if (!p.add(step)) {
+      error = "more than " + std::to_string(Pattern::MAX_STEPS) + " steps";
+      return false;
+    }
+  }
+  out[e] = p;
+  return true;
+}
+
+} // namespace
+
+bool parse(std::string_view spec, Overrides &out, std::string *error) {
+  std::string reason;
+  while (!spec.empty()) {
+    std::string_view entry = take(spec, ';');
+    if (entry.empty()) continue;
+    if (!parseEntry(entry, out, reason)) {
+      if (error) *error = "Feedback pattern \"" + std::string(entry) + "\": " + reason;
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace feedback
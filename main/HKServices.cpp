@@ -2,10 +2,12 @@
 #include "config.hpp"
 #include "eventStructs.hpp"
 #include "HomeKitLock.hpp"
+#include "HomeSpanLoop.hpp"
 #include "LockManager.hpp"
 #include "ReaderDataManager.hpp"
 #include "esp_mac.h"
 #include "HK_HomeKit.h"
+#include "Tlv8View.hpp"
 
 
 const std::array<std::array<uint8_t, 6>, 4> hk_color_vals = { {{0x01,0x04,0xce,0xd5,0xda,0x00}, {0x01,0x04,0xaa,0xd6,0xec,0x00}, {0x01,0x04,0xe3,0xe3,0xe3,0x00}, {0x01,0x04,0x00,0x00,0x00,0x00}} };
@@ -98,7 +100,7 @@ HomeKitLock::LockManagementService::LockManagementService() {
  * @param bridge HomeKit bridge whose characteristic pointers will be set to the newly created characteristics.
  * @param lockManager Lock manager used to obtain the current and target lock state values and the HOMEKIT source identifier.
  */
-HomeKitLock::LockMechanismService::LockMechanismService(HomeKitLock& bridge, LockManager& lockManager) : m_lockManager(lockManager) {
+HomeKitLock::LockMechanismService::LockMechanismService(HomeKitLock& bridge, LockManager& lockManager) : m_bridge(bridge), m_lockManager(lockManager) {
     ESP_LOGI(HomeKitLock::TAG, "Configuring LockMechanism");
     m_lockCurrentState = bridge.m_lockCurrentState = new Characteristic::LockCurrentState(m_lockManager.getCurrentState(), true);
     m_lockTargetState = bridge.m_lockTargetState = new Characteristic::LockTargetState(m_lockManager.getTargetState(), true);
@@ -122,6 +124,12 @@ HomeKitLock::LockMechanismService::LockMechanismService(HomeKitLock& bridge, Loc
  */
 boolean HomeKitLock::LockMechanismService::update() {
     if (m_lockTargetState->updated()) {
+      HomeSpanLoop::instance().commandHandled();
+      {
+        // The controller's write is newer than a target state still waiting to be applied.
+        std::lock_guard lock(m_bridge.m_pendingMutex);
+        m_bridge.m_pending.targetState.reset();
+      }
       EventLockState s{
         .currentState = static_cast<uint8_t>(m_lockCurrentState->getNewVal()),
         .targetState = static_cast<uint8_t>(m_lockTargetState->getNewVal()),
@@ -156,34 +164,50 @@ HomeKitLock::NFCAccessService::NFCAccessService(ReaderDataManager& readerDataMan
  *
  * If no new control TLV is present or the control data is empty, no change is applied and the function returns.
  *
+ * The request is decoded straight from the characteristic into a buffer kept between requests, and the
+ * response is checked with a Tlv8View and stored as-is, so neither is unpacked into TLV8 items. HK_HomeKit
+ * works on m_workingData, which is refreshed from a reader data snapshot only when the data changed since
+ * it was last saved or loaded. Copy-assignment reuses the vectors' capacity, so provisioning a burst of
+ * devices does not reallocate every enrolled endpoint for each request.
+ *
  * @return `true` if the update cycle completed, `false` otherwise.
  */
 boolean HomeKitLock::NFCAccessService::update() {
     if (!m_nfcControlPoint->updated()) return true;
-    TLV8 ctrlData(nullptr, 0);
-    m_nfcControlPoint->getNewTLV(ctrlData);
-    std::vector<uint8_t> tlvData(ctrlData.pack_size());
-    ctrlData.pack(tlvData.data());
-    if (tlvData.empty()) return true;
+    const size_t requestSize = m_nfcControlPoint->getNewData(nullptr, 0);
+    if (requestSize == 0) return true;
+    m_request.resize(requestSize);
+    m_nfcControlPoint->getNewData(m_request.data(), m_request.size());
 
-    auto saveCallback = [this](const readerData_t& data) { return m_readerDataManager.updateReaderData(data); };
-    auto remove_key_cb = [this]() { return m_readerDataManager.eraseReaderKey(); };
-    readerData_t readerDataCopy = m_readerDataManager.getReaderDataCopy();
+    if (const uint32_t generation = m_readerDataManager.generation(); m_workingGeneration != generation) {
+        m_workingData = *m_readerDataManager.snapshot();
+        m_workingGeneration = generation;
+    }
+    // m_workingData matches the stored data again only if the request ended with a save of it.
+    bool inSync = false;
+    auto saveCallback = [this, &inSync](const readerData_t& data) {
+        uint32_t generation;
+        const readerData_t* stored = m_readerDataManager.updateReaderData(data, &generation);
+        inSync = stored != nullptr;
+        m_workingGeneration = generation;
+        return stored;
+    };
+    auto remove_key_cb = [this, &inSync]() {
+        inSync = false;
+        return m_readerDataManager.eraseReaderKey();
+    };
 
-    HK_HomeKit hkCtx(readerDataCopy, saveCallback, remove_key_cb, tlvData);
-    std::vector<uint8_t> result = hkCtx.processResult();
+    HK_HomeKit hkCtx(m_workingData, saveCallback, remove_key_cb, m_request);
+    const std::vector<uint8_t> result = hkCtx.processResult();
+    if (!inSync) m_workingGeneration.reset();
 
-    TLV8 res(NULL, 0);
-    if (!result.empty()) {
-        res.unpack(result.data(), result.size());
-        if(auto it = res.find(kReader_Reader_Key_Response); res.len(it) == 3){
-            HomekitEvent event{.type=ACCESSDATA_CHANGED, .data={}};
-            std::vector<uint8_t> event_data;
-            alpaca::serialize(event, event_data);
-            AppEventLoop::publish(HK_EVENT, HK_INTERNAL_EVENT, event_data.data(), event_data.size());
-        }
+    if (Tlv8View(result).length(kReader_Reader_Key_Response) == 3) {
+        HomekitEvent event{.type=ACCESSDATA_CHANGED, .data={}};
+        std::vector<uint8_t> event_data;
+        alpaca::serialize(event, event_data);
+        AppEventLoop::publish(HK_EVENT, HK_INTERNAL_EVENT, event_data.data(), event_data.size());
     }
-    m_nfcControlPoint->setTLV(res, false);
+    m_nfcControlPoint->setData(result.data(), result.size(), false);
     return true;
 }
 
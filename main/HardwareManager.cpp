@@ -1,5 +1,6 @@
 #include "HardwareManager.hpp"
 #include "LockManager.hpp"
+#include "MetricsRegistry.hpp"
 #include "Pixel.h"
 #include "config.hpp"
 #include "driver/gpio.h"
@@ -8,11 +9,30 @@
 #include "hal/gpio_types.h"
 #include "soc/gpio_num.h"
 #include "magic_enum.hpp"
+#include <algorithm>
 
 const char* HardwareManager::TAG = "HardwareManager";
 
 const std::array<const char*, 6> pixelTypeMap = { "RGB", "RBG", "BRG", "BGR", "GBR", "GRB" };
 
+// How late scheduled feedback steps are switched, in microseconds.
+static constexpr uint32_t TIMER_LATENESS_BUCKETS_US[] = { 50, 100, 250, 500, 1000, 2500, 5000, 10000 };
+// Time from an authorized HomeKey tap to the lock output being driven, in microseconds.
+static constexpr uint32_t LOCK_ACTUATION_BUCKETS_US[] = { 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000 };
+
+/**
+ * @brief Register the feedback series in the metrics registry.
+ */
+HardwareManager::Metrics HardwareManager::registerMetrics() {
+  auto& r = MetricsRegistry::instance();
+  return Metrics{
+      .timerLateness = r.histogram("hk_feedback_timer_lateness_us", "Delay between a feedback step's deadline and its execution", TIMER_LATENESS_BUCKETS_US),
+      .patternsStarted = r.counter("hk_feedback_patterns_total", "Feedback patterns requested by result", "result=\"started\""),
+      .patternsRejected = r.counter("hk_feedback_patterns_total", "Feedback patterns requested by result", "result=\"rejected\""),
+      .lockActuationDirect = r.histogram("hk_lock_actuation_us", "Time from an authorized HomeKey tap to the lock output being driven", LOCK_ACTUATION_BUCKETS_US, "path=\"direct\""),
+      .lockActuationEvent = r.histogram("hk_lock_actuation_us", "Time from an authorized HomeKey tap to the lock output being driven", LOCK_ACTUATION_BUCKETS_US, "path=\"event\""),
+  };
+}
 
 /**
  * @brief Initialize HardwareManager state and register event topics and subscribers.
@@ -29,11 +49,9 @@ const std::array<const char*, 6> pixelTypeMap = { "RGB", "RBG", "BRG", "BGR", "G
  */
 HardwareManager::HardwareManager(const espConfig::actions_config_t& miscConfig)
     : m_miscConfig(miscConfig),
-      m_feedbackTaskHandle(nullptr),
-      m_feedbackQueue(nullptr),
-      m_lockControlTaskHandle(nullptr),
-      m_lockControlQueue(nullptr)
+      m_metrics(registerMetrics())
 {
+  m_initiatorJob = Executor::instance().add("job=\"alt_action_init\"", [this] { armAltAction(); });
   pinAllocations.emplace(PinFunctions::ACTION,
       GPIOAllocator::instance().acquire(gpio_num_t(miscConfig.gpioActionPin), GPIO_MODE_OUTPUT, "ACTION_PIN"));
   pinAllocations.emplace(PinFunctions::SUCCESS,
@@ -76,6 +94,10 @@ HardwareManager::HardwareManager(const espConfig::actions_config_t& miscConfig)
 
     ESP_LOGD(TAG, "Received hardware config event: %s -> %d (old=%d)", s.name.c_str(), s.newValue, s.oldValue);
 
+    if (s.name == "feedbackPatterns") {
+      loadFeedbackPatterns(s.str);
+      return;
+    }
     if (s.newValue == s.oldValue) return;
 
     struct PinMeta {
@@ -109,6 +131,8 @@ HardwareManager::HardwareManager(const espConfig::actions_config_t& miscConfig)
       return;
     }
 
+    // The scheduler drives the indicator pins from the esp_timer task.
+    std::lock_guard lock(m_mutex);
     auto& alloc_entry = pinAllocations.at(meta->func);
     gpio_mode_t mode = meta->default_mode;
     bool level = false;
@@ -161,9 +185,9 @@ HardwareManager::HardwareManager(const espConfig::actions_config_t& miscConfig)
  * @brief Initialize hardware resources and runtime infrastructure based on misc configuration.
  *
  * Configures GPIO pins and initial output states for NFC indicators, action and alternate-action pins;
- * creates and configures the NeoPixel controller if present; installs the alternate-action ISR and
- * creates its initiator queue/task when configured; creates ESP timers for GPIO/pixel/alt-action sources;
- * and creates the feedback and lock-control queues and their associated tasks.
+ * creates and configures the NeoPixel controller if present; installs the alternate-action initiator
+ * ISR when configured; and creates the single timer that drives every
+ * feedback pattern and alt-action timeout.
  *
  * This prepares the HardwareManager to receive events and perform timed feedback and lock control.
  */
@@ -189,10 +213,7 @@ void HardwareManager::begin() {
       case TAG_TAP: {
         EventTagTap s = alpaca::deserialize<EventTagTap>(nfc_event.data, ec);
         if(!ec){
-          if (m_feedbackQueue != nullptr) {
-              FeedbackType feedback = FeedbackType::TAG_EVENT;
-              xQueueSend(m_feedbackQueue, &feedback, 0);
-          }
+          startPattern(feedback::Event::TagEvent);
         } else {
           ESP_LOGE(TAG, "Failed to deserialize Tag event: %s", ec.message().c_str());
           return;
@@ -217,8 +238,6 @@ void HardwareManager::begin() {
     }
     if(pinAllocations.at(ALT_ACTION_INIT).has_value()){
       pinAllocations.at(ALT_ACTION_INIT).value().set_pullup(true);
-      m_initiatorQueue = xQueueCreate(1, sizeof(uint8_t));
-      xTaskCreateUniversal(initiator_task_entry, "initiator_task", 3580, this, 3, &m_initiatorTaskHandle, 1);
       if(esp_err_t err = gpio_install_isr_service(0); err == ESP_OK || err == ESP_ERR_INVALID_STATE){
         isr_service_installed = true;
       }
@@ -238,392 +257,363 @@ void HardwareManager::begin() {
         ESP_LOGI(TAG, "NeoPixel initialized on pin %d with type %s.", m_miscConfig.nfcNeopixelPin, pixelTypeMap[pixelTypeIndex]);
     }
 
-    // Initialize timer contexts as member variables (not static locals)
-    m_gpioS_context = {this, TimerSources::GPIO_S};
-    m_gpioF_context = {this, TimerSources::GPIO_F};
-    m_tagEvent_context = {this, TimerSources::TAG_EVENT};
-    m_pixelS_context = {this, TimerSources::PIXEL_S};
-    m_pixelF_context = {this, TimerSources::PIXEL_F};
-    m_pixelTagEvent_context = {this, TimerSources::PIXEL_TAG_EVENT};
-    m_altAction_context = {this, TimerSources::ALT_GPIO};
-    m_altActionInit_context = {this, TimerSources::ALT_GPIO_INIT};
-
-    const esp_timer_create_args_t gpioS_timer_args = {
-            .callback = &handleTimer,
-            .arg = (void*) &m_gpioS_context,
+    const esp_timer_create_args_t timer_args = {
+            .callback = &timerCallback,
+            .arg = this,
             .dispatch_method = ESP_TIMER_TASK,
-            .name = "gpioSuccessTimer",
+            .name = "hwFeedback",
             .skip_unhandled_events = false
     };
+    if (esp_err_t err = esp_timer_create(&timer_args, &m_timer); err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create feedback timer: %s", esp_err_to_name(err));
+        m_timer = nullptr;
+    }
 
-    const esp_timer_create_args_t gpioF_timer_args = {
-            .callback = &handleTimer,
-            .arg = (void*) &m_gpioF_context,
-            .dispatch_method = ESP_TIMER_TASK,
-            .name = "gpioFailTimer",
-            .skip_unhandled_events = false
-    };
+    loadFeedbackPatterns(m_miscConfig.feedbackPatterns);
+    ESP_LOGI(TAG, "Hardware initialization complete.");
+}
 
-    const esp_timer_create_args_t tagEvent_timer_args = {
-            .callback = &handleTimer,
-            .arg = (void*) &m_tagEvent_context,
-            .dispatch_method = ESP_TIMER_TASK,
-            .name = "tagEventTimer",
-            .skip_unhandled_events = false
-    };
+/**
+ * @brief Write the action pin level for @p state.
+ *
+ * Called from the event loop and, for the direct NFC path, from the NFC task; the pin
+ * lease is guarded by m_mutex because a configuration change can replace it.
+ *
+ * @return false if no action pin is configured or held.
+ */
+bool HardwareManager::writeLockOutput(int state) {
+    if (m_miscConfig.gpioActionPin == 255) {
+        ESP_LOGI(TAG, "Received lock command but no action pin is configured.");
+        return false;
+    }
 
-    const esp_timer_create_args_t pixelS_timer_args = {
-            .callback = &handleTimer,
-            .arg = (void*) &m_pixelS_context,
-            .dispatch_method = ESP_TIMER_TASK,
-            .name = "pixelSuccessTimer",
-            .skip_unhandled_events = false
-    };
+    std::lock_guard lock(m_mutex);
+    auto &action = pinAllocations.at(ACTION);
+    if(action.has_value()){
+      gpio_hold_dis(action->get_pin());
+    } else {
+      ESP_LOGW(TAG, "GPIOLease not held for action pin; skipping lock output");
+      return false;
+    }
+    if (state == LockManager::LOCKED) {
+        action->set_level(m_miscConfig.gpioActionLockState);
+    } else if (state == LockManager::UNLOCKED) {
+        action->set_level(m_miscConfig.gpioActionUnlockState);
+    }
+    gpio_hold_en(action->get_pin());
+    return true;
+}
 
-    const esp_timer_create_args_t pixelF_timer_args = {
-            .callback = &handleTimer,
-            .arg = (void*) &m_pixelF_context,
-            .dispatch_method = ESP_TIMER_TASK,
-            .name = "pixelFailTimer",
-            .skip_unhandled_events = false
+/**
+ * @brief Drive the lock output pin for a desired lock state and report the result.
+ *
+ * Sets the action pin to the configured lock or unlock level and publishes an EventLockState whose
+ * `currentState` equals @p state, `targetState` is `UNKNOWN`, and `source` is `INTERNAL` to the lock
+ * update topic. If no action pin is configured (pin value 255), the command is ignored.
+ *
+ * @param state Desired lock state (for example `LOCKED` or `UNLOCKED`).
+ */
+void HardwareManager::setLockOutput(int state) {
+    if (!writeLockOutput(state)) return;
+    const int64_t expectedAt = m_lockOutputExpectedAt.exchange(0);
+    if (expectedAt != 0) {
+        m_metrics.lockActuationEvent.observe(static_cast<uint32_t>(esp_timer_get_time() - expectedAt));
+    }
+    ESP_LOGI(TAG, "Set lock output for state: %d", state);
+    EventLockState s{
+      .currentState = static_cast<uint8_t>(state),
+      .targetState = LockManager::UNKNOWN,
+      .source = LockManager::INTERNAL
     };
+    std::vector<uint8_t> d;
+    alpaca::serialize(s, d);
+    AppEventLoop::publish(LOCK_EVENT, LOCK_UPDATE_STATE, d.data(), d.size());
+}
 
-    const esp_timer_create_args_t pixelTagEvent_timer_args = {
-            .callback = &handleTimer,
-            .arg = (void*) &m_pixelTagEvent_context,
-            .dispatch_method = ESP_TIMER_TASK,
-            .name = "pixelTagEventTimer",
-            .skip_unhandled_events = false
-    };
+/**
+ * @brief Drive the lock output for an authorized tap without waiting for the event loop.
+ *
+ * Logging is left until after the pin is written, since the UART is slower than the pin.
+ */
+void HardwareManager::driveLockOutputDirect(int state, int64_t authorizedAt) {
+    if (!writeLockOutput(state)) return;
+    m_metrics.lockActuationDirect.observe(static_cast<uint32_t>(esp_timer_get_time() - authorizedAt));
+    ESP_LOGI(TAG, "Set lock output for state: %d (direct)", state);
+}
 
-    const esp_timer_create_args_t altAction_timer_args = {
-            .callback = &handleTimer,
-            .arg = (void*) &m_altAction_context,
-            .dispatch_method = ESP_TIMER_TASK,
-            .name = "altActionTimer",
-            .skip_unhandled_events = false
-    };
+void HardwareManager::expectLockOutput(int64_t authorizedAt) {
+    m_lockOutputExpectedAt = authorizedAt;
+}
 
-    const esp_timer_create_args_t altActionInit_timer_args = {
-            .callback = &handleTimer,
-            .arg = (void*) &m_altActionInit_context,
-            .dispatch_method = ESP_TIMER_TASK,
-            .name = "altActionInitTimer",
-            .skip_unhandled_events = false
-    };
+/**
+ * @brief Play the success feedback pattern.
+ */
+void HardwareManager::showSuccessFeedback() {
+    startPattern(feedback::Event::Success);
+}
 
-    auto create_timer = [](const esp_timer_create_args_t& args, esp_timer_handle_t& handle, const char* name) {
-        esp_err_t err = esp_timer_create(&args, &handle);
-        if (err != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to create %s: %s", name, esp_err_to_name(err));
-            handle = nullptr;
-        }
-    };
+/**
+ * @brief Play the failure feedback pattern.
+ */
+void HardwareManager::showFailureFeedback() {
+    startPattern(feedback::Event::Failure);
+}
 
-    create_timer(gpioS_timer_args, m_gpioSuccessTimer, "gpioSuccessTimer");
-    create_timer(gpioF_timer_args, m_gpioFailTimer, "gpioFailTimer");
-    create_timer(tagEvent_timer_args, m_tagEventTimer, "tagEventTimer");
-    create_timer(pixelS_timer_args, m_pixelSuccessTimer, "pixelSuccessTimer");
-    create_timer(pixelF_timer_args, m_pixelFailTimer, "pixelFailTimer");
-    create_timer(pixelTagEvent_timer_args, m_pixelTagEventTimer, "pixelTagEventTimer");
-    create_timer(altAction_timer_args, m_altActionTimer, "altActionTimer");
-    create_timer(altActionInit_timer_args, m_altActionInitTimer, "altActionInitTimer");
+// ============================================================================
+// Feedback patterns
+// ============================================================================
 
-    m_feedbackQueue = xQueueCreate(5, sizeof(FeedbackType));
-    xTaskCreateUniversal(feedbackTaskEntry, "feedback_task", 3580, this, 3, &m_feedbackTaskHandle, 1);
+/**
+ * @brief Parse a `feedbackPatterns` setting into the overrides used by patternFor().
+ *
+ * Called from begin() and when the setting is saved. A specification that does not
+ * parse leaves every event on its built-in pattern.
+ */
+void HardwareManager::loadFeedbackPatterns(const std::string& spec) {
+    feedback::Overrides overrides;
+    std::string error;
+    if (!feedback::parse(spec, overrides, &error)) {
+        ESP_LOGW(TAG, "%s; using the built-in patterns", error.c_str());
+        overrides = {};
+    }
+    std::lock_guard lock(m_mutex);
+    m_overrides = overrides;
+}
 
-    m_lockControlQueue = xQueueCreate(5, sizeof(int));
-    xTaskCreateUniversal(lockControlTaskEntry, "lock_control_task", 3072, this, 3, &m_lockControlTaskHandle, 1);
-    ESP_LOGI(TAG, "Hardware initialization complete.");
+/**
+ * @brief The custom pattern for @p event from `feedbackPatterns`, or the built-in one. Caller holds m_mutex.
+ */
+feedback::Pattern HardwareManager::patternFor(feedback::Event event) const {
+    if (const auto& custom = m_overrides[static_cast<size_t>(event)]) return *custom;
+    return feedback::builtin(event, m_miscConfig);
 }
 
 /**
- * @brief Enqueue a desired lock state for the lock-control task to apply.
+ * @brief Start the pattern for @p event, taking over the channels it uses.
  *
- * @param state Desired lock state (for example `LOCKED` or `UNLOCKED`) to be processed and applied by the manager.
+ * A channel that is still playing a pattern of higher priority is not taken over; the
+ * new pattern is then dropped altogether so that it never plays half of its channels.
+ * Starting an event that is already playing restarts it.
  */
+void HardwareManager::startPattern(feedback::Event event) {
+    using namespace feedback;
+    const int8_t e = static_cast<int8_t>(event);
+
+    std::lock_guard lock(m_mutex);
+    const Pattern pattern = patternFor(event);
+    for (size_t c = 0; c < CHANNEL_COUNT; c++) {
+        const Track& track = m_tracks[c];
+        if (track.event < 0 || track.event == e || !pattern.uses(Channel(c))) continue;
+        if (m_running[track.event].priority > pattern.priority) {
+            ESP_LOGD(TAG, "Feedback %d suppressed by higher priority feedback %d", e, track.event);
+            m_metrics.patternsRejected.inc();
+            return;
+        }
+    }
+    for (size_t c = 0; c < CHANNEL_COUNT; c++) {
+        if (m_tracks[c].event == e) idleChannel(Channel(c));
+    }
 
-void HardwareManager::setLockOutput(int state) {
-    if (m_lockControlQueue != nullptr) {
-        xQueueSend(m_lockControlQueue, &state, pdMS_TO_TICKS(100));
+    ESP_LOGD(TAG, "Starting feedback %d (%u steps, x%u)", e, pattern.count, pattern.repeat);
+    m_running[e] = pattern;
+    const int64_t now = esp_timer_get_time();
+    for (size_t c = 0; c < CHANNEL_COUNT; c++) {
+        const Channel channel = Channel(c);
+        if (!pattern.uses(channel) || !channelAvailable(channel)) continue;
+        m_tracks[c] = {e, pattern.next(channel, 0), 0};
+        applyStep(channel, now);
+    }
+    m_metrics.patternsStarted.inc();
+    rearm(now);
+}
+
+bool HardwareManager::channelAvailable(feedback::Channel channel) {
+    switch (channel) {
+        case feedback::Channel::Pixel: return m_pixel != nullptr;
+        case feedback::Channel::SuccessGpio: return pinAllocations.at(SUCCESS).has_value();
+        case feedback::Channel::FailGpio: return pinAllocations.at(FAIL).has_value();
+        case feedback::Channel::TagEventGpio: return pinAllocations.at(TAG_EVENT).has_value();
+        default: return false;
     }
 }
 
 /**
- * @brief Enqueue a success feedback event for the feedback task to process.
- *
- * If the internal feedback queue is not initialized, the call has no effect.
+ * @brief Drive a channel to @p step, or to idle when @p step is null or off.
  */
-void HardwareManager::showSuccessFeedback() {
-    if (m_feedbackQueue != nullptr) {
-        FeedbackType feedback = FeedbackType::SUCCESS;
-        xQueueSend(m_feedbackQueue, &feedback, 0);
+void HardwareManager::setChannel(feedback::Channel channel, const feedback::Step* step) {
+    const bool on = step && step->on;
+    auto drive = [&](PinFunctions pin, bool activeLevel) {
+        auto& lease = pinAllocations.at(pin);
+        if (lease.has_value()) lease->set_level(on ? activeLevel : !activeLevel);
+    };
+    switch (channel) {
+        case feedback::Channel::Pixel:
+            if (m_pixel == nullptr) break;
+            if (on) m_pixel->set(m_pixel->RGB(step->r, step->g, step->b));
+            else m_pixel->off();
+            break;
+        case feedback::Channel::SuccessGpio: drive(SUCCESS, m_miscConfig.nfcSuccessHL); break;
+        case feedback::Channel::FailGpio: drive(FAIL, m_miscConfig.nfcFailHL); break;
+        case feedback::Channel::TagEventGpio: drive(TAG_EVENT, m_miscConfig.tagEventHL); break;
+        default: break;
     }
 }
 
+void HardwareManager::idleChannel(feedback::Channel channel) {
+    const size_t c = static_cast<size_t>(channel);
+    setChannel(channel, nullptr);
+    m_tracks[c] = {};
+    m_deadlines[c] = 0;
+}
+
 /**
- * @brief Enqueues a failure feedback event for the feedback task.
- *
- * If the internal feedback queue has been created, posts a FAILURE event so the
- * feedback task will run the configured failure sequence (GPIOs/NeoPixel).
+ * @brief Output the channel's current step and schedule its end @p durationMs after @p start.
  */
-void HardwareManager::showFailureFeedback() {
-    if (m_feedbackQueue != nullptr) {
-        FeedbackType feedback = FeedbackType::FAILURE;
-        xQueueSend(m_feedbackQueue, &feedback, 0);
-    }
+void HardwareManager::applyStep(feedback::Channel channel, int64_t start) {
+    const Track& track = m_tracks[static_cast<size_t>(channel)];
+    const feedback::Step& step = m_running[track.event].steps[track.step];
+    setChannel(channel, &step);
+    schedule(static_cast<Slot>(channel), step.durationMs, start);
 }
 
 /**
- * @brief Timer callback that handles configured hardware timeouts and applies the associated output changes.
- *
- * Processes the provided TimerContext and, based on its TimerSources value, performs one of:
- * - toggle the NFC success or failure GPIO,
- * - turn off the NeoPixel,
- * - toggle the alternate-action GPIO,
- * - clear the alt-action armed flag and turn off the alt-action init LED.
- *
- * @param arg Pointer to a TimerContext whose `hw_manager` and `timer_source` fields determine the target HardwareManager and the action to execute.
+ * @brief Move a channel on to its next step, its next repetition, or back to idle.
  */
+void HardwareManager::advance(feedback::Channel channel, int64_t start) {
+    Track& track = m_tracks[static_cast<size_t>(channel)];
+    const feedback::Pattern& pattern = m_running[track.event];
+    uint8_t next = pattern.next(channel, track.step + 1);
+    if (next == pattern.count) {
+        if (++track.pass >= pattern.repeat) {
+            idleChannel(channel);
+            return;
+        }
+        next = pattern.next(channel, 0);
+    }
+    track.step = next;
+    applyStep(channel, start);
+}
 
-void HardwareManager::handleTimer(void* arg){
-  TimerContext* context = static_cast<TimerContext*>(arg);
-  HardwareManager *i = context->hw_manager;
-  TimerSources t = context->timer_source;
+// ============================================================================
+// Deadline scheduler
+// ============================================================================
 
-  switch (t) {
-    case TimerSources::GPIO_S:
-      if(i->pinAllocations.at(SUCCESS).has_value()) i->pinAllocations.at(SUCCESS).value().set_level(!i->m_miscConfig.nfcSuccessHL);
-      ESP_LOGD(TAG, "GPIO_S");
-      break;
-    case TimerSources::GPIO_F:
-      if(i->pinAllocations.at(FAIL).has_value()) i->pinAllocations.at(FAIL).value().set_level(!i->m_miscConfig.nfcFailHL);
-      ESP_LOGD(TAG, "GPIO_F");
-      break;
-    case TimerSources::TAG_EVENT:
-      if(i->pinAllocations.at(TAG_EVENT).has_value()) i->pinAllocations.at(TAG_EVENT).value().set_level(!i->m_miscConfig.tagEventHL);
-      ESP_LOGD(TAG, "TAG_EVENT");
-      break;
-    case TimerSources::PIXEL_S:
-    case TimerSources::PIXEL_F:
-    case TimerSources::PIXEL_TAG_EVENT:
-      i->m_pixel->off();
-      ESP_LOGD(TAG, "PIXEL");
-      break;
-    case TimerSources::ALT_GPIO:
-      if(i->pinAllocations.at(ALT_ACTION).has_value()) i->pinAllocations.at(ALT_ACTION).value().set_level(!i->m_miscConfig.hkAltActionGpioState);
-      ESP_LOGD(TAG, "ALT_GPIO");
-      break;
-    case TimerSources::ALT_GPIO_INIT:
-      i->m_altActionArmed = false;
-      if(i->pinAllocations.at(ALT_ACTION_LED).has_value()) i->pinAllocations.at(ALT_ACTION_LED).value().set_level(0);
-      ESP_LOGD(TAG, "ALT_GPIO_INIT");
-      break;
-  }
+void HardwareManager::schedule(Slot slot, uint32_t ms, int64_t start) {
+    m_deadlines[static_cast<size_t>(slot)] = start + int64_t(ms) * 1000;
 }
 
 /**
- * @brief Task entry that dispatches to a HardwareManager instance's initiator task.
- *
- * Casts the provided void pointer to a HardwareManager pointer and invokes its initiator_task().
- *
- * @param arg Pointer to the HardwareManager instance.
+ * @brief Point the timer at the earliest pending deadline, or stop it if there is none.
  */
-void HardwareManager::initiator_task_entry(void* arg) {
-    static_cast<HardwareManager*>(arg)->initiator_task();
+void HardwareManager::rearm(int64_t now) {
+    if (!m_timer) return;
+    int64_t next = 0;
+    for (int64_t deadline : m_deadlines) {
+        if (deadline != 0 && (next == 0 || deadline < next)) next = deadline;
+    }
+    esp_timer_stop(m_timer);
+    if (next != 0) esp_timer_start_once(m_timer, std::max<int64_t>(next - now, 1));
+}
+
+void HardwareManager::timerCallback(void* instance) {
+    static_cast<HardwareManager*>(instance)->onTimer();
 }
 
 /**
- * @brief ISR posted by the initiator GPIO; signals the initiator task by enqueuing a wake byte.
- *
- * Posts a single dummy byte to the HardwareManager's initiator queue from ISR context to wake
- * the initiator task without blocking.
+ * @brief Run every slot whose deadline has passed, then re-arm for the next one.
  *
- * @param arg Pointer to the HardwareManager instance whose initiator queue will be signaled.
+ * Each step is timed from the previous step's deadline rather than from when the
+ * callback actually ran, so lateness does not accumulate over a long pattern.
  */
-void IRAM_ATTR HardwareManager::initiator_isr_handler(void* arg) {
-    uint8_t dummy = 0;
-    xQueueSendFromISR(static_cast<HardwareManager*>(arg)->m_initiatorQueue, &dummy, NULL);
+void HardwareManager::onTimer() {
+    std::lock_guard lock(m_mutex);
+    const int64_t now = esp_timer_get_time();
+    for (size_t i = 0; i < SLOT_COUNT; i++) {
+        const int64_t deadline = m_deadlines[i];
+        if (deadline == 0 || deadline > now) continue;
+        m_metrics.timerLateness.observe(static_cast<uint32_t>(now - deadline));
+        m_deadlines[i] = 0;
+        expire(static_cast<Slot>(i), deadline);
+    }
+    rearm(now);
 }
 
 /**
- * @brief Waits for initiator events and arms the alternate action window.
- *
- * This task blocks waiting for a byte posted to the initiator queue (typically from an ISR).
- * When an event is received and the alternate action is not already armed, it marks the
- * alternate action as armed, turns on the configured alt-action-init LED (if a valid pin is set),
- * and starts a one-shot timer that will disarm the initiation window after the configured timeout.
- *
- * Side effects:
- * - Sets `m_altActionArmed` to true.
- * - Writes HIGH to `m_miscConfig.hkAltActionInitLedPin` when that pin is not 255.
- * - Starts `m_altActionInitTimer` for `m_miscConfig.hkAltActionInitTimeout` milliseconds.
+ * @brief Handle a slot whose deadline, @p deadline, has passed.
  */
-void HardwareManager::initiator_task() {
-    uint8_t dummy;
-    while (true) {
-        if (xQueueReceive(m_initiatorQueue, &dummy, portMAX_DELAY)) {
-            if (!m_altActionArmed) {
-                ESP_LOGI(TAG, "Alt action armed for %dms", m_miscConfig.hkAltActionInitTimeout);
-                m_altActionArmed = true;
-                if(pinAllocations.at(ALT_ACTION_LED).has_value()) pinAllocations.at(ALT_ACTION_LED).value().set_level(1);
-
-                if (m_altActionInitTimer) esp_timer_start_once(m_altActionInitTimer, m_miscConfig.hkAltActionInitTimeout * 1000);
-            }
-        }
+void HardwareManager::expire(Slot slot, int64_t deadline) {
+    switch (slot) {
+        case Slot::PIXEL:
+        case Slot::SUCCESS_GPIO:
+        case Slot::FAIL_GPIO:
+        case Slot::TAG_EVENT_GPIO:
+            advance(static_cast<feedback::Channel>(slot), deadline);
+            break;
+        case Slot::ALT_GPIO:
+            if(pinAllocations.at(ALT_ACTION).has_value()) pinAllocations.at(ALT_ACTION)->set_level(!m_miscConfig.hkAltActionGpioState);
+            ESP_LOGD(TAG, "ALT_GPIO");
+            break;
+        case Slot::ALT_GPIO_INIT:
+            m_altActionArmed = false;
+            if(pinAllocations.at(ALT_ACTION_LED).has_value()) pinAllocations.at(ALT_ACTION_LED)->set_level(0);
+            ESP_LOGD(TAG, "ALT_GPIO_INIT");
+            break;
+        default:
+            break;
     }
 }
 
+// ============================================================================
+// Alternate action
+// ============================================================================
+
 /**
- * @brief Task entry wrapper that forwards to the HardwareManager instance's lockControlTask.
+ * @brief ISR attached to the initiator GPIO; hands the press to the executor.
  *
- * @param instance Pointer to a HardwareManager instance (must not be null).
+ * @param arg Pointer to the HardwareManager instance whose initiator job is posted.
  */
-void HardwareManager::lockControlTaskEntry(void* instance) {
-    static_cast<HardwareManager*>(instance)->lockControlTask();
+void IRAM_ATTR HardwareManager::initiator_isr_handler(void* arg) {
+    Executor::instance().postFromISR(static_cast<HardwareManager*>(arg)->m_initiatorJob);
 }
 
 /**
- * @brief Processes lock commands from the internal lock-control queue, drives the configured GPIO, and publishes the resulting lock state.
+ * @brief Arms the alternate action window after an initiator press.
  *
- * Waits for a lock state value from the internal queue; if a GPIO action pin is configured the function sets that pin to the configured lock or unlock level and publishes an EventLockState whose `currentState` equals the received state, `targetState` is `UNKNOWN`, and `source` is `INTERNAL` to the lock update topic. If no action pin is configured (pin value 255), the command is ignored.
+ * Runs on the executor. If the alternate action is not already armed, it marks it as armed,
+ * turns on the configured alt-action-init LED (if a valid pin is set), and schedules the end
+ * of the initiation window after the configured timeout.
  */
-void HardwareManager::lockControlTask() {
-    int receivedState;
-    while (true) {
-        if (xQueueReceive(m_lockControlQueue, &receivedState, portMAX_DELAY)) {
-          if (m_miscConfig.gpioActionPin == 255) {
-              ESP_LOGI(TAG, "Received lock command but no action pin is configured.");
-              continue;
-          }
-          
-          ESP_LOGI(TAG, "Setting lock output for state: %d", receivedState);
-          auto &action = pinAllocations.at(ACTION);
-          if(action.has_value()){
-            gpio_hold_dis(action->get_pin());
-          } else {
-            ESP_LOGW(TAG, "GPIOLease not held for action pin; skipping lock output");
-            continue;
-          }
-          if (receivedState == LockManager::LOCKED) {
-              action->set_level(m_miscConfig.gpioActionLockState);
-          } else if (receivedState == LockManager::UNLOCKED) {
-              action->set_level(m_miscConfig.gpioActionUnlockState);
-          }
-          gpio_hold_en(action->get_pin());
-          EventLockState s{
-            .currentState = static_cast<uint8_t>(receivedState),
-            .targetState = LockManager::UNKNOWN,
-            .source = LockManager::INTERNAL
-          };
-          std::vector<uint8_t> d;
-          alpaca::serialize(s, d);
-          AppEventLoop::publish(LOCK_EVENT, LOCK_UPDATE_STATE, d.data(), d.size());
-        }
-    }
+void HardwareManager::armAltAction() {
+    std::lock_guard lock(m_mutex);
+    if (m_altActionArmed) return;
+    ESP_LOGI(TAG, "Alt action armed for %dms", m_miscConfig.hkAltActionInitTimeout);
+    m_altActionArmed = true;
+    if(pinAllocations.at(ALT_ACTION_LED).has_value()) pinAllocations.at(ALT_ACTION_LED).value().set_level(1);
+
+    const int64_t now = esp_timer_get_time();
+    schedule(Slot::ALT_GPIO_INIT, m_miscConfig.hkAltActionInitTimeout, now);
+    rearm(now);
 }
 
 /**
  * @brief Triggers the configured alternate (home-key) action when armed.
  *
  * If the manager is armed, publishes the "lock/altAction" event. When an alternate-action GPIO is configured (pin != 255),
- * writes the configured GPIO state to that pin and starts the alt-action timer for the configured timeout.
+ * writes the configured GPIO state to that pin and schedules its release after the configured timeout.
  *
- * @note The timer is started for @c hkAltActionTimeout milliseconds.
+ * @note The pin is released after @c hkAltActionTimeout milliseconds.
  */
 void HardwareManager::triggerAltAction() {
-  if (m_altActionArmed) { 
-      AppEventLoop::publish(HW_EVENT, HW_ALT_ACTION, nullptr, 0);
+  {
+      std::lock_guard lock(m_mutex);
+      if (!m_altActionArmed) return;
       if (pinAllocations.at(ALT_ACTION).has_value()) {
           ESP_LOGI(TAG, "Triggering alt action on pin %d for %dms", m_miscConfig.hkAltActionPin, m_miscConfig.hkAltActionTimeout);
           pinAllocations.at(ALT_ACTION)->set_level(m_miscConfig.hkAltActionGpioState);
-          if (m_altActionTimer) esp_timer_start_once(m_altActionTimer, m_miscConfig.hkAltActionTimeout * 1000);
+          const int64_t now = esp_timer_get_time();
+          schedule(Slot::ALT_GPIO, m_miscConfig.hkAltActionTimeout, now);
+          rearm(now);
       }
   }
-}
-
-/**
- * @brief Starts the feedback task for the provided HardwareManager instance.
- *
- * This is a FreeRTOS task entry function that casts the opaque `instance` pointer
- * to `HardwareManager*` and invokes its feedback task routine.
- *
- * @param instance Pointer to a HardwareManager object (must be a valid `HardwareManager*`).
- */
-void HardwareManager::feedbackTaskEntry(void* instance) {
-    static_cast<HardwareManager*>(instance)->feedbackTask();
-}
-
-/**
- * @brief Processes queued feedback events and actuates configured hardware indicators.
- *
- * This task runs indefinitely, blocking on the internal feedback queue. For each
- * FeedbackType received it executes the corresponding sequence:
- * - FeedbackType::SUCCESS: stops conflicting timers, sets the NeoPixel to the
- *   configured success color and starts the pixel success timer, and drives
- *   the configured NFC success GPIO for the configured duration.
- * - FeedbackType::FAILURE: stops conflicting timers, sets the NeoPixel to the
- *   configured failure color and starts the pixel failure timer, and drives
- *   the configured NFC failure GPIO for the configured duration.
- *
- * GPIO pins configured with the sentinel value 255 are ignored. Timers and
- * NeoPixel behavior use durations and colors from the instance's misc configuration.
- */
-void HardwareManager::feedbackTask() {
-    FeedbackType feedback;
-    while (true) {
-        if (xQueueReceive(m_feedbackQueue, &feedback, portMAX_DELAY)) {
-            switch (feedback) {
-                case FeedbackType::SUCCESS:
-                    ESP_LOGD(TAG, "Executing SUCCESS feedback sequence.");
-                    if(m_gpioSuccessTimer && esp_timer_is_active(m_gpioSuccessTimer)) esp_timer_stop(m_gpioSuccessTimer);
-                    if(m_pixelSuccessTimer && esp_timer_is_active(m_pixelSuccessTimer)) esp_timer_stop(m_pixelSuccessTimer);
-                    if (m_pixel != nullptr) {
-                        auto color = m_miscConfig.neopixelSuccessColor;
-                        m_pixel->set(m_pixel->RGB(color[espConfig::actions_config_t::colorMap::R], color[espConfig::actions_config_t::colorMap::G], color[espConfig::actions_config_t::colorMap::B]));
-
-                        if (m_pixelSuccessTimer) esp_timer_start_once(m_pixelSuccessTimer, m_miscConfig.neopixelSuccessTime * 1000);
-                    }
-                    if (pinAllocations.at(SUCCESS).has_value()) {
-                        pinAllocations.at(SUCCESS)->set_level(m_miscConfig.nfcSuccessHL);
-
-                        if (m_gpioSuccessTimer) esp_timer_start_once(m_gpioSuccessTimer, m_miscConfig.nfcSuccessTime * 1000);
-                    }
-                    break;
-
-                case FeedbackType::FAILURE:
-                    ESP_LOGD(TAG, "Executing FAILURE feedback sequence.");
-                    if(m_gpioFailTimer && esp_timer_is_active(m_gpioFailTimer)) esp_timer_stop(m_gpioFailTimer);
-                    if(m_pixelFailTimer && esp_timer_is_active(m_pixelFailTimer)) esp_timer_stop(m_pixelFailTimer);
-                    if (m_pixel != nullptr) {
-                        auto color = m_miscConfig.neopixelFailureColor;
-                        m_pixel->set(m_pixel->RGB(color[espConfig::actions_config_t::colorMap::R], color[espConfig::actions_config_t::colorMap::G], color[espConfig::actions_config_t::colorMap::B]));
-
-                        if (m_pixelFailTimer) esp_timer_start_once(m_pixelFailTimer, m_miscConfig.neopixelFailTime * 1000);
-                    }
-                    if (pinAllocations.at(FAIL).has_value()) {
-                        pinAllocations.at(FAIL)->set_level(m_miscConfig.nfcFailHL);
-
-                        if (m_gpioFailTimer) esp_timer_start_once(m_gpioFailTimer, m_miscConfig.nfcFailTime * 1000);
-                    }
-                    break;
-                case FeedbackType::TAG_EVENT:
-                    ESP_LOGD(TAG, "Executing TAG_EVENT feedback sequence.");
-                    if(m_tagEventTimer && esp_timer_is_active(m_tagEventTimer)) esp_timer_stop(m_tagEventTimer);
-                    if(m_pixelTagEventTimer && esp_timer_is_active(m_pixelTagEventTimer)) esp_timer_stop(m_pixelTagEventTimer);
-                    if (m_pixel != nullptr) {
-                        auto color = m_miscConfig.neopixelTagEventColor;
-                        m_pixel->set(m_pixel->RGB(color[espConfig::actions_config_t::colorMap::R], color[espConfig::actions_config_t::colorMap::G], color[espConfig::actions_config_t::colorMap::B]));
-
-                        if (m_pixelTagEventTimer) esp_timer_start_once(m_pixelTagEventTimer, m_miscConfig.neopixelTagEventTime * 1000);
-                    }
-                    if (pinAllocations.at(TAG_EVENT).has_value()) {
-                        pinAllocations.at(TAG_EVENT)->set_level(m_miscConfig.tagEventHL);
-
-                        if (m_tagEventTimer) esp_timer_start_once(m_tagEventTimer, m_miscConfig.tagEventTimeout * 1000);
-                    }
-                    break;
-            }
-        }
-    }
+  AppEventLoop::publish(HW_EVENT, HW_ALT_ACTION, nullptr, 0);
 }
@@ -0,0 +1,89 @@
+#include "HeapAdmission.hpp"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include <algorithm>
+
+static const char *TAG = "HeapAdmission";
+
+HeapAdmission::HeapAdmission()
+    : m_reservedGauge(MetricsRegistry::instance().gauge("hk_heap_reserved_bytes",
+                                                        "Heap currently reserved by admitted heavy operations")),
+      m_activeGauge(MetricsRegistry::instance().gauge("hk_heap_reservations_active",
+                                                      "Heavy operations currently holding a heap reservation")),
+      m_metrics(registerMetrics()) {}
+
+std::array<HeapAdmission::OpMetrics, static_cast<size_t>(HeapAdmission::Op::Count)> HeapAdmission::registerMetrics() {
+  // Labels are not copied by the registry, so every combination is spelled out as a literal.
+  static constexpr const char *LABELS[][2] = {
+      {R"(op="ota_firmware",result="admitted")", R"(op="ota_firmware",result="rejected")"},
+      {R"(op="ota_littlefs",result="admitted")", R"(op="ota_littlefs",result="rejected")"},
+      {R"(op="certificate_parse",result="admitted")", R"(op="certificate_parse",result="rejected")"},
+      {R"(op="wifi_scan",result="admitted")", R"(op="wifi_scan",result="rejected")"},
+      {R"(op="config_save",result="admitted")", R"(op="config_save",result="rejected")"},
+      {R"(op="ws_backlog_replay",result="admitted")", R"(op="ws_backlog_replay",result="rejected")"},
+  };
+  static_assert(std::size(LABELS) == static_cast<size_t>(Op::Count));
+  static constexpr const char *NAME = "hk_admission_total";
+  static constexpr const char *HELP = "Heavy operations admitted or rejected by the heap admission controller";
+  MetricsRegistry &r = MetricsRegistry::instance();
+  auto entry = [&](size_t i) { return OpMetrics{r.counter(NAME, HELP, LABELS[i][0]), r.counter(NAME, HELP, LABELS[i][1])}; };
+  return {entry(0), entry(1), entry(2), entry(3), entry(4), entry(5)};
+}
+
+HeapAdmission::Reservation HeapAdmission::reserve(Op op, uint32_t bytes) {
+  const Profile &p = profile(op);
+  const uint32_t peak = bytes ? bytes : p.peakBytes;
+  const uint32_t largestNeeded = std::min(peak, p.largestAlloc);
+  OpMetrics &metrics = m_metrics[static_cast<size_t>(op)];
+
+  std::lock_guard lock(m_mutex);
+  const size_t freeHeap = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+  const size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+  const size_t committed = size_t(m_reserved) + peak + ADMISSION_FLOOR;
+  if (freeHeap < committed || largest < largestNeeded) {
+    metrics.rejected.inc();
+    ESP_LOGW(TAG, "Rejected %s: needs %lu (largest %lu), free %zu, largest block %zu, reserved %lu", p.name,
+             (unsigned long)peak, (unsigned long)largestNeeded, freeHeap, largest, (unsigned long)m_reserved);
+    return {};
+  }
+  m_reserved += peak;
+  m_reservedGauge.set(m_reserved);
+  m_activeGauge.add(1);
+  metrics.admitted.inc();
+  ESP_LOGD(TAG, "Admitted %s: %lu bytes, %lu reserved", p.name, (unsigned long)peak, (unsigned long)m_reserved);
+  return Reservation(op, peak);
+}
+
+uint32_t HeapAdmission::reservedBytes() const {
+  std::lock_guard lock(m_mutex);
+  return m_reserved;
+}
+
+void HeapAdmission::release(Op op, uint32_t bytes) {
+  std::lock_guard lock(m_mutex);
+  m_reserved -= std::min(m_reserved, bytes);
+  m_reservedGauge.set(m_reserved);
+  m_activeGauge.add(-1);
+  ESP_LOGD(TAG, "Released %s: %lu bytes, %lu reserved", profile(op).name, (unsigned long)bytes,
+           (unsigned long)m_reserved);
+}
+
+// ============================================================================
+// Reservation
+// ============================================================================
+
+HeapAdmission::Reservation &HeapAdmission::Reservation::operator=(Reservation &&other) noexcept {
+  if (this != &other) {
+    release();
+    m_op = other.m_op;
+    m_bytes = other.m_bytes;
+    other.m_bytes = 0;
+  }
+  return *this;
+}
+
+void HeapAdmission::Reservation::release() {
+  if (m_bytes == 0) return;
+  HeapAdmission::instance().release(m_op, m_bytes);
+  m_bytes = 0;
+}
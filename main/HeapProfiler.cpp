@@ -0,0 +1,329 @@
+#include "HeapProfiler.hpp"
+
+const char *HeapProfiler::tagName(Tag tag) {
+  switch (tag) {
+    case Tag::Nfc: return "nfc";
+    case Tag::Web: return "web";
+    case Tag::Mqtt: return "mqtt";
+    case Tag::HomeSpan: return "homespan";
+    case Tag::Network: return "network";
+    case Tag::Logging: return "logging";
+    default: return "other";
+  }
+}
+
+#if CONFIG_HK_HEAP_PROFILER
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_memory_utils.h"
+#include "esp_random.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "MetricsRegistry.hpp"
+#include "TapArena.hpp"
+
+static const char *TAG = "HeapProfiler";
+
+namespace {
+
+using Tag = HeapProfiler::Tag;
+using Frames = std::array<uintptr_t, HeapProfiler::STACK_DEPTH>;
+
+constexpr uint32_t SAMPLE_BYTES = CONFIG_HK_HEAP_PROFILER_SAMPLE_BYTES;
+constexpr size_t SAMPLE_SLOTS = 512; ///< Power of two.
+constexpr size_t MAX_SAMPLES = SAMPLE_SLOTS * 3 / 4;
+constexpr size_t SITE_SLOTS = 64;
+constexpr uint8_t NO_SITE = 0xFF;
+
+// Heap allocations by the NFC task in one transaction.
+constexpr uint32_t TAP_ALLOCS_BUCKETS[] = { 0, 16, 32, 64, 128, 256, 512, 1024, 2048 };
+constexpr uint32_t TAP_BYTES_BUCKETS[] = { 1024, 4096, 8192, 16384, 32768, 65536, 131072 };
+
+constexpr const char *TAG_LABELS[HeapProfiler::TAG_COUNT] = {
+    "tag=\"other\"", "tag=\"nfc\"", "tag=\"web\"", "tag=\"mqtt\"", "tag=\"homespan\"", "tag=\"network\"",
+    "tag=\"logging\"",
+};
+
+struct TaskPrefix {
+  const char *prefix;
+  Tag tag;
+};
+// loopTask runs setup() and HomeSpan's poll loop.
+constexpr TaskPrefix TASK_TAGS[] = {
+    {"nfc_poll", Tag::Nfc},   {"hk_auth", Tag::Nfc},      {"httpd", Tag::Web},      {"http_worker", Tag::Web},
+    {"ota_", Tag::Web},       {"dns_server", Tag::Web},   {"mqtt", Tag::Mqtt},      {"loopTask", Tag::HomeSpan},
+    {"wifi", Tag::Network},   {"tiT", Tag::Network},      {"sys_evt", Tag::Network},
+};
+
+struct Sample {
+  void *ptr;
+  uint32_t weight;
+  uint8_t tag;
+  uint8_t site;
+};
+
+struct SiteSlot {
+  Frames frames;
+  uint8_t tag;
+  bool used;
+  uint32_t live;
+  uint32_t total;
+};
+
+// Everything the heap hooks touch is static storage, so the hooks never allocate.
+portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+std::atomic<bool> s_enabled{false};
+std::atomic<int32_t> s_countdown{SAMPLE_BYTES};
+std::atomic<uint32_t> s_sampleCount{0};
+Sample s_samples[SAMPLE_SLOTS];
+SiteSlot s_sites[SITE_SLOTS];
+std::atomic<uint32_t> s_live[HeapProfiler::TAG_COUNT];
+std::atomic<uint32_t> s_highWater[HeapProfiler::TAG_COUNT];
+MetricsRegistry::Counter *s_allocs[HeapProfiler::TAG_COUNT];
+MetricsRegistry::Counter *s_allocBytes[HeapProfiler::TAG_COUNT];
+MetricsRegistry::Counter *s_dropped;
+
+std::atomic<TaskHandle_t> s_windowTask{nullptr};
+std::atomic<uint32_t> s_windowAllocs{0};
+std::atomic<uint32_t> s_windowBytes{0};
+std::atomic<bool> s_abMode{false};
+bool s_abBypass = false; ///< Only touched by the task running TapWindows.
+MetricsRegistry::Histogram *s_tapAllocs[2];
+MetricsRegistry::Histogram *s_tapBytes[2];
+
+// Tag + 1, so that 0 means "not set".
+thread_local uint8_t t_taskTag = 0;
+thread_local uint8_t t_scopeTag = 0;
+
+uint8_t classify(const char *taskName) {
+  for (const auto &entry : TASK_TAGS) {
+    if (strncmp(taskName, entry.prefix, strlen(entry.prefix)) == 0) return static_cast<uint8_t>(entry.tag);
+  }
+  return static_cast<uint8_t>(Tag::Other);
+}
+
+uint8_t currentTag() {
+  if (xPortInIsrContext()) return static_cast<uint8_t>(Tag::Other);
+  if (t_scopeTag) return t_scopeTag - 1;
+  if (!t_taskTag) t_taskTag = classify(pcTaskGetName(nullptr)) + 1;
+  return t_taskTag - 1;
+}
+
+size_t slotOf(const void *ptr) {
+  return (reinterpret_cast<uintptr_t>(ptr) >> 3) * 2654435761u & (SAMPLE_SLOTS - 1);
+}
+
+/** @brief Return addresses above the heap hook, innermost first. */
+__attribute__((noinline)) void captureFrames(Frames &frames) {
+  frames.fill(0);
+#if defined(__XTENSA__)
+  // Levels 0 and 1 are the hook and the allocator entry point that called it.
+#define HK_CAPTURE_FRAME(i)                                                                      \
+  {                                                                                              \
+    void *pc = __builtin_return_address((i) + 2);                                                \
+    if (!esp_ptr_executable(pc)) return;                                                         \
+    frames[i] = reinterpret_cast<uintptr_t>(pc);                                                 \
+  }
+  HK_CAPTURE_FRAME(0)
+  HK_CAPTURE_FRAME(1)
+  HK_CAPTURE_FRAME(2)
+  HK_CAPTURE_FRAME(3)
+  HK_CAPTURE_FRAME(4)
+  HK_CAPTURE_FRAME(5)
+#undef HK_CAPTURE_FRAME
+  static_assert(HeapProfiler::STACK_DEPTH == 6, "HK_CAPTURE_FRAME is unrolled for STACK_DEPTH frames");
+#endif
+}
+
+/** @brief Slot for @p frames and @p tag, reusing one with nothing live if the table is full. Lock held. */
+uint8_t siteFor(const Frames &frames, uint8_t tag) {
+  size_t spare = SITE_SLOTS;
+  for (size_t i = 0; i < SITE_SLOTS; i++) {
+    SiteSlot &site = s_sites[i];
+    if (site.used && site.tag == tag && site.frames == frames) return static_cast<uint8_t>(i);
+    if (spare == SITE_SLOTS && (!site.used || site.live == 0)) spare = i;
+  }
+  if (spare == SITE_SLOTS) return NO_SITE;
+  s_sites[spare] = {frames, tag, true, 0, 0};
+  return static_cast<uint8_t>(spare);
+}
+
+void recordSample(void *ptr, uint32_t weight, uint8_t tag) {
+  Frames frames;
+  captureFrames(frames);
+  bool dropped = false;
+  portENTER_CRITICAL_SAFE(&s_lock);
+  const uint8_t site = s_sampleCount.load(std::memory_order_relaxed) < MAX_SAMPLES ? siteFor(frames, tag) : NO_SITE;
+  if (site == NO_SITE) {
+    dropped = true;
+  } else {
+    size_t slot = slotOf(ptr);
+    while (s_samples[slot].ptr) slot = (slot + 1) & (SAMPLE_SLOTS - 1);
+    s_samples[slot] = {ptr, weight, tag, site};
+    s_sampleCount.fetch_add(1, std::memory_order_relaxed);
+    s_sites[site].live += weight;
+    s_sites[site].total += weight;
+    const uint32_t live = s_live[tag].fetch_add(weight, std::memory_order_relaxed) + weight;
+    if (live > s_highWater[tag].load(std::memory_order_relaxed)) {
+      s_highWater[tag].store(live, std::memory_order_relaxed);
+    }
+  }
+  portEXIT_CRITICAL_SAFE(&s_lock);
+  if (dropped) s_dropped->inc();
+}
+
+/** @brief Forget the sample for @p ptr, if it was sampled. */
+void releaseSample(void *ptr) {
+  portENTER_CRITICAL_SAFE(&s_lock);
+  size_t slot = slotOf(ptr);
+  while (s_samples[slot].ptr && s_samples[slot].ptr != ptr) slot = (slot + 1) & (SAMPLE_SLOTS - 1);
+  if (s_samples[slot].ptr) {
+    const Sample &sample = s_samples[slot];
+    s_live[sample.tag].fetch_sub(sample.weight, std::memory_order_relaxed);
+    s_sites[sample.site].live -= sample.weight;
+    s_sampleCount.fetch_sub(1, std::memory_order_relaxed);
+    // Backward-shift deletion keeps every remaining entry reachable from its home slot.
+    size_t hole = slot;
+    for (size_t next = (hole + 1) & (SAMPLE_SLOTS - 1); s_samples[next].ptr; next = (next + 1) & (SAMPLE_SLOTS - 1)) {
+      const size_t home = slotOf(s_samples[next].ptr);
+      if (((next - home) & (SAMPLE_SLOTS - 1)) >= ((next - hole) & (SAMPLE_SLOTS - 1))) {
+        s_samples[hole] = s_samples[next];
+        hole = next;
+      }
+    }
+    s_samples[hole].ptr = nullptr;
+  }
+  portEXIT_CRITICAL_SAFE(&s_lock);
+}
+
+} // namespace
+
+// Called by the ESP-IDF heap for every allocation and free once CONFIG_HEAP_USE_HOOKS is set.
+extern "C" void esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps) {
+  if (!ptr || !s_enabled.load(std::memory_order_relaxed)) return;
+  const uint8_t tag = currentTag();
+  s_allocs[tag]->inc();
+  s_allocBytes[tag]->inc(size);
+  const TaskHandle_t window = s_windowTask.load(std::memory_order_relaxed);
+  if (window && window == xTaskGetCurrentTaskHandle() && !xPortInIsrContext()) {
+    s_windowAllocs.fetch_add(1, std::memory_order_relaxed);
+    s_windowBytes.fetch_add(size, std::memory_order_relaxed);
+  }
+  // The allocation that crosses the countdown is sampled. A random restart keeps the
+  // samples from locking onto a periodic allocation pattern.
+  if (s_countdown.fetch_sub(static_cast<int32_t>(size), std::memory_order_relaxed) > static_cast<int32_t>(size)) return;
+  s_countdown.store(static_cast<int32_t>(esp_random() % (2 * SAMPLE_BYTES)) + 1, std::memory_order_relaxed);
+  recordSample(ptr, std::max<uint32_t>(size, SAMPLE_BYTES), tag);
+}
+
+extern "C" void esp_heap_trace_free_hook(void *ptr) {
+  if (!ptr || s_sampleCount.load(std::memory_order_relaxed) == 0) return;
+  releaseSample(ptr);
+}
+
+void HeapProfiler::begin() {
+  if (s_enabled.load(std::memory_order_relaxed)) return;
+  auto &registry = MetricsRegistry::instance();
+  for (size_t i = 0; i < TAG_COUNT; i++) {
+    s_allocs[i] = &registry.counter("hk_heap_profile_allocs_total", "Heap allocations per subsystem", TAG_LABELS[i]);
+    s_allocBytes[i] = &registry.counter("hk_heap_profile_alloc_bytes_total", "Heap bytes allocated per subsystem",
+                                        TAG_LABELS[i]);
+    registry.gauge("hk_heap_profile_live_bytes", "Estimated heap bytes held per subsystem, from sampling",
+                   TAG_LABELS[i], [i] { return double(s_live[i].load(std::memory_order_relaxed)); });
+    registry.gauge("hk_heap_profile_high_water_bytes", "Highest estimate of heap bytes held per subsystem",
+                   TAG_LABELS[i], [i] { return double(s_highWater[i].load(std::memory_order_relaxed)); });
+  }
+  s_dropped = &registry.counter("hk_heap_profile_dropped_samples_total",
+                                "Allocation samples discarded because the sample or call site table was full");
+  static constexpr const char *ARM_LABELS[2] = {"arena=\"on\"", "arena=\"off\""};
+  for (size_t arm = 0; arm < 2; arm++) {
+    s_tapAllocs[arm] = &registry.histogram("hk_heap_tap_allocs", "Heap allocations by the NFC task per transaction",
+                                           TAP_ALLOCS_BUCKETS, ARM_LABELS[arm]);
+    s_tapBytes[arm] = &registry.histogram("hk_heap_tap_alloc_bytes", "Heap bytes allocated by the NFC task per transaction",
+                                          TAP_BYTES_BUCKETS, ARM_LABELS[arm]);
+  }
+  s_enabled.store(true, std::memory_order_release);
+  ESP_LOGI(TAG, "Tracking heap allocations, one sample per %u bytes", (unsigned)SAMPLE_BYTES);
+}
+
+std::array<HeapProfiler::TagStats, HeapProfiler::TAG_COUNT> HeapProfiler::tags() const {
+  std::array<TagStats, TAG_COUNT> out{};
+  for (size_t i = 0; i < TAG_COUNT; i++) {
+    out[i].tag = static_cast<Tag>(i);
+    if (!s_enabled.load(std::memory_order_acquire)) continue;
+    out[i].allocs = s_allocs[i]->value();
+    out[i].allocBytes = s_allocBytes[i]->value();
+    out[i].liveBytes = s_live[i].load(std::memory_order_relaxed);
+    out[i].highWaterBytes = s_highWater[i].load(std::memory_order_relaxed);
+  }
+  return out;
+}
+
+std::vector<HeapProfiler::Site> HeapProfiler::topSites(size_t count) const {
+  std::vector<Site> out;
+  // Reserved up front: nothing may allocate while the spinlock is held.
+  out.reserve(SITE_SLOTS);
+  portENTER_CRITICAL(&s_lock);
+  for (const auto &site : s_sites) {
+    if (site.used && site.total) {
+      out.push_back({site.frames, static_cast<Tag>(site.tag), site.live, site.total});
+    }
+  }
+  portEXIT_CRITICAL(&s_lock);
+  std::sort(out.begin(), out.end(), [](const Site &a, const Site &b) {
+    return a.liveBytes != b.liveBytes ? a.liveBytes > b.liveBytes : a.totalBytes > b.totalBytes;
+  });
+  if (out.size() > count) out.resize(count);
+  return out;
+}
+
+std::array<HeapProfiler::TapArm, 2> HeapProfiler::taps() const {
+  std::array<TapArm, 2> out{};
+  if (!s_enabled.load(std::memory_order_acquire)) return out;
+  for (size_t arm = 0; arm < 2; arm++) {
+    out[arm] = {s_tapAllocs[arm]->count(), s_tapAllocs[arm]->sum(), s_tapBytes[arm]->sum()};
+  }
+  return out;
+}
+
+void HeapProfiler::setAbMode(bool on) {
+  s_abMode.store(on, std::memory_order_relaxed);
+  if (!on) TapArena::instance().setBypass(false);
+  ESP_LOGI(TAG, "Tap A/B comparison %s", on ? "on: alternate taps bypass the NFC arena" : "off");
+}
+
+bool HeapProfiler::abMode() const { return s_abMode.load(std::memory_order_relaxed); }
+
+HeapProfiler::Scope::Scope(Tag tag) : m_previous(t_scopeTag) { t_scopeTag = static_cast<uint8_t>(tag) + 1; }
+
+HeapProfiler::Scope::~Scope() { t_scopeTag = m_previous; }
+
+HeapProfiler::TapWindow::TapWindow() {
+  if (!s_enabled.load(std::memory_order_acquire)) return;
+  TapArena &arena = TapArena::instance();
+  if (s_abMode.load(std::memory_order_relaxed)) {
+    s_abBypass = !s_abBypass;
+    arena.setBypass(s_abBypass);
+  }
+  m_arena = arena.available();
+  s_windowAllocs.store(0, std::memory_order_relaxed);
+  s_windowBytes.store(0, std::memory_order_relaxed);
+  s_windowTask.store(xTaskGetCurrentTaskHandle(), std::memory_order_release);
+  m_open = true;
+}
+
+HeapProfiler::TapWindow::~TapWindow() {
+  if (!m_open) return;
+  s_windowTask.store(nullptr, std::memory_order_release);
+  const size_t arm = m_arena ? 0 : 1;
+  const uint32_t allocs = s_windowAllocs.load(std::memory_order_relaxed);
+  const uint32_t bytes = s_windowBytes.load(std::memory_order_relaxed);
+  s_tapAllocs[arm]->observe(allocs);
+  s_tapBytes[arm]->observe(bytes);
+  ESP_LOGD(TAG, "Transaction with arena %s: %u heap allocations, %u bytes", m_arena ? "on" : "off",
+           (unsigned)allocs, (unsigned)bytes);
+}
+#endif
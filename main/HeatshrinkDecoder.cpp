@@ -0,0 +1,117 @@
+#include "HeatshrinkDecoder.hpp"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+bool HeatshrinkDecoder::write(const uint8_t *data, size_t len) {
+  if (m_state == State::Header) {
+    size_t take = std::min(len, HEADER_SIZE - m_headerFill);
+    memcpy(m_header.data() + m_headerFill, data, take);
+    m_headerFill += take;
+    data += take;
+    len -= take;
+    if (m_headerFill < HEADER_SIZE) return true;
+    if (!parseHeader()) return false;
+  }
+
+  m_in = data;
+  m_inLen = len;
+  uint32_t value;
+  while (m_state != State::Done && m_state != State::Failed) {
+    switch (m_state) {
+      case State::Tag:
+        if (!bits(1, value)) return flush();
+        m_state = value ? State::Literal : State::Index;
+        break;
+
+      case State::Literal:
+        if (!bits(8, value)) return flush();
+        if (!emit(static_cast<uint8_t>(value))) return false;
+        m_state = State::Tag;
+        break;
+
+      case State::Index:
+        if (!bits(m_windowBits, value)) return flush();
+        m_index = value + 1;
+        m_state = State::Count;
+        break;
+
+      case State::Count: {
+        if (!bits(m_lookaheadBits, value)) return flush();
+        for (uint32_t i = 0; i <= value; i++) {
+          if (!emit(m_window[(m_output - m_index) & m_windowMask])) return false;
+        }
+        m_state = State::Tag;
+        break;
+      }
+
+      default:
+        break;
+    }
+    if (m_state != State::Failed && m_output == m_outputSize) m_state = State::Done;
+  }
+  // Anything after the declared size is bit padding from the encoder.
+  return m_state != State::Failed && flush();
+}
+
+bool HeatshrinkDecoder::finish() {
+  if (m_state == State::Failed) return false;
+  if (!flush()) return false;
+  if (!headerParsed() || m_output != m_outputSize) return fail("Compressed image is truncated");
+  return m_next.finish();
+}
+
+bool HeatshrinkDecoder::parseHeader() {
+  if (memcmp(m_header.data(), "HKHS", 4) != 0) return fail("Not a heatshrink image");
+  m_windowBits = m_header[4];
+  m_lookaheadBits = m_header[5];
+  if (m_windowBits < MIN_WINDOW_BITS || m_windowBits > MAX_WINDOW_BITS || m_lookaheadBits < 3 ||
+      m_lookaheadBits >= m_windowBits) {
+    return fail("Unsupported heatshrink parameters");
+  }
+  m_outputSize = size_t(m_header[8]) | size_t(m_header[9]) << 8 | size_t(m_header[10]) << 16 |
+                 size_t(m_header[11]) << 24;
+  size_t windowSize = size_t(1) << m_windowBits;
+  m_window.reset(new (std::nothrow) uint8_t[windowSize]());
+  if (!m_window) return fail("Out of memory");
+  m_windowMask = windowSize - 1;
+  m_state = m_outputSize ? State::Tag : State::Done;
+  return true;
+}
+
+/**
+ * @brief Take the next @p count bits (MSB first) from the pending input.
+ * @return false if the current input chunk is exhausted; the partial value is kept for the next write().
+ */
+bool HeatshrinkDecoder::bits(uint8_t count, uint32_t &out) {
+  while (m_bitCount < count) {
+    if (m_inLen == 0) return false;
+    m_bitBuffer = (m_bitBuffer << 8) | *m_in++;
+    m_inLen--;
+    m_bitCount += 8;
+  }
+  m_bitCount -= count;
+  out = (m_bitBuffer >> m_bitCount) & ((1u << count) - 1);
+  return true;
+}
+
+bool HeatshrinkDecoder::emit(uint8_t byte) {
+  if (m_output >= m_outputSize) return fail("Decompressed data exceeds the declared size");
+  m_window[m_output & m_windowMask] = byte;
+  m_output++;
+  m_out[m_outFill++] = byte;
+  return m_outFill < m_out.size() || flush();
+}
+
+bool HeatshrinkDecoder::flush() {
+  if (m_outFill == 0) return true;
+  if (!m_next.write(m_out.data(), m_outFill)) return fail("Writing the decompressed image failed");
+  m_outFill = 0;
+  return true;
+}
+
+bool HeatshrinkDecoder::fail(const char *reason) {
+  if (!m_error) m_error = reason;
+  m_state = State::Failed;
+  return false;
+}
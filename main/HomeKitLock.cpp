@@ -7,6 +7,7 @@
 #include "HomeKitLock.hpp"
 #include <cstdint>
 #include <functional>
+#include <utility>
 #include <sodium/crypto_sign.h>
 #include <sodium/crypto_box.h>
 #include "HAP.h"
@@ -14,6 +15,12 @@
 #include "LockManager.hpp"
 #include "ConfigManager.hpp"
 #include "ReaderDataManager.hpp"
+#include "TaskRegistry.hpp"
+#include "HeapProfiler.hpp"
+#include "HomeSpanLoop.hpp"
+#include "MetricsRegistry.hpp"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
 #include "HK_HomeKit.h"
 #include "esp_mac.h"
 #include "hal/spi_types.h"
@@ -22,6 +29,25 @@
 const char* HomeKitLock::TAG = "HomeKitBridge";
 static HomeKitLock* s_instance = nullptr;
 
+namespace {
+
+struct Metrics {
+  MetricsRegistry::Counter& updatesSet;
+  MetricsRegistry::Counter& updatesMerged;
+};
+
+Metrics& metrics() {
+  static Metrics metrics{
+      MetricsRegistry::instance().counter("hk_homekit_char_updates_total",
+                                          "Lock and battery characteristic updates, by whether they were sent or merged away", "result=\"sent\""),
+      MetricsRegistry::instance().counter("hk_homekit_char_updates_total",
+                                          "Lock and battery characteristic updates, by whether they were sent or merged away", "result=\"merged\""),
+  };
+  return metrics;
+}
+
+} // namespace
+
 
 /**
  * @brief Construct the HomeKitLock singleton, register internal event publishers/subscribers, and store manager callbacks.
@@ -62,9 +88,9 @@ HomeKitLock::HomeKitLock(std::function<void(int)> &conn_cb, LockManager& lockMan
               EventValueChanged s = alpaca::deserialize<EventValueChanged>(hk_event.data, ec);
               if(ec) { ESP_LOGE(TAG, "Failed to deserialize EventValueChanged event: %s", ec.message().c_str()); return; }
               if(s.name == "btrLevel") {
-                  updateBatteryStatus(s.newValue, m_statusLowBattery->getVal());
+                  queueUpdate({.batteryLevel = static_cast<uint8_t>(s.newValue)});
               } else if(s.name == "btrLowThreshold"){
-                  updateBatteryStatus(m_batteryLevel->getVal(), s.newValue);
+                  queueUpdate({.lowBattery = s.newValue != 0});
               }
           }
           break;
@@ -329,11 +355,13 @@ void HomeKitLock::begin() {
     const auto& app_version = esp_app_get_description()->version;
     ESP_LOGI(TAG, "Starting HomeSpan setup...");
 
+    uint8_t controlPin = 255;
     if (miscConfig.controlPin != 255){
       static auto hsControlPin = GPIOAllocator::instance().acquire(gpio_num_t(miscConfig.controlPin), GPIO_MODE_DISABLE, "HS_CONTROL_PIN");
-      if(hsControlPin.has_value())
+      if(hsControlPin.has_value()) {
         homeSpan.setControlPin(miscConfig.controlPin);
-      else 
+        controlPin = miscConfig.controlPin;
+      } else 
         ESP_LOGW(TAG, "Could not acquire pin for the HomeSpan Control pin, error: %d", hsControlPin.error());
     }
     if (miscConfig.hsStatusPin != 255){
@@ -360,7 +388,7 @@ void HomeKitLock::begin() {
     homeSpan.setSketchVersion(app_version);
     homeSpan.enableAutoStartAP();
     homeSpan.enableOTA(miscConfig.otaPasswd.c_str());
-    homeSpan.setPortNum(1201);
+    homeSpan.setPortNum(HAP_PORT);
     uint8_t mac[6];
     esp_read_mac(mac, ESP_MAC_BT);
     const std::string macStr = fmt::format("{:02X}{:02X}{:02X}{:02X}", mac[2], mac[3], mac[4], mac[5]);
@@ -387,6 +415,8 @@ void HomeKitLock::begin() {
     homeSpan.setConnectionCallback(connectionEstablished);
     homeSpan.setConnectionTimes(8, 30, 8);
     homeSpan.setApFunction(apStarted);
+    HomeSpanLoop::instance().setBeforePoll([this] { applyPendingUpdates(); });
+    HomeSpanLoop::instance().begin(HAP_PORT, controlPin);
     ESP_LOGI(TAG, "HomeSpan setup complete.");
 }
 
@@ -405,6 +435,9 @@ void HomeKitLock::begin() {
  * - 'N' : Toggle battery-low status (0 = normal, 1 = low).
  * - 'B' : Set battery level percentage.
  * - 'P' : Print registered HomeKey issuers (issuer IDs and public keys).
+ * - 'G' : Print which subsystem owns a GPIO pin.
+ * - 'T' : Print every task's core, priority, stack size and headroom, and CPU share.
+ * - 'H' : Print heap allocations per subsystem; 'Hs' prints the top call sites, 'Ha' toggles the tap A/B comparison.
  */
 void HomeKitLock::setupDebugCommands() {
     new SpanUserCommand('D', "Delete Home Key Data", [](const char* c) {
@@ -490,8 +523,8 @@ void HomeKitLock::setupDebugCommands() {
     });
 
     new SpanUserCommand('P', "Print Issuers", [](const char* c) {
-        const auto readerDataCopy = s_instance->m_readerDataManager.getReaderDataCopy();
-        const auto& issuers = readerDataCopy.issuers;
+        const auto readerData = s_instance->m_readerDataManager.snapshot();
+        const auto& issuers = readerData->issuers;
         ESP_LOGI(TAG, "--- Registered HomeKey Issuers ---");
         if (issuers.empty()) {
             ESP_LOGI(TAG, "None");
@@ -508,44 +541,149 @@ void HomeKitLock::setupDebugCommands() {
       auto s = GPIOAllocator::instance().owner_of(i);
       ESP_LOGI(TAG, "Owner: %s", s.has_value() ? s->c_str() : "Not allocated");
     });
+    new SpanUserCommand('T', "Print task stats", [](const char* c) {
+        ESP_LOGI(TAG, "--- Tasks (sampled every %u s) ---", (unsigned)(TaskRegistry::SAMPLE_INTERVAL_MS / 1000));
+        ESP_LOGI(TAG, "%-16s %4s %4s %6s %6s %6s", "Name", "Core", "Prio", "Stack", "Free", "CPU%");
+        for (const auto& task : TaskRegistry::instance().snapshot()) {
+            // Stack size is only known for tasks the firmware created itself.
+            ESP_LOGI(TAG, "%-16s %4s %4u %6s %6u %6.1f%s", task.name.c_str(),
+                task.core < 0 ? "-" : std::to_string(task.core).c_str(), (unsigned)task.priority,
+                task.stackBytes ? std::to_string(task.stackBytes).c_str() : "-",
+                (unsigned)task.stackFreeBytes, task.cpuPercent, task.running ? "" : " (exited)");
+        }
+        ESP_LOGI(TAG, "------------------------------------");
+    });
+    new SpanUserCommand('H', "Print heap profile (Hs: call sites, Ha: toggle tap A/B)", [](const char* c) {
+        HeapProfiler& profiler = HeapProfiler::instance();
+        if (!HeapProfiler::enabled()) {
+            ESP_LOGI(TAG, "Heap profiler not built in (CONFIG_HK_HEAP_PROFILER)");
+            return;
+        }
+        if (c[1] == 'a') {
+            profiler.setAbMode(!profiler.abMode());
+            return;
+        }
+        if (c[1] == 's') {
+            // Return addresses print as 0x%08x so the serial monitor decodes them to file:line.
+            ESP_LOGI(TAG, "--- Top heap call sites (est. live / total bytes) ---");
+            for (const auto& site : profiler.topSites(10)) {
+                ESP_LOGI(TAG, "%-8s %8u %10u", HeapProfiler::tagName(site.tag), (unsigned)site.liveBytes,
+                    (unsigned)site.totalBytes);
+                for (uintptr_t pc : site.frames) {
+                    if (pc) ESP_LOGI(TAG, "    0x%08x", (unsigned)pc);
+                }
+            }
+            ESP_LOGI(TAG, "------------------------------------");
+            return;
+        }
+        // Rates are per second since the previous @H.
+        static std::array<uint32_t, HeapProfiler::TAG_COUNT> lastAllocs{};
+        static int64_t lastTime = 0;
+        const int64_t now = esp_timer_get_time();
+        const double seconds = lastTime ? (now - lastTime) / 1e6 : 0;
+        lastTime = now;
+        ESP_LOGI(TAG, "--- Heap profile (free %u, largest block %u, min free %u) ---",
+            (unsigned)heap_caps_get_free_size(MALLOC_CAP_DEFAULT),
+            (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT),
+            (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT));
+        ESP_LOGI(TAG, "%-8s %9s %11s %8s %9s %9s", "Tag", "Allocs", "Bytes", "Allocs/s", "Live~", "Peak~");
+        for (const auto& tag : profiler.tags()) {
+            const size_t i = static_cast<size_t>(tag.tag);
+            const double rate = seconds > 0 ? (tag.allocs - lastAllocs[i]) / seconds : 0;
+            lastAllocs[i] = tag.allocs;
+            ESP_LOGI(TAG, "%-8s %9u %11u %8.1f %9u %9u", HeapProfiler::tagName(tag.tag), (unsigned)tag.allocs,
+                (unsigned)tag.allocBytes, rate, (unsigned)tag.liveBytes, (unsigned)tag.highWaterBytes);
+        }
+        const auto arms = profiler.taps();
+        ESP_LOGI(TAG, "Tap A/B %s", profiler.abMode() ? "on" : "off");
+        for (size_t arm = 0; arm < arms.size(); arm++) {
+            const auto& a = arms[arm];
+            ESP_LOGI(TAG, "  arena %-3s: %u taps, %.1f allocs/tap, %.0f bytes/tap", arm == 0 ? "on" : "off",
+                (unsigned)a.taps, a.taps ? double(a.allocs) / a.taps : 0.0, a.taps ? double(a.allocBytes) / a.taps : 0.0);
+        }
+        ESP_LOGI(TAG, "------------------------------------");
+    });
 }
 
 
 /**
- * @brief Update the accessory's current and target lock state characteristics.
+ * @brief Queue new current and target lock states for HomeKit.
  *
- * Applies the provided current and target lock state values to the corresponding HomeKit characteristics
- * when those values differ from the characteristics' existing values.
+ * The values are applied at the end of the coalescing window; see queueUpdate().
  *
  * @param currentState The current lock state to set (use HAP lock state values appropriate for the platform).
  * @param targetState The desired/target lock state to set (use HAP lock target state values appropriate for the platform).
  */
 void HomeKitLock::updateLockState(int currentState, int targetState) {
-    if (m_lockCurrentState->getNewVal() != currentState) {
-        m_lockCurrentState->setVal(currentState);
-    }
-    if (m_lockTargetState->getNewVal() != targetState) {
-        m_lockTargetState->setVal(targetState);
-    }
+    queueUpdate({.currentState = currentState, .targetState = targetState});
 }
 
 /**
- * @brief Update HomeKit battery level and low-battery status characteristics.
+ * @brief Queue a new battery level and low-battery status for HomeKit.
  *
- * Updates the accessory's battery level characteristic and the low-battery status
- * characteristic only when the corresponding characteristic exists and its value
- * differs from the provided one.
+ * The values are applied at the end of the coalescing window; see queueUpdate().
  *
  * @param batteryLevel Battery charge percentage (0–100) to set on the accessory.
  * @param isLow True if the battery should be marked as low, false otherwise.
  */
 void HomeKitLock::updateBatteryStatus(uint8_t batteryLevel, bool isLow) {
-    if (m_batteryLevel && m_batteryLevel->getVal() != batteryLevel) {
-        m_batteryLevel->setVal(batteryLevel);
+    queueUpdate({.batteryLevel = batteryLevel, .lowBattery = isLow});
+}
+
+/**
+ * @brief Hold characteristic values for a short window so that bursts reach controllers as one event.
+ *
+ * A lock transition publishes target, current and sometimes override states within a few
+ * milliseconds, and each setVal() used to become its own HAP event to every controller. Values
+ * queued here replace older ones for the same characteristic. CONFIG_HK_HOMEKIT_COALESCE_MS after
+ * the first of them, applyPendingUpdates() sets the latest values on the HomeSpan task, right before
+ * a poll, which sends everything that changed in one event message per controller.
+ *
+ * Safe from any task.
+ */
+void HomeKitLock::queueUpdate(const PendingUpdates& update) {
+    auto& m = metrics();
+    {
+        std::lock_guard lock(m_pendingMutex);
+        auto merge = [&m](auto& pending, const auto& value) {
+            if (!value) return;
+            if (pending) m.updatesMerged.inc();
+            pending = value;
+        };
+        merge(m_pending.currentState, update.currentState);
+        merge(m_pending.targetState, update.targetState);
+        merge(m_pending.batteryLevel, update.batteryLevel);
+        merge(m_pending.lowBattery, update.lowBattery);
     }
-    if (m_statusLowBattery && m_statusLowBattery->getVal() != (int)isLow) {
-        m_statusLowBattery->setVal(isLow);
+    HomeSpanLoop::instance().schedule(CONFIG_HK_HOMEKIT_COALESCE_MS);
+}
+
+/**
+ * @brief Set the queued characteristic values. Runs on the HomeSpan task, right before a poll.
+ *
+ * The target state is set before the current state, so a controller never sees the lock reach a
+ * state it has not yet been told is the target. Values equal to the characteristic's are dropped.
+ */
+void HomeKitLock::applyPendingUpdates() {
+    PendingUpdates pending;
+    {
+        std::lock_guard lock(m_pendingMutex);
+        pending = std::exchange(m_pending, {});
     }
+    auto& m = metrics();
+    auto apply = [&m](SpanCharacteristic* characteristic, const auto& value) {
+        if (!characteristic || !value) return;
+        if (characteristic->getNewVal() == int(*value)) {
+            m.updatesMerged.inc();
+            return;
+        }
+        characteristic->setVal(*value);
+        m.updatesSet.inc();
+    };
+    apply(m_lockTargetState, pending.targetState);
+    apply(m_lockCurrentState, pending.currentState);
+    apply(m_batteryLevel, pending.batteryLevel);
+    apply(m_statusLowBattery, pending.lowBattery);
 }
 
 /**
@@ -608,10 +746,10 @@ void HomeKitLock::controllerCallback() {
     }
 
     // Remove any stored issuers that no longer correspond to a paired controller.
-    // Iterate over a snapshot copy since removeIssuerIfItExists locks internally
+    // Iterate over a snapshot since removeIssuerIfItExists locks internally
     // and may mutate the manager's live issuer list.
-    readerData_t readerDataSnapshot = m_readerDataManager.getReaderDataCopy();
-    for (const auto& issuer : readerDataSnapshot.issuers) {
+    const auto readerDataSnapshot = m_readerDataManager.snapshot();
+    for (const auto& issuer : readerDataSnapshot->issuers) {
         bool stillPaired = std::any_of(currentIssuerIds.begin(), currentIssuerIds.end(),
             [&issuer](const std::vector<uint8_t>& id) {
                 return issuer.issuer_id.size() == id.size() &&
@@ -0,0 +1,202 @@
+#include "HomeSpanLoop.hpp"
+#include <algorithm>
+#include <unistd.h>
+#include "HomeSpan.h"
+#include "driver/gpio.h"
+#include "esp_log.h"
+#include "esp_netif.h"
+#include "esp_timer.h"
+#include "esp_vfs_eventfd.h"
+#include "esp_wifi_types.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lwip/sockets.h"
+#include "sdkconfig.h"
+
+static const char *TAG = "HomeSpanLoop";
+
+// Time spent in one homeSpan.poll(), and from a command reaching the socket to its update(), in microseconds.
+static constexpr uint32_t POLL_TIME_BUCKETS_US[] = { 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000 };
+static constexpr uint32_t COMMAND_LATENCY_BUCKETS_US[] = { 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000 };
+
+HomeSpanLoop::HomeSpanLoop() : m_metrics(registerMetrics()) {}
+
+HomeSpanLoop::Metrics HomeSpanLoop::registerMetrics() {
+  auto &r = MetricsRegistry::instance();
+  return {
+      .socketWakes = r.counter("hk_homespan_wakeups_total", "HomeSpan polls, by what woke the loop", "reason=\"socket\""),
+      .signalWakes = r.counter("hk_homespan_wakeups_total", "HomeSpan polls, by what woke the loop", "reason=\"signal\""),
+      .timeoutWakes = r.counter("hk_homespan_wakeups_total", "HomeSpan polls, by what woke the loop", "reason=\"timeout\""),
+      .pollTime = r.histogram("hk_homespan_poll_us", "Time spent in one homeSpan.poll()", POLL_TIME_BUCKETS_US),
+      .commandLatency = r.histogram("hk_homekit_command_latency_us",
+                                    "Time from a HomeKit lock command reaching the socket to HomeSpan handling it",
+                                    COMMAND_LATENCY_BUCKETS_US),
+  };
+}
+
+void HomeSpanLoop::begin(uint16_t hapPort, uint8_t controlPin) {
+  if (m_wakeFd.load() >= 0) return;
+  m_hapPort = hapPort;
+
+  esp_vfs_eventfd_config_t config = ESP_VFS_EVENTD_CONFIG_DEFAULT();
+  if (esp_err_t err = esp_vfs_eventfd_register(&config); err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+    ESP_LOGE(TAG, "Could not register eventfd (%s); polling HomeSpan every %u ms", esp_err_to_name(err),
+             (unsigned)FIXED_POLL_MS);
+    return;
+  }
+  // EFD_SUPPORT_ISR lets the control pin's interrupt handler signal it.
+  const int fd = eventfd(0, EFD_SUPPORT_ISR);
+  if (fd < 0) {
+    ESP_LOGE(TAG, "Could not create the wake eventfd; polling HomeSpan every %u ms", (unsigned)FIXED_POLL_MS);
+    return;
+  }
+  m_wakeFd.store(fd);
+
+  // HomeSpan reacts to connectivity changes from poll(): starting the HAP server and mDNS, the
+  // connection callback, and reconnecting.
+  esp_event_handler_instance_register(WIFI_EVENT, ESP_EVENT_ANY_ID, onNetworkEvent, this, nullptr);
+  esp_event_handler_instance_register(IP_EVENT, ESP_EVENT_ANY_ID, onNetworkEvent, this, nullptr);
+
+  if (controlPin != NO_PIN) {
+    if (esp_err_t err = gpio_install_isr_service(0); err == ESP_OK || err == ESP_ERR_INVALID_STATE) {
+      gpio_set_intr_type(gpio_num_t(controlPin), GPIO_INTR_ANYEDGE);
+      gpio_isr_handler_add(gpio_num_t(controlPin), onControlPinEdge, this);
+      gpio_intr_enable(gpio_num_t(controlPin));
+      m_controlPin = controlPin;
+    } else {
+      ESP_LOGW(TAG, "No GPIO ISR service (%s); control button presses wait for the idle poll", esp_err_to_name(err));
+    }
+  }
+#if CONFIG_HK_HOMESPAN_FIXED_POLL
+  ESP_LOGI(TAG, "Polling HomeSpan every %u ms (CONFIG_HK_HOMESPAN_FIXED_POLL)", (unsigned)FIXED_POLL_MS);
+#else
+  ESP_LOGI(TAG, "Servicing HomeSpan on socket activity, idle poll every %u ms", (unsigned)CONFIG_HK_HOMESPAN_IDLE_POLL_MS);
+#endif
+}
+
+void HomeSpanLoop::run() {
+  runDue(esp_timer_get_time());
+  const int64_t start = esp_timer_get_time();
+  homeSpan.poll();
+  const int64_t end = esp_timer_get_time();
+  m_metrics.pollTime.observe(uint32_t(end - start));
+  m_readyAt = 0;
+
+  if (m_wakeFd.load() < 0) {
+    vTaskDelay(pdMS_TO_TICKS(FIXED_POLL_MS));
+    return;
+  }
+#if CONFIG_HK_HOMESPAN_FIXED_POLL
+  // Note when a request arrives, but leave it until the period is over, as the old loop did.
+  const int64_t deadline = end + int64_t(FIXED_POLL_MS) * 1000;
+  for (int64_t now = end; now < deadline; now = esp_timer_get_time()) {
+    if (wait(deadline - now) == Wake::Socket) break;
+  }
+  if (const int64_t left = deadline - esp_timer_get_time(); left > 0) {
+    vTaskDelay(std::max<TickType_t>(pdMS_TO_TICKS(left / 1000), 1));
+  }
+  m_metrics.timeoutWakes.inc();
+#else
+  const bool busy = end < m_busyUntil || controlPinHeld();
+  int64_t timeoutUs = int64_t(busy ? BUSY_POLL_MS : CONFIG_HK_HOMESPAN_IDLE_POLL_MS) * 1000;
+  if (const int64_t due = m_deadline.load(); due) timeoutUs = std::clamp<int64_t>(due - end, 0, timeoutUs);
+  switch (wait(timeoutUs)) {
+    case Wake::Timeout:
+      m_metrics.timeoutWakes.inc();
+      return;
+    case Wake::Socket:
+      m_metrics.socketWakes.inc();
+      break;
+    case Wake::Signal:
+      m_metrics.signalWakes.inc();
+      break;
+  }
+  m_busyUntil = esp_timer_get_time() + int64_t(BUSY_WINDOW_MS) * 1000;
+#endif
+}
+
+void HomeSpanLoop::wake() {
+  const int fd = m_wakeFd.load(std::memory_order_relaxed);
+  if (fd < 0) return;
+  const uint64_t one = 1;
+  write(fd, &one, sizeof(one));
+}
+
+void HomeSpanLoop::schedule(uint32_t delayMs) {
+  const int64_t due = esp_timer_get_time() + int64_t(delayMs) * 1000;
+  int64_t current = m_deadline.load();
+  while (!current || due < current) {
+    if (m_deadline.compare_exchange_weak(current, due)) {
+      // Shorten a select() that is already waiting.
+      wake();
+      return;
+    }
+  }
+}
+
+void HomeSpanLoop::runDue(int64_t now) {
+  int64_t due = m_deadline.load();
+  if (!due || now < due || !m_deadline.compare_exchange_strong(due, 0)) return;
+  if (m_beforePoll) m_beforePoll();
+}
+
+void HomeSpanLoop::commandHandled() {
+  if (m_readyAt) m_metrics.commandLatency.observe(uint32_t(esp_timer_get_time() - m_readyAt));
+}
+
+void HomeSpanLoop::onNetworkEvent(void *self, esp_event_base_t, int32_t, void *) {
+  static_cast<HomeSpanLoop *>(self)->wake();
+}
+
+void HomeSpanLoop::onControlPinEdge(void *self) { static_cast<HomeSpanLoop *>(self)->wake(); }
+
+HomeSpanLoop::Wake HomeSpanLoop::wait(int64_t timeoutUs) {
+  const int wakeFd = m_wakeFd.load(std::memory_order_relaxed);
+  fd_set readable;
+  FD_ZERO(&readable);
+  FD_SET(wakeFd, &readable);
+  const int maxFd = std::max(wakeFd, addHomeSpanSockets(readable));
+
+  timeval tv = {.tv_sec = time_t(timeoutUs / 1000000), .tv_usec = suseconds_t(timeoutUs % 1000000)};
+  const int ready = select(maxFd + 1, &readable, nullptr, nullptr, &tv);
+  if (ready < 0) {
+    // Only the loop task opens and closes HomeSpan's sockets, so this should not happen. Don't spin if it does.
+    ESP_LOGD(TAG, "select() failed: %d", errno);
+    vTaskDelay(pdMS_TO_TICKS(BUSY_POLL_MS));
+    return Wake::Timeout;
+  }
+  if (ready == 0) return Wake::Timeout;
+  if (FD_ISSET(wakeFd, &readable)) {
+    uint64_t count;
+    read(wakeFd, &count, sizeof(count));
+    if (ready == 1) return Wake::Signal;
+  }
+  if (!m_readyAt) m_readyAt = esp_timer_get_time();
+  return Wake::Socket;
+}
+
+int HomeSpanLoop::addHomeSpanSockets(fd_set &fds) const {
+  // HomeSpan's listening socket and every HAP connection it accepted share the HAP port as their
+  // local port; ArduinoOTA listens for invitations on its own. Nothing else binds either.
+  int maxFd = -1;
+  for (int fd = LWIP_SOCKET_OFFSET; fd < LWIP_SOCKET_OFFSET + CONFIG_LWIP_MAX_SOCKETS; fd++) {
+    sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+    if (getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &len) != 0) continue;
+    uint16_t port = 0;
+    if (addr.ss_family == AF_INET) port = ntohs(reinterpret_cast<sockaddr_in *>(&addr)->sin_port);
+#if LWIP_IPV6
+    else if (addr.ss_family == AF_INET6) port = ntohs(reinterpret_cast<sockaddr_in6 *>(&addr)->sin6_port);
+#endif
+    if (port != m_hapPort && port != OTA_PORT) continue;
+    FD_SET(fd, &fds);
+    maxFd = fd;
+  }
+  return maxFd;
+}
+
+bool HomeSpanLoop::controlPinHeld() const {
+  // HomeSpan's control button pulls the pin low. Keep polling while it is held so HomeSpan can
+  // time a long press.
+  return m_controlPin != NO_PIN && gpio_get_level(gpio_num_t(m_controlPin)) == 0;
+}
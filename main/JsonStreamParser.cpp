@@ -0,0 +1,314 @@
+#include "JsonStreamParser.hpp"
+#include <cstring>
+
+JsonStreamParser::JsonStreamParser(Handler& handler, char* tokenBuffer, size_t tokenCapacity)
+    : m_handler(handler), m_token(tokenBuffer), m_capacity(tokenCapacity) {}
+
+/**
+ * @brief Return the parser to its initial state so a new document can be fed.
+ */
+void JsonStreamParser::reset() {
+    m_length = 0;
+    m_position = 0;
+    m_state = State::Value;
+    m_lexeme = Lexeme::None;
+    m_error = Error::None;
+    m_stringIsKey = false;
+    m_literal = nullptr;
+    m_literalPos = 0;
+    m_unicodeDigits = 0;
+    m_unicode = 0;
+    m_highSurrogate = 0;
+    m_depth = 0;
+    m_containers = 0;
+}
+
+const char* JsonStreamParser::errorString() const {
+    switch (m_error) {
+        case Error::None: return "none";
+        case Error::Syntax: return "syntax error";
+        case Error::TokenTooLong: return "token too long";
+        case Error::TooDeep: return "nesting too deep";
+        case Error::Aborted: return "aborted by handler";
+        case Error::Incomplete: return "unexpected end of input";
+    }
+    return "unknown";
+}
+
+bool JsonStreamParser::feed(const char* data, size_t len) {
+    if (m_state == State::Failed) return false;
+    for (size_t i = 0; i < len; ++i) {
+        if (!step(data[i])) return false;
+        ++m_position;
+    }
+    return true;
+}
+
+bool JsonStreamParser::finish() {
+    if (m_state == State::Failed) return false;
+    // A bare top-level number has no terminator of its own.
+    if (m_lexeme == Lexeme::Number && m_depth == 0) {
+        if (!lexNumber(' ')) return false;
+    }
+    if (m_state != State::Done || m_lexeme != Lexeme::None) {
+        return fail(Error::Incomplete);
+    }
+    return true;
+}
+
+bool JsonStreamParser::step(char c) {
+    switch (m_lexeme) {
+        case Lexeme::String:
+        case Lexeme::StringEscape:
+        case Lexeme::StringUnicode:
+            return lexString(c);
+        case Lexeme::Number:
+            return lexNumber(c);
+        case Lexeme::Literal:
+            return lexLiteral(c);
+        case Lexeme::None:
+            break;
+    }
+    return structural(c);
+}
+
+bool JsonStreamParser::structural(char c) {
+    if (c == ' ' || c == '\t' || c == '\n' || c == '\r') return true;
+
+    switch (m_state) {
+        case State::Value:
+            return beginValue(c);
+        case State::ValueOrArrayEnd:
+            if (c == ']') return pop(false);
+            return beginValue(c);
+        case State::KeyOrObjectEnd:
+            if (c == '}') return pop(true);
+            [[fallthrough]];
+        case State::Key:
+            if (c != '"') return fail(Error::Syntax);
+            m_stringIsKey = true;
+            m_length = 0;
+            m_lexeme = Lexeme::String;
+            return true;
+        case State::Colon:
+            if (c != ':') return fail(Error::Syntax);
+            m_state = State::Value;
+            return true;
+        case State::CommaOrEnd:
+            if (c == ',') {
+                m_state = inObject() ? State::Key : State::Value;
+                return true;
+            }
+            if (c == '}') return pop(true);
+            if (c == ']') return pop(false);
+            return fail(Error::Syntax);
+        case State::Done:
+        case State::Failed:
+            break;
+    }
+    return fail(Error::Syntax);
+}
+
+bool JsonStreamParser::beginValue(char c) {
+    m_length = 0;
+    switch (c) {
+        case '{': return push(true);
+        case '[': return push(false);
+        case '"':
+            m_stringIsKey = false;
+            m_lexeme = Lexeme::String;
+            return true;
+        case 't': m_literal = "true"; break;
+        case 'f': m_literal = "false"; break;
+        case 'n': m_literal = "null"; break;
+        default:
+            if (c == '-' || (c >= '0' && c <= '9')) {
+                m_lexeme = Lexeme::Number;
+                return append(c);
+            }
+            return fail(Error::Syntax);
+    }
+    m_lexeme = Lexeme::Literal;
+    m_literalPos = 1;
+    return true;
+}
+
+bool JsonStreamParser::lexString(char c) {
+    if (m_lexeme == Lexeme::StringUnicode) {
+        uint32_t nibble;
+        if (c >= '0' && c <= '9') nibble = c - '0';
+        else if (c >= 'a' && c <= 'f') nibble = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') nibble = c - 'A' + 10;
+        else return fail(Error::Syntax);
+        m_unicode = (m_unicode << 4) | nibble;
+        if (++m_unicodeDigits < 4) return true;
+
+        m_lexeme = Lexeme::String;
+        uint32_t cp = m_unicode;
+        if (cp >= 0xD800 && cp <= 0xDBFF) {
+            if (m_highSurrogate) return fail(Error::Syntax);
+            m_highSurrogate = cp;
+            return true;
+        }
+        if (cp >= 0xDC00 && cp <= 0xDFFF) {
+            if (!m_highSurrogate) return fail(Error::Syntax);
+            cp = 0x10000 + ((m_highSurrogate - 0xD800) << 10) + (cp - 0xDC00);
+            m_highSurrogate = 0;
+        } else if (m_highSurrogate) {
+            return fail(Error::Syntax);
+        }
+        return appendCodepoint(cp);
+    }
+
+    if (m_lexeme == Lexeme::StringEscape) {
+        m_lexeme = Lexeme::String;
+        if (c == 'u') {
+            m_lexeme = Lexeme::StringUnicode;
+            m_unicode = 0;
+            m_unicodeDigits = 0;
+            return true;
+        }
+        if (m_highSurrogate) return fail(Error::Syntax);
+        switch (c) {
+            case '"': return append('"');
+            case '\\': return append('\\');
+            case '/': return append('/');
+            case 'b': return append('\b');
+            case 'f': return append('\f');
+            case 'n': return append('\n');
+            case 'r': return append('\r');
+            case 't': return append('\t');
+            default: return fail(Error::Syntax);
+        }
+    }
+
+    if (c == '\\') {
+        m_lexeme = Lexeme::StringEscape;
+        return true;
+    }
+    // A lone high surrogate must be followed immediately by its low half.
+    if (m_highSurrogate) return fail(Error::Syntax);
+    if (c == '"') {
+        m_lexeme = Lexeme::None;
+        if (m_stringIsKey) {
+            m_state = State::Colon;
+            return emitToken(Event::Key);
+        }
+        if (!emitToken(Event::String)) return false;
+        return afterValue();
+    }
+    if (static_cast<unsigned char>(c) < 0x20) return fail(Error::Syntax);
+    return append(c);
+}
+
+bool JsonStreamParser::lexNumber(char c) {
+    if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E') {
+        return append(c);
+    }
+    m_lexeme = Lexeme::None;
+    if (!validNumber(std::string_view(m_token, m_length))) return fail(Error::Syntax);
+    if (!emitToken(Event::Number)) return false;
+    if (!afterValue()) return false;
+    // The terminating character belongs to the surrounding structure.
+    return structural(c);
+}
+
+bool JsonStreamParser::lexLiteral(char c) {
+    if (c != m_literal[m_literalPos]) return fail(Error::Syntax);
+    if (m_literal[++m_literalPos] != '\0') return true;
+
+    m_lexeme = Lexeme::None;
+    std::string_view text(m_literal);
+    bool ok = (text == "null") ? emit(Event::Null, {}) : emit(Event::Bool, text);
+    if (!ok) return false;
+    return afterValue();
+}
+
+bool JsonStreamParser::append(char c) {
+    if (m_length >= m_capacity) return fail(Error::TokenTooLong);
+    m_token[m_length++] = c;
+    return true;
+}
+
+bool JsonStreamParser::appendCodepoint(uint32_t cp) {
+    if (cp < 0x80) return append(static_cast<char>(cp));
+    if (cp < 0x800) {
+        return append(static_cast<char>(0xC0 | (cp >> 6))) &&
+               append(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+    if (cp < 0x10000) {
+        return append(static_cast<char>(0xE0 | (cp >> 12))) &&
+               append(static_cast<char>(0x80 | ((cp >> 6) & 0x3F))) &&
+               append(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+    return append(static_cast<char>(0xF0 | (cp >> 18))) &&
+           append(static_cast<char>(0x80 | ((cp >> 12) & 0x3F))) &&
+           append(static_cast<char>(0x80 | ((cp >> 6) & 0x3F))) &&
+           append(static_cast<char>(0x80 | (cp & 0x3F)));
+}
+
+bool JsonStreamParser::emit(Event event, std::string_view value) {
+    if (!m_handler.onEvent(event, value, m_depth)) return fail(Error::Aborted);
+    return true;
+}
+
+bool JsonStreamParser::emitToken(Event event) {
+    return emit(event, std::string_view(m_token, m_length));
+}
+
+bool JsonStreamParser::push(bool isObject) {
+    if (m_depth >= MAX_DEPTH) return fail(Error::TooDeep);
+    if (!emit(isObject ? Event::ObjectStart : Event::ArrayStart, {})) return false;
+    if (isObject) m_containers |= (1u << m_depth);
+    else m_containers &= ~(1u << m_depth);
+    ++m_depth;
+    m_state = isObject ? State::KeyOrObjectEnd : State::ValueOrArrayEnd;
+    return true;
+}
+
+bool JsonStreamParser::pop(bool isObject) {
+    if (m_depth == 0 || inObject() != isObject) return fail(Error::Syntax);
+    --m_depth;
+    if (!emit(isObject ? Event::ObjectEnd : Event::ArrayEnd, {})) return false;
+    return afterValue();
+}
+
+bool JsonStreamParser::afterValue() {
+    m_state = (m_depth == 0) ? State::Done : State::CommaOrEnd;
+    return true;
+}
+
+bool JsonStreamParser::fail(Error error) {
+    m_error = error;
+    m_state = State::Failed;
+    return false;
+}
+
+bool JsonStreamParser::inObject() const {
+    return m_depth > 0 && (m_containers & (1u << (m_depth - 1)));
+}
+
+/**
+ * @brief Check @p text against the JSON number grammar: -?(0|[1-9]\d*)(\.\d+)?([eE][+-]?\d+)?
+ */
+bool JsonStreamParser::validNumber(std::string_view text) {
+    size_t i = 0, n = text.size();
+    auto digits = [&]() {
+        size_t start = i;
+        while (i < n && text[i] >= '0' && text[i] <= '9') ++i;
+        return i > start;
+    };
+    if (i < n && text[i] == '-') ++i;
+    if (i < n && text[i] == '0') ++i;
+    else if (!digits()) return false;
+    if (i < n && text[i] == '.') {
+        ++i;
+        if (!digits()) return false;
+    }
+    if (i < n && (text[i] == 'e' || text[i] == 'E')) {
+        ++i;
+        if (i < n && (text[i] == '+' || text[i] == '-')) ++i;
+        if (!digits()) return false;
+    }
+    return i == n;
+}
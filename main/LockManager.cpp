@@ -11,8 +11,8 @@ const char* LockManager::TAG = "LockManager";
  * @brief Initialize a LockManager with configuration and wire its event handlers.
  *
  * Sets initial current and target states to LOCKED, registers EventBus topics and
- * subscriptions for lock state updates and NFC events, and creates the momentary-state
- * timer used to revert temporary unlocks.
+ * subscriptions for lock state updates and NFC events, and registers the executor job
+ * that reverts temporary unlocks.
  *
  * @param miscConfig Configuration controlling NFC behavior, momentary timeout, and high-level lock flags
  *                   (for example: lockAlwaysUnlock, lockAlwaysLock, and HK-related GPIO settings).
@@ -56,14 +56,7 @@ LockManager::LockManager(const espConfig::misc_config_t& miscConfig, const espCo
       size_t d_len = alpaca::serialize(s, d);
       AppEventLoop::publish(LOCK_EVENT, LOCK_STATE_CHANGED, d.data(), d_len);
     });
-  esp_timer_create_args_t momentaryStateTimer_arg = {
-    .callback = handleTimer,
-    .arg = this,
-    .dispatch_method = ESP_TIMER_TASK,
-    .name = "momentaryStateTimer",
-    .skip_unhandled_events = false
-  };
-  esp_timer_create(&momentaryStateTimer_arg, &momentaryStateTimer);
+  m_momentaryJob = Executor::instance().add("job=\"momentary_relock\"", [this] { setTargetState(LOCKED, INTERNAL); });
 }
 
 /**
@@ -88,14 +81,8 @@ void LockManager::begin() {
         EventHKTap s = alpaca::deserialize<EventHKTap>(nfc_event.data, ec);
         if (!ec) {
           if (s.status) {
-            if (m_miscConfig.lockAlwaysUnlock) {
-              setTargetState(lockStates::UNLOCKED, Source::NFC);
-            } else if (m_miscConfig.lockAlwaysLock) {
-              setTargetState(lockStates::LOCKED, Source::NFC);
-            } else {
-              int newState = (m_currentState == lockStates::LOCKED) ? lockStates::UNLOCKED : lockStates::LOCKED;
-              setTargetState(newState, Source::NFC);
-            }
+            const uint8_t pending = m_pendingNfcTarget.exchange(lockStates::MAX);
+            setTargetState(pending != lockStates::MAX ? pending : nfcTargetState(), Source::NFC);
           }
         } else {
           ESP_LOGE(TAG, "Failed to deserialize HomeKey event: %s", ec.message().c_str());
@@ -114,18 +101,32 @@ void LockManager::begin() {
 }
 
 /**
- * @brief Timer callback that sets the lock's target state to LOCKED with source INTERNAL.
+ * @brief The target state a successful HomeKey tap selects: fixed by configuration, or a toggle.
+ */
+uint8_t LockManager::nfcTargetState() const {
+  if (m_miscConfig.lockAlwaysUnlock) return lockStates::UNLOCKED;
+  if (m_miscConfig.lockAlwaysLock) return lockStates::LOCKED;
+  return m_currentState == lockStates::LOCKED ? lockStates::UNLOCKED : lockStates::LOCKED;
+}
+
+/**
+ * @brief Choose the target for an authorized tap and report whether it drives the lock output.
  *
- * @param instance Pointer to the LockManager instance provided to the timer callback.
+ * Mirrors the checks setTargetState() makes for an NFC source: nothing happens when the
+ * lock is already settled in the target state, and the output is only driven in dumb
+ * switch mode or when HomeKey taps control the GPIO.
  */
-void LockManager::handleTimer(void* instance){
-  static_cast<LockManager*>(instance)->setTargetState(LOCKED, INTERNAL);
+std::optional<uint8_t> LockManager::prepareNfcAction() {
+  const uint8_t target = nfcTargetState();
+  m_pendingNfcTarget.store(target);
+  const uint8_t current = m_currentState;
+  if (target == m_targetState && current == target) return std::nullopt;
+  if (!m_actionsConfig.hkDumbSwitchMode && !m_actionsConfig.hkGpioControlledState) return std::nullopt;
+  return target;
 }
 
 void LockManager::stopMomentaryTimer() {
-    if (momentaryStateTimer && esp_timer_is_active(momentaryStateTimer)) {
-        esp_timer_stop(momentaryStateTimer);
-    }
+    Executor::instance().cancel(m_momentaryJob);
 }
 
 void LockManager::startMomentaryTimerIfNeeded(Source source) {
@@ -148,21 +149,18 @@ void LockManager::startMomentaryTimerIfNeeded(Source source) {
     bool isMomentarySource = ((sourceMask & momentarySources) != 0);
 
     if (m_targetState == lockStates::UNLOCKED && isMomentarySource) {
-        if (!momentaryStateTimer) {
-            ESP_LOGE(TAG, "Cannot start momentary unlock timer: timer was not created.");
+        if (m_momentaryJob == Executor::INVALID_JOB) {
+            ESP_LOGE(TAG, "Cannot start momentary unlock timer: job was not registered.");
             return;
         }
-        if (esp_timer_is_active(momentaryStateTimer)) {
+        if (Executor::instance().scheduled(m_momentaryJob)) {
             return;
         }
         ESP_LOGI(TAG,
                  "Starting momentary unlock timer for %d ms from source %d.",
                  m_actionsConfig.gpioActionMomentaryTimeout,
                  static_cast<int>(source));
-        esp_err_t err = esp_timer_start_once(momentaryStateTimer, m_actionsConfig.gpioActionMomentaryTimeout * 1000);
-        if (err != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to start momentary unlock timer: %s", esp_err_to_name(err));
-        }
+        Executor::instance().schedule(m_momentaryJob, m_actionsConfig.gpioActionMomentaryTimeout);
     }
 }
 
@@ -203,7 +201,7 @@ void LockManager::setTargetState(uint8_t state, Source source) {
         return;
     }
 
-    ESP_LOGI(TAG, "Setting target state to %d (c:%d,t:%d), from source %d", state, m_currentState, m_targetState, static_cast<int>(source));
+    ESP_LOGI(TAG, "Setting target state to %d (c:%d,t:%d), from source %d", state, m_currentState.load(), m_targetState.load(), static_cast<int>(source));
 
     stopMomentaryTimer();
 
@@ -218,7 +216,7 @@ void LockManager::setTargetState(uint8_t state, Source source) {
     size_t d_len = alpaca::serialize(s, d);
     if (m_actionsConfig.hkDumbSwitchMode) {
       ESP_LOGI(TAG, "Dummy Action is enabled!");
-      m_currentState = m_targetState;
+      m_currentState = m_targetState.load();
       s.currentState = m_targetState;
       d_len = alpaca::serialize(s, d);
       AppEventLoop::publish(HW_EVENT, HW_ACTION, d.data(), d_len);
@@ -251,8 +249,8 @@ void LockManager::overrideState(uint8_t c_state, uint8_t t_state, Source source)
 
     ESP_LOGI(TAG, "External source %d reported new c_state: %d t_state: %d. Overriding internal state.", static_cast<int>(source), c_state, t_state);
 
-    m_currentState = c_state != lockStates::MAX ? c_state : m_currentState;
-    m_targetState = t_state != lockStates::MAX ? t_state : m_targetState;
+    if (c_state != lockStates::MAX) m_currentState = c_state;
+    if (t_state != lockStates::MAX) m_targetState = t_state;
 
     stopMomentaryTimer();
     EventLockState s{
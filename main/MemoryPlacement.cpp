@@ -0,0 +1,78 @@
+#include "MemoryPlacement.hpp"
+#include "cJSON.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "MetricsRegistry.hpp"
+#if CONFIG_SPIRAM
+#include "esp_psram.h"
+#endif
+
+static const char *TAG = "MemoryPlacement";
+
+namespace {
+
+struct Metrics {
+  MetricsRegistry::Counter &bulkFallbacks;
+};
+
+Metrics &metrics() {
+  static Metrics metrics{
+      MetricsRegistry::instance().counter("hk_mem_bulk_fallbacks_total",
+                                          "Bulk buffers placed in internal RAM because PSRAM was full"),
+  };
+  return metrics;
+}
+
+void *bulkMalloc(size_t bytes) { return MemoryPlacement::allocate(MemoryPlacement::Class::Bulk, bytes); }
+
+} // namespace
+
+void MemoryPlacement::begin() {
+  metrics();
+  auto &registry = MetricsRegistry::instance();
+  registry.gauge("hk_heap_psram_free_bytes", "Free PSRAM; 0 on boards without it", nullptr,
+                 [] { return double(heap_caps_get_free_size(MALLOC_CAP_SPIRAM)); });
+  registry.gauge("hk_heap_psram_largest_free_block_bytes", "Largest free PSRAM block", nullptr,
+                 [] { return double(heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM)); });
+  // Web responses, WebSocket status frames and MQTT discovery payloads are all cJSON documents.
+  cJSON_Hooks hooks = {bulkMalloc, release};
+  cJSON_InitHooks(&hooks);
+  if (psramAvailable()) {
+    ESP_LOGI(TAG, "PSRAM found, %u bytes free; bulk buffers go there",
+             (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+  } else {
+    ESP_LOGI(TAG, "No PSRAM; bulk buffers use internal RAM");
+  }
+}
+
+bool MemoryPlacement::psramAvailable() {
+#if CONFIG_SPIRAM
+  return esp_psram_is_initialized();
+#else
+  return false;
+#endif
+}
+
+void *MemoryPlacement::allocate(Class cls, size_t bytes) {
+  switch (cls) {
+    case Class::Hot:
+      return heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    case Class::Dma:
+      return heap_caps_malloc(bytes, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    case Class::Bulk:
+      break;
+  }
+  if (psramAvailable()) {
+    if (void *p = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)) return p;
+    metrics().bulkFallbacks.inc();
+  }
+  return heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+}
+
+void MemoryPlacement::release(void *p) { heap_caps_free(p); }
+
+int MemoryPlacement::appendToBulk(void *vector, const char *data, size_t len) {
+  auto &out = *static_cast<BulkVector<uint8_t> *>(vector);
+  out.insert(out.end(), data, data + len);
+  return 0;
+}
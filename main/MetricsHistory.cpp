@@ -0,0 +1,125 @@
+#include "MetricsHistory.hpp"
+#include <algorithm>
+#include <vector>
+
+MetricsHistory::MetricsHistory() {
+  m_levels[0].name = "1s";
+  m_levels[0].periodSeconds = 1;
+  m_levels[0].capacity = 60; // 1 minute
+  m_levels[1].name = "1m";
+  m_levels[1].periodSeconds = 60;
+  m_levels[1].capacity = 60; // 1 hour
+  m_levels[2].name = "1h";
+  m_levels[2].periodSeconds = 3600;
+  m_levels[2].capacity = 48; // 2 days
+}
+
+void MetricsHistory::recordTap(uint32_t latencyMs) {
+  size_t bucket = 0;
+  while (bucket < std::size(LATENCY_BOUNDS_MS) && latencyMs > LATENCY_BOUNDS_MS[bucket]) bucket++;
+  std::lock_guard lock(m_mutex);
+  if (m_pendingLatency[bucket] < UINT16_MAX) m_pendingLatency[bucket]++;
+  if (m_pendingTaps < UINT16_MAX) m_pendingTaps++;
+}
+
+void MetricsHistory::addSample(uint32_t uptimeSeconds, uint32_t heapFree, uint32_t heapLargest, int8_t rssi) {
+  std::lock_guard lock(m_mutex);
+  for (Level &level : m_levels) {
+    Accumulator &acc = level.acc;
+    acc.heapFree = std::min(acc.heapFree, heapFree);
+    acc.heapLargest = std::min(acc.heapLargest, heapLargest);
+    acc.rssiSum += rssi;
+    acc.samples++;
+    acc.taps = std::min<uint32_t>(UINT16_MAX, acc.taps + m_pendingTaps);
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+      acc.latency[i] = std::min<uint32_t>(UINT16_MAX, acc.latency[i] + m_pendingLatency[i]);
+    }
+    if (acc.samples >= level.periodSeconds) close(level, uptimeSeconds);
+  }
+  m_pendingTaps = 0;
+  m_pendingLatency.fill(0);
+}
+
+void MetricsHistory::close(Level &level, uint32_t uptimeSeconds) {
+  const Accumulator &acc = level.acc;
+  Point &p = level.points[level.head];
+  p.heapFree = acc.heapFree;
+  p.heapLargest = acc.heapLargest;
+  p.rssi = static_cast<int8_t>(acc.rssiSum / acc.samples);
+  p.taps = acc.taps;
+  p.latencyP50 = percentile(acc, 50);
+  p.latencyP90 = percentile(acc, 90);
+  p.latencyP99 = percentile(acc, 99);
+  level.head = (level.head + 1) % level.capacity;
+  level.count = std::min(level.count + 1, level.capacity);
+  level.newestEnd = uptimeSeconds;
+  level.acc = Accumulator{};
+}
+
+/**
+ * @brief Estimate a latency percentile by interpolating inside the bucket that holds it.
+ * @return 0 when the period had no taps.
+ */
+uint16_t MetricsHistory::percentile(const Accumulator &acc, uint32_t per100) {
+  uint32_t total = 0;
+  for (uint16_t n : acc.latency) total += n;
+  if (total == 0) return 0;
+  uint32_t rank = (total * per100 + 99) / 100;
+  uint32_t seen = 0;
+  for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+    if (seen + acc.latency[i] < rank) {
+      seen += acc.latency[i];
+      continue;
+    }
+    uint32_t lower = i ? LATENCY_BOUNDS_MS[i - 1] : 0;
+    if (i == std::size(LATENCY_BOUNDS_MS)) return static_cast<uint16_t>(lower);
+    uint32_t upper = LATENCY_BOUNDS_MS[i];
+    return static_cast<uint16_t>(lower + (upper - lower) * (rank - seen) / acc.latency[i]);
+  }
+  return LATENCY_BOUNDS_MS[std::size(LATENCY_BOUNDS_MS) - 1];
+}
+
+bool MetricsHistory::render(const MetricsRegistry::Sink &sink) const {
+  struct Series {
+    const char *name;
+    long (*get)(const Point &);
+  };
+  static constexpr Series SERIES[] = {
+      {"heap_free", [](const Point &p) -> long { return p.heapFree; }},
+      {"heap_largest", [](const Point &p) -> long { return p.heapLargest; }},
+      {"rssi", [](const Point &p) -> long { return p.rssi; }},
+      {"taps", [](const Point &p) -> long { return p.taps; }},
+      {"latency_p50", [](const Point &p) -> long { return p.latencyP50; }},
+      {"latency_p90", [](const Point &p) -> long { return p.latencyP90; }},
+      {"latency_p99", [](const Point &p) -> long { return p.latencyP99; }},
+  };
+
+  MetricsRegistry::Writer out(sink);
+  std::vector<Point> points;
+  points.reserve(MAX_POINTS);
+  out.printf("{\"levels\":[");
+  for (size_t l = 0; l < m_levels.size(); l++) {
+    uint32_t period, end;
+    const char *name;
+    {
+      std::lock_guard lock(m_mutex);
+      const Level &level = m_levels[l];
+      name = level.name;
+      period = level.periodSeconds;
+      end = level.newestEnd;
+      points.clear();
+      size_t first = (level.head + level.capacity - level.count) % level.capacity;
+      for (size_t i = 0; i < level.count; i++) points.push_back(level.points[(first + i) % level.capacity]);
+    }
+    out.printf("%s{\"name\":\"%s\",\"period\":%lu,\"end\":%lu", l ? "," : "", name, (unsigned long)period,
+               (unsigned long)end);
+    for (const Series &series : SERIES) {
+      out.printf(",\"%s\":[", series.name);
+      for (size_t i = 0; i < points.size(); i++) out.printf("%s%ld", i ? "," : "", series.get(points[i]));
+      out.printf("]");
+    }
+    out.printf("}");
+  }
+  out.printf("]}");
+  return out.flush();
+}
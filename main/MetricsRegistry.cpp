@@ -0,0 +1,150 @@
+#include "MetricsRegistry.hpp"
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <new>
+
+MetricsRegistry::Histogram::Histogram(std::span<const uint32_t> bounds)
+    : m_bounds(bounds), m_buckets(new std::atomic<uint32_t>[bounds.size() + 1]) {
+  for (size_t i = 0; i <= bounds.size(); i++) m_buckets[i].store(0, std::memory_order_relaxed);
+}
+
+void MetricsRegistry::Histogram::observe(uint32_t value) {
+  size_t i = 0;
+  while (i < m_bounds.size() && value > m_bounds[i]) i++;
+  m_buckets[i].fetch_add(1, std::memory_order_relaxed);
+  m_sum.fetch_add(value, std::memory_order_relaxed);
+  m_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+// ============================================================================
+// Registration
+// ============================================================================
+
+MetricsRegistry::Series &MetricsRegistry::series(const char *name, const char *help, Type type,
+                                                 const char *labels) {
+  if (!labels) labels = "";
+  Family *family = nullptr;
+  for (auto &f : m_families) {
+    if (strcmp(f->name, name) == 0) {
+      family = f.get();
+      break;
+    }
+  }
+  if (!family) {
+    m_families.push_back(std::make_unique<Family>(Family{name, help, type, {}}));
+    family = m_families.back().get();
+  }
+  for (auto &s : family->series) {
+    if (strcmp(s->labels, labels) == 0) return *s;
+  }
+  family->series.push_back(std::make_unique<Series>());
+  Series &s = *family->series.back();
+  s.labels = labels;
+  return s;
+}
+
+MetricsRegistry::Counter &MetricsRegistry::counter(const char *name, const char *help, const char *labels) {
+  std::lock_guard lock(m_mutex);
+  Series &s = series(name, help, Type::Counter, labels);
+  if (!s.counter) s.counter = std::make_unique<Counter>();
+  return *s.counter;
+}
+
+MetricsRegistry::Gauge &MetricsRegistry::gauge(const char *name, const char *help, const char *labels) {
+  std::lock_guard lock(m_mutex);
+  Series &s = series(name, help, Type::Gauge, labels);
+  if (!s.gauge) s.gauge = std::make_unique<Gauge>();
+  return *s.gauge;
+}
+
+void MetricsRegistry::gauge(const char *name, const char *help, const char *labels, GaugeFn fn) {
+  std::lock_guard lock(m_mutex);
+  series(name, help, Type::Gauge, labels).fn = std::move(fn);
+}
+
+MetricsRegistry::Histogram &MetricsRegistry::histogram(const char *name, const char *help,
+                                                       std::span<const uint32_t> bounds, const char *labels) {
+  std::lock_guard lock(m_mutex);
+  Series &s = series(name, help, Type::Histogram, labels);
+  if (!s.histogram) s.histogram = std::make_unique<Histogram>(bounds);
+  return *s.histogram;
+}
+
+// ============================================================================
+// Rendering
+// ============================================================================
+
+void MetricsRegistry::Writer::printf(const char *format, ...) {
+  if (m_failed) return;
+  va_list args;
+  va_start(args, format);
+  va_list retry;
+  va_copy(retry, args);
+  int n = vsnprintf(m_buffer + m_fill, sizeof(m_buffer) - m_fill, format, args);
+  va_end(args);
+  if (n >= 0 && size_t(n) >= sizeof(m_buffer) - m_fill) {
+    // Did not fit: send what is buffered and format again into the empty buffer.
+    if (flush() && size_t(n) < sizeof(m_buffer)) {
+      vsnprintf(m_buffer, sizeof(m_buffer), format, retry);
+    } else if (!m_failed) {
+      // Longer than the whole buffer; send it on its own.
+      std::unique_ptr<char[]> line(new (std::nothrow) char[n + 1]);
+      if (line) {
+        vsnprintf(line.get(), n + 1, format, retry);
+        if (!m_sink(line.get(), n)) m_failed = true;
+      } else {
+        m_failed = true;
+      }
+      n = 0;
+    }
+  }
+  va_end(retry);
+  if (n > 0 && !m_failed) m_fill += n;
+}
+
+bool MetricsRegistry::Writer::flush() {
+  if (!m_failed && m_fill > 0 && !m_sink(m_buffer, m_fill)) m_failed = true;
+  m_fill = 0;
+  return !m_failed;
+}
+
+bool MetricsRegistry::render(const Sink &sink) const {
+  static constexpr const char *TYPE_NAMES[] = {"counter", "gauge", "histogram"};
+  Writer out(sink);
+  std::lock_guard lock(m_mutex);
+  for (const auto &family : m_families) {
+    out.printf("# HELP %s %s\n", family->name, family->help);
+    out.printf("# TYPE %s %s\n", family->name, TYPE_NAMES[static_cast<size_t>(family->type)]);
+    for (const auto &s : family->series) renderSeries(out, *family, *s);
+  }
+  return out.flush();
+}
+
+void MetricsRegistry::renderSeries(Writer &out, const Family &family, const Series &s) {
+  const char *open = *s.labels ? "{" : "";
+  const char *close = *s.labels ? "}" : "";
+  if (s.counter) {
+    out.printf("%s%s%s%s %lu\n", family.name, open, s.labels, close, (unsigned long)s.counter->value());
+  } else if (s.gauge) {
+    out.printf("%s%s%s%s %ld\n", family.name, open, s.labels, close, (long)s.gauge->value());
+  } else if (s.fn) {
+    out.printf("%s%s%s%s %.10g\n", family.name, open, s.labels, close, s.fn());
+  } else if (s.histogram) {
+    const Histogram &h = *s.histogram;
+    const char *sep = *s.labels ? "," : "";
+    uint32_t cumulative = 0;
+    for (size_t i = 0; i < h.bounds().size(); i++) {
+      cumulative += h.bucket(i);
+      out.printf("%s_bucket{%s%sle=\"%lu\"} %lu\n", family.name, s.labels, sep, (unsigned long)h.bounds()[i],
+                 (unsigned long)cumulative);
+    }
+    cumulative += h.bucket(h.bounds().size());
+    out.printf("%s_bucket{%s%sle=\"+Inf\"} %lu\n", family.name, s.labels, sep, (unsigned long)cumulative);
+    out.printf("%s_sum%s%s%s %llu\n", family.name, open, s.labels, close, (unsigned long long)h.sum());
+    // Derived from the buckets so a scrape racing an observe() stays self-consistent.
+    out.printf("%s_count%s%s%s %lu\n", family.name, open, s.labels, close, (unsigned long)cumulative);
+  }
+}
@@ -4,15 +4,22 @@
 #include "LockManager.hpp"
 #include "ConfigManager.hpp"
 #include "JsonGuard.hpp"
+#include "JsonWriter.hpp"
+#include "TaskRegistry.hpp"
+#include <charconv>
 #include <cstdlib>
 #include <esp_log.h>
 #include <esp_app_desc.h>
+#include <esp_random.h>
+#include <LittleFS.h>
+#include <nvs.h>
 #include "eventStructs.hpp"
 #include <string>
 #include <vector>
 #include <cstring>
 
 const char* MqttManager::TAG = "MqttManager";
+const std::string MqttManager::HASS_STATUS_TOPIC = "homeassistant/status";
 
 /**
  * @brief Initialize MqttManager from configuration and register MQTT-related event subscribers and publishers.
@@ -28,21 +35,64 @@ MqttManager::MqttManager(const ConfigManager& configManager)
       m_mqttSslConfig(configManager.getMqttSslConfig()),
       m_client(nullptr),
       device_name(configManager.getConfig<espConfig::misc_config_t>().deviceName),
-      m_sslConfigured(false)
+      m_spool(LittleFS, "/mqtt_spool"),
+      m_sslConfigured(false),
+      m_metrics(registerMetrics())
 {
 }
 
+// Time spent handling one command on the MQTT task, in microseconds. Includes waiting for
+// room in the event loop queue, so it grows once commands arrive faster than they are consumed.
+static constexpr uint32_t COMMAND_DISPATCH_BUCKETS_US[] = { 50, 100, 250, 500, 1000, 2500, 5000, 10000, 50000 };
+// Command received to resulting lock state handed to the client, in milliseconds.
+static constexpr uint32_t COMMAND_ROUND_TRIP_BUCKETS_MS[] = { 5, 10, 25, 50, 100, 250, 500, 1000, 5000 };
+// A command not answered by a state publish within this time (e.g. it did not change the state) is dropped.
+static constexpr int64_t COMMAND_ROUND_TRIP_EXPIRY_US = 30 * 1000 * 1000;
+// Time a message waited in the outbox before it was handed to the client, in milliseconds.
+static constexpr uint32_t OUTBOX_WAIT_BUCKETS_MS[] = { 1, 5, 10, 25, 50, 100, 250, 1000, 5000 };
+
+/**
+ * @brief Register the MQTT series in the metrics registry.
+ */
+MqttManager::Metrics MqttManager::registerMetrics() {
+    auto& r = MetricsRegistry::instance();
+    return Metrics{
+        .published = r.counter("hk_mqtt_publishes_total", "MQTT messages handed to the client by result", "result=\"ok\""),
+        .publishFailed = r.counter("hk_mqtt_publishes_total", "MQTT messages handed to the client by result", "result=\"failed\""),
+        .connects = r.counter("hk_mqtt_connects_total", "Successful connections to the MQTT broker, including reconnects"),
+        .disconnects = r.counter("hk_mqtt_disconnects_total", "Connections to the MQTT broker that were lost"),
+        .connected = r.gauge("hk_mqtt_connected", "1 while connected to the MQTT broker"),
+        .depthAccess = r.gauge("hk_mqtt_queue_depth", "Outbound MQTT messages waiting in memory by priority", "priority=\"access\""),
+        .depthState = r.gauge("hk_mqtt_queue_depth", "Outbound MQTT messages waiting in memory by priority", "priority=\"state\""),
+        .depthTelemetry = r.gauge("hk_mqtt_queue_depth", "Outbound MQTT messages waiting in memory by priority", "priority=\"telemetry\""),
+        .depthDiscovery = r.gauge("hk_mqtt_queue_depth", "Outbound MQTT messages waiting in memory by priority", "priority=\"discovery\""),
+        .queueCoalesced = r.counter("hk_mqtt_queue_coalesced_total", "Queued MQTT messages replaced by a newer value for the same topic"),
+        .queueDropped = r.counter("hk_mqtt_queue_dropped_total", "Outbound MQTT messages dropped because the queue or spool was full"),
+        .spooled = r.counter("hk_mqtt_spooled_total", "Access events written to the offline spool"),
+        .replayed = r.counter("hk_mqtt_replayed_total", "Spooled access events published after a reconnect"),
+        .spoolDropped = r.counter("hk_mqtt_spool_dropped_total", "Spooled access events lost because the spool wrapped"),
+        .spoolBytes = r.gauge("hk_mqtt_spool_bytes", "Size of the offline spool on LittleFS"),
+        .commands = r.counter("hk_mqtt_commands_total", "Messages received on subscribed command topics"),
+        .commandDispatch = r.histogram("hk_mqtt_command_dispatch_us", "Time the MQTT task spends handling one command", COMMAND_DISPATCH_BUCKETS_US),
+        .commandRoundTrip = r.histogram("hk_mqtt_command_roundtrip_ms", "Time from a lock command to the resulting state being published", COMMAND_ROUND_TRIP_BUCKETS_MS),
+        .outboxWait = r.histogram("hk_mqtt_outbox_wait_ms", "Time outbound messages waited in the queue before being sent", OUTBOX_WAIT_BUCKETS_MS),
+    };
+}
+
 /**
  * @brief Stops and destroys the MQTT client (if active) and unsubscribes all EventBus listeners registered by this instance.
  *
  * Ensures the MQTT client is cleanly stopped and its resources freed, then removes subscriptions for lock state, alternate action, and NFC events from the shared EventBus.
  */
 MqttManager::~MqttManager() {
-   if (m_client) {
-       esp_mqtt_client_stop(m_client);
-       esp_mqtt_client_destroy(m_client);
-       m_client = nullptr;
+   {
+       std::scoped_lock lock(m_clientMutex, m_outboxMutex);
+       if (m_drainTaskHandle) {
+           vTaskDelete(m_drainTaskHandle);
+           m_drainTaskHandle = nullptr;
+       }
    }
+   end();
 }
 
 /**
@@ -52,14 +102,23 @@ MqttManager::~MqttManager() {
  * then removes all EventBus subscriptions registered by this instance.
  */
 void MqttManager::end() {
-    if (m_client) {
-        ESP_LOGI(TAG, "Stopping MQTT client...");
-        esp_mqtt_client_stop(m_client);
-        esp_mqtt_client_destroy(m_client);
-        m_client = nullptr;
-        m_isConnected = false;
-        ESP_LOGI(TAG, "MQTT client stopped");
+    esp_mqtt_client_handle_t client;
+    {
+        std::lock_guard lock(m_clientMutex);
+        client = m_client;
     }
+    if (!client) return;
+    ESP_LOGI(TAG, "Stopping MQTT client...");
+    // Not under m_clientMutex: esp-mqtt holds its API lock while it delivers events, and
+    // the drain task takes the two locks in the opposite order.
+    esp_mqtt_client_stop(client);
+    std::lock_guard lock(m_clientMutex);
+    deleteReconnectTimer();
+    esp_mqtt_client_destroy(m_client);
+    m_client = nullptr;
+    m_isConnected = false;
+    m_metrics.connected.set(0);
+    ESP_LOGI(TAG, "MQTT client stopped");
 }
 
 /**
@@ -88,7 +147,7 @@ bool MqttManager::begin(std::string deviceID) {
     });
     m_alt_action = AppEventLoop::subscribe(HW_EVENT, HW_ALT_ACTION, [&](const uint8_t* data, size_t size){
       (void)data; (void)size;
-      publish(m_mqttConfig.hkAltActionTopic, "1");
+      publish(m_mqttConfig.hkAltActionTopic, "1", 0, false, MqttOutbox::Priority::Access);
     });
     m_nfc_event = AppEventLoop::subscribe(NFC_EVENT, NFC_TAP_EVENT, [&](const uint8_t* data, size_t size){
       if(size == 0 || data == nullptr) return;
@@ -152,6 +211,10 @@ bool MqttManager::begin(std::string deviceID) {
     mqtt_cfg.session.last_will.msg_len = 7;
     mqtt_cfg.session.last_will.retain = true;
     mqtt_cfg.session.last_will.qos = 1;
+    // Reconnects are scheduled by scheduleReconnect() with backoff and jitter.
+    mqtt_cfg.network.disable_auto_reconnect = true;
+
+    renderHassDiscovery();
 
     m_client = esp_mqtt_client_init(&mqtt_cfg);
     if (!m_client) {
@@ -159,6 +222,27 @@ bool MqttManager::begin(std::string deviceID) {
         return false;
     }
     
+    if (!m_drainTaskHandle) {
+        if (TaskRegistry::instance().create(drainTaskEntry, "mqtt_outbox", 4096, this, 4, &m_drainTaskHandle, 1) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create MQTT outbox task");
+            m_drainTaskHandle = nullptr;
+        }
+    }
+
+    if (!m_reconnectTimer) {
+        const esp_timer_create_args_t timerArgs = {
+            .callback = &MqttManager::reconnectTimerCallback,
+            .arg = this,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "mqttReconnect",
+            .skip_unhandled_events = true,
+        };
+        if (esp_timer_create(&timerArgs, &m_reconnectTimer) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to create MQTT reconnect timer");
+            m_reconnectTimer = nullptr;
+        }
+    }
+
     esp_mqtt_client_register_event(m_client, MQTT_EVENT_ANY, mqttEventHandler, this);
     esp_err_t start_result = esp_mqtt_client_start(m_client);
     
@@ -174,21 +258,203 @@ bool MqttManager::begin(std::string deviceID) {
 }
 
 /**
- * @brief Publish a message to the configured MQTT broker.
+ * @brief Queue a message for the configured MQTT broker.
  *
- * Publishes the given payload to the specified MQTT topic using the provided QoS and retain flag.
+ * The message is handed to the outbox and sent by the drain task, highest priority first.
+ * Callers therefore never wait on the network, and a discovery burst cannot hold up a lock
+ * state update or a tap.
  *
  * @param topic Destination MQTT topic.
  * @param payload Message payload (may be empty).
  * @param qos MQTT quality of service level (typically 0, 1, or 2).
  * @param retain If true, the broker will retain the message as the last known value for the topic.
+ * @param priority Outbox class; everything but Access keeps only the latest value per topic.
  */
-void MqttManager::publish(const std::string& topic, const std::string& payload, int qos, bool retain) {
+void MqttManager::publish(const std::string& topic, std::string_view payload, int qos, bool retain,
+                          MqttOutbox::Priority priority) {
     if (!m_client) {
         ESP_LOGW(TAG, "Cannot publish, MQTT client not initialized.");
         return;
     }
-    esp_mqtt_client_publish(m_client, topic.c_str(), payload.c_str(), payload.length(), qos, retain);
+    MqttOutbox::PushResult result;
+    {
+        std::lock_guard lock(m_outboxMutex);
+        result = m_outbox.push({topic, std::string(payload), static_cast<uint8_t>(qos), retain, priority,
+                                 esp_timer_get_time()});
+        updateQueueMetrics();
+    }
+    switch (result) {
+        case MqttOutbox::PushResult::Coalesced:
+            m_metrics.queueCoalesced.inc();
+            break;
+        case MqttOutbox::PushResult::Evicted:
+        case MqttOutbox::PushResult::Rejected:
+            ESP_LOGW(TAG, "Outbox full, dropped a message (%s)", result == MqttOutbox::PushResult::Rejected ? topic.c_str() : "older");
+            m_metrics.queueDropped.inc();
+            break;
+        default:
+            break;
+    }
+    if (m_drainTaskHandle) xTaskNotifyGive(m_drainTaskHandle);
+}
+
+/**
+ * @brief Hand one message to the ESP-MQTT client. Caller holds m_clientMutex.
+ * @return false if the client refused it (typically because the connection just dropped).
+ */
+bool MqttManager::publishNow(const MqttOutbox::Message& msg) {
+    if (esp_mqtt_client_publish(m_client, msg.topic.c_str(), msg.payload.c_str(), msg.payload.length(), msg.qos,
+                                msg.retain) < 0) {
+        m_metrics.publishFailed.inc();
+        return false;
+    }
+    m_metrics.published.inc();
+    return true;
+}
+
+void MqttManager::drainTaskEntry(void* arg) {
+    static_cast<MqttManager*>(arg)->drainTask();
+}
+
+/**
+ * @brief Outbox drain loop.
+ *
+ * Woken whenever a message is queued or the connection changes state, and once a second
+ * regardless. While disconnected it moves access events to the spool. Once connected it
+ * first replays the spool, which holds the oldest events, and then empties the outbox by
+ * priority. A failed publish puts the message back and waits for the next wake-up.
+ */
+void MqttManager::drainTask() {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+        std::lock_guard clientLock(m_clientMutex);
+        if (!m_client) continue;
+        if (!m_isConnected) {
+            spillAccessEvents();
+            continue;
+        }
+
+        if (!m_spool.empty()) {
+            size_t replayed = m_spool.replay([this](const MqttOutbox::Message& msg) {
+                return m_isConnected && publishNow(msg);
+            });
+            if (replayed) ESP_LOGI(TAG, "Replayed %u spooled message(s)", (unsigned)replayed);
+            m_metrics.replayed.inc(replayed);
+            updateSpoolMetrics();
+            if (!m_spool.empty()) continue; // Connection dropped again; keep the order.
+        }
+
+        while (m_isConnected) {
+            std::optional<MqttOutbox::Message> msg;
+            {
+                std::lock_guard lock(m_outboxMutex);
+                msg = m_outbox.pop();
+                updateQueueMetrics();
+            }
+            if (!msg) break;
+            if (!publishNow(*msg)) {
+                std::lock_guard lock(m_outboxMutex);
+                m_outbox.pushFront(std::move(*msg));
+                updateQueueMetrics();
+                break;
+            }
+            const int64_t now = esp_timer_get_time();
+            m_metrics.outboxWait.observe(static_cast<uint32_t>((now - msg->queuedAt) / 1000));
+            if (msg->priority == MqttOutbox::Priority::Discovery) onDiscoveryPublished(*msg);
+            if (msg->priority == MqttOutbox::Priority::State && msg->topic == m_mqttConfig.lockStateTopic) {
+                int64_t commandAt = m_pendingCommandAt.exchange(0);
+                if (commandAt && now - commandAt <= COMMAND_ROUND_TRIP_EXPIRY_US) {
+                    m_metrics.commandRoundTrip.observe(static_cast<uint32_t>((now - commandAt) / 1000));
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Move queued access events to the LittleFS spool while the broker is unreachable.
+ */
+void MqttManager::spillAccessEvents() {
+    std::vector<MqttOutbox::Message> events;
+    {
+        std::lock_guard lock(m_outboxMutex);
+        events = m_outbox.take(MqttOutbox::Priority::Access);
+        updateQueueMetrics();
+    }
+    if (events.empty()) return;
+    for (const auto& event : events) {
+        if (m_spool.append(event)) {
+            m_metrics.spooled.inc();
+        } else {
+            m_metrics.queueDropped.inc();
+        }
+    }
+    ESP_LOGI(TAG, "Spooled %u access event(s) while offline", (unsigned)events.size());
+    updateSpoolMetrics();
+}
+
+/**
+ * @brief Refresh the queue depth series. Caller holds m_outboxMutex.
+ */
+void MqttManager::updateQueueMetrics() {
+    m_metrics.depthAccess.set(m_outbox.size(MqttOutbox::Priority::Access));
+    m_metrics.depthState.set(m_outbox.size(MqttOutbox::Priority::State));
+    m_metrics.depthTelemetry.set(m_outbox.size(MqttOutbox::Priority::Telemetry));
+    m_metrics.depthDiscovery.set(m_outbox.size(MqttOutbox::Priority::Discovery));
+}
+
+/**
+ * @brief Refresh the spool series. Only the drain task touches the spool.
+ */
+void MqttManager::updateSpoolMetrics() {
+    m_metrics.spoolBytes.set(m_spool.bytes());
+    if (m_spool.dropped() != m_spoolDroppedSeen) {
+        m_metrics.spoolDropped.inc(m_spool.dropped() - m_spoolDroppedSeen);
+        m_spoolDroppedSeen = m_spool.dropped();
+    }
+}
+
+/**
+ * @brief Arm the one-shot reconnect timer with exponential backoff and full jitter.
+ *
+ * The delay ceiling doubles from RECONNECT_BASE_MS up to RECONNECT_MAX_MS with every
+ * failed attempt, and the actual delay is drawn uniformly below it. When a broker restart
+ * drops a whole fleet at once, the devices therefore spread their reconnects over the
+ * window instead of arriving together.
+ */
+void MqttManager::scheduleReconnect() {
+    std::lock_guard lock(m_reconnectMutex);
+    if (!m_reconnectTimer) return;
+    const uint32_t shift = std::min<uint32_t>(m_reconnectAttempt, 16);
+    const uint32_t ceiling = std::min<uint32_t>(RECONNECT_MAX_MS, RECONNECT_BASE_MS << shift);
+    const uint32_t delayMs = RECONNECT_MIN_MS + esp_random() % ceiling;
+    m_reconnectAttempt++;
+    esp_timer_stop(m_reconnectTimer);
+    esp_timer_start_once(m_reconnectTimer, uint64_t(delayMs) * 1000);
+    ESP_LOGI(TAG, "Reconnecting in %lu ms (attempt %lu)", (unsigned long)delayMs, (unsigned long)m_reconnectAttempt);
+}
+
+void MqttManager::reconnectTimerCallback(void* arg) {
+    MqttManager* instance = static_cast<MqttManager*>(arg);
+    std::lock_guard lock(instance->m_clientMutex);
+    if (instance->m_client && !instance->m_isConnected) {
+        esp_err_t err = esp_mqtt_client_reconnect(instance->m_client);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Reconnect request failed: %s", esp_err_to_name(err));
+            instance->scheduleReconnect();
+        }
+    }
+}
+
+/**
+ * @brief Stop and delete the reconnect timer.
+ */
+void MqttManager::deleteReconnectTimer() {
+    std::lock_guard lock(m_reconnectMutex);
+    if (!m_reconnectTimer) return;
+    esp_timer_stop(m_reconnectTimer);
+    esp_timer_delete(m_reconnectTimer);
+    m_reconnectTimer = nullptr;
 }
 
 /**
@@ -230,13 +496,20 @@ void MqttManager::onMqttEvent(esp_event_base_t base, int32_t event_id, void* eve
         case MQTT_EVENT_CONNECTED:
             ESP_LOGI(TAG, "MQTT_EVENT_CONNECTED: Connection established successfully");
             m_isConnected = true;
+            m_metrics.connects.inc();
+            m_metrics.connected.set(1);
             publishMqttStatus(true, MqttErrorCode::NONE);
             onConnected();
+            if (m_drainTaskHandle) xTaskNotifyGive(m_drainTaskHandle);
             break;
         case MQTT_EVENT_DISCONNECTED:
             ESP_LOGW(TAG, "MQTT_EVENT_DISCONNECTED: Client disconnected from broker");
             m_isConnected = false;
+            m_metrics.disconnects.inc();
+            m_metrics.connected.set(0);
             publishMqttStatus(false, MqttErrorCode::NONE);
+            if (m_drainTaskHandle) xTaskNotifyGive(m_drainTaskHandle);
+            scheduleReconnect();
             break;
         case MQTT_EVENT_SUBSCRIBED:
             ESP_LOGI(TAG, "MQTT_EVENT_SUBSCRIBED: Successfully subscribed to topic (msg_id=%d)", event->msg_id);
@@ -247,13 +520,11 @@ void MqttManager::onMqttEvent(esp_event_base_t base, int32_t event_id, void* eve
         case MQTT_EVENT_PUBLISHED:
             ESP_LOGD(TAG, "MQTT_EVENT_PUBLISHED: Message published successfully (msg_id=%d)", event->msg_id);
             break;
-        case MQTT_EVENT_DATA: {
-            std::string topic(event->topic, event->topic_len);
-            std::string data(event->data, event->data_len);
-            ESP_LOGD(TAG, "MQTT_EVENT_DATA: Received %d bytes on topic '%s'", event->data_len, topic.c_str());
-            onData(topic, data);
+        case MQTT_EVENT_DATA:
+            ESP_LOGD(TAG, "MQTT_EVENT_DATA: Received %d of %d bytes at offset %d", event->data_len,
+                     event->total_data_len, event->current_data_offset);
+            onData(*event);
             break;
-        }
         case MQTT_EVENT_BEFORE_CONNECT:
             ESP_LOGI(TAG, "MQTT_EVENT_BEFORE_CONNECT: Initiating connection attempt to %s:%d",
                      m_mqttConfig.mqttBroker.c_str(), m_mqttConfig.mqttPort);
@@ -327,8 +598,13 @@ void MqttManager::onMqttEvent(esp_event_base_t base, int32_t event_id, void* eve
  */
 void MqttManager::onConnected() {
     m_isConnected = true;
+    {
+        std::lock_guard lock(m_reconnectMutex);
+        m_reconnectAttempt = 0;
+    }
+    buildDispatchTable();
 
-    publish(m_mqttConfig.lwtTopic, "online", 1, true);
+    publish(m_mqttConfig.lwtTopic, "online", 1, true, MqttOutbox::Priority::State);
 
     int ret;
     ret = esp_mqtt_client_subscribe(m_client, m_mqttConfig.lockStateCmd.c_str(), 0);
@@ -345,98 +621,241 @@ void MqttManager::onConnected() {
     }
 
     if (m_mqttConfig.hassMqttDiscoveryEnabled) {
-        publishHassDiscovery();
+        ret = esp_mqtt_client_subscribe(m_client, HASS_STATUS_TOPIC.c_str(), 0);
+        if (ret < 0) ESP_LOGW(TAG, "Failed to subscribe to %s", HASS_STATUS_TOPIC.c_str());
+        publishHassDiscovery(false);
+    }
+}
+
+namespace {
+/** @brief 32-bit FNV-1a. Topic matches are always verified; content hashes only gate republishing. */
+constexpr uint32_t fnv1a(const char* data, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ static_cast<uint8_t>(data[i])) * 16777619u;
+    }
+    return h;
+}
+
+/** @brief What a custom lock state value received on lockCustomStateCmd turns into. */
+struct CustomStateAction {
+    const char* key;
+    uint8_t currentState;
+    uint8_t targetState;
+    int32_t event;
+};
+
+// Earlier entries win when two custom states share a value.
+constexpr CustomStateAction CUSTOM_STATES[] = {
+    {"C_UNLOCKING", LockManager::MAX, LockManager::UNLOCKED, LOCK_TARGET_STATE_CHANGED},
+    {"C_LOCKING", LockManager::MAX, LockManager::LOCKED, LOCK_TARGET_STATE_CHANGED},
+    {"C_UNLOCKED", LockManager::UNLOCKED, LockManager::UNLOCKED, LOCK_OVERRIDE_STATE},
+    {"C_LOCKED", LockManager::LOCKED, LockManager::LOCKED, LOCK_OVERRIDE_STATE},
+    {"C_JAMMED", LockManager::JAMMED, LockManager::MAX, LOCK_OVERRIDE_STATE},
+    {"C_UNKNOWN", LockManager::UNKNOWN, LockManager::MAX, LOCK_OVERRIDE_STATE},
+};
+
+bool parseU8(const char* data, size_t len, uint8_t& out) {
+    unsigned v = 0;
+    auto [end, ec] = std::from_chars(data, data + len, v);
+    if (ec != std::errc() || end == data || v > 255) return false;
+    out = static_cast<uint8_t>(v);
+    return true;
+}
+
+void publishLockEvent(int32_t event, uint8_t currentState, uint8_t targetState) {
+    EventLockState s{
+        .currentState = currentState,
+        .targetState = targetState,
+        .source = LockManager::MQTT,
+    };
+    std::array<uint8_t, sizeof(EventLockState)> d{};
+    size_t d_len = alpaca::serialize(s, d);
+    AppEventLoop::publish(LOCK_EVENT, event, d.data(), d_len);
+}
+
+// Sized for the longest tap: 10-byte UID plus a 16-character reader id, with headroom.
+constexpr size_t TAP_PAYLOAD_SIZE = 192;
+using TapBuffer = std::array<char, TAP_PAYLOAD_SIZE>;
+
+std::string_view encodeHomeKeyTap(TapBuffer& buf, std::span<const uint8_t> issuerId,
+                                  std::span<const uint8_t> endpointId, std::span<const uint8_t> readerId) {
+    return JsonWriter(buf)
+        .addHex("issuerId", issuerId)
+        .addHex("endpointId", endpointId)
+        .addHex("readerId", readerId)
+        .addBool("homekey", true)
+        .finish();
+}
+
+std::string_view encodeUidTap(TapBuffer& buf, std::span<const uint8_t> uid, std::span<const uint8_t> atqa,
+                              uint8_t sak, std::string_view readerId) {
+    return JsonWriter(buf)
+        .addHex("uid", uid)
+        .addBool("homekey", false)
+        .addHex("atqa", atqa)
+        .addHex("sak", {&sak, 1})
+        .addString("readerId", readerId)
+        .finish();
+}
+
+/** @brief Decimal text of @p value in @p buf; MQTT state payloads are plain integers. */
+std::string_view formatInt(std::array<char, 12>& buf, int value) {
+    auto [end, ec] = std::to_chars(buf.data(), buf.data() + buf.size(), value);
+    return {buf.data(), static_cast<size_t>(end - buf.data())};
+}
+
+} // namespace
+
+void MqttManager::buildDispatchTable() {
+    m_routeCount = 0;
+    auto add = [this](const std::string& topic, CommandHandler handler, const char* name) {
+        if (topic.empty() || m_routeCount == m_routes.size()) return;
+        m_routes[m_routeCount++] = {fnv1a(topic.data(), topic.size()), &topic, handler, nullptr, name};
+    };
+    add(m_mqttConfig.lockStateCmd, &MqttManager::onLockStateCmd, "lockStateCmd");
+    add(m_mqttConfig.lockTStateCmd, &MqttManager::onTargetStateCmd, "lockTStateCmd");
+    add(m_mqttConfig.lockCStateCmd, &MqttManager::onCurrentStateCmd, "lockCStateCmd");
+    add(m_mqttConfig.btrLvlCmdTopic, &MqttManager::onBatteryLevelCmd, "btrLvlCmdTopic");
+    if (m_mqttConfig.lockEnableCustomState) {
+        add(m_mqttConfig.lockCustomStateCmd, &MqttManager::onCustomStateCmd, "lockCustomStateCmd");
+    }
+    if (m_mqttConfig.hassMqttDiscoveryEnabled && m_routeCount < m_routes.size()) {
+        m_routes[m_routeCount++] = {fnv1a(HASS_STATUS_TOPIC.data(), HASS_STATUS_TOPIC.size()), &HASS_STATUS_TOPIC,
+                                    nullptr, &MqttManager::onHassStatus, "hassStatus"};
+    }
+
+    m_customStateByValue.fill(NO_CUSTOM_STATE);
+    for (size_t i = std::size(CUSTOM_STATES); i-- > 0;) {
+        auto it = m_mqttConfig.customLockStates.find(CUSTOM_STATES[i].key);
+        if (it != m_mqttConfig.customLockStates.end()) m_customStateByValue[it->second] = i;
+    }
+    m_fragmentRoute = nullptr;
+}
+
+const MqttManager::CommandRoute* MqttManager::findRoute(const char* topic, size_t len) const {
+    const uint32_t hash = fnv1a(topic, len);
+    for (size_t i = 0; i < m_routeCount; i++) {
+        const CommandRoute& r = m_routes[i];
+        if (r.hash == hash && r.topic->size() == len && memcmp(r.topic->data(), topic, len) == 0) return &r;
     }
+    return nullptr;
 }
 
 /**
- * @brief Translate received MQTT command messages into internal EventBus events.
+ * @brief Route a received MQTT message to its command handler.
  *
- * Processes configured MQTT command topics (lock state/target/current/custom and battery level)
- * and publishes the corresponding EventLockState or HomeKit events onto the EventBus.
+ * The topic is looked up in the table built by buildDispatchTable(). Single-part payloads
+ * are parsed straight from the event buffer. A payload split over several data events
+ * is collected in a small fixed buffer first. The topic only comes with the first part,
+ * so the route found then is kept until the last part arrives. Nothing is allocated.
  *
- * @param topic MQTT topic of the received message (used to determine the command).
- * @param data Payload of the received message as a string (interpreted per-topic).
+ * @param event The MQTT_EVENT_DATA event, possibly one fragment of a larger message.
  */
-void MqttManager::onData(const std::string& topic, const std::string& data) {
-    ESP_LOGI(TAG, "Received message on topic '%s': %s", topic.c_str(), data.c_str());
-    
-    auto to_u8 = [](const std::string &str, uint8_t& out) -> bool {
-      const char* begin = str.c_str(); char* end = nullptr;
-      unsigned long v = strtoul(begin, &end, 10);
-      if(end == begin || v < 0 || v > 255) return false;
-      out = static_cast<uint8_t>(v); return true;
-    };
-    EventLockState s{
-    .source = LockManager::MQTT
-    };
-    std::array<uint8_t, sizeof(EventLockState)> d{};
-    if (topic == m_mqttConfig.lockStateCmd) {
-      uint8_t v; if (!to_u8(data, v)) { ESP_LOGW(TAG, "Invalid lockStateCmd payload: %s", data.c_str()); return; }
-      s.currentState = v;
-      s.targetState = v;
-      size_t d_len = alpaca::serialize(s, d);
-      AppEventLoop::publish(LOCK_EVENT, LOCK_OVERRIDE_STATE, d.data(), d_len);
-    } else if (topic == m_mqttConfig.lockTStateCmd) {
-      uint8_t v; if (!to_u8(data, v)) { ESP_LOGW(TAG, "Invalid lockTStateCmd payload: %s", data.c_str()); return; }
-      s.currentState = LockManager::UNKNOWN;
-      s.targetState = v;
-      size_t d_len = alpaca::serialize(s, d);
-      AppEventLoop::publish(LOCK_EVENT, LOCK_TARGET_STATE_CHANGED, d.data(), d_len);
-    } else if (topic == m_mqttConfig.lockCStateCmd) {
-      uint8_t v; if (!to_u8(data, v)) { ESP_LOGW(TAG, "Invalid lockCStateCmd payload: %s", data.c_str()); return; }
-      s.currentState = v;
-      s.targetState = LockManager::UNKNOWN;
-      size_t d_len = alpaca::serialize(s, d);
-      AppEventLoop::publish(LOCK_EVENT, LOCK_UPDATE_STATE, d.data(), d_len);
-    } else if (m_mqttConfig.lockEnableCustomState &&
-               topic == m_mqttConfig.lockCustomStateCmd) {
-      uint8_t v; if (!to_u8(data, v)) { ESP_LOGW(TAG, "Invalid lockCStateCmd payload: %s", data.c_str()); return; }
-      if (m_mqttConfig.customLockStates.at("C_UNLOCKING") == v) {
-        s.currentState = LockManager::MAX;
-        s.targetState = LockManager::UNLOCKED;
-        size_t d_len = alpaca::serialize(s, d);
-        AppEventLoop::publish(LOCK_EVENT, LOCK_TARGET_STATE_CHANGED, d.data(), d_len);
-      } else if (m_mqttConfig.customLockStates.at("C_LOCKING") == v) {
-        s.currentState = LockManager::MAX;
-        s.targetState = LockManager::LOCKED;
-        size_t d_len = alpaca::serialize(s, d);
-        AppEventLoop::publish(LOCK_EVENT, LOCK_TARGET_STATE_CHANGED, d.data(), d_len);
-      } else if (m_mqttConfig.customLockStates.at("C_UNLOCKED") == v) {
-        s.currentState = LockManager::UNLOCKED;
-        s.targetState = LockManager::UNLOCKED;
-        size_t d_len = alpaca::serialize(s, d);
-        AppEventLoop::publish(LOCK_EVENT, LOCK_OVERRIDE_STATE, d.data(), d_len);
-      } else if (m_mqttConfig.customLockStates.at("C_LOCKED") == v) {
-        s.currentState = LockManager::LOCKED;
-        s.targetState = LockManager::LOCKED;
-        size_t d_len = alpaca::serialize(s, d);
-        AppEventLoop::publish(LOCK_EVENT, LOCK_OVERRIDE_STATE, d.data(), d_len);
-      } else if (m_mqttConfig.customLockStates.at("C_JAMMED") == v) {
-        s.currentState = LockManager::JAMMED;
-        s.targetState = LockManager::MAX;
-        size_t d_len = alpaca::serialize(s, d);
-        AppEventLoop::publish(LOCK_EVENT, LOCK_OVERRIDE_STATE, d.data(), d_len);
-      } else if (m_mqttConfig.customLockStates.at("C_UNKNOWN") == v) {
-        s.currentState = LockManager::UNKNOWN;
-        s.targetState = LockManager::MAX;
-        size_t d_len = alpaca::serialize(s, d);
-        AppEventLoop::publish(LOCK_EVENT, LOCK_OVERRIDE_STATE, d.data(), d_len);
-      }
-    } else if (topic == m_mqttConfig.btrLvlCmdTopic) { 
-        uint8_t v; if (!to_u8(data, v)) { ESP_LOGW(TAG, "Invalid btrLvlCmdTopic payload: %s", data.c_str()); return; }
-        EventValueChanged s{
-          .name = "btrLevel",
-          .oldValue = 0,
-          .newValue = v,
-        };
-        std::vector<uint8_t> d;
-        alpaca::serialize(s, d);
-        HomekitEvent event{.type = HomekitEventType::BTR_PROP_CHANGED, .data = d};
-        std::vector<uint8_t> event_data;
-        alpaca::serialize(event, event_data);
-        AppEventLoop::publish(HK_EVENT, HK_INTERNAL_EVENT, event_data.data(), event_data.size());
+void MqttManager::onData(const esp_mqtt_event_t& event) {
+    if (event.current_data_offset == 0) {
+        m_fragmentRoute = nullptr;
+        const CommandRoute* route = findRoute(event.topic, event.topic_len);
+        if (!route) {
+            ESP_LOGD(TAG, "No handler for topic '%.*s'", event.topic_len, event.topic);
+            return;
+        }
+        if (event.data_len == event.total_data_len) {
+            dispatch(*route, event.data, event.data_len);
+            return;
+        }
+        m_fragmentRoute = route;
+        m_fragmentLen = 0;
+        m_fragmentOverflow = false;
     }
+    if (!m_fragmentRoute) return;
+
+    if (m_fragmentLen + event.data_len > m_fragmentBuf.size()) {
+        m_fragmentOverflow = true;
+    } else {
+        memcpy(m_fragmentBuf.data() + m_fragmentLen, event.data, event.data_len);
+        m_fragmentLen += event.data_len;
+    }
+    if (event.current_data_offset + event.data_len < event.total_data_len) return;
+
+    const CommandRoute& route = *m_fragmentRoute;
+    m_fragmentRoute = nullptr;
+    if (m_fragmentOverflow) {
+        ESP_LOGW(TAG, "Ignoring %d-byte payload on %s", event.total_data_len, route.name);
+        return;
+    }
+    dispatch(route, m_fragmentBuf.data(), m_fragmentLen);
+}
+
+void MqttManager::dispatch(const CommandRoute& route, const char* payload, size_t len) {
+    const int64_t start = esp_timer_get_time();
+    m_metrics.commands.inc();
+    ESP_LOGI(TAG, "Received message on topic '%s': %.*s", route.topic->c_str(), (int)len, payload);
+    if (route.payloadHandler) {
+        (this->*route.payloadHandler)(payload, len);
+        return;
+    }
+    uint8_t value;
+    if (!parseU8(payload, len, value)) {
+        ESP_LOGW(TAG, "Invalid %s payload: %.*s", route.name, (int)len, payload);
+        return;
+    }
+    // Round trips are timed from the oldest unanswered lock command; later ones are answered by the same state.
+    // A stamp that has expired unanswered is replaced rather than reported as a huge round trip later.
+    if (route.handler != &MqttManager::onBatteryLevelCmd) {
+        int64_t pending = m_pendingCommandAt.load();
+        while ((pending == 0 || start - pending > COMMAND_ROUND_TRIP_EXPIRY_US) &&
+               !m_pendingCommandAt.compare_exchange_weak(pending, start)) {
+        }
+    }
+    (this->*route.handler)(value);
+    m_metrics.commandDispatch.observe(static_cast<uint32_t>(esp_timer_get_time() - start));
+}
+
+void MqttManager::onLockStateCmd(uint8_t value) {
+    publishLockEvent(LOCK_OVERRIDE_STATE, value, value);
+}
+
+void MqttManager::onTargetStateCmd(uint8_t value) {
+    publishLockEvent(LOCK_TARGET_STATE_CHANGED, LockManager::UNKNOWN, value);
+}
+
+void MqttManager::onCurrentStateCmd(uint8_t value) {
+    publishLockEvent(LOCK_UPDATE_STATE, value, LockManager::UNKNOWN);
+}
+
+void MqttManager::onCustomStateCmd(uint8_t value) {
+    uint8_t index = m_customStateByValue[value];
+    if (index == NO_CUSTOM_STATE) {
+        ESP_LOGW(TAG, "No custom lock state mapped to %u", value);
+        m_pendingCommandAt.store(0);
+        return;
+    }
+    const CustomStateAction& action = CUSTOM_STATES[index];
+    publishLockEvent(action.event, action.currentState, action.targetState);
+}
+
+/**
+ * @brief Home Assistant came (back) online; it may have lost its retained discovery state.
+ */
+void MqttManager::onHassStatus(const char* payload, size_t len) {
+    if (len == 6 && memcmp(payload, "online", 6) == 0) {
+        publishHassDiscovery(true);
+    }
+}
+
+void MqttManager::onBatteryLevelCmd(uint8_t value) {
+    EventValueChanged s{
+      .name = "btrLevel",
+      .oldValue = 0,
+      .newValue = value,
+    };
+    std::vector<uint8_t> d;
+    alpaca::serialize(s, d);
+    HomekitEvent event{.type = HomekitEventType::BTR_PROP_CHANGED, .data = d};
+    std::vector<uint8_t> event_data;
+    alpaca::serialize(event, event_data);
+    AppEventLoop::publish(HK_EVENT, HK_INTERNAL_EVENT, event_data.data(), event_data.size());
 }
 
 /**
@@ -452,43 +871,43 @@ void MqttManager::onData(const std::string& topic, const std::string& data) {
  */
 
 void MqttManager::publishLockState(const int currentState, const int targetState) {
-    std::string stateStr;
+    std::array<char, 12> buf;
+    int state = currentState;
     if (currentState != targetState) {
-        stateStr = (targetState == LockManager::UNLOCKED) ? std::to_string(LockManager::UNLOCKING) : std::to_string(LockManager::LOCKING);
-    } else {
-        stateStr = std::to_string(currentState);
+        state = (targetState == LockManager::UNLOCKED) ? LockManager::UNLOCKING : LockManager::LOCKING;
     }
-    publish(m_mqttConfig.lockStateTopic, stateStr, 0, true);
+    publish(m_mqttConfig.lockStateTopic, formatInt(buf, state), 0, true, MqttOutbox::Priority::State);
     if(m_mqttConfig.lockEnableCustomState){
-      publish(m_mqttConfig.lockCustomStateTopic, (targetState == LockManager::UNLOCKED) ? std::to_string(m_mqttConfig.customLockActions.at("UNLOCK")) : std::to_string(m_mqttConfig.customLockActions.at("LOCK")));
+      int custom = m_mqttConfig.customLockActions.at((targetState == LockManager::UNLOCKED) ? "UNLOCK" : "LOCK");
+      publish(m_mqttConfig.lockCustomStateTopic, formatInt(buf, custom), 0, false, MqttOutbox::Priority::State);
     }
 }
 
 /**
  * @brief Publish a Home Key Tap event to the configured Home Key MQTT topic.
  *
- * Constructs a JSON payload containing hex-encoded identifiers and a "homekey" flag, then publishes it to the configured Home Key topic.
+ * Encodes a JSON payload containing hex-encoded identifiers and a "homekey" flag into a stack buffer, then publishes it to the configured Home Key topic.
  *
  * @param issuerId Byte sequence of the issuer identifier; encoded as an uppercase hex string in the `issuerId` JSON field.
  * @param endpointId Byte sequence of the endpoint identifier; encoded as an uppercase hex string in the `endpointId` JSON field.
  * @param readerId Byte sequence of the reader identifier; encoded as an uppercase hex string in the `readerId` JSON field.
  */
 void MqttManager::publishHomeKeyTap(const std::vector<uint8_t>& issuerId, const std::vector<uint8_t>& endpointId, const std::vector<uint8_t>& readerId) {
-    std::string payload = JsonBuilder::object()
-        .addString("issuerId", fmt::format("{:02X}", fmt::join(issuerId, "")))
-        .addString("endpointId", fmt::format("{:02X}", fmt::join(endpointId, "")))
-        .addString("readerId", fmt::format("{:02X}", fmt::join(readerId, "")))
-        .addBool("homekey", true)
-        .toStringUnformatted();
-    publish(m_mqttConfig.hkTopic, payload);
+    TapBuffer buf;
+    std::string_view payload = encodeHomeKeyTap(buf, issuerId, endpointId, readerId);
+    if (payload.empty()) {
+        ESP_LOGE(TAG, "HomeKey tap payload exceeds %u bytes, not published", (unsigned)buf.size());
+        return;
+    }
+    publish(m_mqttConfig.hkTopic, payload, 0, false, MqttOutbox::Priority::Access);
 }
 
 /**
  * @brief Publish an NFC tag UID tap payload to the configured Home Key topic.
  *
- * When configured to allow NFC tag publishing, builds a JSON payload containing
+ * When configured to allow NFC tag publishing, encodes a JSON payload containing
  * the tag UID, ATQA, and SAK as uppercase hex strings and a `homekey` flag set
- * to `false`, then publishes it to the manager's configured hkTopic.
+ * to `false` into a stack buffer, then publishes it to the manager's configured hkTopic.
  *
  * @param uid Byte vector of the tag UID to include in the payload.
  * @param atqa Byte vector of the tag ATQA to include in the payload.
@@ -498,27 +917,28 @@ void MqttManager::publishHomeKeyTap(const std::vector<uint8_t>& issuerId, const
  */
 void MqttManager::publishUidTap(const std::vector<uint8_t>& uid, const std::array<uint8_t,2> &atqa, const uint8_t &sak) {
     if(!m_mqttConfig.nfcTagNoPublish){
-      std::string payload = JsonBuilder::object()
-          .addString("uid", fmt::format("{:02X}", fmt::join(uid, "")))
-          .addBool("homekey", false)
-          .addString("atqa", fmt::format("{:02X}", fmt::join(atqa, "")))
-          .addString("sak", fmt::format("{:02X}", sak))
-          .addString("readerId", this->deviceID)
-          .toStringUnformatted();
-      publish(m_mqttConfig.hkTopic, payload);
+      TapBuffer buf;
+      std::string_view payload = encodeUidTap(buf, uid, atqa, sak, this->deviceID);
+      if (payload.empty()) {
+          ESP_LOGE(TAG, "Tag tap payload exceeds %u bytes, not published", (unsigned)buf.size());
+          return;
+      }
+      publish(m_mqttConfig.hkTopic, payload, 0, false, MqttOutbox::Priority::Access);
     } else ESP_LOGW(TAG, "MQTT publishing of Tag UID not enabled, ignoring!");
 }
 
 /**
- * @brief Publish Home Assistant MQTT discovery payloads for the device's lock and (optionally) NFC tag.
+ * @brief Render the Home Assistant MQTT discovery payloads once for this boot.
  *
- * Composes a device descriptor and sends retained, QoS 1 discovery messages to Home Assistant discovery topics
- * so the lock entity and, if enabled, an NFC tag entity are automatically discovered. The lock payload includes
- * state and command topics, payload values for lock states, and the availability topic. The NFC/tag payload
- * includes the topic and a JSON value template for extracting the tag UID.
+ * Builds the device descriptor and one retained document each for the lock entity and
+ * the issuer, endpoint and (unless disabled) NFC tag triggers. Every document keeps a
+ * content hash so publishHassDiscovery() can tell which ones changed since they were
+ * last published. A disabled document keeps its topic with an empty payload and hash 0;
+ * publishing that clears an entity left over from an earlier configuration.
  */
-void MqttManager::publishHassDiscovery() {
-    ESP_LOGI(TAG, "Publishing Home Assistant discovery messages...");
+void MqttManager::renderHassDiscovery() {
+    m_discovery.clear();
+    if (!m_mqttConfig.hassMqttDiscoveryEnabled) return;
 
     cJSON *device = cJSON_CreateObject();
     cJSON *identifiers = cJSON_CreateArray();
@@ -535,10 +955,24 @@ void MqttManager::publishHassDiscovery() {
     cJSON_AddStringToObject(device, "configuration_url", fmt::format("http://{}.local", macStr).c_str());
     cJSON_AddStringToObject(device, "serial_number", macStr.c_str());
 
+    auto add = [this, device](std::string topic, cJSON *doc) {
+        DiscoveryDoc entry{std::move(topic), {}, 0};
+        if (doc) {
+            cJSON_AddItemToObject(doc, "device", cJSON_Duplicate(device, true));
+            char *payload = cJSON_PrintUnformatted(doc);
+            entry.payload = payload;
+            free(payload);
+            cJSON_Delete(doc);
+            std::string keyed = entry.topic + '\n' + entry.payload;
+            entry.hash = fnv1a(keyed.data(), keyed.size());
+            if (entry.hash == 0) entry.hash = 1;
+        }
+        m_discovery.push_back(std::move(entry));
+    };
+
     cJSON *lockPayload = cJSON_CreateObject();
     cJSON_AddStringToObject(lockPayload, "name", "Lock");
     cJSON_AddStringToObject(lockPayload, "unique_id", deviceID.c_str());
-    cJSON_AddItemToObject(lockPayload, "device", cJSON_Duplicate(device, true));
     cJSON_AddStringToObject(lockPayload, "state_topic", m_mqttConfig.lockStateTopic.c_str());
     cJSON_AddStringToObject(lockPayload, "command_topic", m_mqttConfig.lockTStateCmd.c_str());
     cJSON_AddStringToObject(lockPayload, "payload_lock", std::to_string(LockManager::LOCKED).c_str());
@@ -549,58 +983,88 @@ void MqttManager::publishHassDiscovery() {
     cJSON_AddStringToObject(lockPayload, "state_unlocking", std::to_string(LockManager::UNLOCKING).c_str());
     cJSON_AddStringToObject(lockPayload, "state_jammed", std::to_string(LockManager::JAMMED).c_str());
     cJSON_AddStringToObject(lockPayload, "availability_topic", m_mqttConfig.lwtTopic.c_str());
-
-    char *payload_cstr = cJSON_Print(lockPayload);
-    std::string payload(payload_cstr);
-    free(payload_cstr);
-    std::string lockConfigTopic = "homeassistant/lock/" + m_mqttConfig.mqttClientId + "/lock/config";
-    publish(lockConfigTopic, payload, 1, true);
-    cJSON_Delete(lockPayload);
+    add("homeassistant/lock/" + m_mqttConfig.mqttClientId + "/lock/config", lockPayload);
 
     cJSON *issuerPayload = cJSON_CreateObject();
     cJSON_AddStringToObject(issuerPayload, "name", "HomeKey Issuer");
     cJSON_AddStringToObject(issuerPayload, "unique_id", deviceID.c_str());
-    cJSON_AddItemToObject(issuerPayload, "device", cJSON_Duplicate(device, true));
     cJSON_AddStringToObject(issuerPayload, "topic", m_mqttConfig.hkTopic.c_str());
     cJSON_AddStringToObject(issuerPayload, "value_template", "{{ value_json.issuerId }}");
-    char *issuerPayload_cstr = cJSON_Print(issuerPayload);
-    std::string issuerPayload_str(issuerPayload_cstr);
-    free(issuerPayload_cstr);
-    std::string issuerConfigTopic = "homeassistant/tag/" + m_mqttConfig.mqttClientId + "/hk_issuer/config";
-    publish(issuerConfigTopic, issuerPayload_str, 1, true);
-    cJSON_Delete(issuerPayload);
+    add("homeassistant/tag/" + m_mqttConfig.mqttClientId + "/hk_issuer/config", issuerPayload);
 
     cJSON *endpointPayload = cJSON_CreateObject();
     cJSON_AddStringToObject(endpointPayload, "name", "HomeKey Endpoint");
     cJSON_AddStringToObject(endpointPayload, "unique_id", deviceID.c_str());
-    cJSON_AddItemToObject(endpointPayload, "device", cJSON_Duplicate(device, true));
     cJSON_AddStringToObject(endpointPayload, "topic", m_mqttConfig.hkTopic.c_str());
     cJSON_AddStringToObject(endpointPayload, "value_template", "{{ value_json.endpointId }}");
-    char *endpointPayload_cstr = cJSON_Print(endpointPayload);
-    std::string endpointPayload_str(endpointPayload_cstr);
-    free(endpointPayload_cstr);
-    std::string endpointConfigTopic = "homeassistant/tag/" + m_mqttConfig.mqttClientId + "/hk_endpoint/config";
-    publish(endpointConfigTopic, endpointPayload_str, 1, true);
-    cJSON_Delete(endpointPayload);
+    add("homeassistant/tag/" + m_mqttConfig.mqttClientId + "/hk_endpoint/config", endpointPayload);
 
+    cJSON *rfidPayload = nullptr;
     if (!m_mqttConfig.nfcTagNoPublish) {
-        cJSON *rfidPayload = cJSON_CreateObject();
+        rfidPayload = cJSON_CreateObject();
         cJSON_AddStringToObject(rfidPayload, "name", "NFC Tag");
         cJSON_AddStringToObject(rfidPayload, "unique_id", deviceID.c_str());
-        cJSON_AddItemToObject(rfidPayload, "device", cJSON_Duplicate(device, true));
         cJSON_AddStringToObject(rfidPayload, "topic", m_mqttConfig.hkTopic.c_str());
         cJSON_AddStringToObject(rfidPayload, "value_template", "{{ value_json.uid }}");
-        char *payload_cstr = cJSON_Print(rfidPayload);
-        std::string payload(payload_cstr);
-        free(payload_cstr);
-        std::string rfidConfigTopic = "homeassistant/tag/" + m_mqttConfig.mqttClientId + "/rfid/config";
-        publish(rfidConfigTopic, payload, 1, true);
-        cJSON_Delete(rfidPayload);
     }
+    add("homeassistant/tag/" + m_mqttConfig.mqttClientId + "/rfid/config", rfidPayload);
 
     cJSON_Delete(device);
+}
+
+/**
+ * @brief Publish the discovery documents that changed since they were last published.
+ *
+ * The hash of each document the client accepted is kept in NVS (see
+ * onDiscoveryPublished()), so a reconnect, or a reboot with an unchanged configuration
+ * and firmware, sends nothing. A document still queued when the connection or the device
+ * goes down is therefore sent again next time. Changing the device name,
+ * topics or firmware version changes the hashes and republishes only what differs.
+ *
+ * @param force Republish every document, e.g. after the Home Assistant birth message.
+ */
+void MqttManager::publishHassDiscovery(bool force) {
+    nvs_handle_t nvs = 0;
+    const bool haveNvs = nvs_open("SAVED_DATA", NVS_READONLY, &nvs) == ESP_OK;
+    if (!haveNvs) ESP_LOGW(TAG, "NVS unavailable, publishing all discovery documents");
+
+    size_t published = 0;
+    for (size_t i = 0; i < m_discovery.size(); i++) {
+        const DiscoveryDoc &doc = m_discovery[i];
+        char key[16];
+        snprintf(key, sizeof(key), "hassDisc%u", (unsigned)i);
+        uint32_t stored = 0;
+        if (haveNvs) nvs_get_u32(nvs, key, &stored);
+        const bool skip = doc.hash == 0 ? stored == 0 : (haveNvs && !force && stored == doc.hash);
+        if (skip) continue;
+        publish(doc.topic, doc.payload, 1, true, MqttOutbox::Priority::Discovery);
+        published++;
+    }
+    if (haveNvs) nvs_close(nvs);
+    ESP_LOGI(TAG, "HASS discovery: %u of %u document(s) published%s.", (unsigned)published,
+             (unsigned)m_discovery.size(), force ? " (requested by Home Assistant)" : "");
+}
 
-    ESP_LOGI(TAG, "HASS discovery messages published.");
+/**
+ * @brief Record that a discovery document was handed to the client. Called by the drain task.
+ *
+ * Only the rendered payload counts, so an outdated document that was still queued does
+ * not mark the current one as published.
+ */
+void MqttManager::onDiscoveryPublished(const MqttOutbox::Message& msg) {
+    for (size_t i = 0; i < m_discovery.size(); i++) {
+        const DiscoveryDoc &doc = m_discovery[i];
+        if (doc.topic != msg.topic || doc.payload != msg.payload) continue;
+        nvs_handle_t nvs = 0;
+        if (nvs_open("SAVED_DATA", NVS_READWRITE, &nvs) != ESP_OK) return;
+        char key[16];
+        snprintf(key, sizeof(key), "hassDisc%u", (unsigned)i);
+        uint32_t stored = 0;
+        nvs_get_u32(nvs, key, &stored);
+        if (stored != doc.hash && nvs_set_u32(nvs, key, doc.hash) == ESP_OK) nvs_commit(nvs);
+        nvs_close(nvs);
+        return;
+    }
 }
 
 // --- SSL/TLS Configuration Methods ---
@@ -0,0 +1,237 @@
+#include "MqttOutbox.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#ifdef ESP_PLATFORM
+#include "esp_log.h"
+#endif
+
+// ============================================================================
+// MqttOutbox
+// ============================================================================
+
+std::deque<MqttOutbox::Message>::iterator MqttOutbox::find(std::deque<Message> &queue, const std::string &topic) {
+  return std::find_if(queue.begin(), queue.end(), [&](const Message &m) { return m.topic == topic; });
+}
+
+MqttOutbox::PushResult MqttOutbox::push(Message &&msg) {
+  std::deque<Message> &queue = m_queues[index(msg.priority)];
+  if (coalesces(msg.priority)) {
+    auto it = find(queue, msg.topic);
+    if (it != queue.end()) {
+      it->payload = std::move(msg.payload);
+      it->qos = msg.qos;
+      it->retain = msg.retain;
+      return PushResult::Coalesced;
+    }
+  }
+
+  PushResult result = PushResult::Queued;
+  if (m_size >= m_capacity) {
+    size_t victim = m_queues.size();
+    while (victim > 0 && m_queues[victim - 1].empty()) victim--;
+    if (victim == 0 || victim - 1 < index(msg.priority)) return PushResult::Rejected;
+    m_queues[victim - 1].pop_front();
+    m_size--;
+    result = PushResult::Evicted;
+  }
+  queue.push_back(std::move(msg));
+  m_size++;
+  return result;
+}
+
+void MqttOutbox::pushFront(Message &&msg) {
+  std::deque<Message> &queue = m_queues[index(msg.priority)];
+  // A newer value for the same topic arrived while this one was in flight; it wins.
+  if (coalesces(msg.priority) && find(queue, msg.topic) != queue.end()) return;
+  queue.push_front(std::move(msg));
+  m_size++;
+}
+
+std::optional<MqttOutbox::Message> MqttOutbox::pop() {
+  for (auto &queue : m_queues) {
+    if (queue.empty()) continue;
+    Message msg = std::move(queue.front());
+    queue.pop_front();
+    m_size--;
+    return msg;
+  }
+  return std::nullopt;
+}
+
+std::vector<MqttOutbox::Message> MqttOutbox::take(Priority priority) {
+  std::deque<Message> &queue = m_queues[index(priority)];
+  std::vector<Message> out(std::make_move_iterator(queue.begin()), std::make_move_iterator(queue.end()));
+  m_size -= queue.size();
+  queue.clear();
+  return out;
+}
+
+#ifdef ESP_PLATFORM
+// ============================================================================
+// MqttSpool
+// ============================================================================
+
+static const char *TAG = "MqttSpool";
+
+std::string MqttSpool::path(uint32_t seq) const {
+  char name[16];
+  snprintf(name, sizeof(name), "/%08lu", (unsigned long)seq);
+  return std::string(m_dir) + name;
+}
+
+/**
+ * @brief Find the existing segments once per boot; later calls are free.
+ */
+bool MqttSpool::scan() {
+  if (m_scanned) return true;
+  if (!m_fs.exists(m_dir) && !m_fs.mkdir(m_dir)) {
+    ESP_LOGE(TAG, "Cannot create %s", m_dir);
+    return false;
+  }
+  fs::File dir = m_fs.open(m_dir);
+  if (!dir || !dir.isDirectory()) return false;
+
+  uint32_t first = UINT32_MAX, last = 0;
+  size_t total = 0;
+  for (fs::File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+    const char *name = f.name();
+    const char *base = strrchr(name, '/');
+    base = base ? base + 1 : name;
+    char *end = nullptr;
+    unsigned long seq = strtoul(base, &end, 10);
+    if (end == base || *end != '\0' || seq == 0) continue;
+    total += f.size();
+    first = std::min<uint32_t>(first, seq);
+    last = std::max<uint32_t>(last, seq);
+  }
+  if (last != 0) {
+    m_first = first;
+    m_last = last;
+    // The newest segment may end in a record torn by the reset; never append after it.
+    m_lastSize = SEGMENT_BYTES;
+    m_bytes = total;
+    ESP_LOGI(TAG, "Found %lu spooled segment(s), %u bytes", (unsigned long)(last - first + 1), (unsigned)total);
+  } else {
+    m_first = 1;
+    m_last = 0;
+  }
+  m_scanned = true;
+  return true;
+}
+
+bool MqttSpool::empty() { return !scan() || m_first > m_last; }
+
+bool MqttSpool::append(const MqttOutbox::Message &msg) {
+  if (!scan()) return false;
+  const size_t topicLen = msg.topic.size(), payloadLen = msg.payload.size();
+  const size_t recordLen = HEADER_BYTES + topicLen + payloadLen;
+  if (recordLen > SEGMENT_BYTES) {
+    ESP_LOGW(TAG, "Message for %s too large to spool (%u bytes)", msg.topic.c_str(), (unsigned)recordLen);
+    return false;
+  }
+
+  if (m_first > m_last || m_lastSize + recordLen > SEGMENT_BYTES) {
+    if (m_first > m_last) m_first = m_last + 1;
+    m_last++;
+    m_lastSize = 0;
+  }
+  while (m_last - m_first + 1 > MAX_SEGMENTS) {
+    std::string oldest = path(m_first);
+    fs::File f = m_fs.open(oldest.c_str(), "r");
+    size_t size = f ? f.size() : 0;
+    f.close();
+    uint32_t lost = countRecords(m_first);
+    m_fs.remove(oldest.c_str());
+    m_bytes -= std::min(m_bytes, size);
+    m_dropped += lost;
+    m_first++;
+    m_resumeOffset = 0;
+    ESP_LOGW(TAG, "Spool full, dropped %lu oldest message(s)", (unsigned long)lost);
+  }
+
+  std::string file = path(m_last);
+  fs::File f = m_fs.open(file.c_str(), "a");
+  if (!f) {
+    ESP_LOGE(TAG, "Cannot open %s", file.c_str());
+    return false;
+  }
+  const uint8_t header[HEADER_BYTES] = {
+      RECORD_MAGIC,
+      static_cast<uint8_t>((msg.qos & 0x03) | (msg.retain ? 0x04 : 0) | (static_cast<uint8_t>(msg.priority) << 4)),
+      static_cast<uint8_t>(topicLen & 0xFF),
+      static_cast<uint8_t>(topicLen >> 8),
+      static_cast<uint8_t>(payloadLen & 0xFF),
+      static_cast<uint8_t>(payloadLen >> 8),
+  };
+  size_t written = f.write(header, sizeof(header));
+  written += f.write(reinterpret_cast<const uint8_t *>(msg.topic.data()), topicLen);
+  written += f.write(reinterpret_cast<const uint8_t *>(msg.payload.data()), payloadLen);
+  f.close();
+  m_lastSize += written;
+  m_bytes += written;
+  if (written != recordLen) {
+    ESP_LOGE(TAG, "Short write to %s (%u of %u bytes)", file.c_str(), (unsigned)written, (unsigned)recordLen);
+    return false;
+  }
+  return true;
+}
+
+bool MqttSpool::readRecord(fs::File &file, MqttOutbox::Message &msg) {
+  uint8_t header[HEADER_BYTES];
+  if (file.read(header, sizeof(header)) != sizeof(header) || header[0] != RECORD_MAGIC) return false;
+  const size_t topicLen = header[2] | (header[3] << 8);
+  const size_t payloadLen = header[4] | (header[5] << 8);
+  if (topicLen == 0 || HEADER_BYTES + topicLen + payloadLen > SEGMENT_BYTES) return false;
+  msg.qos = header[1] & 0x03;
+  msg.retain = header[1] & 0x04;
+  msg.priority = static_cast<MqttOutbox::Priority>(
+      std::min<uint8_t>(header[1] >> 4, static_cast<uint8_t>(MqttOutbox::Priority::Count) - 1));
+  msg.topic.resize(topicLen);
+  msg.payload.resize(payloadLen);
+  if (file.read(reinterpret_cast<uint8_t *>(msg.topic.data()), topicLen) != topicLen) return false;
+  return file.read(reinterpret_cast<uint8_t *>(msg.payload.data()), payloadLen) == payloadLen;
+}
+
+size_t MqttSpool::countRecords(uint32_t seq) {
+  std::string file = path(seq);
+  fs::File f = m_fs.open(file.c_str(), "r");
+  if (!f) return 0;
+  size_t n = 0;
+  MqttOutbox::Message msg;
+  while (readRecord(f, msg)) n++;
+  return n;
+}
+
+size_t MqttSpool::replay(const Publisher &publish) {
+  if (!scan()) return 0;
+  size_t sent = 0;
+  while (m_first <= m_last) {
+    std::string file = path(m_first);
+    fs::File f = m_fs.open(file.c_str(), "r");
+    size_t size = 0;
+    if (f) {
+      size = f.size();
+      f.seek(m_resumeOffset);
+      MqttOutbox::Message msg;
+      while (true) {
+        size_t offset = f.position();
+        if (!readRecord(f, msg)) break;
+        if (!publish(msg)) {
+          m_resumeOffset = offset;
+          return sent;
+        }
+        sent++;
+      }
+      f.close();
+    }
+    m_fs.remove(file.c_str());
+    m_bytes -= std::min(m_bytes, size);
+    if (m_first == m_last) m_lastSize = 0;
+    m_first++;
+    m_resumeOffset = 0;
+  }
+  return sent;
+}
+#endif
@@ -10,7 +10,11 @@
 #include "Pn7160Reader.hpp"
 #include "St25r3916Reader.hpp"
 #include "hal/gpio_types.h"
+#include "HeapProfiler.hpp"
 #include "magic_enum.hpp"
+#include "MetricsHistory.hpp"
+#include "TapArena.hpp"
+#include "TaskRegistry.hpp"
 #include "utils.hpp"
 
 #include <array>
@@ -24,6 +28,25 @@ const char* NfcManager::TAG = "NfcManager";
 
 static const uint8_t ECP_HEAD[] = { 0x6A, 0x2, 0xCB, 0x2, 0x6, 0x2, 0x11, 0x00 };
 
+// Tap processing time buckets, in milliseconds.
+static constexpr uint32_t TAP_DURATION_BUCKETS_MS[] = { 50, 100, 200, 300, 500, 750, 1000, 2000, 5000 };
+
+/**
+ * @brief Register the NFC series in the metrics registry.
+ */
+NfcManager::Metrics NfcManager::registerMetrics() {
+  auto& r = MetricsRegistry::instance();
+  return Metrics{
+      .homekeyTaps = r.counter("hk_nfc_taps_total", "NFC taps by tag type", "type=\"homekey\""),
+      .genericTaps = r.counter("hk_nfc_taps_total", "NFC taps by tag type", "type=\"generic\""),
+      .authSuccess = r.counter("hk_homekey_auth_total", "HomeKey authentication attempts by result", "result=\"success\""),
+      .authFailure = r.counter("hk_homekey_auth_total", "HomeKey authentication attempts by result", "result=\"failure\""),
+      .authCacheHit = r.counter("hk_homekey_auth_cache_total", "HomeKey taps served from a precomputed auth context", "result=\"hit\""),
+      .authCacheMiss = r.counter("hk_homekey_auth_cache_total", "HomeKey taps served from a precomputed auth context", "result=\"miss\""),
+      .tapDuration = r.histogram("hk_nfc_tap_duration_ms", "Time from tag detection to the end of tap processing", TAP_DURATION_BUCKETS_MS),
+  };
+}
+
 /**
  * @brief Task entry wrapper that invokes an instance's auth precompute task.
  *
@@ -77,7 +100,7 @@ void NfcManager::initAuthPrecompute() {
   // random key material, so a 4096-byte stack left as little as 40 bytes of
   // headroom and intermittently overflowed -- panicking mid-transaction, which
   // the phone reported as a protocol error.
-  BaseType_t ok = xTaskCreateUniversal(authPrecomputeTaskEntry, "hk_auth_precompute", kAuthPrecomputeStackBytes, this, 3, &m_authPrecomputeTaskHandle, 0);
+  BaseType_t ok = TaskRegistry::instance().create(authPrecomputeTaskEntry, "hk_auth_precompute", kAuthPrecomputeStackBytes, this, 3, &m_authPrecomputeTaskHandle, 0);
   if (ok != pdPASS || !m_authPrecomputeTaskHandle) {
     ESP_LOGE(TAG, "Failed to start auth precompute task.");
     m_authPrecomputeTaskHandle = nullptr;
@@ -250,7 +273,8 @@ NfcManager::NfcManager(ReaderDataManager& readerDataManager,
       m_hkAuthPrecomputeEnabled(hkAuthPrecomputeEnabled),
       m_nfcFastPollingEnabled(nfcFastPollingEnabled),
       m_pollingTaskHandle(nullptr),
-      m_retryTaskHandle(nullptr)
+      m_retryTaskHandle(nullptr),
+      m_metrics(registerMetrics())
 {
   std::copy(ECP_HEAD, ECP_HEAD + 8, m_ecpData.begin());
   if (nfcReaderType == ST25R3916) {
@@ -281,8 +305,8 @@ NfcManager::NfcManager(ReaderDataManager& readerDataManager,
     if(ec) { ESP_LOGE(TAG, "Failed to deserialize HomeKit event: %s", ec.message().c_str()); return; }
     switch(hk_event.type) {
       case ACCESSDATA_CHANGED: {
-        const auto readerData = m_readerDataManager.getReaderDataCopy();
-        const auto& readerGid = readerData.reader_gid;
+        const auto readerData = m_readerDataManager.snapshot();
+        const auto& readerGid = readerData->reader_gid;
         if (readerGid.size() == 8) {
             std::copy(ECP_HEAD, ECP_HEAD + 8, m_ecpData.begin());
             memcpy(m_ecpData.data() + 8, readerGid.data(), 8);
@@ -320,8 +344,8 @@ NfcManager::NfcManager(ReaderDataManager& readerDataManager,
  * @return `true` if the NFC polling task was started, `false` otherwise.
  */
 bool NfcManager::begin() {
-    const auto readerData = m_readerDataManager.getReaderDataCopy();
-    const auto& readerGid = readerData.reader_gid;
+    const auto readerData = m_readerDataManager.snapshot();
+    const auto& readerGid = readerData->reader_gid;
     if (readerGid.size() == 8) {
         memcpy(m_ecpData.data() + 8, readerGid.data(), 8);
         Utils::crc16a(m_ecpData.data(), 16, m_ecpData.data() + 16);
@@ -353,6 +377,7 @@ bool NfcManager::begin() {
     	ESP_LOGE(TAG, "Unsupported NFC reader type: %u", m_nfcReaderType);
     	return false;
     }
+    TapArena::instance().reserve(CONFIG_HK_NFC_TAP_ARENA_SIZE);
     if (m_hkAuthPrecomputeEnabled) {
         initAuthPrecompute();
     } else {
@@ -360,7 +385,7 @@ bool NfcManager::begin() {
     }
     ESP_LOGI(TAG, "NFC fast polling: %s", m_nfcFastPollingEnabled ? "enabled" : "disabled");
     ESP_LOGI(TAG, "Starting NFC polling task...");
-		BaseType_t ok = xTaskCreateUniversal(
+		BaseType_t ok = TaskRegistry::instance().create(
 				pollingTaskEntry, "nfc_poll_task", 8192, this, 4, &m_pollingTaskHandle, 1);
 		if (ok != pdPASS || !m_pollingTaskHandle) {
 			ESP_LOGE(TAG, "Failed to create NFC polling task.");
@@ -481,8 +506,13 @@ void NfcManager::pollingTask() {
  * Attempts to select the HomeKey applet on the tag via an APDU select command; if selection succeeds, proceeds with
  * HomeKey authentication handling. If selection fails, reads the tag's UID/ATQA/SAK and processes it as a generic ISO14443A tag.
  * Logs the tag processing duration and releases the reader device state before returning.
+ * mbedTLS allocations made by this task during the tap come from the TapArena. With the heap
+ * profiler built in, the tap's remaining heap allocations are counted as one HeapProfiler::TapWindow.
  */
 void NfcManager::handleTagPresence(const std::vector<uint8_t>& uid, const std::array<uint8_t,2>& atqa, const uint8_t& sak) {
+    // Opened first so that it can choose the arena arm before the arena is activated.
+    HeapProfiler::TapWindow heapWindow;
+    TapArena::Scope arena(TapArena::instance());
     auto startTime = std::chrono::high_resolution_clock::now();
     uint8_t selectAppletCmd[] = { 0x00, 0xA4, 0x04, 0x00, 0x07, 0xA0, 0x00, 0x00, 0x08, 0x58, 0x01, 0x01, 0x00 };
     std::vector<uint8_t> response;
@@ -491,15 +521,20 @@ void NfcManager::handleTagPresence(const std::vector<uint8_t>& uid, const std::a
     // Check for success SW1=0x90, SW2=0x00
     if (ok && response.size() >= 2 && response[response.size() - 2] == 0x90 && response[response.size() - 1] == 0x00) {
         ESP_LOGI(TAG, "HomeKey applet selected successfully.");
+        m_metrics.homekeyTaps.inc();
         handleHomeKeyAuth();
     } else {
         ESP_LOGI(TAG, "Not a HomeKey tag, or failed to select applet.");
         ESP_LOGD(TAG, "Passive target UID: %s (%zu)", fmt::format("{:02X}", fmt::join(uid, "")).c_str(), uid.size());
+        m_metrics.genericTaps.inc();
         handleGenericTag(uid, atqa, sak);
     }
 
     auto stopTime = std::chrono::high_resolution_clock::now();
-    ESP_LOGI(TAG, "Total processing time: %lli ms", std::chrono::duration_cast<std::chrono::milliseconds>(stopTime - startTime).count());
+    const auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(stopTime - startTime).count();
+    m_metrics.tapDuration.observe(static_cast<uint32_t>(elapsedMs));
+    MetricsHistory::instance().recordTap(static_cast<uint32_t>(elapsedMs));
+    ESP_LOGI(TAG, "Total processing time: %lli ms", elapsedMs);
     // Headroom check. This task runs mbedTLS P-256 operations (ECDH, ECDSA) on
     // top of the reader's frame buffers, and an overflow here would look
     // exactly like the observed symptom: a reboot part-way through a
@@ -547,16 +582,18 @@ void NfcManager::waitForTagRemoval() {
  * If HomeKey precomputation is enabled, a precomputed authentication context may be consumed (when
  * generation matches current reader data); otherwise a fresh ("cold") authentication context is used.
  *
- * Side effects: may update ReaderDataManager, publish a HOMEKEY_TAP event on the NFC bus, notify the
- * auth precompute task, and modify internal auth-cache queues.
+ * Side effects: may update ReaderDataManager, run the authorized hook, publish a HOMEKEY_TAP event on
+ * the NFC bus, notify the auth precompute task, and modify internal auth-cache queues.
  */
 void NfcManager::handleHomeKeyAuth() {
-    auto publishAuthResult = [](
+    auto publishAuthResult = [this](
         const AuthContextResult& authResult,
         const std::vector<uint8_t>& readerId
     ) {
         if (authResult.flow != kFlowFailed) {
+            if (m_authorizedHook) m_authorizedHook();
             ESP_LOGI(TAG, "HomeKey authentication successful!");
+            m_metrics.authSuccess.inc();
             EventHKTap s{.status = true, .issuerId = authResult.issuer_id, .endpointId = authResult.endpoint_id, .readerId = readerId };
             std::vector<uint8_t> d;
             alpaca::serialize(s, d);
@@ -566,6 +603,7 @@ void NfcManager::handleHomeKeyAuth() {
             AppEventLoop::publish(NFC_EVENT, NFC_TAP_EVENT, event_data.data(), event_data.size());
         } else {
             ESP_LOGW(TAG, "HomeKey authentication failed.");
+            m_metrics.authFailure.inc();
             EventHKTap s{.status = false, .issuerId = {}, .endpointId = {}, .readerId = {} };
             std::vector<uint8_t> d;
             alpaca::serialize(s, d);
@@ -633,6 +671,7 @@ void NfcManager::handleHomeKeyAuth() {
         const UBaseType_t freeAfter = m_authCtxFreeQueue ? uxQueueMessagesWaiting(m_authCtxFreeQueue) : 0;
         ESP_LOGI(TAG, "Auth cache hit (gen=%u, free=%u->%u, ready=%u->%u).",
                  genNow, freeBefore, freeAfter, readyBefore, readyAfter);
+        m_metrics.authCacheHit.inc();
         if (m_authPrecomputeTaskHandle) {
           xTaskNotifyGive(m_authPrecomputeTaskHandle);
         }
@@ -648,6 +687,7 @@ void NfcManager::handleHomeKeyAuth() {
     }
 
     ESP_LOGI(TAG, "Auth cache miss (gen=%u, free=%u, ready=%u) -> cold init.", genNow, freeBefore, readyBefore);
+    m_metrics.authCacheMiss.inc();
     if (m_authPrecomputeTaskHandle) {
       xTaskNotifyGive(m_authPrecomputeTaskHandle);
     }
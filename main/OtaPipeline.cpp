@@ -0,0 +1,222 @@
+#include "OtaPipeline.hpp"
+#include "esp32-hal.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "MemoryPlacement.hpp"
+#include "TaskRegistry.hpp"
+#include <algorithm>
+
+const char *OtaPipeline::TAG = "OtaPipeline";
+
+// The receiving task runs next to the network stack on core 0; flash work goes to the other core.
+static constexpr BaseType_t WRITER_CORE = 1;
+static constexpr uint32_t WRITER_STACK_SIZE = 6144;
+
+OtaPipeline::OtaPipeline(OtaSink &sink, size_t bufferSize, size_t bufferCount)
+    : m_sink(sink), m_bufferSize(bufferSize), m_bufferCount(bufferCount) {}
+
+OtaPipeline::~OtaPipeline() {
+  abort();
+  if (m_done) vSemaphoreDelete(m_done);
+  if (m_fullQueue) vQueueDelete(m_fullQueue);
+  if (m_freeQueue) vQueueDelete(m_freeQueue);
+  MemoryPlacement::release(m_pool);
+}
+
+bool OtaPipeline::start() {
+  // Received from a socket and written to flash in order; neither needs internal RAM.
+  m_pool = static_cast<uint8_t *>(MemoryPlacement::allocate(MemoryPlacement::Class::Bulk, m_bufferSize * m_bufferCount));
+  m_freeQueue = xQueueCreate(m_bufferCount, sizeof(uint8_t *));
+  // One extra slot so the end-of-stream marker can always be queued.
+  m_fullQueue = xQueueCreate(m_bufferCount + 1, sizeof(Chunk));
+  m_done = xSemaphoreCreateBinary();
+  if (!m_pool || !m_freeQueue || !m_fullQueue || !m_done) {
+    ESP_LOGE(TAG, "Failed to allocate %u x %u byte pipeline buffers", (unsigned)m_bufferCount, (unsigned)m_bufferSize);
+    return false;
+  }
+  for (size_t i = 0; i < m_bufferCount; i++) {
+    uint8_t *buffer = m_pool + i * m_bufferSize;
+    xQueueSend(m_freeQueue, &buffer, 0);
+  }
+  if (TaskRegistry::instance().create(writerTaskEntry, "ota_writer", WRITER_STACK_SIZE, this, 5, nullptr, WRITER_CORE) != pdPASS) {
+    ESP_LOGE(TAG, "Failed to create writer task");
+    return false;
+  }
+  m_running = true;
+  return true;
+}
+
+uint8_t *OtaPipeline::acquire() {
+  uint8_t *buffer = nullptr;
+  int64_t waitStart = esp_timer_get_time();
+  xQueueReceive(m_freeQueue, &buffer, portMAX_DELAY);
+  m_receiveStallUs += static_cast<uint32_t>(esp_timer_get_time() - waitStart);
+  if (m_failed) {
+    release(buffer);
+    return nullptr;
+  }
+  return buffer;
+}
+
+void OtaPipeline::submit(uint8_t *buffer, size_t len) {
+  Chunk chunk{buffer, len};
+  xQueueSend(m_fullQueue, &chunk, portMAX_DELAY);
+  m_submittedBytes += len;
+}
+
+void OtaPipeline::release(uint8_t *buffer) { xQueueSend(m_freeQueue, &buffer, portMAX_DELAY); }
+
+bool OtaPipeline::finish() { return stop(true); }
+
+void OtaPipeline::abort() { stop(false); }
+
+bool OtaPipeline::stop(bool finishSink) {
+  if (!m_running) return m_result;
+  m_finishSink = finishSink;
+  Chunk end{nullptr, 0};
+  xQueueSend(m_fullQueue, &end, portMAX_DELAY);
+  xSemaphoreTake(m_done, portMAX_DELAY);
+  m_running = false;
+  return m_result;
+}
+
+OtaPipeline::Stats OtaPipeline::stats() const {
+  return {m_submittedBytes.load(), m_receiveStallUs.load(), m_writeStallUs.load()};
+}
+
+void OtaPipeline::writerTaskEntry(void *arg) {
+  static_cast<OtaPipeline *>(arg)->writerTask();
+  vTaskDelete(NULL);
+}
+
+void OtaPipeline::writerTask() {
+  Chunk chunk;
+  while (true) {
+    int64_t waitStart = esp_timer_get_time();
+    xQueueReceive(m_fullQueue, &chunk, portMAX_DELAY);
+    m_writeStallUs += static_cast<uint32_t>(esp_timer_get_time() - waitStart);
+    if (!chunk.data) break;
+    if (!m_failed && !m_sink.write(chunk.data, chunk.len)) {
+      ESP_LOGE(TAG, "Sink rejected %u bytes at offset %u", (unsigned)chunk.len,
+               (unsigned)(m_submittedBytes - chunk.len));
+      m_failed = true;
+    }
+    xQueueSend(m_freeQueue, &chunk.data, portMAX_DELAY);
+  }
+  m_result = !m_failed && m_finishSink && m_sink.finish();
+  if (!m_result) m_failed = true;
+  xSemaphoreGive(m_done);
+}
+
+// ============================================================================
+// Flash sinks
+// ============================================================================
+
+OtaFirmwareSink::~OtaFirmwareSink() {
+  if (m_handle) esp_ota_abort(m_handle);
+}
+
+bool OtaFirmwareSink::begin() {
+  esp_err_t err = esp_ota_begin(m_partition, OTA_WITH_SEQUENTIAL_WRITES, &m_handle);
+  if (err != ESP_OK) {
+    ESP_LOGE(OtaPipeline::TAG, "esp_ota_begin failed: %s", esp_err_to_name(err));
+    m_handle = 0;
+    return false;
+  }
+  return true;
+}
+
+bool OtaFirmwareSink::write(const uint8_t *data, size_t len) {
+  esp_err_t err = esp_ota_write(m_handle, data, len);
+  if (err != ESP_OK) {
+    ESP_LOGE(OtaPipeline::TAG, "esp_ota_write failed: %s", esp_err_to_name(err));
+    return false;
+  }
+  m_written += len;
+  return true;
+}
+
+bool OtaFirmwareSink::finish() {
+  esp_err_t err = esp_ota_end(m_handle);
+  m_handle = 0; // released by esp_ota_end regardless of the result
+  if (err != ESP_OK) {
+    ESP_LOGE(OtaPipeline::TAG, "esp_ota_end failed: %s", esp_err_to_name(err));
+    return false;
+  }
+  return true;
+}
+
+bool OtaPartitionSink::write(const uint8_t *data, size_t len) {
+  size_t offset = m_written;
+  if (offset + len > m_partition->size) {
+    ESP_LOGE(OtaPipeline::TAG, "Image exceeds partition %s", m_partition->label);
+    return false;
+  }
+  while (m_erasedEnd < offset + len) {
+    size_t eraseLen = std::min(ERASE_BLOCK, m_partition->size - m_erasedEnd);
+    if (esp_partition_erase_range(m_partition, m_erasedEnd, eraseLen) != ESP_OK) {
+      ESP_LOGE(OtaPipeline::TAG, "Erase failed at 0x%x", (unsigned)m_erasedEnd);
+      return false;
+    }
+    m_erasedEnd += eraseLen;
+  }
+  if (esp_partition_write(m_partition, offset, data, len) != ESP_OK) {
+    ESP_LOGE(OtaPipeline::TAG, "Write failed at 0x%x", (unsigned)offset);
+    return false;
+  }
+  m_written += len;
+  return true;
+}
+
+// ============================================================================
+// Delta update helpers
+// ============================================================================
+
+bool OtaPartitionSource::accept(const DeltaPatcher::Header &header) {
+  if (header.sourceSize > m_partition->size) {
+    ESP_LOGE(OtaPipeline::TAG, "Patch source size %lu exceeds partition %s", (unsigned long)header.sourceSize,
+             m_partition->label);
+    return false;
+  }
+  mbedtls_sha256_context ctx;
+  mbedtls_sha256_init(&ctx);
+  mbedtls_sha256_starts(&ctx, 0);
+  uint8_t buffer[512];
+  bool ok = true;
+  for (size_t offset = 0; ok && offset < header.sourceSize; offset += sizeof(buffer)) {
+    size_t len = std::min(sizeof(buffer), header.sourceSize - offset);
+    ok = esp_partition_read(m_partition, offset, buffer, len) == ESP_OK;
+    if (ok) mbedtls_sha256_update(&ctx, buffer, len);
+  }
+  std::array<uint8_t, 32> digest;
+  mbedtls_sha256_finish(&ctx, digest.data());
+  mbedtls_sha256_free(&ctx);
+  if (!ok || digest != header.sourceSha256) {
+    ESP_LOGE(OtaPipeline::TAG, "Patch base does not match partition %s", m_partition->label);
+    return false;
+  }
+  return true;
+}
+
+bool OtaPartitionSource::read(size_t offset, uint8_t *out, size_t len) {
+  return esp_partition_read(m_partition, offset, out, len) == ESP_OK;
+}
+
+OtaDigestSink::OtaDigestSink(OtaSink &next) : m_next(next) {
+  mbedtls_sha256_init(&m_ctx);
+  mbedtls_sha256_starts(&m_ctx, 0);
+}
+
+OtaDigestSink::~OtaDigestSink() { mbedtls_sha256_free(&m_ctx); }
+
+bool OtaDigestSink::write(const uint8_t *data, size_t len) {
+  if (!m_next.write(data, len)) return false;
+  mbedtls_sha256_update(&m_ctx, data, len);
+  return true;
+}
+
+bool OtaDigestSink::finish() {
+  mbedtls_sha256_finish(&m_ctx, m_digest.data());
+  m_finished = true;
+  return m_next.finish();
+}
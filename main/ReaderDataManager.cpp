@@ -7,6 +7,7 @@
 #include "app_event_loop.hpp"
 #include "eventStructs.hpp"
 #include "msgpack.h"
+#include "MemoryPlacement.hpp"
 
 const char* ReaderDataManager::TAG = "ReaderDataManager";
 const char* ReaderDataManager::NVS_KEY = "READERDATA";
@@ -76,6 +77,23 @@ readerData_t ReaderDataManager::getReaderDataCopy() const {
     return m_readerData;
 }
 
+/**
+ * @brief Returns the shared snapshot of the reader data, building it if the data changed since the last one.
+ *
+ * @return ReaderDataManager::Snapshot Immutable reader data, shared with other callers.
+ */
+ReaderDataManager::Snapshot ReaderDataManager::snapshot() const {
+    std::lock_guard<std::mutex> lock(m_readerDataMutex);
+    if (!m_snapshot) m_snapshot = std::make_shared<const readerData_t>(m_readerData);
+    return m_snapshot;
+}
+
+void ReaderDataManager::changed() {
+    // Holders of the old snapshot keep it; the next snapshot() copies the new data once.
+    m_snapshot.reset();
+    m_generation.fetch_add(1, std::memory_order_release);
+}
+
 /**
  * @brief Accesses the reader's group identifier.
  *
@@ -118,6 +136,7 @@ void ReaderDataManager::load() {
         ESP_LOGI(TAG, "Reader data not found in NVS. Starting with a clean slate.");
         std::lock_guard<std::mutex> lock(m_readerDataMutex);
         m_readerData = {}; // Reset to default
+        changed();
         return;
     }
     if (err != ESP_OK) {
@@ -129,7 +148,7 @@ void ReaderDataManager::load() {
         return;
     }
 
-    std::vector<uint8_t> buffer(required_size);
+    BulkVector<uint8_t> buffer(required_size);
     err = nvs_get_blob(m_nvsHandle, NVS_KEY, buffer.data(), &required_size);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Error (%s) reading blob for key '%s'", esp_err_to_name(err), NVS_KEY);
@@ -145,6 +164,7 @@ void ReaderDataManager::load() {
         unpack_readerData_t(obj, loadedReaderData);
         std::lock_guard<std::mutex> lock(m_readerDataMutex);
         m_readerData = std::move(loadedReaderData);
+        changed();
     } else {
         ESP_LOGE(TAG, "Failed to parse msgpack for reader data. Data may be corrupt.");
     }
@@ -167,15 +187,13 @@ const readerData_t* ReaderDataManager::saveData() {
         ESP_LOGE(TAG, "Cannot save, not initialized.");
         return nullptr;
     }
-    const readerData_t readerDataSnapshot = getReaderDataCopy();
-    msgpack_sbuffer sbuf;
+    const Snapshot readerDataSnapshot = snapshot();
+    BulkVector<uint8_t> blob;
     msgpack_packer pk;
-    msgpack_sbuffer_init(&sbuf);
-    msgpack_packer_init(&pk, &sbuf, msgpack_sbuffer_write);
-    pack_readerData_t(&pk, readerDataSnapshot);
+    msgpack_packer_init(&pk, &blob, MemoryPlacement::appendToBulk);
+    pack_readerData_t(&pk, *readerDataSnapshot);
 
-    esp_err_t set_err = nvs_set_blob(m_nvsHandle, NVS_KEY, sbuf.data, sbuf.size);
-    msgpack_sbuffer_destroy(&sbuf);
+    esp_err_t set_err = nvs_set_blob(m_nvsHandle, NVS_KEY, blob.data(), blob.size());
 
     if (set_err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to set blob in NVS: %s", esp_err_to_name(set_err));
@@ -196,12 +214,15 @@ const readerData_t* ReaderDataManager::saveData() {
  * @brief Replace the in-memory reader data with the supplied data and persist it to NVS.
  *
  * @param newData The reader data to store (replaces the current in-memory state).
+ * @param[out] generation If not null, receives the generation that holds `newData`.
  * @return const readerData_t* Pointer to the stored reader data after a successful save, or `nullptr` on error.
  */
-const readerData_t* ReaderDataManager::updateReaderData(const readerData_t& newData) {
+const readerData_t* ReaderDataManager::updateReaderData(const readerData_t& newData, uint32_t* generation) {
     {
         std::lock_guard<std::mutex> lock(m_readerDataMutex);
         m_readerData = newData;
+        changed();
+        if (generation) *generation = m_generation.load(std::memory_order_relaxed);
     }
     return saveData();
 }
@@ -226,6 +247,7 @@ bool ReaderDataManager::eraseReaderKey() {
         m_readerData.reader_pk = {};
         m_readerData.reader_pk_x = {};
         m_readerData.reader_sk = {};
+        changed();
     }
     ESP_LOGI(TAG, "In-memory reader key cleared.");
 
@@ -252,6 +274,7 @@ bool ReaderDataManager::deleteAllReaderData() {
     {
         std::lock_guard<std::mutex> lock(m_readerDataMutex);
         m_readerData = {};
+        changed();
     }
     ESP_LOGI(TAG, "In-memory reader data cleared.");
 
@@ -301,6 +324,7 @@ bool ReaderDataManager::addIssuerIfNotExists(const std::vector<uint8_t>& issuerI
     newIssuer.issuer_pk.assign(publicKey, publicKey + 32);
 
     m_readerData.issuers.emplace_back(newIssuer);
+    changed();
     return true;
 }
 
@@ -329,6 +353,7 @@ bool ReaderDataManager::removeIssuerIfItExists(const std::vector<uint8_t>& issue
 
     ESP_LOGI(TAG, "Removing issuer.");
     m_readerData.issuers.erase(it);
+    changed();
     return true;
 }
 
@@ -0,0 +1,154 @@
+#include "TapArena.hpp"
+#include <cstring>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "mbedtls/platform.h"
+
+static const char *TAG = "TapArena";
+
+// Arena bytes used by one transaction.
+static constexpr uint32_t TAP_BYTES_BUCKETS[] = { 1024, 2048, 4096, 6144, 8192, 12288, 16384, 24576, 32768 };
+
+TapArena::Metrics TapArena::registerMetrics() {
+  auto &r = MetricsRegistry::instance();
+  return {
+      r.gauge("hk_nfc_arena_capacity_bytes", "Size of the NFC transaction arena"),
+      r.gauge("hk_nfc_arena_peak_bytes", "Most NFC arena bytes used by one transaction since boot"),
+      r.histogram("hk_nfc_arena_tap_bytes", "NFC arena bytes used per transaction", TAP_BYTES_BUCKETS),
+      r.counter("hk_nfc_arena_overflows_total", "mbedTLS allocations in a transaction that fell back to the heap"),
+      r.counter("hk_nfc_arena_pinned_total", "Transactions that ended with NFC arena blocks still allocated"),
+  };
+}
+
+bool TapArena::reserve(size_t bytes) {
+  if (m_base || bytes == 0) return bytes == 0 || m_base;
+#if defined(MBEDTLS_PLATFORM_MEMORY) && !defined(MBEDTLS_PLATFORM_CALLOC_MACRO)
+  m_capacity = bytes & ~(HEADER_BYTES - 1);
+  m_base = static_cast<uint8_t *>(heap_caps_aligned_alloc(HEADER_BYTES, m_capacity, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+  if (!m_base) {
+    ESP_LOGE(TAG, "Failed to reserve %u bytes", (unsigned)m_capacity);
+    m_capacity = 0;
+    return false;
+  }
+  m_metrics.capacity.set(static_cast<int32_t>(m_capacity));
+  mbedtls_platform_set_calloc_free(mbedtlsCalloc, mbedtlsFree);
+  ESP_LOGI(TAG, "Reserved %u bytes for NFC transactions", (unsigned)m_capacity);
+  return true;
+#else
+  ESP_LOGW(TAG, "mbedTLS is built without MBEDTLS_PLATFORM_MEMORY; arena disabled");
+  return false;
+#endif
+}
+
+void TapArena::activate() {
+  if (!m_base || m_bypass.load(std::memory_order_relaxed)) return;
+  m_owner.store(xTaskGetCurrentTaskHandle(), std::memory_order_relaxed);
+  if (m_live.load(std::memory_order_acquire) != 0) {
+    // A previous transaction left blocks behind; carving over them would corrupt their owner.
+    if (!m_pinnedLogged) {
+      ESP_LOGW(TAG, "%u blocks from an earlier transaction are still allocated; using the heap",
+               (unsigned)m_live.load(std::memory_order_relaxed));
+      m_pinnedLogged = true;
+    }
+    return;
+  }
+  reset();
+  m_pinnedLogged = false;
+  m_active.store(true, std::memory_order_release);
+}
+
+void TapArena::deactivate() {
+  if (!m_active.load(std::memory_order_relaxed)) return;
+  m_active.store(false, std::memory_order_release);
+  m_metrics.tapPeak.observe(static_cast<uint32_t>(m_used));
+  if (m_used > m_peak) {
+    m_peak = m_used;
+    m_metrics.peak.set(static_cast<int32_t>(m_peak));
+  }
+  ESP_LOGD(TAG, "Transaction used %u of %u bytes", (unsigned)m_used, (unsigned)m_capacity);
+  if (m_live.load(std::memory_order_acquire) == 0) {
+    reset();
+  } else {
+    m_metrics.pinned.inc();
+  }
+}
+
+void TapArena::reset() {
+  m_used = 0;
+  m_free.fill(nullptr);
+}
+
+void *TapArena::allocate(size_t bytes) {
+  const size_t need = bytes + HEADER_BYTES;
+  uint8_t sizeClass = LARGE_CLASS;
+  size_t blockSize = (need + HEADER_BYTES - 1) & ~(HEADER_BYTES - 1);
+  for (uint8_t i = 0; i < CLASS_SIZES.size(); i++) {
+    if (need <= CLASS_SIZES[i]) {
+      sizeClass = i;
+      blockSize = CLASS_SIZES[i];
+      break;
+    }
+  }
+
+  uint8_t *block;
+  if (sizeClass != LARGE_CLASS && m_free[sizeClass]) {
+    block = reinterpret_cast<uint8_t *>(m_free[sizeClass]);
+    m_free[sizeClass] = m_free[sizeClass]->next;
+  } else if (m_capacity - m_used >= blockSize) {
+    block = m_base + m_used;
+    m_used += blockSize;
+  } else {
+    m_metrics.overflows.inc();
+    return nullptr;
+  }
+  reinterpret_cast<Header *>(block)->sizeClass = sizeClass;
+  m_live.fetch_add(1, std::memory_order_relaxed);
+  void *p = block + HEADER_BYTES;
+  memset(p, 0, bytes);
+  return p;
+}
+
+void TapArena::release(void *p) {
+  uint8_t *block = static_cast<uint8_t *>(p) - HEADER_BYTES;
+  const uint8_t sizeClass = reinterpret_cast<Header *>(block)->sizeClass;
+  // Only the owner touches the free lists; a block freed elsewhere is reclaimed by the next reset.
+  if (sizeClass != LARGE_CLASS && m_active.load(std::memory_order_acquire) &&
+      xTaskGetCurrentTaskHandle() == m_owner.load(std::memory_order_relaxed)) {
+    auto *freed = reinterpret_cast<FreeBlock *>(block);
+    freed->next = m_free[sizeClass];
+    m_free[sizeClass] = freed;
+  }
+  m_live.fetch_sub(1, std::memory_order_release);
+}
+
+void *TapArena::mbedtlsCalloc(size_t count, size_t size) {
+  TapArena &arena = instance();
+  size_t bytes;
+  if (arena.m_active.load(std::memory_order_acquire) &&
+      xTaskGetCurrentTaskHandle() == arena.m_owner.load(std::memory_order_relaxed) &&
+      !__builtin_mul_overflow(count, size, &bytes)) {
+    if (void *p = arena.allocate(bytes)) return p;
+  }
+  return heapCalloc(count, size);
+}
+
+void TapArena::mbedtlsFree(void *p) {
+  if (!p) return;
+  TapArena &arena = instance();
+  if (arena.owns(p)) {
+    arena.release(p);
+  } else {
+    heap_caps_free(p);
+  }
+}
+
+/** @brief The allocation mbedTLS would have made without the arena, per the project's mbedTLS memory setting. */
+void *TapArena::heapCalloc(size_t count, size_t size) {
+#if CONFIG_MBEDTLS_EXTERNAL_MEM_ALLOC
+  return heap_caps_calloc(count, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#elif CONFIG_MBEDTLS_DEFAULT_MEM_ALLOC
+  return calloc(count, size);
+#else
+  return heap_caps_calloc(count, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#endif
+}
@@ -0,0 +1,183 @@
+#include "TaskRegistry.hpp"
+#include <algorithm>
+#include "esp_log.h"
+#include "MetricsRegistry.hpp"
+
+static const char *TAG = "TaskRegistry";
+
+BaseType_t TaskRegistry::create(TaskFunction_t fn, const char *name, uint32_t stackBytes, void *arg,
+                                UBaseType_t priority, TaskHandle_t *handle, BaseType_t core) {
+  if (core < 0 || core >= portNUM_PROCESSORS) core = tskNO_AFFINITY;
+  // Written by the kernel before the task can run, so a task may read its own handle.
+  TaskHandle_t local = nullptr;
+  TaskHandle_t *out = handle ? handle : &local;
+  BaseType_t ok = xTaskCreatePinnedToCore(fn, name, stackBytes, arg, priority, out, core);
+  if (ok != pdPASS) return ok;
+
+  Task *task;
+  {
+    std::lock_guard lock(m_mutex);
+    task = find(name);
+    if (!task) task = add(name);
+    task->handle = *out;
+    task->firmware = true;
+    task->hasRunTime = false;
+    task->core.store(core == tskNO_AFFINITY ? -1 : static_cast<int8_t>(core), std::memory_order_relaxed);
+    task->priority.store(static_cast<uint8_t>(priority), std::memory_order_relaxed);
+    task->stackBytes.store(stackBytes, std::memory_order_relaxed);
+  }
+  registerMetrics(*task, true);
+  return ok;
+}
+
+void TaskRegistry::begin() {
+  if (m_sampleJob != Executor::INVALID_JOB) return;
+#if !configUSE_TRACE_FACILITY
+  ESP_LOGW(TAG, "CONFIG_FREERTOS_USE_TRACE_FACILITY is off; only configured task sizes are reported");
+#else
+  m_sampleJob = Executor::instance().add("job=\"task_sampler\"", [this] {
+    sample();
+    Executor::instance().schedule(m_sampleJob, SAMPLE_INTERVAL_MS);
+  });
+  sample();
+  Executor::instance().schedule(m_sampleJob, SAMPLE_INTERVAL_MS);
+#endif
+}
+
+void TaskRegistry::sample() {
+#if configUSE_TRACE_FACILITY
+  std::vector<Task *> added;
+  {
+    std::lock_guard lock(m_mutex);
+    // Headroom for tasks created between the two calls; if even that is not enough the
+    // call returns 0 and the next sample uses the larger buffer.
+    const size_t capacity = uxTaskGetNumberOfTasks() + 4;
+    if (m_status.size() < capacity) m_status.resize(capacity);
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    const UBaseType_t count = uxTaskGetSystemState(m_status.data(), m_status.size(), &total);
+    if (count == 0) return;
+    // The run time counter measures wall time, which passes on every core at once.
+    const double elapsed = double(configRUN_TIME_COUNTER_TYPE(total - m_lastTotalRunTime)) * portNUM_PROCESSORS;
+    m_lastTotalRunTime = total;
+
+    for (auto &task : m_tasks) task->seen = false;
+    std::vector<Task *> matched(count, nullptr);
+    // Same task as last time: its handle and name both match.
+    for (UBaseType_t i = 0; i < count; i++) {
+      for (auto &task : m_tasks) {
+        if (!task->seen && task->handle == m_status[i].xHandle && task->taskName == m_status[i].pcTaskName) {
+          task->seen = true;
+          matched[i] = task.get();
+          break;
+        }
+      }
+    }
+    // A task that is new, or restarted under a name seen before.
+    for (UBaseType_t i = 0; i < count; i++) {
+      if (matched[i]) continue;
+      const char *name = m_status[i].pcTaskName;
+      Task *task = nullptr;
+      for (auto &t : m_tasks) {
+        if (!t->seen && t->taskName == name) {
+          task = t.get();
+          break;
+        }
+      }
+      if (!task) {
+        task = add(name);
+        added.push_back(task);
+      }
+      task->handle = m_status[i].xHandle;
+      task->hasRunTime = false;
+      task->seen = true;
+      matched[i] = task;
+    }
+
+    for (UBaseType_t i = 0; i < count; i++) {
+      const TaskStatus_t &status = m_status[i];
+      Task &task = *matched[i];
+      task.priority.store(static_cast<uint8_t>(status.uxCurrentPriority), std::memory_order_relaxed);
+      task.stackFreeBytes.store(status.usStackHighWaterMark * sizeof(StackType_t), std::memory_order_relaxed);
+#if configGENERATE_RUN_TIME_STATS
+      if (task.hasRunTime && elapsed > 0) {
+        const double used = double(configRUN_TIME_COUNTER_TYPE(status.ulRunTimeCounter - task.lastRunTime));
+        task.cpuCentiPercent.store(static_cast<uint32_t>(std::min(used / elapsed, 1.0) * 10000),
+                                   std::memory_order_relaxed);
+      }
+      task.lastRunTime = status.ulRunTimeCounter;
+      task.hasRunTime = true;
+#endif
+    }
+    for (auto &task : m_tasks) {
+      if (task->seen) continue;
+      task->handle = nullptr;
+      task->hasRunTime = false;
+      task->cpuCentiPercent.store(0, std::memory_order_relaxed);
+    }
+  }
+  for (Task *task : added) registerMetrics(*task, false);
+#endif
+}
+
+std::vector<TaskRegistry::Info> TaskRegistry::snapshot() {
+  std::vector<Info> out;
+  {
+    std::lock_guard lock(m_mutex);
+    out.reserve(m_tasks.size());
+    for (auto &task : m_tasks) {
+      Info info;
+      info.name = task->name;
+      info.core = task->core.load(std::memory_order_relaxed);
+      info.priority = task->priority.load(std::memory_order_relaxed);
+      info.stackBytes = task->stackBytes.load(std::memory_order_relaxed);
+      info.stackFreeBytes = task->stackFreeBytes.load(std::memory_order_relaxed);
+      info.cpuPercent = task->cpuCentiPercent.load(std::memory_order_relaxed) / 100.0f;
+      info.running = task->handle != nullptr;
+      info.firmware = task->firmware;
+      out.push_back(std::move(info));
+    }
+  }
+  std::sort(out.begin(), out.end(), [](const Info &a, const Info &b) {
+    if (a.firmware != b.firmware) return a.firmware;
+    return a.name < b.name;
+  });
+  return out;
+}
+
+TaskRegistry::Task *TaskRegistry::find(const char *name) {
+  for (auto &task : m_tasks) {
+    if (task->taskName == name) return task.get();
+  }
+  return nullptr;
+}
+
+TaskRegistry::Task *TaskRegistry::add(const char *name) {
+  auto task = std::make_unique<Task>();
+  task->taskName = name;
+  task->name = name;
+  // Two live tasks may share a name (the kernel does not care); number the later ones.
+  for (unsigned n = 2; std::any_of(m_tasks.begin(), m_tasks.end(), [&](auto &t) { return t->name == task->name; });
+       n++) {
+    task->name = std::string(name) + "#" + std::to_string(n);
+  }
+  task->labels = "task=\"" + task->name + "\"";
+  m_tasks.push_back(std::move(task));
+  return m_tasks.back().get();
+}
+
+void TaskRegistry::registerMetrics(Task &task, bool firmware) {
+  auto &registry = MetricsRegistry::instance();
+  const char *labels = task.labels.c_str();
+  Task *t = &task;
+  registry.gauge("hk_task_stack_free_bytes", "Lowest amount of free stack a task has had", labels,
+                 [t] { return double(t->stackFreeBytes.load(std::memory_order_relaxed)); });
+  registry.gauge("hk_task_cpu_percent", "Share of total CPU time a task used over the last sample interval",
+                 labels, [t] { return t->cpuCentiPercent.load(std::memory_order_relaxed) / 100.0; });
+  registry.gauge("hk_task_priority", "Current FreeRTOS priority of a task", labels,
+                 [t] { return double(t->priority.load(std::memory_order_relaxed)); });
+  if (!firmware) return;
+  registry.gauge("hk_task_stack_size_bytes", "Stack size a firmware task was created with", labels,
+                 [t] { return double(t->stackBytes.load(std::memory_order_relaxed)); });
+  registry.gauge("hk_task_core", "Core a firmware task is pinned to, or -1 if it is not pinned", labels,
+                 [t] { return double(t->core.load(std::memory_order_relaxed)); });
+}
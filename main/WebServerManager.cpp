@@ -10,10 +10,20 @@
 #include "fmt/ranges.h"
 #include "WebServerManager.hpp"
 #include "ConfigManager.hpp"
+#include "ConfigPatch.hpp"
+#include "DeltaPatcher.hpp"
+#include "FeedbackPattern.hpp"
+#include "HeapAdmission.hpp"
+#include "HeapProfiler.hpp"
+#include "HeatshrinkDecoder.hpp"
+#include "JsonStreamParser.hpp"
 #include "HomeSpan.h"
+#include "MetricsHistory.hpp"
 #include "MqttManager.hpp"
 #include "NfcManager.hpp"
+#include "OtaPipeline.hpp"
 #include "ReaderDataManager.hpp"
+#include "TaskRegistry.hpp"
 #include "cJSON.h"
 #include "config.hpp"
 #include "esp_chip_info.h"
@@ -27,6 +37,7 @@
 #include "eventStructs.hpp"
 #include "freertos/idf_additions.h"
 #include "loggable.hpp"
+#include "lwip/sockets.h"
 #include "sodium/randombytes.h"
 #include <LittleFS.h>
 #include <algorithm>
@@ -52,6 +63,13 @@ const char *WebServerManager::TAG = "WebServerManager";
 const size_t MAX_WS_PAYLOAD = 8192;
 const size_t HEAP_UPPER_THRESHOLD = 70 * 1000;
 const size_t HEAP_LOWER_THRESHOLD = 50 * 1000;
+// Worker pool for handlers that would otherwise block the httpd task (scans, x509 parsing, saves).
+const uint8_t ASYNC_WORKER_COUNT = 2;
+const uint8_t ASYNC_QUEUE_LENGTH = 4;
+const uint32_t ASYNC_WORKER_STACK_SIZE = 6144;
+// Metric pushes ignore changes smaller than these; uptime is only sent in snapshots.
+const uint32_t METRICS_HEAP_DEADBAND = 1024;
+const int METRICS_RSSI_DEADBAND = 3;
 
 // ============================================================================
 // Helper Functions
@@ -108,7 +126,8 @@ inline bool decideNfcPin(uint8_t incoming_pin,
 WebServerManager::WebServerManager(ConfigManager &configManager,
                                    ReaderDataManager &readerDataManager)
     : m_server(nullptr), m_configManager(configManager),
-      m_readerDataManager(readerDataManager), m_mqttManager(nullptr), m_nfcManager(nullptr) {
+      m_readerDataManager(readerDataManager), m_mqttManager(nullptr), m_nfcManager(nullptr),
+      m_metrics(registerMetrics()) {
 }
 
 /**
@@ -122,15 +141,22 @@ WebServerManager::WebServerManager(ConfigManager &configManager,
 WebServerManager::~WebServerManager() {
   ESP_LOGI(TAG, "WebServerManager destructor called");
 
+  stopAsyncWorkers();
   if (m_server) {
     httpd_stop(m_server);
     m_server = nullptr;
   }
+  releaseAsyncWorkers();
   if (m_statusTimer) {
     esp_timer_stop(m_statusTimer);
     esp_timer_delete(m_statusTimer);
     m_statusTimer = nullptr;
   }
+  if (m_historyTimer) {
+    esp_timer_stop(m_historyTimer);
+    esp_timer_delete(m_historyTimer);
+    m_historyTimer = nullptr;
+  }
 }
 
 bool WebServerManager::shouldEnableHttps() const {
@@ -167,6 +193,30 @@ esp_err_t WebServerManager::sendJsonError(httpd_req_t *req, const std::string &m
   return ESP_OK;
 }
 
+/**
+ * @brief Reject a request with 503 Service Unavailable and a Retry-After hint.
+ */
+esp_err_t WebServerManager::sendBusy(httpd_req_t *req, const char *msg, uint8_t retryAfterSeconds) {
+  char retryAfter[4];
+  snprintf(retryAfter, sizeof(retryAfter), "%u", retryAfterSeconds);
+  httpd_resp_set_hdr(req, "Retry-After", retryAfter);
+  return sendJsonError(req, msg, "503 Service Unavailable");
+}
+
+/**
+ * @brief Reserve heap for a heavy operation, answering 503 when the controller says no.
+ * @return An engaged reservation to hold for the duration of the operation; when empty,
+ *         the response has already been sent.
+ */
+HeapAdmission::Reservation WebServerManager::admitOrBusy(httpd_req_t *req, HeapAdmission::Op op, uint32_t bytes) {
+  HeapAdmission::Reservation reservation = HeapAdmission::instance().reserve(op, bytes);
+  if (!reservation) {
+    sendBusy(req, "Not enough free memory right now, try again shortly",
+             HeapAdmission::profile(op).retryAfterSeconds);
+  }
+  return reservation;
+}
+
 std::string ownerConflictMsg(int pin, const std::string &key, const std::string &owner) {
   return std::to_string(pin) + " for \"" + key + "\" already owned by \"" + owner + "\".";
 }
@@ -257,21 +307,20 @@ void WebServerManager::begin() {
       return;
     }
   }
-  m_wsQueue = xQueueCreate(20, sizeof(WsFrame *));
+  // The frame queue and its send job outlive end()/begin(), so they are only created once.
   if (!m_wsQueue) {
-    ESP_LOGE(TAG, "Failed to create WebSocket queue");
-    httpd_stop(m_server);
-    m_server = nullptr;
-    return;
+    m_wsQueue = xQueueCreate(20, sizeof(WsFrame *));
+    if (!m_wsQueue) {
+      ESP_LOGE(TAG, "Failed to create WebSocket queue");
+      httpd_stop(m_server);
+      m_server = nullptr;
+      return;
+    }
+    m_wsSendJob = Executor::instance().add("job=\"ws_send\"", [this] { sendQueuedWsFrames(); });
   }
 
-  if (xTaskCreate(ws_send_task, "ws_send_task", 4096, this, 2,
-                  &m_wsTaskHandle) != pdPASS) {
-    ESP_LOGE(TAG, "Failed to create WebSocket task");
-    vQueueDelete(m_wsQueue);
-    httpd_stop(m_server);
-    m_server = nullptr;
-    return;
+  if (!startAsyncWorkers()) {
+    ESP_LOGE(TAG, "Failed to start async request workers, heavy routes will run inline");
   }
 
   if (isApMode) {
@@ -286,6 +335,18 @@ void WebServerManager::begin() {
     ESP_LOGE(TAG, "Failed to create status timer");
   }
 
+  // History keeps sampling across end()/begin(), so it is only created once.
+  if (!m_historyTimer) {
+    esp_timer_create_args_t historyArgs = {
+        .callback = &historyTimerCallback, .arg = this, .name = "metricsHistory"};
+    if (esp_timer_create(&historyArgs, &m_historyTimer) == ESP_OK) {
+      esp_timer_start_periodic(m_historyTimer, 1000 * 1000);
+    } else {
+      ESP_LOGE(TAG, "Failed to create metrics history timer");
+      m_historyTimer = nullptr;
+    }
+  }
+
   ESP_LOGI(TAG, "Web server initialization complete");
 
   m_isInitialized = true;
@@ -302,20 +363,20 @@ void WebServerManager::end() {
 
   if(!m_isInitialized) return;
 
+  stopAsyncWorkers();
+
   if (m_server) {
     httpd_ssl_stop(m_server);
     ESP_LOGI(TAG, "HTTP Server stopped!");
     m_server = nullptr;
   }
-
-  if (m_wsTaskHandle) {
-    vTaskDelete(m_wsTaskHandle);
-    m_wsTaskHandle = nullptr;
-  }
+  releaseAsyncWorkers();
 
   if (m_wsQueue) {
-    vQueueDelete(m_wsQueue);
-    m_wsQueue = nullptr;
+    WsFrame *frame = nullptr;
+    while (xQueueReceive(m_wsQueue, &frame, 0) == pdTRUE) {
+      WsFramePtr discard(frame);
+    }
   }
 
   if (m_statusTimer) {
@@ -362,13 +423,19 @@ esp_err_t WebServerManager::ws_post_handshake_cb(httpd_req_t *req) {
 
   int sockfd = httpd_req_to_sockfd(req);
   ESP_LOGI(TAG, "WebSocket connection established: fd=%d", sockfd);
+  // Frames are sent from the shared executor, so a client that stops reading must fail
+  // fast instead of blocking it for the server's send_wait_timeout.
+  const timeval sendTimeout = {.tv_sec = 0, .tv_usec = suseconds_t(WS_SEND_TIMEOUT_MS * 1000)};
+  if (setsockopt(sockfd, SOL_SOCKET, SO_SNDTIMEO, &sendTimeout, sizeof(sendTimeout)) != 0) {
+    ESP_LOGW(TAG, "Could not set WebSocket send timeout on fd=%d (errno %d)", sockfd, errno);
+  }
   instance->addWebSocketClient(sockfd);
 
   // Send initial device status & metrics
   std::string status = instance->getDeviceInfo();
   instance->queue_ws_frame(sockfd, (const uint8_t *)status.c_str(),
                            status.size(), HTTPD_WS_TYPE_TEXT);
-  std::string metrics = instance->getDeviceMetrics();
+  std::string metrics = instance->metricsSnapshot(sockfd, METRICS_ALL, false);
   instance->queue_ws_frame(sockfd, (const uint8_t *)metrics.c_str(),
                            metrics.size(), HTTPD_WS_TYPE_TEXT);
 
@@ -377,8 +444,25 @@ esp_err_t WebServerManager::ws_post_handshake_cb(httpd_req_t *req) {
   }
 
   if(!instance->m_wsBroadcastBuffer.empty()){
+    // Every replayed frame is copied into the send queue before the first one goes out. Only
+    // the internal RAM share is reserved: with PSRAM, payloads past the inline buffer go there.
+    const bool payloadsInPsram = MemoryPlacement::psramAvailable();
+    uint32_t backlogBytes = 0;
     for (auto &v : instance->m_wsBroadcastBuffer) {
-      instance->queue_ws_frame(sockfd, v.data(), v.size(), HTTPD_WS_TYPE_TEXT);
+      backlogBytes += sizeof(WsFrame);
+      if (!payloadsInPsram && v.size() > WsFrame::INLINE_SIZE) backlogBytes += v.size();
+    }
+    auto heap = std::make_shared<HeapAdmission::Reservation>(
+        HeapAdmission::instance().reserve(HeapAdmission::Op::WsBacklogReplay, backlogBytes));
+    if (!*heap) {
+      // Keep the backlog for the next client rather than risk the heap on it now.
+      ESP_LOGW(TAG, "Skipping backlog replay to fd=%d (%lu bytes), low memory", sockfd,
+               (unsigned long)backlogBytes);
+      return ESP_OK;
+    }
+    // Each frame holds the reservation, so it is returned once the last one is sent or dropped.
+    for (auto &v : instance->m_wsBroadcastBuffer) {
+      instance->queue_ws_frame(sockfd, v.data(), v.size(), HTTPD_WS_TYPE_TEXT, heap);
     }
     instance->m_wsBroadcastBuffer.clear();
   }
@@ -395,6 +479,7 @@ void WebServerManager::setupRoutes() {
     esp_err_t (*handler)(httpd_req_t *);
     void *ctx;
     bool is_ws = false;
+    uint8_t asyncLimit = 0; // > 0: run on the worker pool with at most this many in flight
   };
 
   RouteConfig routes[] = {
@@ -405,7 +490,7 @@ void WebServerManager::setupRoutes() {
       // Configuration endpoints
       {"/config", HTTP_GET, handleGetConfig, this},
       {"/config/clear", HTTP_POST, handleClearConfig, this},
-      {"/config/save", HTTP_POST, handleSaveConfig, this},
+      {"/config/save", HTTP_POST, handleSaveConfig, this, false, 1},
       {"/eth_get_config", HTTP_GET, handleGetEthConfig, this},
       {"/nfc_get_presets", HTTP_GET, handleGetNfcPresets, this},
 
@@ -422,10 +507,16 @@ void WebServerManager::setupRoutes() {
       {"/ota/*", HTTP_POST, handleOTAUpload, this},
 
       // Certificate endpoints
-      {"/certificates", HTTP_POST, handleCertificateUpload, this},
-      {"/certificates", HTTP_GET, handleCertificateStatus, this},
+      {"/certificates", HTTP_POST, handleCertificateUpload, this, false, 1},
+      {"/certificates", HTTP_GET, handleCertificateStatus, this, false, 1},
       {"/certificates", HTTP_DELETE, handleCertificateDelete, this},
 
+      // Prometheus scrape endpoint
+      {"/metrics", HTTP_GET, handleMetrics, this},
+      {"/metrics/history", HTTP_GET, handleMetricsHistory, this},
+      {"/metrics/tasks", HTTP_GET, handleMetricsTasks, this},
+      {"/metrics/heap", HTTP_GET, handleMetricsHeap, this},
+
       // Catch-all (must be last)
       {"/*", HTTP_GET, handleRootOrHash, this}};
 
@@ -440,10 +531,7 @@ void WebServerManager::setupRoutes() {
       uri.ws_post_handshake_cb = ws_post_handshake_cb;
     }
 #endif
-    esp_err_t err = httpd_register_uri_handler(m_server, &uri);
-    if (err != ESP_OK) {
-      ESP_LOGE(TAG, "Failed to register URI %s: %s", r.uri, esp_err_to_name(err));
-    }
+    registerRoute(uri, r.asyncLimit);
   }
   ESP_LOGI(TAG, "Routes setup complete");
 }
@@ -460,15 +548,16 @@ void WebServerManager::setupCaptivePortalRoutes() {
     httpd_method_t method;
     esp_err_t (*handler)(httpd_req_t *);
     void *ctx;
+    uint8_t asyncLimit = 0;
   };
 
   RouteConfig routes[] = {
       // Captive portal API endpoints
       {"/captive_portal_config", HTTP_GET, handleGetCaptivePortalConfig, this},
-      {"/captive_portal_config", HTTP_POST, handleSaveCaptivePortalConfig, this},
+      {"/captive_portal_config", HTTP_POST, handleSaveCaptivePortalConfig, this, 1},
       {"/nfc_get_presets", HTTP_GET, handleGetNfcPresets, this},
       {"/eth_get_config", HTTP_GET, handleGetEthConfig, this},
-      {"/wifi_scan", HTTP_GET, handleWifiScan, this},
+      {"/wifi_scan", HTTP_GET, handleWifiScan, this, 1},
       {"/reboot_device", HTTP_POST, handleReboot, this},
       // Static files needed for the captive portal UI
       {"/static/*", HTTP_GET, handleStaticFiles, this},
@@ -488,14 +577,167 @@ void WebServerManager::setupCaptivePortalRoutes() {
                        .is_websocket = false,
                        .handle_ws_control_frames = false,
                        .supported_subprotocol = nullptr};
-    esp_err_t err = httpd_register_uri_handler(m_server, &uri);
-    if (err != ESP_OK) {
-      ESP_LOGE(TAG, "Failed to register captive portal URI %s: %s", r.uri, esp_err_to_name(err));
-    }
+    registerRoute(uri, r.asyncLimit);
   }
   ESP_LOGI(TAG, "Captive portal routes setup complete");
 }
 
+/**
+ * @brief Register a URI handler, routing it through the async worker pool when @p asyncLimit > 0.
+ *
+ * Async routes get an AsyncRoute as their httpd user context so the dispatcher knows which
+ * handler to run and how many requests for it may be in flight.
+ */
+void WebServerManager::registerRoute(httpd_uri_t &uri, uint8_t asyncLimit) {
+  if (asyncLimit > 0 && m_asyncQueue) {
+    auto route = std::make_unique<AsyncRoute>();
+    route->handler = uri.handler;
+    route->instance = this;
+    route->maxConcurrent = asyncLimit;
+    uri.handler = dispatchAsync;
+    uri.user_ctx = route.get();
+    m_asyncRoutes.push_back(std::move(route));
+  }
+  esp_err_t err = httpd_register_uri_handler(m_server, &uri);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to register URI %s: %s", uri.uri, esp_err_to_name(err));
+  }
+}
+
+// ============================================================================
+// Async Request Workers
+// ============================================================================
+
+bool WebServerManager::startAsyncWorkers() {
+  m_asyncQueue = xQueueCreate(ASYNC_QUEUE_LENGTH, sizeof(AsyncJob));
+  m_asyncWorkersDone = xSemaphoreCreateCounting(ASYNC_WORKER_COUNT, 0);
+  // No async route is registered yet, so nothing can dispatch into what is released here.
+  if (!m_asyncQueue || !m_asyncWorkersDone) {
+    releaseAsyncWorkers();
+    return false;
+  }
+  for (uint8_t i = 0; i < ASYNC_WORKER_COUNT; i++) {
+    // Numbered so each worker gets its own TaskRegistry record.
+    char name[configMAX_TASK_NAME_LEN];
+    snprintf(name, sizeof(name), "http_worker%u", (unsigned)i);
+    if (TaskRegistry::instance().create(asyncWorkerTask, name, ASYNC_WORKER_STACK_SIZE, this, 4) != pdPASS) {
+      break;
+    }
+    m_asyncWorkerCount++;
+  }
+  if (m_asyncWorkerCount == 0) {
+    releaseAsyncWorkers();
+    return false;
+  }
+  m_asyncAccepting = true;
+  return true;
+}
+
+/**
+ * @brief Let each worker finish its current request, reject queued ones, and wait for the workers to exit.
+ *
+ * Runs while the server is still up: a detached request holds its httpd session until
+ * httpd_req_async_handler_complete(), so it must finish before httpd is stopped. The queue and
+ * routes stay valid, because async handlers remain registered until the server stops; call
+ * releaseAsyncWorkers() after that.
+ */
+void WebServerManager::stopAsyncWorkers() {
+  m_asyncAccepting = false;
+  if (m_server) {
+    // dispatchAsync() only runs on the httpd task. Once a no-op queued behind it has run, no
+    // dispatch that saw m_asyncAccepting still set is left to enqueue after the stop markers.
+    if (SemaphoreHandle_t fence = xSemaphoreCreateBinary()) {
+      if (httpd_queue_work(m_server, [](void *done) { xSemaphoreGive(static_cast<SemaphoreHandle_t>(done)); },
+                           fence) == ESP_OK) {
+        xSemaphoreTake(fence, pdMS_TO_TICKS(1000));
+      }
+      vSemaphoreDelete(fence);
+    }
+  }
+  if (m_asyncQueue && m_asyncWorkerCount > 0) {
+    AsyncJob job;
+    while (xQueueReceive(m_asyncQueue, &job, 0) == pdTRUE) {
+      sendBusy(job.req, "Server is shutting down");
+      job.route->active--;
+      httpd_req_async_handler_complete(job.req);
+    }
+    for (uint8_t i = 0; i < m_asyncWorkerCount; i++) {
+      AsyncJob stop{nullptr, nullptr};
+      xQueueSend(m_asyncQueue, &stop, portMAX_DELAY);
+    }
+    for (uint8_t i = 0; i < m_asyncWorkerCount; i++) {
+      xSemaphoreTake(m_asyncWorkersDone, portMAX_DELAY);
+    }
+  }
+  m_asyncWorkerCount = 0;
+}
+
+/**
+ * @brief Free the async queue and routes. Only once httpd is stopped, as they are its handlers' context.
+ */
+void WebServerManager::releaseAsyncWorkers() {
+  if (m_asyncQueue) {
+    vQueueDelete(m_asyncQueue);
+    m_asyncQueue = nullptr;
+  }
+  if (m_asyncWorkersDone) {
+    vSemaphoreDelete(m_asyncWorkersDone);
+    m_asyncWorkersDone = nullptr;
+  }
+  m_asyncRoutes.clear();
+}
+
+/**
+ * @brief httpd entry point for async routes: detach the request and queue it for a worker.
+ *
+ * Runs on the httpd task and never blocks. Requests over the route's concurrency limit,
+ * or arriving while the queue is full, are answered with 503 and Retry-After.
+ */
+esp_err_t WebServerManager::dispatchAsync(httpd_req_t *req) {
+  AsyncRoute *route = static_cast<AsyncRoute *>(req->user_ctx);
+  WebServerManager *instance = route->instance;
+
+  if (!instance->m_asyncAccepting) return sendBusy(req, "Server is shutting down");
+
+  if (route->active.fetch_add(1) >= route->maxConcurrent) {
+    route->active--;
+    return sendBusy(req, "Another request of this kind is in progress");
+  }
+
+  httpd_req_t *asyncReq = nullptr;
+  if (httpd_req_async_handler_begin(req, &asyncReq) != ESP_OK) {
+    route->active--;
+    return sendJsonError(req, "Failed to schedule request", "500 Internal Server Error");
+  }
+
+  AsyncJob job{asyncReq, route};
+  if (xQueueSend(instance->m_asyncQueue, &job, 0) != pdTRUE) {
+    route->active--;
+    sendBusy(asyncReq, "Server busy");
+    httpd_req_async_handler_complete(asyncReq);
+  }
+  return ESP_OK;
+}
+
+void WebServerManager::asyncWorkerTask(void *arg) {
+  WebServerManager *instance = static_cast<WebServerManager *>(arg);
+  AsyncJob job;
+  while (xQueueReceive(instance->m_asyncQueue, &job, portMAX_DELAY) == pdTRUE && job.req) {
+    // Handlers resolve their instance through getInstance(), which expects it as the user context.
+    job.req->user_ctx = instance;
+    int sockfd = httpd_req_to_sockfd(job.req);
+    esp_err_t ret = job.route->handler(job.req);
+    job.route->active--;
+    httpd_req_async_handler_complete(job.req);
+    // Mirror httpd: a handler returning an error closes the connection.
+    if (ret != ESP_OK) {
+      httpd_sess_trigger_close(instance->m_server, sockfd);
+    }
+  }
+  xSemaphoreGive(instance->m_asyncWorkersDone);
+  vTaskDelete(NULL);
+}
+
 // ============================================================================
 // Utility Methods
 // ============================================================================
@@ -689,17 +931,17 @@ esp_err_t WebServerManager::handleGetConfig(httpd_req_t *req) {
     responseJson =
         instance->m_configManager.serializeToJson<espConfig::actions_config_t>();
   } else if (type == "hkinfo") {
-    const auto readerData = instance->m_readerDataManager.getReaderDataCopy();
+    const auto readerData = instance->m_readerDataManager.snapshot();
     cJSON *hkInfo = cJSON_CreateObject();
     cJSON_AddStringToObject(
         hkInfo, "group_identifier",
-        fmt::format("{:02X}", fmt::join(readerData.reader_gid, "")).c_str());
+        fmt::format("{:02X}", fmt::join(readerData->reader_gid, "")).c_str());
     cJSON_AddStringToObject(
         hkInfo, "unique_identifier",
-        fmt::format("{:02X}", fmt::join(readerData.reader_id, "")).c_str());
+        fmt::format("{:02X}", fmt::join(readerData->reader_id, "")).c_str());
 
     cJSON *issuersArray = cJSON_CreateArray();
-    for (const auto &issuer : readerData.issuers) {
+    for (const auto &issuer : readerData->issuers) {
       cJSON *issuerJson = cJSON_CreateObject();
       cJSON_AddStringToObject(
           issuerJson, "issuerId",
@@ -843,14 +1085,12 @@ esp_err_t WebServerManager::handleGetEthConfig(httpd_req_t *req) {
 /**
  * @brief Handle an HTTP request to save a configuration object for a given config type.
  *
- * Processes the request's "type" query parameter and JSON body, validates the payload
- * against the current configuration schema, applies updates, persists the configuration,
- * publishes relevant configuration change events, and sends an appropriate JSON HTTP response.
- * May trigger a device reboot when certain configuration keys change.
+ * Processes the request's "type" query parameter and dispatches to saveConfigSection
+ * for the selected configuration struct.
  *
  * @param req The HTTP request containing the query parameter `type=<mqtt|misc|actions>` and
  *            a JSON body with the configuration fields to update.
- * @return esp_err_t `ESP_OK` if the configuration was saved and applied; `ESP_FAIL` otherwise.
+ * @return esp_err_t `ESP_OK` if a response was sent; `ESP_FAIL` if the connection failed.
  */
 esp_err_t WebServerManager::handleSaveConfig(httpd_req_t *req) {
   WebServerManager *instance = getInstance(req);
@@ -869,74 +1109,118 @@ esp_err_t WebServerManager::handleSaveConfig(httpd_req_t *req) {
     return sendJsonError(req, "Missing 'type' parameter");
   }
 
+  HeapAdmission::Reservation heap = admitOrBusy(req, HeapAdmission::Op::ConfigSave);
+  if (!heap) {
+    return ESP_OK;
+  }
+
+  std::string type = type_param;
+  if (type == "mqtt") {
+    return saveConfigSection<espConfig::mqttConfig_t>(req, instance);
+  } else if (type == "misc") {
+    return saveConfigSection<espConfig::misc_config_t>(req, instance);
+  } else if (type == "actions") {
+    return saveConfigSection<espConfig::actions_config_t>(req, instance);
+  }
+  return sendJsonError(req, "Invalid 'type' parameter");
+}
+
+/**
+ * @brief Stream the request body through the JSON tokenizer into a config patch.
+ *
+ * The body is received in small chunks and fed to a JsonStreamParser whose events
+ * are matched against the compile-time field table of @p ConfigType, so no document
+ * tree is built and peak memory is bounded by the longest single value.
+ *
+ * @param req The HTTP request whose body holds a JSON object of config fields.
+ * @param builder Receives the parsed fields; holds the patch on success.
+ * @return esp_err_t `ESP_OK` on success, `ESP_ERR_INVALID_ARG` if the body was rejected
+ *         (an error response has already been sent), `ESP_FAIL` if receiving failed.
+ */
+template <typename ConfigType>
+esp_err_t WebServerManager::receiveConfigPatch(httpd_req_t *req,
+                                               espConfig::fields::ConfigPatchBuilder<ConfigType> &builder) {
   const size_t max_content_size = 2048;
   if (req->content_len >= max_content_size) {
-    return sendJsonError(req, "Request body too large", "413 Payload Too Large");
+    sendJsonError(req, "Request body too large", "413 Payload Too Large");
+    return ESP_ERR_INVALID_ARG;
   }
 
-  std::vector<char> content(max_content_size, 0);
-  int ret = httpd_req_recv(req, content.data(), content.size() - 1);
-  if (ret <= 0) {
-    // recv itself failed — the socket may already be broken, so let the
-    // framework close it rather than risk sending on a dead connection.
-    return ESP_FAIL;
-  }
-  content[ret] = '\0';
+  std::array<char, 256> token;
+  std::array<char, 128> chunk;
+  JsonStreamParser parser(builder, token.data(), token.size());
 
-  cJSON *obj = cJSON_Parse(content.data());
-  if (!obj) {
-    instance->sendJsonError(req, "Invalid JSON");
+  size_t remaining = req->content_len;
+  while (remaining > 0) {
+    int ret = httpd_req_recv(req, chunk.data(), std::min(remaining, chunk.size()));
+    if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+      continue;
+    }
+    if (ret <= 0) {
+      // recv itself failed — the socket may already be broken, so let the
+      // framework close it rather than risk sending on a dead connection.
+      return ESP_FAIL;
+    }
+    remaining -= ret;
+    if (!parser.feed(chunk.data(), ret)) {
+      break;
+    }
+  }
+  if (parser.error() == JsonStreamParser::Error::None && parser.finish()) {
     return ESP_OK;
   }
 
-  std::string type = type_param;
-  cJSON *configSchema = nullptr;
-
-  if (type == "mqtt") {
-    std::string s =
-        instance->m_configManager.serializeToJson<espConfig::mqttConfig_t>();
-    configSchema = cJSON_Parse(s.c_str());
-  } else if (type == "misc") {
-    std::string s =
-        instance->m_configManager.serializeToJson<espConfig::misc_config_t>();
-    configSchema = cJSON_Parse(s.c_str());
-  } else if (type == "actions") {
-    std::string s =
-        instance->m_configManager.serializeToJson<espConfig::actions_config_t>();
-    configSchema = cJSON_Parse(s.c_str());
+  if (parser.error() == JsonStreamParser::Error::Aborted) {
+    sendJsonError(req, builder.error());
   } else {
-    cJSON_Delete(obj);
-    return sendJsonError(req, "Invalid 'type' parameter");
+    ESP_LOGW(TAG, "Config body rejected: %s at offset %zu", parser.errorString(), parser.position());
+    sendJsonError(req, "Invalid JSON");
   }
+  return ESP_ERR_INVALID_ARG;
+}
 
-  if (!validateRequest(req, configSchema, obj)) {
-    cJSON_Delete(configSchema);
-    cJSON_Delete(obj);
-    return ESP_OK;   // validateRequest already sent a full error response
+/**
+ * @brief Parse, validate, apply and persist one configuration section.
+ *
+ * Publishes the configuration change events for every field whose value actually
+ * changed and reboots when the section or a changed key requires it.
+ */
+template <typename ConfigType>
+esp_err_t WebServerManager::saveConfigSection(httpd_req_t *req, WebServerManager *instance) {
+  using namespace espConfig::fields;
+  ConfigManager &configManager = instance->m_configManager;
+  const ConfigType &current = configManager.getConfig<ConfigType>();
+
+  ConfigPatchBuilder<ConfigType> builder(current);
+  esp_err_t err = receiveConfigPatch(req, builder);
+  if (err == ESP_FAIL) {
+    return ESP_FAIL;
+  }
+  if (err != ESP_OK) {
+    return ESP_OK;   // receiveConfigPatch already sent a full error response
   }
 
-  bool success = false, rebootNeeded = false;
-  std::string rebootMsg, errorMsg;
-
-  cJSON *it = obj->child;
-  if (it == NULL) {
-    cJSON_Delete(configSchema);
-    cJSON_Delete(obj);
+  ConfigPatch<ConfigType> &patch = builder.patch();
+  if (patch.empty()) {
     return sendJsonError(req, "Received empty object, nothing to save");
   }
-  char *data_str = cJSON_PrintUnformatted(obj);
-  std::string result;
-  while (it) {
-    cJSON *configSchemaItem = cJSON_GetObjectItem(configSchema, it->string);
-    if (cJSON_Compare(it, configSchemaItem, true)) {
-      it = it->next;
+  if (!validatePatch(req, current, patch)) {
+    return ESP_OK;   // validatePatch already sent a full error response
+  }
+
+  bool success = false, rebootNeeded = false, clearDumbSwitchMode = false;
+  std::string rebootMsg, errorMsg;
+
+  for (const auto &change : patch) {
+    const auto &field = *change.field;
+    if (equals(current, field, change.value)) {
       continue;
     }
 
-    const std::string keyStr = it->string;
+    const std::string keyStr(field.name);
 
     if (keyStr == "setupCode") {
-      EventValueChanged s{.name = keyStr, .str = it->valuestring};
+      EventValueChanged s{.name = keyStr, .str = std::get<std::string>(change.value)};
       std::vector<uint8_t> d;
       alpaca::serialize(s, d);
       HomekitEvent event{.type = HomekitEventType::SETUP_CODE_CHANGED,
@@ -947,19 +1231,20 @@ esp_err_t WebServerManager::handleSaveConfig(httpd_req_t *req) {
     } else if (keyStr == "nfcNeopixelPin") {
       rebootNeeded = true;
       rebootMsg = "Pixel GPIO pin changed, reboot needed! Rebooting...";
-    } else if (str_ends_with(keyStr.c_str(), "Pin")) {
+    } else if (field.has(F_GPIO) && field.type() == FieldType::U8) {
+      const uint8_t newPin = std::get<uint8_t>(change.value);
       EventValueChanged s{.name = keyStr,
-                          .oldValue = (uint8_t)configSchemaItem->valueint,
-                          .newValue = (uint8_t)it->valueint};
+                          .oldValue = *get<uint8_t>(current, field),
+                          .newValue = newPin};
       std::vector<uint8_t> d;
       alpaca::serialize(s, d);
       AppEventLoop::publish(HW_EVENT, HW_CONFIG_CHANGED, d.data(), d.size());
-      if (keyStr == "gpioActionPin" && it->valueint != 255 && cJSON_IsTrue(cJSON_GetObjectItem(configSchema, "hkDumbSwitchMode"))) {
-        cJSON_AddBoolToObject(obj, "hkDumbSwitchMode",false);
+      if (keyStr == "gpioActionPin" && newPin != 255) {
+        clearDumbSwitchMode = true;
       }
     } else if (keyStr == "btrLowStatusThreshold") {
       EventValueChanged s{.name = "btrLowThreshold",
-                          .newValue = (uint8_t)it->valueint};
+                          .newValue = std::get<uint8_t>(change.value)};
       std::vector<uint8_t> d;
       alpaca::serialize(s, d);
       HomekitEvent event{.type = HomekitEventType::BTR_PROP_CHANGED, .data = d};
@@ -969,45 +1254,47 @@ esp_err_t WebServerManager::handleSaveConfig(httpd_req_t *req) {
     } else if (keyStr == "neoPixelType") {
       rebootNeeded = true;
       rebootMsg = "Pixel Type changed, reboot needed! Rebooting...";
+    } else if (keyStr == "feedbackPatterns") {
+      EventValueChanged s{.name = keyStr, .str = std::get<std::string>(change.value)};
+      std::vector<uint8_t> d;
+      alpaca::serialize(s, d);
+      AppEventLoop::publish(HW_EVENT, HW_CONFIG_CHANGED, d.data(), d.size());
     }
-    it = it->next;
   }
 
-  if (type == "mqtt") {
-    result = instance->m_configManager.updateFromJson<espConfig::mqttConfig_t>(data_str);
-    if (!result.empty()) {
-      success = instance->m_configManager.saveConfig<espConfig::mqttConfig_t>();
+  if constexpr (std::is_same_v<ConfigType, espConfig::actions_config_t>) {
+    if (clearDumbSwitchMode && current.hkDumbSwitchMode) {
+      patch.set(*find<ConfigType>("hkDumbSwitchMode"), false);
+    }
+  }
+
+  std::string result = configManager.applyPatch(patch);
+  if (!result.empty()) {
+    success = configManager.saveConfig<ConfigType>();
+    if constexpr (std::is_same_v<ConfigType, espConfig::mqttConfig_t>) {
       rebootNeeded = true;
       rebootMsg = "MQTT config saved, reboot needed! Rebooting...";
-    }
-  } else if (type == "misc") {
-    result = instance->m_configManager.updateFromJson<espConfig::misc_config_t>(data_str);
-    if (!result.empty()) {
-      success =
-          instance->m_configManager.saveConfig<espConfig::misc_config_t>();
+    } else if constexpr (std::is_same_v<ConfigType, espConfig::misc_config_t>) {
       rebootNeeded = true;
       rebootMsg = "Misc config saved, reboot needed! Rebooting...";
     }
-  } else if (type == "actions") {
-    result = instance->m_configManager.updateFromJson<espConfig::actions_config_t>(data_str);
-    if (!result.empty()) {
-      success =
-          instance->m_configManager.saveConfig<espConfig::actions_config_t>();
-    }
   }
 
-  cJSON_free(data_str);
-  cJSON_Delete(configSchema);
-  cJSON_Delete(obj);
-
   if (success) {
+    // The section is already serialized; send it as "data" as-is rather than parsing it
+    // back into a cJSON tree just to print it again.
     httpd_resp_set_type(req, "application/json");
-    cJSON *res = cJSON_CreateObject();
-    cJSON_AddItemToObject(res, "success", cJSON_CreateBool(true));
-    cJSON_AddItemToObject(res, "message", cJSON_CreateString(rebootNeeded ? rebootMsg.c_str() : "Saved and applied!"));
-    cJSON_AddItemToObject(res, "data", cJSON_Parse(result.c_str()));
-    std::string response = cjson_to_string_and_free(res);
-    httpd_resp_send(req, response.c_str(), HTTPD_RESP_USE_STRLEN);
+    cJSON *head = cJSON_CreateObject();
+    cJSON_AddItemToObject(head, "success", cJSON_CreateBool(true));
+    cJSON_AddItemToObject(head, "message", cJSON_CreateString(rebootNeeded ? rebootMsg.c_str() : "Saved and applied!"));
+    std::string prefix = cjson_to_string_and_free(head);
+    if (prefix.empty()) prefix = "{";
+    else prefix.back() = ',';   // Reopen the object for "data".
+    prefix += "\"data\":";
+    httpd_resp_send_chunk(req, prefix.c_str(), prefix.size());
+    httpd_resp_send_chunk(req, result.c_str(), result.size());
+    httpd_resp_send_chunk(req, "}", 1);
+    httpd_resp_send_chunk(req, nullptr, 0);
     if (rebootNeeded) {
       vTaskDelay(pdMS_TO_TICKS(1000));
       esp_restart();
@@ -1024,59 +1311,32 @@ esp_err_t WebServerManager::handleSaveConfig(httpd_req_t *req) {
   return ESP_OK;
 }
 
-bool WebServerManager::validateRequest(httpd_req_t *req, cJSON *currentData,
-                                       cJSON *obj) {
-  bool overrideStrapping = false;
-  cJSON *ovrStrItem = cJSON_GetObjectItem(obj, "overrideStrappingRestriction");
-  if (!ovrStrItem) ovrStrItem = cJSON_GetObjectItem(currentData, "overrideStrappingRestriction");
+/**
+ * @brief Apply the cross-field and device-state rules that the field table cannot express.
+ *
+ * Types and numeric bounds were already enforced while parsing; this checks the setup
+ * code, GPIO validity and ownership, and the heap guards for TLS features.
+ *
+ * @return true if the patch may be applied; false after sending an error response.
+ */
+template <typename ConfigType>
+bool WebServerManager::validatePatch(httpd_req_t *req, const ConfigType &current,
+                                     const espConfig::fields::ConfigPatch<ConfigType> &patch) {
+  using namespace espConfig::fields;
+  const ConfigManager &configManager = getInstance(req)->m_configManager;
 
-  if (ovrStrItem) {
-    overrideStrapping = cJSON_IsBool(ovrStrItem) && cJSON_IsTrue(ovrStrItem);
-  } else {
-    overrideStrapping = getInstance(req)->m_configManager
-        .getConfig<espConfig::misc_config_t>().overrideStrappingRestriction;
-  }
-
-  cJSON *it = obj->child;
-  while (it) {
-    std::string keyStr = it->string;
-    cJSON *existingValue = cJSON_GetObjectItem(currentData, keyStr.c_str());
-
-    if (!existingValue) {
-      std::string msg = "\"" + keyStr + "\" is not a valid configuration key.";
-      sendJsonError(req, msg);
-      return false;
-    }
-
-    // Type validation
-    cJSON *incomingValue = it;
-    bool typeOk = false;
-    if (cJSON_IsString(existingValue))
-      typeOk = cJSON_IsString(incomingValue);
-    else if (cJSON_IsObject(existingValue))
-      typeOk = cJSON_IsObject(incomingValue);
-    else if (cJSON_IsArray(existingValue))
-      typeOk = cJSON_IsArray(incomingValue);
-    else if (cJSON_IsBool(existingValue))
-      typeOk = cJSON_IsBool(incomingValue) ||
-               (cJSON_IsNumber(incomingValue) &&
-                (incomingValue->valueint == 0 || incomingValue->valueint == 1));
-    else if (cJSON_IsNumber(existingValue))
-      typeOk = cJSON_IsNumber(incomingValue);
-
-    if (!typeOk) {
-      char *valueStr = cJSON_PrintUnformatted(incomingValue);
-      std::string msg = "Invalid type for key \"" + keyStr +
-                        "\". Received: " + std::string(valueStr);
-      free(valueStr);
-      sendJsonError(req, msg);
-      return false;
-    }
+  bool overrideStrapping = configManager.getConfig<espConfig::misc_config_t>().overrideStrappingRestriction;
+  if (const bool *ovr = patch.template get<bool>("overrideStrappingRestriction")) {
+    overrideStrapping = *ovr;
+  }
+
+  for (const auto &change : patch) {
+    const auto &field = *change.field;
+    const std::string keyStr(field.name);
 
     // Setup code validation
     if (keyStr == "setupCode") {
-      // Type check above already guarantees cJSON_IsString
-      std::string code = incomingValue->valuestring;
+      const std::string &code = std::get<std::string>(change.value);
       if (code.length() != 8 ||
           std::find_if(code.begin(), code.end(), [](unsigned char c) {
             return !std::isdigit(c);
@@ -1095,24 +1355,22 @@ bool WebServerManager::validateRequest(httpd_req_t *req, cJSON *currentData,
         return false;
       }
       if (homeSpan.controllerListBegin() != homeSpan.controllerListEnd() &&
-          code.compare(cJSON_GetStringValue(existingValue)) != 0) {
+          code != *get<std::string>(current, field)) {
         sendJsonError(req, "Setup Code can only be set if no devices are paired");
         return false;
       }
     }
-    // Pin validation
-    else if (str_ends_with(keyStr.c_str(), "Pin")) {
-      // Reject anything outside uint8_t range BEFORE truncating, so a value
-      // like 256 can't wrap to a valid-looking pin (0) and slip past both
-      // the GPIO-validity check and the ownership check below.
-      if (incomingValue->valueint < 0 || incomingValue->valueint > 255) {
-        std::string msg = std::to_string(incomingValue->valueint) +
-                          " is not a valid GPIO Pin for \"" + keyStr + "\".";
-        sendJsonError(req, msg);
+    else if (keyStr == "feedbackPatterns") {
+      feedback::Overrides overrides;
+      std::string error;
+      if (!feedback::parse(std::get<std::string>(change.value), overrides, &error)) {
+        sendJsonError(req, error);
         return false;
       }
-
-      const uint8_t incomingPin = static_cast<uint8_t>(incomingValue->valueint);
+    }
+    // Pin validation
+    else if (field.has(F_GPIO) && field.type() == FieldType::U8) {
+      const uint8_t incomingPin = std::get<uint8_t>(change.value);
 
       // Fix: Should use || instead of && because output is a strict subset of input.
       if (incomingPin != 255 && (!GPIO_IS_VALID_GPIO(incomingPin) ||
@@ -1123,106 +1381,61 @@ bool WebServerManager::validateRequest(httpd_req_t *req, cJSON *currentData,
         return false;
       }
 
-      const uint8_t currentPin   = (cJSON_IsNumber(existingValue) &&
-                                    existingValue->valueint >= 0 &&
-                                    existingValue->valueint <= 255)
-                                        ? static_cast<uint8_t>(existingValue->valueint)
-                                        : uint8_t{255};
+      const uint8_t currentPin   = *get<uint8_t>(current, field);
       const bool    isNfcScalar  = (keyStr == "nfcIrqPin" || keyStr == "nfcVenPin");
       auto          currentOwner = GPIOAllocator::instance().owner_of(incomingPin);
 
       if (isNfcScalar) {
-        auto decision = decideNfcPin(incomingPin, currentPin, currentOwner, overrideStrapping);
-        if (!decision) {
-          std::string msg = std::to_string(incomingPin) +
-                            " for \"" + keyStr + "\" already owned by \"" +
-                            currentOwner.value() + "\".";
-          sendJsonError(req, msg);
+        if (!decideNfcPin(incomingPin, currentPin, currentOwner, overrideStrapping)) {
+          sendJsonError(req, ownerConflictMsg(incomingPin, keyStr, currentOwner.value()));
           return false;
         }
       } else if (incomingPin != currentPin && currentOwner.has_value()) {
         bool isAllowedStrapping = (currentOwner == "STRAPPING" && overrideStrapping);
         bool isAllowedSPI = currentOwner->contains("SPI"); // Unify behavior with array elements
         if (!isAllowedStrapping && !isAllowedSPI) {
-          std::string msg = std::to_string(incomingPin) +
-                            " for \"" + keyStr + "\" already owned by \"" +
-                            currentOwner.value() + "\".";
-          sendJsonError(req, msg);
+          sendJsonError(req, ownerConflictMsg(incomingPin, keyStr, currentOwner.value()));
           return false;
         }
       }
-    } else if (keyStr == "ethSpiBus" && cJSON_IsNumber(incomingValue) && (incomingValue->valueint < SPI2_HOST || incomingValue->valueint >= SPI_HOST_MAX)){
-        std::string msg = std::to_string(incomingValue->valueint) +
-                      " is not a valid SPI Bus value";
-        sendJsonError(req, msg);
-        return false;
-    } else if ((str_ends_with(keyStr.c_str(), "Pins") || str_ends_with(keyStr.c_str(), "SpiConfig")) && cJSON_IsArray(incomingValue)){
+    } else if (field.has(F_GPIO)) {
       const bool isNfcArray = (keyStr == "nfcGpioPins");
-      cJSON *currentArr = cJSON_GetObjectItem(currentData, keyStr.c_str());
-      cJSON *el = NULL;
-      int idx = 0;
-      cJSON_ArrayForEach(el, incomingValue) {
-        if (cJSON_IsNumber(el)) {
-          if (idx == 0 && keyStr == "ethSpiConfig") { idx++; continue; }
-
-          // Reject out-of-range values before truncating so a wrapped value
-          // can't slip past the ownership lookup below.
-          if (el->valueint < 0 || el->valueint > 255) {
-            std::string msg = std::to_string(el->valueint) +
-                              " is not a valid GPIO Pin for \"" + keyStr + "\".";
-            sendJsonError(req, msg);
+      const FieldValue existing = load(current, field);
+      const auto currentArr = bytes(existing);
+      const auto incomingArr = bytes(change.value);
+      for (size_t idx = 0; idx < incomingArr.size(); ++idx) {
+        if (idx == 0 && field.has(F_FIRST_NOT_GPIO)) continue;
+
+        const uint8_t elPin = incomingArr[idx];
+        const uint8_t currentPin = idx < currentArr.size() ? currentArr[idx] : uint8_t{255};
+        auto currentOwner = GPIOAllocator::instance().owner_of(elPin);
+
+        if (isNfcArray) {
+          if (!decideNfcPin(elPin, currentPin, currentOwner, overrideStrapping)) {
+            sendJsonError(req, ownerConflictMsg(elPin, keyStr, currentOwner.value()));
             return false;
           }
-          const uint8_t elPin = static_cast<uint8_t>(el->valueint);
-
-          uint8_t currentPin = 255;
-          if (currentArr && cJSON_IsArray(currentArr)) {
-            cJSON *ce = cJSON_GetArrayItem(currentArr, idx);
-            if (ce && cJSON_IsNumber(ce) && ce->valueint >= 0 && ce->valueint <= 255)
-              currentPin = static_cast<uint8_t>(ce->valueint);
-          }
-          auto currentOwner = GPIOAllocator::instance().owner_of(elPin);
-
-          if (isNfcArray) {
-            auto decision = decideNfcPin(elPin, currentPin, currentOwner, overrideStrapping);
-            if (!decision) {
-              std::string msg = std::to_string(elPin) +
-                                " for \"" + keyStr + "\" already owned by \"" +
-                                currentOwner.value() + "\".";
-              sendJsonError(req, msg);
-              return false;
-            }
-          } else if (elPin != currentPin && currentOwner.has_value()) {
-            bool isAllowedSPI = currentOwner->contains("SPI");
-            bool isAllowedStrapping = (currentOwner == "STRAPPING" && overrideStrapping);
-            if (!isAllowedSPI && !isAllowedStrapping) {
-              std::string msg = std::to_string(elPin) +
-                                " for \"" + keyStr + "\" already owned by \"" +
-                                currentOwner.value() + "\".";
-              sendJsonError(req, msg);
-              return false;
-            }
+        } else if (elPin != currentPin && currentOwner.has_value()) {
+          bool isAllowedSPI = currentOwner->contains("SPI");
+          bool isAllowedStrapping = (currentOwner == "STRAPPING" && overrideStrapping);
+          if (!isAllowedSPI && !isAllowedStrapping) {
+            sendJsonError(req, ownerConflictMsg(elPin, keyStr, currentOwner.value()));
+            return false;
           }
         }
-        idx++;
       }
     }
     // --- Heap Memory Guard Checks ---
-    if (keyStr == "webHttpsEnabled" && cJSON_IsTrue(it)) {
-      bool mqttSsl = getInstance(req)->m_configManager.getConfig<espConfig::mqttConfig_t>().useSSL;
+    const bool *enabled = std::get_if<bool>(&change.value);
+    if (keyStr == "webHttpsEnabled" && enabled && *enabled) {
+      bool mqttSsl = configManager.getConfig<espConfig::mqttConfig_t>().useSSL;
       if (!heapGuardOk(req, mqttSsl, "HTTPS", "MQTT SSL")) { return false; }
-    } else if (keyStr == "useSSL" && cJSON_IsTrue(it)) {
-      bool https = getInstance(req)->m_configManager.getConfig<espConfig::misc_config_t>().webHttpsEnabled;
+    } else if (keyStr == "useSSL" && enabled && *enabled) {
+      bool https = configManager.getConfig<espConfig::misc_config_t>().webHttpsEnabled;
       if (!heapGuardOk(req, https, "MQTT SSL", "HTTPS")) { return false; }
     }
-
-    if (cJSON_IsBool(existingValue) && cJSON_IsNumber(incomingValue)) {
-      cJSON_SetBoolValue(incomingValue, incomingValue->valueint);
-    }
-    
-    it = it->next;
   }
-  
+
   return true;
 }
 
@@ -1435,136 +1648,45 @@ esp_err_t WebServerManager::handleSaveCaptivePortalConfig(httpd_req_t *req) {
     return ESP_FAIL;
   }
 
-  const size_t max_content_size = 2048;
-  if (req->content_len >= max_content_size) {
-    httpd_resp_set_status(req, "413 Payload Too Large");
-    httpd_resp_set_type(req, "application/json");
-    cJSON *res = cJSON_CreateObject();
-    cJSON_AddItemToObject(res, "success", cJSON_CreateBool(false));
-    cJSON_AddItemToObject(res, "error", cJSON_CreateString("Request body too large"));
-    std::string response = cjson_to_string_and_free(res);
-    httpd_resp_send(req, response.c_str(), HTTPD_RESP_USE_STRLEN);
-    return ESP_FAIL;
-  }
-
-  std::vector<char> content(max_content_size, 0);
-  int ret = httpd_req_recv(req, content.data(), content.size() - 1);
-  if (ret <= 0) {
-    httpd_resp_set_status(req, "400 Bad Request");
-    httpd_resp_set_type(req, "application/json");
-    cJSON *res = cJSON_CreateObject();
-    cJSON_AddItemToObject(res, "success", cJSON_CreateBool(false));
-    cJSON_AddItemToObject(res, "error", cJSON_CreateString("Invalid request body"));
-    std::string response = cjson_to_string_and_free(res);
-    httpd_resp_send(req, response.c_str(), HTTPD_RESP_USE_STRLEN);
-    return ESP_FAIL;
+  HeapAdmission::Reservation heap = admitOrBusy(req, HeapAdmission::Op::ConfigSave);
+  if (!heap) {
+    return ESP_OK;
   }
-  content[ret] = '\0';
 
-  cJSON *obj = cJSON_Parse(content.data());
-  if (!obj) {
-    httpd_resp_set_status(req, "400 Bad Request");
-    httpd_resp_set_type(req, "application/json");
-    cJSON *res = cJSON_CreateObject();
-    cJSON_AddItemToObject(res, "success", cJSON_CreateBool(false));
-    cJSON_AddItemToObject(res, "error", cJSON_CreateString("Invalid JSON"));
-    std::string response = cjson_to_string_and_free(res);
-    httpd_resp_send(req, response.c_str(), HTTPD_RESP_USE_STRLEN);
-    return ESP_FAIL;
-  }
+  using namespace espConfig::fields;
+  const auto &current = instance->m_configManager.getConfig<espConfig::misc_config_t>();
 
   std::string ssid;
   std::string password;
-  std::string setupCode;
-  bool wifiProvided = false;
-  bool hasSetupCode = false;
+  ConfigPatchBuilder<espConfig::misc_config_t> builder(current);
+  builder.capture("wifiSsid", &ssid);
+  builder.capture("wifiPassword", &password);
 
-  cJSON *ssidItem = cJSON_GetObjectItem(obj, "wifiSsid");
-  cJSON *passwordItem = cJSON_GetObjectItem(obj, "wifiPassword");
-  if (ssidItem && cJSON_IsString(ssidItem)) {
-    ssid = ssidItem->valuestring;
-    if (!ssid.empty()) {
-      wifiProvided = true;
-    }
-  }
-  if (passwordItem && cJSON_IsString(passwordItem)) {
-    password = passwordItem->valuestring;
+  if (receiveConfigPatch(req, builder) != ESP_OK) {
+    return ESP_FAIL; // receiveConfigPatch has already sent the HTTP error response
   }
+  const ConfigPatch<espConfig::misc_config_t> &patch = builder.patch();
 
-  cJSON_DeleteItemFromObject(obj, "wifiSsid");
-  cJSON_DeleteItemFromObject(obj, "wifiPassword");
-
-  cJSON *ethEnabledItem = cJSON_GetObjectItem(obj, "ethernetEnabled");
-  bool ethernetEnabled = (ethEnabledItem && cJSON_IsBool(ethEnabledItem) && cJSON_IsTrue(ethEnabledItem));
+  bool wifiProvided = !ssid.empty();
+  const bool *ethEnabledItem = patch.get<bool>("ethernetEnabled");
+  bool ethernetEnabled = ethEnabledItem && *ethEnabledItem;
 
   if (!ethernetEnabled && !wifiProvided) {
-    cJSON_Delete(obj);
-    httpd_resp_set_status(req, "400 Bad Request");
-    httpd_resp_set_type(req, "application/json");
-    cJSON *res = cJSON_CreateObject();
-    cJSON_AddItemToObject(res, "success", cJSON_CreateBool(false));
-    cJSON_AddItemToObject(res, "error", cJSON_CreateString("WiFi SSID and password are required (or enable Ethernet)"));
-    std::string response = cjson_to_string_and_free(res);
-    httpd_resp_send(req, response.c_str(), HTTPD_RESP_USE_STRLEN);
+    sendJsonError(req, "WiFi SSID and password are required (or enable Ethernet)");
     return ESP_FAIL;
   }
 
   if (wifiProvided) {
     if (ssid.length() > 32 || password.length() < 8 || password.length() > 64) {
-      cJSON_Delete(obj);
-      httpd_resp_set_status(req, "400 Bad Request");
-      httpd_resp_set_type(req, "application/json");
-      cJSON *res = cJSON_CreateObject();
-      cJSON_AddItemToObject(res, "success", cJSON_CreateBool(false));
-      cJSON_AddItemToObject(res, "error", cJSON_CreateString("Invalid WiFi credentials length"));
-      std::string response = cjson_to_string_and_free(res);
-      httpd_resp_send(req, response.c_str(), HTTPD_RESP_USE_STRLEN);
+      sendJsonError(req, "Invalid WiFi credentials length");
       return ESP_FAIL;
     }
   }
 
-  cJSON *colorItem = cJSON_GetObjectItem(obj, "hk_key_color");
-  if (colorItem && cJSON_IsNumber(colorItem) && colorItem->valueint > 3) {
-    cJSON_Delete(obj);
-    httpd_resp_set_status(req, "400 Bad Request");
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, "{\"success\":false,\"error\":\"Invalid hk_key_color (must be <= 3)\"}");
-    return ESP_FAIL;
+  if (!validatePatch(req, current, patch)) {
+    return ESP_FAIL; // validatePatch has already sent the HTTP error response
   }
 
-  cJSON *nfcReaderTypeItem = cJSON_GetObjectItem(obj, "nfcReaderType");
-  // 0 = PN532 (SPI), 1 = PN7160, 2 = ST25R3916 (I2C).
-  if (nfcReaderTypeItem && cJSON_IsNumber(nfcReaderTypeItem) && (nfcReaderTypeItem->valueint < 0 || nfcReaderTypeItem->valueint > 2)) {
-    cJSON_Delete(obj);
-    httpd_resp_set_status(req, "400 Bad Request");
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, "{\"success\":false,\"error\":\"Invalid nfcReaderType\"}");
-    return ESP_FAIL;
-  }
-
-  cJSON *setupCodeItem = cJSON_GetObjectItem(obj, "setupCode");
-  if (setupCodeItem && cJSON_IsString(setupCodeItem)) {
-    setupCode = setupCodeItem->valuestring;
-    hasSetupCode = true;
-  }
-
-  std::string currentConfigJson = instance->m_configManager.serializeToJson<espConfig::misc_config_t>();
-  cJSON *currentConfigData = cJSON_Parse(currentConfigJson.c_str());
-  if (!currentConfigData) {
-    cJSON_Delete(obj);
-    httpd_resp_send_500(req);
-    return ESP_FAIL;
-  }
-
-  bool isValid = instance->validateRequest(req, currentConfigData, obj);
-  cJSON_Delete(currentConfigData);
-
-  if (!isValid) {
-    cJSON_Delete(obj);
-    return ESP_FAIL; // validateRequest has already sent the HTTP error response
-  }
-  auto cleaned_body_str = cjson_to_string_and_free(obj);
-
   if (wifiProvided) {
     if (!connectWiFi(ssid.c_str(), password.c_str(), 15000)) {
       httpd_resp_set_status(req, "400 Bad Request");
@@ -1579,11 +1701,11 @@ esp_err_t WebServerManager::handleSaveCaptivePortalConfig(httpd_req_t *req) {
     homeSpan.setWifiCredentials(ssid.c_str(), password.c_str());
   }
 
-  if (hasSetupCode) {
-    homeSpan.setPairingCode(setupCode.c_str(), false);
+  if (const std::string *setupCode = patch.get<std::string>("setupCode")) {
+    homeSpan.setPairingCode(setupCode->c_str(), false);
   }
 
-  instance->m_configManager.updateFromJson<espConfig::misc_config_t>(cleaned_body_str);
+  instance->m_configManager.applyPatch(patch);
   instance->m_configManager.saveConfig<espConfig::misc_config_t>();
 
   httpd_resp_set_type(req, "application/json");
@@ -1599,6 +1721,10 @@ esp_err_t WebServerManager::handleSaveCaptivePortalConfig(httpd_req_t *req) {
 }
 
 esp_err_t WebServerManager::handleWifiScan(httpd_req_t *req) {
+  HeapAdmission::Reservation heap = admitOrBusy(req, HeapAdmission::Op::WifiScan);
+  if (!heap) {
+    return ESP_OK;
+  }
   ESP_LOGI(TAG, "Starting WiFi scan...");
 
   wifi_mode_t current_mode;
@@ -1835,6 +1961,7 @@ void WebServerManager::broadcastWs(const uint8_t *payload, size_t len,
   if (fds.empty() && wsBacklogSize > 0) {
     if(m_wsBroadcastBuffer.size() >= wsBacklogSize){
       m_wsBroadcastBuffer.pop_front();
+      m_metrics.wsDroppedBacklog.inc();
     }
     m_wsBroadcastBuffer.emplace_back(payload, payload + len);
     return;
@@ -1844,76 +1971,102 @@ void WebServerManager::broadcastWs(const uint8_t *payload, size_t len,
   }
 }
 
+/**
+ * @brief Queue one frame for @p fd. A frame that cannot be queued resets the client's
+ *        metrics baseline, since it may have carried a metrics delta.
+ */
 void WebServerManager::queue_ws_frame(int fd, const uint8_t *payload,
-                                      size_t len, httpd_ws_type_t type) {
+                                      size_t len, httpd_ws_type_t type,
+                                      std::shared_ptr<HeapAdmission::Reservation> heap) {
   WsFrame *frame = new WsFrame;
-  if (!frame)
+  if (!frame) {
+    resetMetricBaseline(fd);
     return;
+  }
 
   frame->fd = fd;
   frame->type = type;
   frame->len = len;
+  frame->heap = std::move(heap);
   if (len <= WsFrame::INLINE_SIZE) {
     memcpy(frame->inlinePayload, payload, len);
     frame->payload = frame->inlinePayload;
   } else {
-    frame->payload = new uint8_t[len];
+    frame->payload = static_cast<uint8_t *>(MemoryPlacement::allocate(MemoryPlacement::Class::Bulk, len));
+    if (!frame->payload) {
+      delete frame;
+      resetMetricBaseline(fd);
+      return;
+    }
     memcpy(frame->payload, payload, len);
   }
 
   if (xQueueSend(m_wsQueue, &frame, pdMS_TO_TICKS(100)) != pdTRUE) {
-    if (frame->payload != frame->inlinePayload)
-      delete[] frame->payload;
-    delete frame;
+    m_metrics.wsDroppedQueueFull.inc();
+    WsFrameDeleter()(frame);
+    resetMetricBaseline(fd);
+    return;
   }
+  Executor::instance().post(m_wsSendJob);
 }
 
-void WebServerManager::ws_send_task(void *arg) {
-  WebServerManager *instance = static_cast<WebServerManager *>(arg);
+/**
+ * @brief Executor job: send up to WS_FRAMES_PER_RUN queued frames, re-posting itself if more remain.
+ *
+ * Bounding each run keeps a burst of log frames from holding the shared worker. A send to
+ * a client that stopped reading gives up after WS_SEND_TIMEOUT_MS (set on the socket at the
+ * handshake); the frame is then torn, so that client's session is closed and its remaining
+ * frames are dropped.
+ */
+void WebServerManager::sendQueuedWsFrames() {
   WsFrame *raw_frame = nullptr;
+  for (size_t sent = 0; sent < WS_FRAMES_PER_RUN; sent++) {
+    if (xQueueReceive(m_wsQueue, &raw_frame, 0) != pdPASS)
+      return;
+    if (!raw_frame)
+      continue;
 
-  while (true) {
-    if (xQueueReceive(instance->m_wsQueue, &raw_frame, portMAX_DELAY) ==
-        pdPASS) {
-      if (!raw_frame)
-        continue;
-
-      WsFramePtr frame(raw_frame);
-
-      int target_fd = -1;
-      {
-        std::scoped_lock<std::mutex> lock(instance->m_wsClientsMutex);
-        auto it = std::find_if(
-            instance->m_wsClients.begin(), instance->m_wsClients.end(),
-            [fd = frame->fd](const std::unique_ptr<WsClient> &c) {
-              return c->fd == fd;
-            });
-        if (it != instance->m_wsClients.end())
-          target_fd = frame->fd;
-      }
+    WsFramePtr frame(raw_frame);
+
+    int target_fd = -1;
+    {
+      std::scoped_lock<std::mutex> lock(m_wsClientsMutex);
+      auto it = std::find_if(
+          m_wsClients.begin(), m_wsClients.end(),
+          [fd = frame->fd](const std::unique_ptr<WsClient> &c) {
+            return c->fd == fd;
+          });
+      if (it != m_wsClients.end())
+        target_fd = frame->fd;
+    }
 
-      if (target_fd != -1) {
-        httpd_ws_frame_t ws_pkt = {};
-        ws_pkt.final = true;
-        ws_pkt.fragmented = false;
-        ws_pkt.type = frame->type;
-        ws_pkt.len = frame->len;
-        ws_pkt.payload = frame->payload;
-
-        esp_err_t send_ret = httpd_ws_send_frame_async(instance->m_server, target_fd, &ws_pkt);
-        if (send_ret != ESP_OK) {
-          const char *err = esp_err_to_name(send_ret);
-          bool is_err =
-              (err && (strstr(err, "masked") || strstr(err, "MASKED"))) ||
-              send_ret == ESP_FAIL;
-          if (is_err || send_ret == ESP_ERR_INVALID_STATE ||
-              send_ret == ESP_ERR_INVALID_ARG) {
-            instance->removeWebSocketClient(frame->fd);
-          }
+    if (target_fd != -1) {
+      httpd_ws_frame_t ws_pkt = {};
+      ws_pkt.final = true;
+      ws_pkt.fragmented = false;
+      ws_pkt.type = frame->type;
+      ws_pkt.len = frame->len;
+      ws_pkt.payload = frame->payload;
+
+      esp_err_t send_ret = httpd_ws_send_frame_async(m_server, target_fd, &ws_pkt);
+      if (send_ret != ESP_OK) {
+        m_metrics.wsSendFailed.inc();
+        const char *err = esp_err_to_name(send_ret);
+        bool is_err =
+            (err && (strstr(err, "masked") || strstr(err, "MASKED"))) ||
+            send_ret == ESP_FAIL;
+        if (is_err || send_ret == ESP_ERR_INVALID_STATE ||
+            send_ret == ESP_ERR_INVALID_ARG) {
+          removeWebSocketClient(frame->fd);
+          httpd_sess_trigger_close(m_server, frame->fd);
+        } else {
+          resetMetricBaseline(frame->fd);
         }
       }
     }
   }
+  if (uxQueueMessagesWaiting(m_wsQueue) > 0)
+    Executor::instance().post(m_wsSendJob);
 }
 
 esp_err_t WebServerManager::handleWebSocketMessage(httpd_req_t *req,
@@ -1945,7 +2098,19 @@ esp_err_t WebServerManager::handleWebSocketMessage(httpd_req_t *req,
     cJSON_AddNumberToObject(pong, "timestamp", static_cast<uint32_t>(esp_timer_get_time() / 1000));
     response = cjson_to_string_and_free(pong);
   } else if (msg_type == "metrics") {
-    response = getDeviceMetrics();
+    response = metricsSnapshot(sockfd, METRICS_ALL, false);
+  } else if (msg_type == "subscribe") {
+    cJSON *groups_item = cJSON_GetObjectItem(json, "groups");
+    uint8_t groups = 0;
+    cJSON *group = nullptr;
+    cJSON_ArrayForEach(group, groups_item) {
+      if (!cJSON_IsString(group)) continue;
+      if (strcmp(group->valuestring, "system") == 0) groups |= METRICS_SYSTEM;
+      else if (strcmp(group->valuestring, "nfc") == 0) groups |= METRICS_NFC;
+      else if (strcmp(group->valuestring, "mqtt") == 0) groups |= METRICS_MQTT;
+      else if (strcmp(group->valuestring, "all") == 0) groups |= METRICS_ALL;
+    }
+    response = metricsSnapshot(sockfd, groups, true);
   } else if (msg_type == "sysinfo") {
     response = getDeviceInfo();
   } else if (msg_type == "ota_info") {
@@ -1986,20 +2151,176 @@ esp_err_t WebServerManager::handleWebSocketMessage(httpd_req_t *req,
 // Device Info/Status Methods
 // ============================================================================
 
-std::string WebServerManager::getDeviceMetrics() {
-  cJSON *status = cJSON_CreateObject();
-  cJSON_AddStringToObject(status, "type", "metrics");
-  cJSON_AddNumberToObject(status, "uptime", std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::duration<int64_t, std::micro>(esp_timer_get_time())).count());
-  cJSON_AddNumberToObject(status, "free_heap", esp_get_free_heap_size());
-  cJSON_AddNumberToObject(status, "wifi_rssi", WiFi.RSSI());
-  cJSON_AddBoolToObject(status, "nfc_connected", m_nfcManager ? m_nfcManager->isConnected() : false);
-  cJSON_AddNumberToObject(status, "nfc_reader_type", m_configManager.getConfig<espConfig::misc_config_t>().nfcReaderType);
-  cJSON_AddBoolToObject(status, "mqtt_connected", m_mqttManager ? m_mqttManager->isConnected() : false);
-  cJSON_AddNumberToObject(status, "mqtt_error_code", m_mqttManager ? static_cast<uint8_t>(m_mqttManager->getLastErrorCode()) : 0);
-  if (m_mqttManager && !m_mqttManager->getLastErrorMessage().empty()) {
-    cJSON_AddStringToObject(status, "mqtt_error_message", m_mqttManager->getLastErrorMessage().c_str());
+/**
+ * @brief Register the web server's own series and the system-wide gauges in the metrics registry.
+ *
+ * Heap and event loop gauges live here because this is the component that serves them;
+ * they are computed on every scrape rather than sampled.
+ */
+WebServerManager::Metrics WebServerManager::registerMetrics() {
+  auto &r = MetricsRegistry::instance();
+  r.gauge("hk_uptime_seconds", "Time since boot", nullptr,
+          [] { return esp_timer_get_time() / 1e6; });
+  r.gauge("hk_heap_free_bytes", "Free internal heap", nullptr,
+          [] { return double(heap_caps_get_free_size(MALLOC_CAP_INTERNAL)); });
+  r.gauge("hk_heap_min_free_bytes", "Lowest free heap since boot", nullptr,
+          [] { return double(esp_get_minimum_free_heap_size()); });
+  r.gauge("hk_heap_largest_free_block_bytes", "Largest allocatable internal heap block", nullptr,
+          [] { return double(heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL)); });
+  r.gauge("hk_event_loop_pending", "Published application events not yet dispatched", nullptr,
+          [] { return double(AppEventLoop::pendingEvents()); });
+  return Metrics{
+      .wsDroppedQueueFull = r.counter("hk_ws_frames_dropped_total", "WebSocket frames that were never sent, by reason", "reason=\"queue_full\""),
+      .wsDroppedBacklog = r.counter("hk_ws_frames_dropped_total", "WebSocket frames that were never sent, by reason", "reason=\"backlog_full\""),
+      .wsSendFailed = r.counter("hk_ws_frames_dropped_total", "WebSocket frames that were never sent, by reason", "reason=\"send_failed\""),
+      .metricPushesSent = r.counter("hk_ws_metric_pushes_total", "Periodic per-client metric updates, by whether anything had changed", "result=\"sent\""),
+      .metricPushesSuppressed = r.counter("hk_ws_metric_pushes_total", "Periodic per-client metric updates, by whether anything had changed", "result=\"suppressed\""),
+  };
+}
+
+WebServerManager::MetricsSample WebServerManager::sampleMetrics() {
+  MetricsSample sample;
+  sample.uptimeMs = esp_timer_get_time() / 1000;
+  sample.freeHeap = esp_get_free_heap_size();
+  sample.wifiRssi = WiFi.RSSI();
+  sample.nfcConnected = m_nfcManager ? m_nfcManager->isConnected() : false;
+  sample.nfcReaderType = m_configManager.getConfig<espConfig::misc_config_t>().nfcReaderType;
+  if (m_mqttManager) {
+    sample.mqttConnected = m_mqttManager->isConnected();
+    sample.mqttErrorCode = static_cast<uint8_t>(m_mqttManager->getLastErrorCode());
+    sample.mqttErrorMessage = m_mqttManager->getLastErrorMessage();
+  }
+  return sample;
+}
+
+/**
+ * @brief Encode the fields of @p groups that the client does not already hold.
+ *
+ * With @p full set, or for a group the client has never received, every field is
+ * written; otherwise only fields that changed (beyond the heap/RSSI dead bands) since
+ * the client's last update. The client's baseline is advanced for every field written.
+ *
+ * @return A `metrics` message, or an empty string if there is nothing to send.
+ */
+std::string WebServerManager::encodeMetrics(const MetricsSample &now, WsClient &client, uint8_t groups, bool full) {
+  std::string out = R"({"type":"metrics")";
+  const size_t emptySize = out.size();
+  auto it = std::back_inserter(out);
+  MetricsSample &last = client.lastSent;
+
+  if (groups & METRICS_SYSTEM) {
+    bool fresh = full || !(client.sentGroups & METRICS_SYSTEM);
+    if (fresh) {
+      fmt::format_to(it, R"(,"uptime":{})", now.uptimeMs);
+      last.uptimeMs = now.uptimeMs;
+    }
+    if (fresh || std::max(now.freeHeap, last.freeHeap) - std::min(now.freeHeap, last.freeHeap) >= METRICS_HEAP_DEADBAND) {
+      fmt::format_to(it, R"(,"free_heap":{})", now.freeHeap);
+      last.freeHeap = now.freeHeap;
+    }
+    if (fresh || std::abs(now.wifiRssi - last.wifiRssi) >= METRICS_RSSI_DEADBAND) {
+      fmt::format_to(it, R"(,"wifi_rssi":{})", now.wifiRssi);
+      last.wifiRssi = now.wifiRssi;
+    }
+  }
+  if (groups & METRICS_NFC) {
+    bool fresh = full || !(client.sentGroups & METRICS_NFC);
+    if (fresh || now.nfcConnected != last.nfcConnected) {
+      fmt::format_to(it, R"(,"nfc_connected":{})", now.nfcConnected);
+      last.nfcConnected = now.nfcConnected;
+    }
+    if (fresh || now.nfcReaderType != last.nfcReaderType) {
+      fmt::format_to(it, R"(,"nfc_reader_type":{})", now.nfcReaderType);
+      last.nfcReaderType = now.nfcReaderType;
+    }
+  }
+  if (groups & METRICS_MQTT) {
+    bool fresh = full || !(client.sentGroups & METRICS_MQTT);
+    if (fresh || now.mqttConnected != last.mqttConnected) {
+      fmt::format_to(it, R"(,"mqtt_connected":{})", now.mqttConnected);
+      last.mqttConnected = now.mqttConnected;
+    }
+    if (fresh || now.mqttErrorCode != last.mqttErrorCode) {
+      fmt::format_to(it, R"(,"mqtt_error_code":{})", now.mqttErrorCode);
+      last.mqttErrorCode = now.mqttErrorCode;
+    }
+    // Sent even when empty once it changes, so clients merging updates drop a stale message.
+    if (fresh || now.mqttErrorMessage != last.mqttErrorMessage) {
+      out += R"(,"mqtt_error_message":")";
+      for (char c : now.mqttErrorMessage) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) out += c;
+      }
+      out += '"';
+      last.mqttErrorMessage = now.mqttErrorMessage;
+    }
+  }
+  client.sentGroups |= groups;
+  if (out.size() == emptySize && !full) {
+    return {};
+  }
+  out += '}';
+  return out;
+}
+
+/**
+ * @brief Build a full `metrics` message for @p groups and make it the client's baseline.
+ * @param resubscribe Replace the client's subscription with @p groups.
+ */
+std::string WebServerManager::metricsSnapshot(int fd, uint8_t groups, bool resubscribe) {
+  MetricsSample now = sampleMetrics();
+  std::scoped_lock lock(m_wsClientsMutex);
+  auto it = std::find_if(m_wsClients.begin(), m_wsClients.end(),
+                         [fd](const std::unique_ptr<WsClient> &c) { return c->fd == fd; });
+  if (it == m_wsClients.end()) {
+    WsClient detached(fd);
+    return encodeMetrics(now, detached, groups, true);
+  }
+  if (resubscribe) {
+    (*it)->metricGroups = groups;
+    (*it)->sentGroups = 0;
+  }
+  return encodeMetrics(now, **it, groups, true);
+}
+
+/**
+ * @brief Make the next metrics push to @p fd a full snapshot.
+ *
+ * encodeMetrics() advances the baseline as it encodes, so a frame lost after that would
+ * otherwise leave the client without the values it missed until they change again.
+ */
+void WebServerManager::resetMetricBaseline(int fd) {
+  std::scoped_lock lock(m_wsClientsMutex);
+  auto it = std::find_if(m_wsClients.begin(), m_wsClients.end(),
+                         [fd](const std::unique_ptr<WsClient> &c) { return c->fd == fd; });
+  if (it != m_wsClients.end()) (*it)->sentGroups = 0;
+}
+
+/**
+ * @brief Send each subscribed client the metrics that changed since its last update.
+ *
+ * The device is sampled once per tick. Clients with nothing new get no frame at all.
+ */
+void WebServerManager::pushMetricDeltas() {
+  MetricsSample now = sampleMetrics();
+  std::vector<std::pair<int, std::string>> updates;
+  {
+    std::scoped_lock lock(m_wsClientsMutex);
+    for (auto &client : m_wsClients) {
+      if (!client->metricGroups) continue;
+      std::string delta = encodeMetrics(now, *client, client->metricGroups, false);
+      if (delta.empty()) {
+        m_metrics.metricPushesSuppressed.inc();
+      } else {
+        updates.emplace_back(client->fd, std::move(delta));
+      }
+    }
+  }
+  // Queued outside the lock: the send task takes it for every frame.
+  for (auto &[fd, payload] : updates) {
+    m_metrics.metricPushesSent.inc();
+    queue_ws_frame(fd, reinterpret_cast<const uint8_t *>(payload.data()), payload.size(), HTTPD_WS_TYPE_TEXT);
   }
-  return cjson_to_string_and_free(status);
 }
 
 std::string WebServerManager::getDeviceInfo() {
@@ -2023,10 +2344,145 @@ std::string WebServerManager::getDeviceInfo() {
 }
 
 void WebServerManager::statusTimerCallback(void *arg) {
-  WebServerManager *instance = static_cast<WebServerManager *>(arg);
-  auto metrics = instance->getDeviceMetrics();
-  instance->broadcastWs((const uint8_t *)(metrics.c_str()), metrics.size(),
-                        HTTPD_WS_TYPE_TEXT);
+  static_cast<WebServerManager *>(arg)->pushMetricDeltas();
+}
+
+void WebServerManager::historyTimerCallback(void *arg) {
+  (void)arg;
+  MetricsHistory::instance().addSample(static_cast<uint32_t>(esp_timer_get_time() / 1000000),
+                                       heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+                                       heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL), WiFi.RSSI());
+}
+
+/**
+ * @brief Serve the metrics registry in the Prometheus text format.
+ *
+ * Output is rendered straight into chunked response frames, so the page never has to fit
+ * in memory at once.
+ */
+esp_err_t WebServerManager::handleMetrics(httpd_req_t *req) {
+  WebServerManager *instance = getInstance(req);
+  if (!instance->basicAuth(req)) {
+    return sendAuthFailure(req);
+  }
+  httpd_resp_set_type(req, "text/plain; version=0.0.4; charset=utf-8");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  bool ok = MetricsRegistry::instance().render([req](const char *data, size_t len) {
+    return httpd_resp_send_chunk(req, data, len) == ESP_OK;
+  });
+  if (!ok) {
+    ESP_LOGW(TAG, "Metrics scrape aborted by the client");
+    return ESP_FAIL;
+  }
+  return httpd_resp_send_chunk(req, nullptr, 0);
+}
+
+/**
+ * @brief Serve the on-device metrics history (1 s / 1 min / 1 h rings) as one JSON document.
+ */
+esp_err_t WebServerManager::handleMetricsHistory(httpd_req_t *req) {
+  WebServerManager *instance = getInstance(req);
+  if (!instance->basicAuth(req)) {
+    return sendAuthFailure(req);
+  }
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  bool ok = MetricsHistory::instance().render([req](const char *data, size_t len) {
+    return httpd_resp_send_chunk(req, data, len) == ESP_OK;
+  });
+  if (!ok) {
+    return ESP_FAIL;
+  }
+  return httpd_resp_send_chunk(req, nullptr, 0);
+}
+
+/**
+ * @brief Serve the TaskRegistry's last sample as JSON, for the dashboard's task table.
+ */
+esp_err_t WebServerManager::handleMetricsTasks(httpd_req_t *req) {
+  WebServerManager *instance = getInstance(req);
+  if (!instance->basicAuth(req)) {
+    return sendAuthFailure(req);
+  }
+  cJSON *response = cJSON_CreateObject();
+  cJSON *data = cJSON_CreateObject();
+  cJSON_AddNumberToObject(data, "interval_ms", TaskRegistry::SAMPLE_INTERVAL_MS);
+  cJSON *tasks = cJSON_AddArrayToObject(data, "tasks");
+  for (const auto &info : TaskRegistry::instance().snapshot()) {
+    cJSON *task = cJSON_CreateObject();
+    cJSON_AddStringToObject(task, "name", info.name.c_str());
+    cJSON_AddNumberToObject(task, "core", info.core);
+    cJSON_AddNumberToObject(task, "priority", info.priority);
+    cJSON_AddNumberToObject(task, "stack_size", info.stackBytes);
+    cJSON_AddNumberToObject(task, "stack_free", info.stackFreeBytes);
+    cJSON_AddNumberToObject(task, "cpu", info.cpuPercent);
+    cJSON_AddBoolToObject(task, "running", info.running);
+    cJSON_AddBoolToObject(task, "firmware", info.firmware);
+    cJSON_AddItemToArray(tasks, task);
+  }
+  cJSON_AddItemToObject(response, "data", data);
+  cJSON_AddItemToObject(response, "success", cJSON_CreateBool(true));
+  std::string resp = cjson_to_string_and_free(response);
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  httpd_resp_send(req, resp.c_str(), HTTPD_RESP_USE_STRLEN);
+  return ESP_OK;
+}
+
+esp_err_t WebServerManager::handleMetricsHeap(httpd_req_t *req) {
+  WebServerManager *instance = getInstance(req);
+  if (!instance->basicAuth(req)) {
+    return sendAuthFailure(req);
+  }
+  HeapProfiler &profiler = HeapProfiler::instance();
+  cJSON *response = cJSON_CreateObject();
+  cJSON *data = cJSON_CreateObject();
+  cJSON_AddBoolToObject(data, "enabled", HeapProfiler::enabled());
+  cJSON_AddNumberToObject(data, "uptime_ms", esp_timer_get_time() / 1000);
+  cJSON_AddNumberToObject(data, "free", heap_caps_get_free_size(MALLOC_CAP_DEFAULT));
+  cJSON_AddNumberToObject(data, "largest_block", heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT));
+  cJSON_AddNumberToObject(data, "min_free", heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT));
+  if (HeapProfiler::enabled()) {
+    cJSON_AddNumberToObject(data, "sample_bytes", HeapProfiler::sampleBytes());
+    cJSON *tags = cJSON_AddArrayToObject(data, "tags");
+    for (const auto &stats : profiler.tags()) {
+      cJSON *tag = cJSON_CreateObject();
+      cJSON_AddStringToObject(tag, "tag", HeapProfiler::tagName(stats.tag));
+      cJSON_AddNumberToObject(tag, "allocs", stats.allocs);
+      cJSON_AddNumberToObject(tag, "alloc_bytes", stats.allocBytes);
+      cJSON_AddNumberToObject(tag, "live_bytes", stats.liveBytes);
+      cJSON_AddNumberToObject(tag, "high_water_bytes", stats.highWaterBytes);
+      cJSON_AddItemToArray(tags, tag);
+    }
+    cJSON *sites = cJSON_AddArrayToObject(data, "sites");
+    for (const auto &s : profiler.topSites(10)) {
+      cJSON *site = cJSON_CreateObject();
+      cJSON_AddStringToObject(site, "tag", HeapProfiler::tagName(s.tag));
+      cJSON_AddNumberToObject(site, "live_bytes", s.liveBytes);
+      cJSON_AddNumberToObject(site, "total_bytes", s.totalBytes);
+      cJSON *frames = cJSON_AddArrayToObject(site, "frames");
+      for (uintptr_t pc : s.frames) {
+        if (pc) cJSON_AddItemToArray(frames, cJSON_CreateString(fmt::format("0x{:08x}", pc).c_str()));
+      }
+      cJSON_AddItemToArray(sites, site);
+    }
+    cJSON *ab = cJSON_AddObjectToObject(data, "taps");
+    cJSON_AddBoolToObject(ab, "ab_mode", profiler.abMode());
+    const auto arms = profiler.taps();
+    for (size_t i = 0; i < arms.size(); i++) {
+      cJSON *arm = cJSON_AddObjectToObject(ab, i == 0 ? "arena" : "heap");
+      cJSON_AddNumberToObject(arm, "taps", arms[i].taps);
+      cJSON_AddNumberToObject(arm, "allocs", arms[i].allocs);
+      cJSON_AddNumberToObject(arm, "alloc_bytes", arms[i].allocBytes);
+    }
+  }
+  cJSON_AddItemToObject(response, "data", data);
+  cJSON_AddItemToObject(response, "success", cJSON_CreateBool(true));
+  std::string resp = cjson_to_string_and_free(response);
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  httpd_resp_send(req, resp.c_str(), HTTPD_RESP_USE_STRLEN);
+  return ESP_OK;
 }
 
 // ============================================================================
@@ -2054,12 +2510,15 @@ esp_err_t WebServerManager::handleOTAUpload(httpd_req_t *req) {
   }
 
   char *type = strrchr(req->uri, '/');
-  OTAUploadType uploadType = (type && strncmp(type + 1, "littlefs", 8) == 0)
-                                 ? OTAUploadType::LITTLEFS
-                                 : OTAUploadType::FIRMWARE;
+  OTAUploadType uploadType = OTAUploadType::FIRMWARE;
+  if (type && strncmp(type + 1, "littlefs", 8) == 0) {
+    uploadType = OTAUploadType::LITTLEFS;
+  } else if (type && strncmp(type + 1, "delta", 5) == 0) {
+    uploadType = OTAUploadType::FIRMWARE_DELTA;
+  }
 
  auto app_part =  esp_ota_get_running_partition();
-  if (uploadType == OTAUploadType::FIRMWARE && req->content_len > app_part->size) {
+  if (uploadType != OTAUploadType::LITTLEFS && req->content_len > app_part->size) {
     ESP_LOGE(TAG, "OTA size %zu > max %zu", req->content_len, app_part->size);
     instance->m_otaInProgress = false;
     httpd_resp_set_status(req, "413 Payload Too Large");
@@ -2084,6 +2543,35 @@ esp_err_t WebServerManager::handleOTAUpload(httpd_req_t *req) {
           ESP_OK) {
     skipReboot = (strcmp(param, "true") == 0);
   }
+  bool compressed = false;
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+      httpd_query_key_value(query, "compression", param, sizeof(param)) ==
+          ESP_OK) {
+    if (strcmp(param, "heatshrink") != 0) {
+      instance->m_otaInProgress = false;
+      httpd_resp_set_status(req, "400 Bad Request");
+      httpd_resp_set_type(req, "application/json");
+      httpd_resp_sendstr(req, "{\"success\":false,\"error\":\"Unsupported compression\"}");
+      return ESP_OK;
+    }
+    compressed = true;
+  }
+
+  // The decoder's window is sized by the stream header; reserve for the largest one accepted.
+  const HeapAdmission::Op heapOp =
+      uploadType == OTAUploadType::LITTLEFS ? HeapAdmission::Op::OtaLittleFs : HeapAdmission::Op::OtaFirmware;
+  uint32_t heapBytes = HeapAdmission::profile(heapOp).peakBytes;
+  // The pipeline's buffers are Bulk, so on a board with PSRAM they are not taken from internal RAM.
+  if (MemoryPlacement::psramAvailable()) {
+    heapBytes -= OtaPipeline::DEFAULT_BUFFER_SIZE * OtaPipeline::DEFAULT_BUFFER_COUNT;
+  }
+  if (compressed) heapBytes += (1u << HeatshrinkDecoder::MAX_WINDOW_BITS) + 512;
+  if (uploadType == OTAUploadType::FIRMWARE_DELTA) heapBytes += 2 * 1024;
+  HeapAdmission::Reservation heap = admitOrBusy(req, heapOp, heapBytes);
+  if (!heap) {
+    instance->m_otaInProgress = false;
+    return ESP_OK;
+  }
 
   httpd_req_t *reqCopy = nullptr;
   if (httpd_req_async_handler_begin(req, &reqCopy) != ESP_OK) {
@@ -2094,10 +2582,12 @@ esp_err_t WebServerManager::handleOTAUpload(httpd_req_t *req) {
     return ESP_OK;
   }
 
-  OTAParams *params = new OTAParams{reqCopy, instance, uploadType, skipReboot, req->content_len, new OTAState()};
+  OTAParams *params = new OTAParams{reqCopy, instance, uploadType, skipReboot, compressed, req->content_len,
+                                    new OTAState(), std::move(heap)};
   params->state->inProgress = true;
 
-  if (xTaskCreate(otaTask, "ota_task", 8192, params, 5, NULL) != pdPASS) {
+  // Receive next to the network stack; OtaPipeline runs flash writes on the other core.
+  if (TaskRegistry::instance().create(otaTask, "ota_task", 8192, params, 5, nullptr, 0) != pdPASS) {
     ESP_LOGE(TAG, "Failed to create OTA task");
     delete params->state;
     delete params;
@@ -2120,32 +2610,64 @@ void WebServerManager::otaTask(void *pvParameters) {
   params->state->currentUploadType = params->uploadType;
   params->state->skipReboot = params->skipReboot;
   params->state->totalBytes = params->contentLength;
+  params->state->receivedBytes = 0;
   params->state->writtenBytes = 0;
+  params->state->compressed = params->compressed;
+  params->state->imageBytes =
+      (params->uploadType == OTAUploadType::FIRMWARE_DELTA || params->compressed) ? 0 : params->contentLength;
   params->state->error.clear();
 
-  params->state->handle = 0;
   params->state->updatePartition = nullptr;
   params->state->littlefsPartition = nullptr;
 
   ESP_LOGI(TAG, "Starting OTA task. Type: %d, Size: %zu", (int)params->uploadType, params->contentLength);
 
-  const size_t buffer_size = 4096;
-  char *buffer = (char *)heap_caps_malloc(buffer_size, MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL);
-  if (!buffer) {
-    params->state->error = "Buffer allocation failed";
-    goto error;
-  }
+  // Sink chain, head first: [HeatshrinkDecoder ->] [DeltaPatcher -> OtaDigestSink ->] OtaFirmwareSink,
+  // or [HeatshrinkDecoder ->] OtaPartitionSink.
+  OtaSink *imageSink = nullptr;
+  std::unique_ptr<OtaFirmwareSink> firmwareSink;
+  std::unique_ptr<OtaPartitionSink> partitionSink;
+  std::unique_ptr<OtaDigestSink> digestSink;
+  std::unique_ptr<OtaPartitionSource> deltaSource;
+  std::unique_ptr<DeltaPatcher> deltaPatcher;
+  std::unique_ptr<HeatshrinkDecoder> decoder;
+  std::unique_ptr<OtaPipeline> pipeline;
+  auto refreshStats = [&]() {
+    OtaPipeline::Stats stats = pipeline->stats();
+    params->state->receivedBytes = stats.submittedBytes;
+    params->state->receiveStallUs = stats.receiveStallUs;
+    params->state->writeStallUs = stats.writeStallUs;
+    params->state->writtenBytes = firmwareSink ? firmwareSink->writtenBytes() : partitionSink->writtenBytes();
+    if (deltaPatcher && deltaPatcher->headerParsed()) {
+      params->state->imageBytes = deltaPatcher->header().targetSize;
+    } else if (!deltaPatcher && decoder && decoder->headerParsed()) {
+      params->state->imageBytes = decoder->outputSize();
+    }
+  };
+  auto pipelineError = [&](const char *fallback) {
+    if (decoder && decoder->error()) return std::string(decoder->error());
+    return std::string(deltaPatcher && deltaPatcher->error() ? deltaPatcher->error() : fallback);
+  };
 
-  if (params->uploadType == OTAUploadType::FIRMWARE) {
+  if (params->uploadType != OTAUploadType::LITTLEFS) {
     params->state->updatePartition = esp_ota_get_next_update_partition(NULL);
     if (!params->state->updatePartition) {
        params->state->error = "No OTA partition";
        goto error;
     }
-    if (esp_ota_begin(params->state->updatePartition, params->contentLength, &params->state->handle) != ESP_OK) {
+    firmwareSink = std::make_unique<OtaFirmwareSink>(params->state->updatePartition);
+    if (!firmwareSink->begin()) {
        params->state->error = "OTA begin failed";
        goto error;
     }
+    if (params->uploadType == OTAUploadType::FIRMWARE_DELTA) {
+      digestSink = std::make_unique<OtaDigestSink>(*firmwareSink);
+      deltaSource = std::make_unique<OtaPartitionSource>(esp_ota_get_running_partition());
+      deltaPatcher = std::make_unique<DeltaPatcher>(*deltaSource, *digestSink);
+      imageSink = deltaPatcher.get();
+    } else {
+      imageSink = firmwareSink.get();
+    }
   } else {
     params->state->littlefsPartition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, "spiffs");
     if (!params->state->littlefsPartition) {
@@ -2157,54 +2679,72 @@ void WebServerManager::otaTask(void *pvParameters) {
       goto error;
     }
     LittleFS.end();
-    if (esp_partition_erase_range(params->state->littlefsPartition, 0, params->state->littlefsPartition->size) != ESP_OK) {
-      params->state->error = "Erase failed";
-      goto error;
-    }
+    partitionSink = std::make_unique<OtaPartitionSink>(params->state->littlefsPartition);
+    imageSink = partitionSink.get();
+  }
+
+  if (params->compressed) {
+    decoder = std::make_unique<HeatshrinkDecoder>(*imageSink);
+    imageSink = decoder.get();
+  }
+  pipeline = std::make_unique<OtaPipeline>(*imageSink);
+  if (!pipeline->start()) {
+    params->state->error = "Buffer allocation failed";
+    goto error;
   }
 
   {
     size_t remaining = params->contentLength;
     size_t last_broadcast = 0;
-    int received;
+    params->state->startTime = esp_timer_get_time();
     while (remaining > 0) {
-        received = httpd_req_recv(req, buffer, std::min(remaining, buffer_size));
-        if (received < 0) {
-            if (received == HTTPD_SOCK_ERR_TIMEOUT) {
-                continue;
-            }
-            params->state->error = "Receive error";
+        uint8_t *buffer = pipeline->acquire();
+        if (!buffer) {
+            params->state->error = pipelineError("Write error");
             goto error;
         }
-        
-        if (received > 0) {
-            if (params->uploadType == OTAUploadType::FIRMWARE) {
-                if (esp_ota_write(params->state->handle, buffer, received) != ESP_OK) {
-                    params->state->error = "Write error";
-                    goto error;
-                }
-            } else {
-                if (esp_partition_write(params->state->littlefsPartition, params->state->writtenBytes, buffer, received) != ESP_OK) {
-                    params->state->error = "Write error";
-                    goto error;
-                }
+        // Fill the whole buffer before handing it to the writer so flash sees large writes.
+        size_t want = std::min(remaining, pipeline->bufferSize());
+        size_t filled = 0;
+        while (filled < want) {
+            int received = httpd_req_recv(req, (char *)buffer + filled, want - filled);
+            if (received == HTTPD_SOCK_ERR_TIMEOUT) {
+                continue;
             }
-            params->state->writtenBytes += received;
-            remaining -= received;
-            
-            if ((params->state->writtenBytes - last_broadcast) >= std::max(params->contentLength / 20, (size_t)1) || remaining == 0) {
-                instance->broadcastOTAStatus(*params->state);
-                last_broadcast = params->state->writtenBytes;
+            if (received <= 0) {
+                pipeline->release(buffer);
+                params->state->error = received < 0 ? "Receive error" : "Received empty payload, aborting";
+                goto error;
             }
-        } else {
-            params->state->error = "Received empty payload, aborting";
-            goto error;
+            filled += received;
+        }
+        pipeline->submit(buffer, filled);
+        remaining -= filled;
+
+        size_t received_total = params->contentLength - remaining;
+        if ((received_total - last_broadcast) >= std::max(params->contentLength / 20, (size_t)1) || remaining == 0) {
+            refreshStats();
+            instance->broadcastOTAStatus(*params->state);
+            last_broadcast = received_total;
         }
     }
   }
 
-  if (params->uploadType == OTAUploadType::FIRMWARE) {
-    if (esp_ota_end(params->state->handle) != ESP_OK || esp_ota_set_boot_partition(params->state->updatePartition) != ESP_OK) {
+  if (!pipeline->finish()) {
+    params->state->error = pipelineError(params->uploadType == OTAUploadType::LITTLEFS ? "Write error" : "End/SetBoot failed");
+    goto error;
+  }
+  if (deltaPatcher && !digestSink->matches(deltaPatcher->header().targetSha256)) {
+    params->state->error = "Patched image hash mismatch";
+    goto error;
+  }
+  refreshStats();
+  ESP_LOGI(TAG, "OTA image written: %zu bytes in %lld ms, receive stall %lu ms, write stall %lu ms",
+           params->state->writtenBytes, (esp_timer_get_time() - params->state->startTime) / 1000,
+           (unsigned long)(params->state->receiveStallUs / 1000), (unsigned long)(params->state->writeStallUs / 1000));
+
+  if (params->uploadType != OTAUploadType::LITTLEFS) {
+    if (esp_ota_set_boot_partition(params->state->updatePartition) != ESP_OK) {
         params->state->error = "End/SetBoot failed";
         goto error;
     }
@@ -2225,7 +2765,14 @@ void WebServerManager::otaTask(void *pvParameters) {
     httpd_req_async_handler_complete(req);
     instance->m_otaInProgress = false;
 
-    if (buffer) free(buffer);
+    // vTaskDelete() does not return, so release everything explicitly.
+    pipeline.reset();
+    decoder.reset();
+    deltaPatcher.reset();
+    deltaSource.reset();
+    digestSink.reset();
+    firmwareSink.reset();
+    partitionSink.reset();
     delete params->state;
     delete params;
 
@@ -2239,10 +2786,16 @@ void WebServerManager::otaTask(void *pvParameters) {
   }
 
 error:
+  // Stop the writer before the sinks go away; destroying an unfinished firmware sink aborts the OTA handle.
+  pipeline.reset();
+  decoder.reset();
+  deltaPatcher.reset();
+  deltaSource.reset();
+  digestSink.reset();
+  firmwareSink.reset();
+  partitionSink.reset();
   params->state->inProgress = false;
   instance->broadcastOTAStatus(*params->state);
-  if (params->state->handle) esp_ota_abort(params->state->handle);
-  if (buffer) free(buffer);
   
   httpd_resp_set_type(req, "application/json");
   httpd_resp_set_status(req, "500 Internal Server Error");
@@ -2282,16 +2835,36 @@ void WebServerManager::broadcastOTAStatus(const OTAState& state) {
     cJSON_AddStringToObject(status, "error", state.error.c_str());
   cJSON_AddBoolToObject(status, "in_progress", state.inProgress);
   cJSON_AddNumberToObject(status, "bytes_written", state.writtenBytes);
-  cJSON_AddStringToObject(status, "upload_type",
-                          (state.currentUploadType == OTAUploadType::LITTLEFS)
-                              ? "littlefs"
-                              : "firmware");
+  const char *uploadType = "firmware";
+  if (state.currentUploadType == OTAUploadType::LITTLEFS) uploadType = "littlefs";
+  else if (state.currentUploadType == OTAUploadType::FIRMWARE_DELTA) uploadType = "firmware_delta";
+  cJSON_AddStringToObject(status, "upload_type", uploadType);
+  if (state.compressed) cJSON_AddStringToObject(status, "compression", "heatshrink");
 
   if (state.inProgress && state.totalBytes > 0) {
-    cJSON_AddNumberToObject(status, "progress_percent",
-                            (float)state.writtenBytes / state.totalBytes *
-                                100.0f);
+    // Progress follows the image written to flash when its size is known, the upload otherwise.
+    float progress = state.imageBytes > 0 ? (float)state.writtenBytes / state.imageBytes
+                                          : (float)state.receivedBytes / state.totalBytes;
+    cJSON_AddNumberToObject(status, "progress_percent", progress * 100.0f);
+    if (state.imageBytes > 0 && state.imageBytes != state.totalBytes) {
+      cJSON_AddNumberToObject(status, "upload_percent", (float)state.receivedBytes / state.totalBytes * 100.0f);
+    }
     cJSON_AddNumberToObject(status, "total_bytes", state.totalBytes);
+    if (state.imageBytes > 0) cJSON_AddNumberToObject(status, "image_bytes", state.imageBytes);
+  }
+
+  if (state.startTime > 0) {
+    float elapsed = (esp_timer_get_time() - state.startTime) / 1e6f;
+    cJSON_AddNumberToObject(status, "bytes_received", state.receivedBytes);
+    cJSON_AddNumberToObject(status, "receive_stall_ms", state.receiveStallUs / 1000);
+    cJSON_AddNumberToObject(status, "write_stall_ms", state.writeStallUs / 1000);
+    if (elapsed > 0) {
+      float rate = state.receivedBytes / elapsed;
+      cJSON_AddNumberToObject(status, "throughput_kbps", rate / 1024.0f);
+      if (state.inProgress && rate > 0 && state.totalBytes > state.receivedBytes) {
+        cJSON_AddNumberToObject(status, "eta_seconds", (state.totalBytes - state.receivedBytes) / rate);
+      }
+    }
   }
   
   std::string otaStatus = cjson_to_string_and_free(status);
@@ -2349,6 +2922,11 @@ esp_err_t WebServerManager::handleCertificateUpload(httpd_req_t *req) {
     return ESP_FAIL;
   }
 
+  HeapAdmission::Reservation heap = admitOrBusy(req, HeapAdmission::Op::CertificateParse);
+  if (!heap) {
+    return ESP_OK;
+  }
+
   std::string certBuf;
   certBuf.reserve(content_len + 1);
   char buffer[1024];
@@ -2407,6 +2985,11 @@ esp_err_t WebServerManager::handleCertificateStatus(httpd_req_t *req) {
     return ESP_FAIL;
   }
 
+  HeapAdmission::Reservation heap = admitOrBusy(req, HeapAdmission::Op::CertificateParse);
+  if (!heap) {
+    return ESP_OK;
+  }
+
   cJSON *response = cJSON_CreateObject();
   cJSON *certificates = cJSON_CreateObject();
 
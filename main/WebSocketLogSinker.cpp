@@ -1,6 +1,7 @@
 #include "WebSocketLogSinker.h"
 #include "WebServerManager.hpp"
 #include "cJSON.h"
+#include "HeapProfiler.hpp"
 #include "esp_timer.h"
 #include <chrono>
 #include <cstdint>
@@ -55,6 +56,7 @@ void WebSocketLogSinker::consume(const LogMessage& message) {
         explicit Guard(bool& f) : flag(f) { flag = true; }
         ~Guard() { flag = false; }
     } guard(in_append);
+    HeapProfiler::Scope heapTag(HeapProfiler::Tag::Logging);
 
     cJSON* root = cJSON_CreateObject();
     if (root == nullptr) {
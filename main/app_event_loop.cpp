@@ -1,5 +1,6 @@
 #include "app_event_loop.hpp"
 #include "esp_log.h"
+#include <atomic>
 #include <cstring>
 #include <memory>
 #include <vector>
@@ -10,6 +11,17 @@ static const char* TAG = "AppEventLoop";
 
 using CallbackFunc = std::function<void(const uint8_t*, size_t)>;
 
+// Every event carries a small header ahead of its payload: the payload length and a
+// sequence number. The default loop dispatches in order, so the highest sequence seen by
+// a handler tells how many published events are still queued behind it.
+struct EventHeader {
+    uint16_t size;
+    uint32_t seq;
+};
+
+static std::atomic<uint32_t> s_published{0};
+static std::atomic<uint32_t> s_dispatched{0};
+
 struct HandlerContext {
     CallbackFunc callback;
 };
@@ -21,11 +33,15 @@ static void event_handler(void* handler_arg, esp_event_base_t base, int32_t id,
     if (!ctx || !ctx->callback) return;
 
     const uint8_t* data = static_cast<const uint8_t*>(event_data);
-    uint16_t size = 0;
+    EventHeader header{};
     if (data) {
-        std::memcpy(&size, data, sizeof(size));
+        std::memcpy(&header, data, sizeof(header));
+        uint32_t seen = s_dispatched.load(std::memory_order_relaxed);
+        while (static_cast<int32_t>(header.seq - seen) > 0 &&
+               !s_dispatched.compare_exchange_weak(seen, header.seq, std::memory_order_relaxed)) {
+        }
     }
-    ctx->callback(data ? data + sizeof(size) : nullptr, size);
+    ctx->callback(data ? data + sizeof(header) : nullptr, header.size);
 }
 
 SubscriptionHandle subscribe(esp_event_base_t base, int32_t id,
@@ -52,14 +68,20 @@ esp_err_t publish(esp_event_base_t base, int32_t id, const void* data, size_t si
         size = MAX_PAYLOAD;
     }
 
-    std::vector<uint8_t> buffer(sizeof(uint16_t) + size);
-    uint16_t len = static_cast<uint16_t>(size);
-    std::memcpy(buffer.data(), &len, sizeof(len));
+    std::vector<uint8_t> buffer(sizeof(EventHeader) + size);
+    EventHeader header{static_cast<uint16_t>(size), s_published.fetch_add(1, std::memory_order_relaxed) + 1};
+    std::memcpy(buffer.data(), &header, sizeof(header));
     if (data && size > 0) {
-        std::memcpy(buffer.data() + sizeof(len), data, size);
+        std::memcpy(buffer.data() + sizeof(header), data, size);
     }
 
     return esp_event_post(base, id, buffer.data(), buffer.size(), portMAX_DELAY);
 }
 
+uint32_t pendingEvents() {
+    int32_t pending = static_cast<int32_t>(s_published.load(std::memory_order_relaxed) -
+                                           s_dispatched.load(std::memory_order_relaxed));
+    return pending > 0 ? pending : 0;
+}
+
 } // namespace AppEventLoop
@@ -0,0 +1,306 @@
+#pragma once
+#include "config.hpp"
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <span>
+#include <string>
+#include <string_view>
+#include <variant>
+
+/**
+ * @brief Compile-time field descriptors for the `espConfig` structs.
+ *
+ * Every persisted/editable member of a config struct is listed once in a constexpr
+ * table together with its external key, bounds and behaviour flags. Code that needs
+ * to walk a config generically (NVS MessagePack blobs, JSON responses and requests,
+ * validation) iterates the table instead of building runtime lookup structures.
+ */
+namespace espConfig::fields {
+
+using StateMap = std::map<std::string, uint8_t>;
+using ColorMap = std::map<actions_config_t::colorMap, uint8_t>;
+
+/**
+ * @brief Field kinds; the order matches the alternatives of Member and FieldValue.
+ */
+enum class FieldType : uint8_t { String, U16, U8, Bool, StateMap, ColorMap, Bytes4, Bytes5, Bytes7 };
+
+enum Flags : uint8_t {
+  F_NONE = 0,
+  F_SECRET = 1 << 0,         // masked when reported back to clients
+  F_GPIO = 1 << 1,           // value, or every array element, is a GPIO number (255 = unset)
+  F_FIRST_NOT_GPIO = 1 << 2, // GPIO array whose first element is not a pin (e.g. SPI clock)
+};
+
+template <typename Config>
+using Member = std::variant<std::string Config::*, uint16_t Config::*, uint8_t Config::*, bool Config::*,
+                            StateMap Config::*, ColorMap Config::*, std::array<uint8_t, 4> Config::*,
+                            std::array<uint8_t, 5> Config::*, std::array<uint8_t, 7> Config::*>;
+
+using FieldValue = std::variant<std::string, uint16_t, uint8_t, bool, StateMap, ColorMap, std::array<uint8_t, 4>,
+                                std::array<uint8_t, 5>, std::array<uint8_t, 7>>;
+
+template <typename Config>
+struct FieldDescriptor {
+  /** Always a string literal, so `name.data()` is NUL-terminated. */
+  std::string_view name;
+  Member<Config> member;
+  /** Numeric bounds; for strings `max` is the maximum length, for arrays and maps it bounds each element. */
+  uint16_t min;
+  uint16_t max;
+  uint8_t flags;
+
+  constexpr FieldType type() const { return static_cast<FieldType>(member.index()); }
+  constexpr bool has(Flags flag) const { return (flags & flag) != 0; }
+};
+
+template <typename T>
+struct member_value;
+template <typename T, typename Config>
+struct member_value<T Config::*> {
+  using type = T;
+};
+template <typename M>
+using member_value_t = typename member_value<M>::type;
+
+template <typename T>
+constexpr uint16_t defaultMax() {
+  if constexpr (std::is_same_v<T, uint16_t>) return std::numeric_limits<uint16_t>::max();
+  else if constexpr (std::is_same_v<T, bool>) return 1;
+  else return std::numeric_limits<uint8_t>::max();
+}
+
+template <typename Config, typename T>
+constexpr FieldDescriptor<Config> field(std::string_view name, T Config::*member, uint8_t flags = F_NONE) {
+  static_assert(!std::is_same_v<T, std::string>, "string fields need an explicit maximum length");
+  return {name, member, 0, defaultMax<T>(), flags};
+}
+
+template <typename Config, typename T>
+constexpr FieldDescriptor<Config> field(std::string_view name, T Config::*member, uint16_t min, uint16_t max,
+                                        uint8_t flags = F_NONE) {
+  return {name, member, min, max, flags};
+}
+
+/** Longest PEM certificate or key ConfigManager::saveCertificate() accepts. */
+inline constexpr uint16_t MAX_CERT_LENGTH = 16384;
+/** A DNS name is at most 253 characters. */
+inline constexpr uint16_t MAX_HOST_LENGTH = 253;
+/**
+ * Longest MQTT client id, credential or topic. The CONNECT packet carries the client id,
+ * user name, password and LWT topic and has to fit esp-mqtt's 1024-byte buffer.
+ */
+inline constexpr uint16_t MAX_MQTT_STRING_LENGTH = 200;
+/** The device name is the mDNS instance name, a single DNS label. */
+inline constexpr uint16_t MAX_DEVICE_NAME_LENGTH = 63;
+/** HomeSpan refuses to enable OTA with a longer password. */
+inline constexpr uint16_t MAX_OTA_PASSWORD_LENGTH = 32;
+/** The Basic auth header for both credentials has to fit esp_http_server's 512-byte header limit. */
+inline constexpr uint16_t MAX_WEB_CREDENTIAL_LENGTH = 128;
+/** Longest WPA2 passphrase. */
+inline constexpr uint16_t MAX_WIFI_PASSWORD_LENGTH = 63;
+
+template <typename Config>
+struct Schema;
+
+template <>
+struct Schema<mqttConfig_t> {
+  using C = mqttConfig_t;
+  static constexpr auto fields = std::to_array<FieldDescriptor<C>>({
+      field("mqttBroker", &C::mqttBroker, 0, MAX_HOST_LENGTH),
+      field("mqttPort", &C::mqttPort, 1, std::numeric_limits<uint16_t>::max()),
+      field("mqttClientId", &C::mqttClientId, 0, MAX_MQTT_STRING_LENGTH),
+      field("mqttUsername", &C::mqttUsername, 0, MAX_MQTT_STRING_LENGTH),
+      field("mqttPassword", &C::mqttPassword, 0, MAX_MQTT_STRING_LENGTH, F_SECRET),
+      field("hassMqttDiscoveryEnabled", &C::hassMqttDiscoveryEnabled),
+      field("lwtTopic", &C::lwtTopic, 0, MAX_MQTT_STRING_LENGTH),
+      field("hkTopic", &C::hkTopic, 0, MAX_MQTT_STRING_LENGTH),
+      field("lockStateTopic", &C::lockStateTopic, 0, MAX_MQTT_STRING_LENGTH),
+      field("lockStateCmd", &C::lockStateCmd, 0, MAX_MQTT_STRING_LENGTH),
+      field("lockCStateCmd", &C::lockCStateCmd, 0, MAX_MQTT_STRING_LENGTH),
+      field("lockTStateCmd", &C::lockTStateCmd, 0, MAX_MQTT_STRING_LENGTH),
+      field("btrLvlCmdTopic", &C::btrLvlCmdTopic, 0, MAX_MQTT_STRING_LENGTH),
+      field("hkAltActionTopic", &C::hkAltActionTopic, 0, MAX_MQTT_STRING_LENGTH),
+      field("lockCustomStateTopic", &C::lockCustomStateTopic, 0, MAX_MQTT_STRING_LENGTH),
+      field("lockCustomStateCmd", &C::lockCustomStateCmd, 0, MAX_MQTT_STRING_LENGTH),
+      field("lockEnableCustomState", &C::lockEnableCustomState),
+      field("nfcTagNoPublish", &C::nfcTagNoPublish),
+      field("useSSL", &C::useSSL),
+      field("allowInsecure", &C::allowInsecure),
+      field("customLockStates", &C::customLockStates),
+      field("customLockActions", &C::customLockActions),
+  });
+};
+
+template <>
+struct Schema<misc_config_t> {
+  using C = misc_config_t;
+  static constexpr auto fields = std::to_array<FieldDescriptor<C>>({
+      field("deviceName", &C::deviceName, 0, MAX_DEVICE_NAME_LENGTH),
+      field("otaPasswd", &C::otaPasswd, 0, MAX_OTA_PASSWORD_LENGTH, F_SECRET),
+      field("hk_key_color", &C::hk_key_color, TAN, BLACK),
+      field("setupCode", &C::setupCode, 0, 8),
+      field("lockAlwaysUnlock", &C::lockAlwaysUnlock),
+      field("lockAlwaysLock", &C::lockAlwaysLock),
+      field("hkAuthPrecomputeEnabled", &C::hkAuthPrecomputeEnabled),
+      field("nfcFastPollingEnabled", &C::nfcFastPollingEnabled),
+      // 0 = PN532 (SPI), 1 = PN7160, 2 = ST25R3916 (I2C).
+      field("nfcReaderType", &C::nfcReaderType, 0, 2),
+      field("nfcIrqPin", &C::nfcIrqPin, F_GPIO),
+      field("nfcVenPin", &C::nfcVenPin, F_GPIO),
+      field("controlPin", &C::controlPin, F_GPIO),
+      field("hsStatusPin", &C::hsStatusPin, F_GPIO),
+      field("webAuthEnabled", &C::webAuthEnabled),
+      field("webUsername", &C::webUsername, 0, MAX_WEB_CREDENTIAL_LENGTH),
+      field("webPassword", &C::webPassword, 0, MAX_WEB_CREDENTIAL_LENGTH, F_SECRET),
+      field("webHttpsEnabled", &C::webHttpsEnabled),
+      field("nfcGpioPins", &C::nfcGpioPins, F_GPIO),
+      field("nfcPinsPreset", &C::nfcPinsPreset),
+      field("btrLowStatusThreshold", &C::btrLowStatusThreshold, 0, 100),
+      field("proxBatEnabled", &C::proxBatEnabled),
+      field("ethernetEnabled", &C::ethernetEnabled),
+      field("ethActivePreset", &C::ethActivePreset),
+      field("ethPhyType", &C::ethPhyType),
+      field("ethSpiBus", &C::ethSpiBus, SPI2_HOST, SPI_HOST_MAX - 1),
+      field("ethRmiiConfig", &C::ethRmiiConfig),
+      field("ethSpiConfig", &C::ethSpiConfig, F_GPIO | F_FIRST_NOT_GPIO),
+      field("overrideStrappingRestriction", &C::overrideStrappingRestriction),
+      field("accessPointPassword", &C::accessPointPassword, 0, MAX_WIFI_PASSWORD_LENGTH, F_SECRET),
+  });
+};
+
+template <>
+struct Schema<actions_config_t> {
+  using C = actions_config_t;
+  static constexpr auto fields = std::to_array<FieldDescriptor<C>>({
+      field("nfcNeopixelPin", &C::nfcNeopixelPin, F_GPIO),
+      field("neoPixelType", &C::neoPixelType),
+      field("neopixelSuccessColor", &C::neopixelSuccessColor),
+      field("neopixelFailureColor", &C::neopixelFailureColor),
+      field("neopixelSuccessTime", &C::neopixelSuccessTime),
+      field("neopixelFailTime", &C::neopixelFailTime),
+      field("neopixelTagEventTime", &C::neopixelTagEventTime),
+      field("neopixelTagEventColor", &C::neopixelTagEventColor),
+      field("nfcSuccessPin", &C::nfcSuccessPin, F_GPIO),
+      field("nfcSuccessTime", &C::nfcSuccessTime),
+      field("nfcSuccessHL", &C::nfcSuccessHL),
+      field("nfcFailPin", &C::nfcFailPin, F_GPIO),
+      field("nfcFailTime", &C::nfcFailTime),
+      field("nfcFailHL", &C::nfcFailHL),
+      field("tagEventPin", &C::tagEventPin, F_GPIO),
+      field("tagEventTimeout", &C::tagEventTimeout),
+      field("tagEventHL", &C::tagEventHL),
+      field("gpioActionPin", &C::gpioActionPin, F_GPIO),
+      field("gpioActionLockState", &C::gpioActionLockState),
+      field("gpioActionUnlockState", &C::gpioActionUnlockState),
+      field("gpioActionMomentaryEnabled", &C::gpioActionMomentaryEnabled),
+      field("hkGpioControlledState", &C::hkGpioControlledState),
+      field("gpioActionMomentaryTimeout", &C::gpioActionMomentaryTimeout),
+      field("hkDumbSwitchMode", &C::hkDumbSwitchMode),
+      field("hkAltActionPin", &C::hkAltActionPin, F_GPIO),
+      field("hkAltActionTimeout", &C::hkAltActionTimeout),
+      field("hkAltActionGpioState", &C::hkAltActionGpioState),
+      field("hkAltActionInitPin", &C::hkAltActionInitPin, F_GPIO),
+      field("hkAltActionInitLedPin", &C::hkAltActionInitLedPin, F_GPIO),
+      field("hkAltActionInitTimeout", &C::hkAltActionInitTimeout),
+      field("feedbackPatterns", &C::feedbackPatterns, 0, 512),
+  });
+};
+
+template <>
+struct Schema<mqtt_ssl_t> {
+  using C = mqtt_ssl_t;
+  static constexpr auto fields = std::to_array<FieldDescriptor<C>>({
+      field("caCert", &C::caCert, 0, MAX_CERT_LENGTH),
+      field("clientCert", &C::clientCert, 0, MAX_CERT_LENGTH),
+      field("clientKey", &C::clientKey, 0, MAX_CERT_LENGTH, F_SECRET),
+  });
+};
+
+template <>
+struct Schema<https_certs_t> {
+  using C = https_certs_t;
+  static constexpr auto fields = std::to_array<FieldDescriptor<C>>({
+      field("serverCert", &C::serverCert, 0, MAX_CERT_LENGTH),
+      field("privateKey", &C::privateKey, 0, MAX_CERT_LENGTH, F_SECRET),
+      field("caCert", &C::caCert, 0, MAX_CERT_LENGTH),
+  });
+};
+
+/**
+ * @brief Look up a field descriptor by its external key.
+ * @return Pointer into the static table, or nullptr if @p name is not a field of @p Config.
+ */
+template <typename Config>
+constexpr const FieldDescriptor<Config>* find(std::string_view name) {
+  for (const auto& f : Schema<Config>::fields) {
+    if (f.name == name) return &f;
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Typed access to a field of a config instance.
+ * @return Pointer to the member, or nullptr if the field is not of type @p T.
+ */
+template <typename T, typename Config>
+const T* get(const Config& config, const FieldDescriptor<Config>& field) {
+  if (auto m = std::get_if<T Config::*>(&field.member)) return &(config.**m);
+  return nullptr;
+}
+
+/**
+ * @brief Copy the current value of a field into a type-erased FieldValue.
+ */
+template <typename Config>
+FieldValue load(const Config& config, const FieldDescriptor<Config>& field) {
+  return std::visit([&](auto m) -> FieldValue { return config.*m; }, field.member);
+}
+
+/**
+ * @brief Assign a FieldValue to the corresponding member; the value must hold the field's type.
+ */
+template <typename Config>
+void store(Config& config, const FieldDescriptor<Config>& field, const FieldValue& value) {
+  std::visit([&](auto m) { config.*m = std::get<member_value_t<decltype(m)>>(value); }, field.member);
+}
+
+template <typename Config>
+bool equals(const Config& config, const FieldDescriptor<Config>& field, const FieldValue& value) {
+  return std::visit([&](auto m) {
+    using T = member_value_t<decltype(m)>;
+    const T* v = std::get_if<T>(&value);
+    return v && config.*m == *v;
+  }, field.member);
+}
+
+/**
+ * @brief View the bytes of a fixed-size array value; empty for any other type.
+ */
+inline std::span<const uint8_t> bytes(const FieldValue& value) {
+  return std::visit([](const auto& v) -> std::span<const uint8_t> {
+    using T = std::decay_t<decltype(v)>;
+    if constexpr (std::is_same_v<T, std::array<uint8_t, 4>> || std::is_same_v<T, std::array<uint8_t, 5>> ||
+                  std::is_same_v<T, std::array<uint8_t, 7>>) {
+      return v;
+    } else {
+      return {};
+    }
+  }, value);
+}
+
+inline std::span<uint8_t> bytes(FieldValue& value) {
+  return std::visit([](auto& v) -> std::span<uint8_t> {
+    using T = std::decay_t<decltype(v)>;
+    if constexpr (std::is_same_v<T, std::array<uint8_t, 4>> || std::is_same_v<T, std::array<uint8_t, 5>> ||
+                  std::is_same_v<T, std::array<uint8_t, 7>>) {
+      return v;
+    } else {
+      return {};
+    }
+  }, value);
+}
+
+} // namespace espConfig::fields
@@ -9,6 +9,9 @@
 #include <map>
 #include <LittleFS.h>
 #include "msgpack/object.h"
+#include "MemoryPlacement.hpp"
+
+namespace espConfig::fields { template <typename Config> class ConfigPatch; }
 
 struct CertificateStatus {
   espConfig::CertType type;
@@ -55,7 +58,7 @@ public:
     std::string serializeToJson();
 
     template <typename ConfigType>
-    std::string updateFromJson(const std::string& json_string);
+    std::string applyPatch(const espConfig::fields::ConfigPatch<ConfigType>& patch);
 
     bool saveCertificate(espConfig::CertType certType, const std::string& certContent);
     bool deleteCertificate(espConfig::CertType certType);
@@ -75,17 +78,14 @@ public:
     bool getBacklogMaxSize(uint16_t &size);
 
   private:
-    using ConfigMapType = std::map<std::string,
-                      std::variant<
-                          std::string *, uint16_t *, uint8_t *, bool *,
-                          std::map<std::string, uint8_t> *,
-                          std::map<espConfig::actions_config_t::colorMap, uint8_t> *,
-                          std::array<uint8_t, 4> *, std::array<uint8_t, 5> *,
-                          std::array<uint8_t, 7> *>>;
-    void deserialize(msgpack_object obj, std::string key);
+    template <typename ConfigType>
+    ConfigType& configFor();
+
+    template <typename ConfigType>
+    void deserialize(msgpack_object obj, ConfigType& config);
 
     template <typename ConfigType>
-    std::vector<uint8_t> serialize();
+    BulkVector<uint8_t> serialize();
 
     void loadConfigFromNvs(const char* key);
     bool saveConfigToNvs(const char* key);
@@ -94,7 +94,6 @@ public:
     bool validatePrivateKeyContent(const std::string& keyContent);
     bool validateKeyCertPair(const std::string& privateKey, const std::string& certificate, const char* context);
 
-    std::map<std::string, ConfigMapType> m_configMap;
     espConfig::mqttConfig_t m_mqttConfig;
     espConfig::mqtt_ssl_t m_mqttSslConfig;
     espConfig::https_certs_t m_httpsCertsConfig;
@@ -0,0 +1,278 @@
+#pragma once
+#include "ConfigFields.hpp"
+#include "JsonStreamParser.hpp"
+#include <array>
+#include <charconv>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace espConfig::fields {
+
+/**
+ * @brief A validated set of pending changes to one config struct.
+ *
+ * Holds only the fields that were present in a request, keyed by their static
+ * descriptor, so memory use scales with the size of the change rather than the
+ * size of the whole configuration.
+ */
+template <typename Config>
+class ConfigPatch {
+public:
+  struct Change {
+    const FieldDescriptor<Config>* field;
+    FieldValue value;
+  };
+
+  /** @brief Stage @p value for @p field, replacing any earlier value for the same field. */
+  void set(const FieldDescriptor<Config>& field, FieldValue value) {
+    for (auto& c : m_changes) {
+      if (c.field == &field) {
+        c.value = std::move(value);
+        return;
+      }
+    }
+    m_changes.push_back({&field, std::move(value)});
+  }
+
+  const Change* find(std::string_view name) const {
+    for (const auto& c : m_changes) {
+      if (c.field->name == name) return &c;
+    }
+    return nullptr;
+  }
+
+  /** @brief Staged value of @p name if present and of type @p T. */
+  template <typename T>
+  const T* get(std::string_view name) const {
+    const Change* c = find(name);
+    return c ? std::get_if<T>(&c->value) : nullptr;
+  }
+
+  void apply(Config& target) const {
+    for (const auto& c : m_changes) store(target, *c.field, c.value);
+  }
+
+  bool empty() const { return m_changes.empty(); }
+  auto begin() const { return m_changes.begin(); }
+  auto end() const { return m_changes.end(); }
+
+private:
+  std::vector<Change> m_changes;
+};
+
+/**
+ * @brief JsonStreamParser handler that turns a flat JSON object into a ConfigPatch.
+ *
+ * Each member is matched against Schema<Config> as soon as its key arrives and its
+ * value is type- and range-checked while it streams in. Parsing stops at the first
+ * invalid member and error() describes the problem in a form suitable for clients.
+ * Keys that are not config fields can be captured as plain strings via capture().
+ */
+template <typename Config>
+class ConfigPatchBuilder : public JsonStreamParser::Handler {
+public:
+  using Event = JsonStreamParser::Event;
+
+  explicit ConfigPatchBuilder(const Config& current) : m_current(current) {}
+
+  /** @brief Accept @p key as a top-level string outside of the schema and store it in @p out. */
+  void capture(std::string_view key, std::string* out) {
+    for (auto& e : m_extras) {
+      if (!e.out) {
+        e = {key, out};
+        return;
+      }
+    }
+  }
+
+  bool onEvent(Event event, std::string_view value, uint8_t depth) override {
+    if (depth == 0) {
+      if (event == Event::ObjectStart || event == Event::ObjectEnd) return true;
+      return reject("JSON root is not an object.");
+    }
+    if (depth == 1 && event == Event::Key && !m_field && !m_extra) return beginMember(value);
+    if (m_extra) {
+      if (depth != 1 || event != Event::String) return typeError(event, value);
+      m_extra->assign(value);
+      m_extra = nullptr;
+      return true;
+    }
+    if (!m_field) return reject("Malformed request.");
+    return memberValue(event, value, depth);
+  }
+
+  ConfigPatch<Config>& patch() { return m_patch; }
+  const std::string& error() const { return m_error; }
+
+private:
+  struct Extra {
+    std::string_view key;
+    std::string* out = nullptr;
+  };
+
+  bool beginMember(std::string_view key) {
+    for (auto& e : m_extras) {
+      if (e.out && e.key == key) {
+        m_extra = e.out;
+        return true;
+      }
+    }
+    m_field = find<Config>(key);
+    if (!m_field) return reject("\"" + std::string(key) + "\" is not a valid configuration key.");
+    m_index = 0;
+    return true;
+  }
+
+  bool memberValue(Event event, std::string_view value, uint8_t depth) {
+    const auto& f = *m_field;
+    switch (f.type()) {
+      case FieldType::String:
+        if (depth != 1 || event != Event::String) return typeError(event, value);
+        if (value.size() > f.max) {
+          return reject("\"" + std::string(f.name) + "\" is too long (max " + std::to_string(f.max) + " characters).");
+        }
+        return commit(std::string(value));
+
+      case FieldType::Bool:
+        if (depth == 1 && event == Event::Bool) return commit(value == "true");
+        if (depth == 1 && event == Event::Number && (value == "0" || value == "1")) return commit(value == "1");
+        return typeError(event, value);
+
+      case FieldType::U8:
+      case FieldType::U16: {
+        if (depth != 1 || event != Event::Number) return typeError(event, value);
+        uint16_t v;
+        if (!parseNumber(value, f.min, f.max, v)) return rangeError(value);
+        if (f.type() == FieldType::U8) return commit(static_cast<uint8_t>(v));
+        return commit(v);
+      }
+
+      case FieldType::Bytes4:
+      case FieldType::Bytes5:
+      case FieldType::Bytes7: {
+        if (depth == 1 && event == Event::ArrayStart) {
+          m_value = load(m_current, f);
+          return true;
+        }
+        auto arr = bytes(m_value);
+        if (depth == 2 && event == Event::Number) {
+          uint16_t v;
+          if (m_index >= arr.size()) return sizeError(arr.size());
+          if (!parseNumber(value, f.min, f.max, v)) return rangeError(value);
+          arr[m_index++] = static_cast<uint8_t>(v);
+          return true;
+        }
+        if (depth == 1 && event == Event::ArrayEnd) {
+          if (m_index != arr.size()) return sizeError(arr.size());
+          return commit(std::move(m_value));
+        }
+        return typeError(event, value);
+      }
+
+      case FieldType::StateMap: {
+        // The object replaces the whole map, so a key left out of it is removed.
+        if (depth == 1 && event == Event::ObjectStart) {
+          m_value = StateMap{};
+          return true;
+        }
+        if (depth == 2 && event == Event::Key) {
+          m_mapKey.assign(value);
+          return true;
+        }
+        if (depth == 2 && event == Event::Number) {
+          uint16_t v;
+          if (!parseNumber(value, f.min, f.max, v)) return rangeError(value);
+          std::get<StateMap>(m_value)[m_mapKey] = static_cast<uint8_t>(v);
+          return true;
+        }
+        if (depth == 1 && event == Event::ObjectEnd) return commit(std::move(m_value));
+        return typeError(event, value);
+      }
+
+      case FieldType::ColorMap: {
+        if (depth == 1 && event == Event::ArrayStart) {
+          m_value = ColorMap{};
+          return true;
+        }
+        if (depth == 2 && event == Event::ArrayStart) {
+          m_index = 0;
+          return true;
+        }
+        if (depth == 3 && event == Event::Number && m_index < 2) {
+          uint16_t v;
+          uint16_t max = m_index == 0 ? static_cast<uint16_t>(actions_config_t::B) : f.max;
+          if (!parseNumber(value, 0, max, v)) return rangeError(value);
+          m_pair[m_index++] = static_cast<uint8_t>(v);
+          return true;
+        }
+        if (depth == 2 && event == Event::ArrayEnd && m_index == 2) {
+          std::get<ColorMap>(m_value)[static_cast<actions_config_t::colorMap>(m_pair[0])] = m_pair[1];
+          return true;
+        }
+        if (depth == 1 && event == Event::ArrayEnd) return commit(std::move(m_value));
+        return reject("Invalid value for key \"" + std::string(f.name) + "\". Expected an array of [key, value] pairs.");
+      }
+    }
+    return typeError(event, value);
+  }
+
+  bool commit(FieldValue value) {
+    m_patch.set(*m_field, std::move(value));
+    m_field = nullptr;
+    return true;
+  }
+
+  /**
+   * @brief Parse an integral JSON number and check it against [min, max].
+   */
+  static bool parseNumber(std::string_view text, uint16_t min, uint16_t max, uint16_t& out) {
+    long v = 0;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), v);
+    if (ec != std::errc() || ptr != text.data() + text.size() || v < min || v > max) return false;
+    out = static_cast<uint16_t>(v);
+    return true;
+  }
+
+  bool typeError(Event event, std::string_view value) {
+    std::string received;
+    switch (event) {
+      case Event::ObjectStart: received = "object"; break;
+      case Event::ArrayStart: received = "array"; break;
+      case Event::Null: received = "null"; break;
+      case Event::String: received = "\"" + std::string(value) + "\""; break;
+      default: received = std::string(value); break;
+    }
+    std::string key = m_field ? std::string(m_field->name) : "value";
+    return reject("Invalid type for key \"" + key + "\". Received: " + received);
+  }
+
+  bool rangeError(std::string_view value) {
+    return reject(std::string(value) + " is not a valid value for \"" + std::string(m_field->name) + "\" (" +
+                  std::to_string(m_field->min) + "-" + std::to_string(m_field->max) + ").");
+  }
+
+  bool sizeError(size_t expected) {
+    return reject("Invalid array size for key \"" + std::string(m_field->name) + "\". Expected " +
+                  std::to_string(expected) + " elements.");
+  }
+
+  bool reject(std::string msg) {
+    m_error = std::move(msg);
+    return false;
+  }
+
+  const Config& m_current;
+  ConfigPatch<Config> m_patch;
+  const FieldDescriptor<Config>* m_field = nullptr;
+  std::string* m_extra = nullptr;
+  std::array<Extra, 2> m_extras{};
+  FieldValue m_value;
+  std::string m_mapKey;
+  std::array<uint8_t, 2> m_pair{};
+  size_t m_index = 0;
+  std::string m_error;
+};
+
+} // namespace espConfig::fields
@@ -0,0 +1,89 @@
+#pragma once
+#include "OtaSink.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Streaming applier for delta firmware patches.
+ *
+ * A patch rebuilds the target image from the currently running image (the "source") and
+ * is applied while it is being received: no part of the patch, source or target is held
+ * in memory beyond a small work buffer. The class has no ESP-IDF dependencies so it can
+ * be built and run against sample images on the host.
+ *
+ * Patch layout (all integers little-endian, varints are unsigned LEB128):
+ *
+ *     "HKDP" | u8 version (1) | u8[3] reserved
+ *     u32 source size | u32 target size
+ *     u8[32] SHA-256 of the source | u8[32] SHA-256 of the target
+ *     op*
+ *
+ *     0x00                                   END, must be the last byte of the patch
+ *     0x01 varint offset, varint len         COPY len bytes from source[offset]
+ *     0x02 varint len, u8[len]               INSERT literal bytes
+ *     0x03 varint offset, varint len, u8[len] ADD: out[i] = source[offset + i] + data[i]
+ *
+ * Verifying the hashes is left to the Source (source hash) and the caller or target sink
+ * (target hash), which have access to a SHA-256 implementation.
+ */
+class DeltaPatcher : public OtaSink {
+public:
+  static constexpr uint8_t VERSION = 1;
+  static constexpr size_t HEADER_SIZE = 80;
+
+  struct Header {
+    uint32_t sourceSize;
+    uint32_t targetSize;
+    std::array<uint8_t, 32> sourceSha256;
+    std::array<uint8_t, 32> targetSha256;
+  };
+
+  /** @brief Random-access reader for the image the patch was generated against. */
+  class Source {
+  public:
+    virtual ~Source() = default;
+    /** @brief Called once the header is parsed; return false if this is not the patch's base image. */
+    virtual bool accept(const Header &header) = 0;
+    virtual bool read(size_t offset, uint8_t *out, size_t len) = 0;
+  };
+
+  DeltaPatcher(Source &source, OtaSink &target) : m_source(source), m_target(target) {}
+
+  bool write(const uint8_t *data, size_t len) override;
+
+  /** @brief Checks that END was reached and the full target was produced, then finishes the target. */
+  bool finish() override;
+
+  bool headerParsed() const { return m_state > State::Header; }
+  const Header &header() const { return m_header; }
+  size_t outputBytes() const { return m_output; }
+  /** @brief Reason for the last failure, or nullptr. */
+  const char *error() const { return m_error; }
+
+private:
+  enum class State : uint8_t { Header, Opcode, Offset, Length, Insert, Add, End, Failed };
+  enum Op : uint8_t { OP_END = 0, OP_COPY = 1, OP_INSERT = 2, OP_ADD = 3 };
+
+  bool parseHeader();
+  bool readVarint(uint8_t byte, uint32_t &out);
+  bool beginOp();
+  bool copy();
+  bool add(const uint8_t *data, size_t len);
+  bool emit(const uint8_t *data, size_t len);
+  bool fail(const char *reason);
+
+  Source &m_source;
+  OtaSink &m_target;
+  Header m_header{};
+  State m_state = State::Header;
+  uint8_t m_op = OP_END;
+  uint32_t m_offset = 0;
+  uint32_t m_length = 0;
+  uint32_t m_varint = 0;
+  uint8_t m_varintShift = 0;
+  size_t m_headerFill = 0;
+  size_t m_output = 0;
+  const char *m_error = nullptr;
+  std::array<uint8_t, 256> m_buffer{};
+};
@@ -0,0 +1,87 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "MetricsRegistry.hpp"
+
+/**
+ * @brief One worker task that runs the firmware's small, non-blocking jobs.
+ *
+ * Managers used to give every short piece of background work its own FreeRTOS task,
+ * each with a stack sized for the worst case and mostly blocked. A job here is a callback
+ * registered once. It runs on the shared worker when it is posted (from a task or an
+ * ISR) or when its one-shot deadline passes.
+ *
+ * The run queue is the worker's task notification value: posting a job sets its bit, and
+ * the worker takes all set bits at once and runs those jobs in registration order. A job
+ * that is posted several times before it runs, runs once. Deadlines have the resolution
+ * of the FreeRTOS tick, so work that needs tighter timing belongs on an esp_timer.
+ *
+ * Jobs must not block: they share one stack and delay each other. Each job's run time is
+ * recorded in `hk_executor_job_run_us{job=...}`, whose `_sum` is the CPU time it used.
+ */
+class Executor {
+public:
+  using Callback = std::function<void()>;
+  using JobId = uint8_t;
+
+  static constexpr JobId INVALID_JOB = 0xFF;
+  static constexpr size_t MAX_JOBS = 16;
+
+  static Executor &instance() {
+    static Executor instance;
+    return instance;
+  }
+
+  /** @brief Start the worker task. Jobs may be added and scheduled before this, but posts are ignored. */
+  bool begin();
+
+  /**
+   * @brief Register a job.
+   * @param labels Metric labels naming the job, e.g. `job="ws_send"`. Must be a string literal.
+   * @return The job's id, or INVALID_JOB if all MAX_JOBS slots are taken.
+   */
+  JobId add(const char *labels, Callback fn);
+  /** @brief Unregister a job and drop any pending run or deadline. Not from inside the job itself. */
+  void remove(JobId job);
+
+  /** @brief Run @p job soon on the worker. */
+  void post(JobId job);
+  /** @brief post() for interrupt handlers. */
+  void IRAM_ATTR postFromISR(JobId job);
+
+  /** @brief Run @p job once, @p delayMs from now; replaces a deadline already set for it. */
+  void schedule(JobId job, uint32_t delayMs);
+  /** @brief Drop @p job's deadline, if any. A run that is already posted still happens. */
+  void cancel(JobId job);
+  /** @brief Whether @p job has a deadline that has not yet passed. */
+  bool scheduled(JobId job);
+
+private:
+  struct Job {
+    const char *labels = nullptr;
+    Callback fn;
+    MetricsRegistry::Histogram *runTime = nullptr;
+    int64_t deadline = 0; ///< esp_timer time in us; 0 = none.
+  };
+
+  static constexpr uint32_t JOB_BITS = (1UL << MAX_JOBS) - 1;
+  static constexpr uint32_t WAKE_BIT = 1UL << 31; ///< Notification bit that only re-reads the deadlines.
+  static constexpr uint32_t STACK_SIZE = 4096;
+  static constexpr UBaseType_t PRIORITY = 3;
+
+  Executor() = default;
+  static void taskEntry(void *instance);
+  void run();
+  /** @brief Move due jobs to @p ready; @return ticks until the next deadline, or portMAX_DELAY. */
+  TickType_t collectDue(uint32_t &ready);
+
+  std::mutex m_mutex; ///< Guards m_jobs; never taken from an ISR.
+  std::array<Job, MAX_JOBS> m_jobs{};
+  TaskHandle_t m_task = nullptr;
+};
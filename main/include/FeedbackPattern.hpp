@@ -0,0 +1,88 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace espConfig { struct actions_config_t; }
+
+/**
+ * @brief Declarative descriptions of the reader's visual/GPIO feedback.
+ *
+ * A pattern is a list of timed steps, each of which drives one output channel (the
+ * NeoPixel or one of the indicator GPIOs) for a number of milliseconds. The steps for
+ * one channel play in order; different channels play in parallel. Every channel's
+ * sequence is played @c repeat times and the channel then returns to idle (pixel off,
+ * GPIO at its inactive level).
+ *
+ * Built-in patterns mirror the per-event colors and durations of actions_config_t.
+ * The `feedbackPatterns` setting can replace any of them with a custom pattern:
+ *
+ *     spec   := entry (';' entry)*
+ *     entry  := event ['!' priority] ['*' repeat] '=' step (',' step)*
+ *     event  := success | failure | tag
+ *     step   := channel ':' value '/' milliseconds
+ *     channel:= pixel | successPin | failPin | tagPin
+ *     value  := RRGGBB | on | off      (a hex color is only valid for pixel)
+ *
+ * For example `failure*3=pixel:FF0000/150,pixel:off/150,failPin:on/900` blinks the pixel
+ * red three times while the failure GPIO is held active for the whole 2.7 s.
+ */
+namespace feedback {
+
+enum class Channel : uint8_t { Pixel, SuccessGpio, FailGpio, TagEventGpio, Count };
+enum class Event : uint8_t { Success, Failure, TagEvent, Count };
+
+inline constexpr size_t CHANNEL_COUNT = static_cast<size_t>(Channel::Count);
+inline constexpr size_t EVENT_COUNT = static_cast<size_t>(Event::Count);
+
+struct Step {
+  Channel channel = Channel::Pixel;
+  bool on = false;          ///< Pixel lit with r/g/b, or GPIO driven to its active level.
+  uint8_t r = 0, g = 0, b = 0;
+  uint16_t durationMs = 0;
+};
+
+/**
+ * @brief Fixed-capacity step list; copied by value so a running pattern never allocates.
+ *
+ * When two patterns compete for a channel, the one with the higher priority keeps it;
+ * on equal priority the newer one wins.
+ */
+struct Pattern {
+  static constexpr size_t MAX_STEPS = 16;
+
+  std::array<Step, MAX_STEPS> steps{};
+  uint8_t count = 0;
+  uint8_t repeat = 1;
+  uint8_t priority = 0;
+
+  bool add(const Step &step) {
+    if (count == MAX_STEPS) return false;
+    steps[count++] = step;
+    return true;
+  }
+  bool uses(Channel channel) const;
+  /** @brief Index of the first step for @p channel at or after @p from, or count if none. */
+  uint8_t next(Channel channel, uint8_t from) const;
+};
+
+using Overrides = std::array<std::optional<Pattern>, EVENT_COUNT>;
+
+/** @brief Default priority of an event's pattern; HomeKey results outrank plain tag reads. */
+uint8_t defaultPriority(Event event);
+
+/** @brief The pattern described by the per-event color, time and pin settings. */
+Pattern builtin(Event event, const espConfig::actions_config_t &config);
+
+/**
+ * @brief Parse a `feedbackPatterns` specification.
+ * @param out Receives one pattern for every event named in @p spec; others are left unset.
+ * @param error Set to a human-readable reason when parsing fails.
+ * @return false if @p spec is malformed; @p out is then left unspecified.
+ */
+bool parse(std::string_view spec, Overrides &out, std::string *error = nullptr);
+
+} // namespace feedback
@@ -4,10 +4,16 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <expected>
 #include <map>
+#include <mutex>
 #include "GPIOAllocator.hpp"
+#include "Executor.hpp"
+#include "FeedbackPattern.hpp"
+#include "MetricsRegistry.hpp"
 
 class ConfigManager;
 class Pixel;
@@ -20,6 +26,13 @@ namespace espConfig { struct actions_config_t; }
  * This class provides a high-level API for controlling physical hardware. It abstracts
  * away pin numbers, active high/low logic, and the implementation details of
  * providing user feedback (e.g., blinking an LED or lighting a NeoPixel).
+ *
+ * Feedback is played from declarative feedback::Pattern step lists. Every output that
+ * has to be switched back later (each feedback channel, the alt-action pin and the
+ * alt-action arming window) has one deadline slot, and a single one-shot esp_timer is
+ * kept pointed at the earliest of them. Lock output is applied directly on the event
+ * loop, and the alt-action initiator interrupt is handled by a job on the shared Executor,
+ * so the manager has no tasks of its own.
  */
 class HardwareManager {
 public:
@@ -37,7 +50,7 @@ public:
 ~HardwareManager() = default;
 
     /**
-     * @brief Initializes all hardware pins and starts background tasks for feedback.
+     * @brief Initializes all hardware pins, the NeoPixel and the feedback timer.
      */
     void begin();
 
@@ -47,6 +60,24 @@ public:
      */
     void setLockOutput(int state);
 
+    /**
+     * @brief Drive the lock output straight from the NFC task after a successful HomeKey tap.
+     *
+     * Only the GPIO is written. The state notifications follow when LockManager's HW_ACTION
+     * event arrives and setLockOutput() runs, which finds the pin already at that level.
+     * @param state The desired lock state (LOCKED or UNLOCKED).
+     * @param authorizedAt esp_timer time the tap was authorized, for the actuation latency metric.
+     */
+    void driveLockOutputDirect(int state, int64_t authorizedAt);
+
+    /**
+     * @brief Attribute the next setLockOutput() to a tap authorized at @p authorizedAt.
+     *
+     * Used instead of driveLockOutputDirect() when the direct path is disabled, so that the
+     * event-driven path reports its actuation latency too.
+     */
+    void expectLockOutput(int64_t authorizedAt);
+
     /**
      * @brief Triggers a non-blocking visual/audible signal for a successful action.
      */
@@ -64,79 +95,78 @@ public:
 
 private:
     /**
-     * @enum FeedbackType
-     * @brief Defines the types of feedback that can be requested.
+     * @brief Everything that is switched back after a delay, each with one deadline.
+     *
+     * The first entries coincide with feedback::Channel, so a channel's index is its slot.
      */
-    enum class FeedbackType {
-        SUCCESS,
-        FAILURE,
-        TAG_EVENT
-    };
-
-    enum class TimerSources : uint8_t {
-      GPIO_S,
-      GPIO_F,
-      TAG_EVENT,
-      PIXEL_S,
-      PIXEL_F,
-      PIXEL_TAG_EVENT,
+    enum class Slot : uint8_t {
+      PIXEL,
+      SUCCESS_GPIO,
+      FAIL_GPIO,
+      TAG_EVENT_GPIO,
       ALT_GPIO,
-      ALT_GPIO_INIT
+      ALT_GPIO_INIT,
+      COUNT
     };
-
-    struct TimerContext {
-        HardwareManager* hw_manager;
-        TimerSources timer_source;
+    static constexpr size_t SLOT_COUNT = static_cast<size_t>(Slot::COUNT);
+    static_assert(feedback::CHANNEL_COUNT <= SLOT_COUNT);
+
+    /// Progress of the pattern currently driving one feedback channel.
+    struct Track {
+        int8_t event = -1;      ///< feedback::Event playing on the channel, -1 when idle.
+        uint8_t step = 0;       ///< Index of the current step in the event's pattern.
+        uint8_t pass = 0;       ///< Completed repetitions.
     };
 
-    // --- FreeRTOS Task Management ---
-    static void feedbackTaskEntry(void* instance);
-    void feedbackTask();
-
-    static void lockControlTaskEntry(void* instance);
-    void lockControlTask();
-
-    static void initiator_task_entry(void* arg);
-    void initiator_task();
+    struct Metrics {
+        MetricsRegistry::Histogram& timerLateness;
+        MetricsRegistry::Counter& patternsStarted;
+        MetricsRegistry::Counter& patternsRejected;
+        MetricsRegistry::Histogram& lockActuationDirect;
+        MetricsRegistry::Histogram& lockActuationEvent;
+    };
+    static Metrics registerMetrics();
+
+    bool writeLockOutput(int state);
+
+    // --- Feedback patterns and the deadline scheduler (m_mutex) ---
+    void startPattern(feedback::Event event);
+    void loadFeedbackPatterns(const std::string& spec);
+    feedback::Pattern patternFor(feedback::Event event) const;
+    bool channelAvailable(feedback::Channel channel);
+    void applyStep(feedback::Channel channel, int64_t start);
+    void advance(feedback::Channel channel, int64_t start);
+    void setChannel(feedback::Channel channel, const feedback::Step* step);
+    void idleChannel(feedback::Channel channel);
+    void expire(Slot slot, int64_t deadline);
+    void schedule(Slot slot, uint32_t ms, int64_t start);
+    void rearm(int64_t now);
+    static void timerCallback(void* instance);
+    void onTimer();
+
+    // --- Alternate action initiator ---
+    void armAltAction();
     static void IRAM_ATTR initiator_isr_handler(void* arg);
 
-    static void handleTimer(void *instance);
-    
     // --- Member Variables ---
     const espConfig::actions_config_t& m_miscConfig;
+    Metrics m_metrics;
 
     Pixel* m_pixel = nullptr;
-  
-    esp_timer_handle_t m_gpioSuccessTimer;
-    esp_timer_handle_t m_gpioFailTimer;
-    esp_timer_handle_t m_tagEventTimer;
-    esp_timer_handle_t m_pixelSuccessTimer;
-    esp_timer_handle_t m_pixelFailTimer;
-    esp_timer_handle_t m_pixelTagEventTimer;
-    esp_timer_handle_t m_altActionTimer;
-    esp_timer_handle_t m_altActionInitTimer;
 
-    TaskHandle_t m_feedbackTaskHandle;
-    QueueHandle_t m_feedbackQueue;
+    std::mutex m_mutex;
+    esp_timer_handle_t m_timer = nullptr;
+    std::array<int64_t, SLOT_COUNT> m_deadlines{};   ///< esp_timer time in us; 0 = not scheduled.
+    std::array<Track, feedback::CHANNEL_COUNT> m_tracks{};
+    std::array<feedback::Pattern, feedback::EVENT_COUNT> m_running{};
+    feedback::Overrides m_overrides{};              ///< Parsed `feedbackPatterns`; empty entries use the built-in pattern.
 
-    TaskHandle_t m_lockControlTaskHandle;
-    QueueHandle_t m_lockControlQueue;
+    std::atomic<int64_t> m_lockOutputExpectedAt{0};   ///< Set by expectLockOutput(), 0 = none.
 
-    TaskHandle_t m_initiatorTaskHandle;
-    QueueHandle_t m_initiatorQueue;
+    Executor::JobId m_initiatorJob = Executor::INVALID_JOB;
 
     bool m_altActionArmed = false;
 
-    // Timer contexts (non-static to handle re-initialization correctly)
-    TimerContext m_gpioS_context;
-    TimerContext m_gpioF_context;
-    TimerContext m_tagEvent_context;
-    TimerContext m_pixelS_context;
-    TimerContext m_pixelF_context;
-    TimerContext m_pixelTagEvent_context;
-    TimerContext m_altAction_context;
-    TimerContext m_altActionInit_context;
-
     static const char* TAG;
 
     AppEventLoop::SubscriptionHandle m_hardware_action_event;
@@ -0,0 +1,126 @@
+#pragma once
+#include "MetricsRegistry.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * @brief Central admission control for operations that need a large amount of heap at once.
+ *
+ * Each heavy operation has a profile with its expected peak heap use and the largest
+ * single allocation it makes. Before it starts, the operation asks for a reservation.
+ * The reservation is granted only if the internal heap, minus everything already
+ * reserved, still keeps ADMISSION_FLOOR bytes free once this operation reaches its peak.
+ * It must also be possible to satisfy the largest allocation from one free block.
+ * Otherwise the caller is expected to answer 503 with the profile's Retry-After hint.
+ *
+ * A reservation is charged in full until it is released, even after the operation has
+ * actually allocated its memory (which the live heap figure then already reflects). This
+ * double counting is deliberate: it errs on the side of rejecting a second operation
+ * rather than letting two peaks overlap and reset the device.
+ *
+ * Reservations and rejections are exported as hk_heap_reserved_bytes and
+ * hk_admission_total{op,result}.
+ */
+class HeapAdmission {
+public:
+  enum class Op : uint8_t {
+    OtaFirmware,
+    OtaLittleFs,
+    CertificateParse,
+    WifiScan,
+    ConfigSave,
+    WsBacklogReplay,
+    Count
+  };
+
+  struct Profile {
+    const char *name;
+    uint32_t peakBytes;       ///< Expected peak heap use; may be overridden per request.
+    uint32_t largestAlloc;    ///< Largest single allocation; needs one free block this big.
+    uint8_t retryAfterSeconds;
+  };
+
+  /**
+   * @brief Move-only handle for an admitted operation; releases its bytes when destroyed.
+   *
+   * A default-constructed or rejected reservation is empty and converts to false.
+   */
+  class Reservation {
+  public:
+    Reservation() = default;
+    Reservation(Reservation &&other) noexcept : m_op(other.m_op), m_bytes(other.m_bytes) { other.m_bytes = 0; }
+    Reservation &operator=(Reservation &&other) noexcept;
+    Reservation(const Reservation &) = delete;
+    Reservation &operator=(const Reservation &) = delete;
+    ~Reservation() { release(); }
+
+    explicit operator bool() const { return m_bytes != 0; }
+    Op op() const { return m_op; }
+    /** @brief Return the reserved bytes early; safe to call more than once. */
+    void release();
+
+  private:
+    friend class HeapAdmission;
+    Reservation(Op op, uint32_t bytes) : m_op(op), m_bytes(bytes) {}
+
+    Op m_op = Op::Count;
+    uint32_t m_bytes = 0;
+  };
+
+  static HeapAdmission &instance() {
+    static HeapAdmission instance;
+    return instance;
+  }
+
+  static const Profile &profile(Op op) { return PROFILES[static_cast<size_t>(op)]; }
+
+  /**
+   * @brief Reserve heap for one run of @p op.
+   * @param bytes Peak to reserve instead of the profile default, for operations whose
+   *              footprint depends on the request (0 = use the profile).
+   * @return An engaged reservation when admitted, an empty one when rejected.
+   */
+  Reservation reserve(Op op, uint32_t bytes = 0);
+
+  /** @brief Bytes currently held by outstanding reservations. */
+  uint32_t reservedBytes() const;
+
+private:
+  /// Internal heap that must stay free after every admitted operation peaks.
+  static constexpr uint32_t ADMISSION_FLOOR = 24 * 1024;
+
+  static constexpr std::array<Profile, static_cast<size_t>(Op::Count)> PROFILES = {{
+      // mbedTLS record buffers are already accounted for by the open connection; this is the
+      // 4 KiB receive buffer, the pipeline's two 4 KiB flash pages and the partition/OTA handles.
+      {"ota_firmware", 32 * 1024, 12 * 1024, 10},
+      {"ota_littlefs", 32 * 1024, 12 * 1024, 10},
+      // PEM body (8 KiB max) plus the parsed x509/pk contexts.
+      {"certificate_parse", 16 * 1024, 8 * 1024, 5},
+      // Scan result list for up to ~20 APs plus the JSON response.
+      {"wifi_scan", 8 * 1024, 4 * 1024, 5},
+      // Patch builder, config copy and the NVS/msgpack blob.
+      {"config_save", 6 * 1024, 4 * 1024, 2},
+      // Default only; callers pass the actual backlog size.
+      {"ws_backlog_replay", 4 * 1024, 1 * 1024, 2},
+  }};
+
+  struct OpMetrics {
+    MetricsRegistry::Counter &admitted;
+    MetricsRegistry::Counter &rejected;
+  };
+
+  HeapAdmission();
+  HeapAdmission(const HeapAdmission &) = delete;
+  HeapAdmission &operator=(const HeapAdmission &) = delete;
+
+  void release(Op op, uint32_t bytes);
+  static std::array<OpMetrics, static_cast<size_t>(Op::Count)> registerMetrics();
+
+  mutable std::mutex m_mutex;
+  uint32_t m_reserved = 0;
+  MetricsRegistry::Gauge &m_reservedGauge;
+  MetricsRegistry::Gauge &m_activeGauge;
+  std::array<OpMetrics, static_cast<size_t>(Op::Count)> m_metrics;
+};
@@ -0,0 +1,131 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "sdkconfig.h"
+
+#ifndef CONFIG_HK_HEAP_PROFILER
+#define CONFIG_HK_HEAP_PROFILER 0
+#endif
+
+/**
+ * @brief Optional heap allocation profiler that attributes allocations to subsystems.
+ *
+ * Built with CONFIG_HK_HEAP_PROFILER, which installs the ESP-IDF heap hooks. Every
+ * allocation made after begin() is tagged with the subsystem it came from. The tag comes
+ * from the allocating task's name, or from a Scope for code that runs on someone else's
+ * task (log sinks). Allocation counts and bytes per tag are exact.
+ *
+ * Live bytes are estimated by sampling: about one allocation per
+ * CONFIG_HK_HEAP_PROFILER_SAMPLE_BYTES allocated bytes is remembered along with its call
+ * stack, and stands for that many bytes until it is freed. Blocks that stay allocated for
+ * a long time are sampled in proportion to their size, so the call sites holding the most
+ * sampled bytes are where a slow leak or a fragmenting long-lived block comes from.
+ * Allocations made before begin() are not tracked. Call stacks are only walked on Xtensa
+ * chips (ESP32, ESP32-S3); on RISC-V chips each tag is a single site.
+ *
+ * A TapWindow around an NFC transaction counts what the NFC task allocates during it. In
+ * A/B mode alternate taps bypass the TapArena, so the two arms show the heap churn per tap
+ * with and without it.
+ *
+ * With the option off, every method is an inline no-op and enabled() is false.
+ */
+class HeapProfiler {
+public:
+  enum class Tag : uint8_t { Other, Nfc, Web, Mqtt, HomeSpan, Network, Logging };
+  static constexpr size_t TAG_COUNT = 7;
+  /// Return addresses kept per sampled call site. Stacks are only walked on Xtensa chips.
+  static constexpr size_t STACK_DEPTH = 6;
+
+  struct TagStats {
+    Tag tag;
+    uint32_t allocs;          ///< Allocations since begin().
+    uint32_t allocBytes;      ///< Bytes requested since begin(); wraps at 4 GiB.
+    uint32_t liveBytes;       ///< Estimated bytes still allocated.
+    uint32_t highWaterBytes;  ///< Highest liveBytes estimate.
+  };
+
+  struct Site {
+    std::array<uintptr_t, STACK_DEPTH> frames; ///< Innermost first; unused entries are 0.
+    Tag tag;
+    uint32_t liveBytes;   ///< Estimated bytes allocated here and not yet freed.
+    uint32_t totalBytes;  ///< Estimated bytes allocated here since begin().
+  };
+
+  /** @brief Per-tap totals for one arm of the A/B comparison. */
+  struct TapArm {
+    uint32_t taps;
+    uint64_t allocs;
+    uint64_t allocBytes;
+  };
+
+  static HeapProfiler &instance() {
+    static HeapProfiler instance;
+    return instance;
+  }
+
+  static constexpr bool enabled() { return CONFIG_HK_HEAP_PROFILER; }
+  static const char *tagName(Tag tag);
+
+#if CONFIG_HK_HEAP_PROFILER
+  /** @brief Register metrics and start tracking allocations. */
+  void begin();
+
+  std::array<TagStats, TAG_COUNT> tags() const;
+  /** @brief Up to @p count call sites, most estimated live bytes first. */
+  std::vector<Site> topSites(size_t count) const;
+  /** @brief Index 0 is taps served with the TapArena, 1 is taps on the heap. */
+  std::array<TapArm, 2> taps() const;
+  /** @brief Alternate taps between the TapArena and the heap. */
+  void setAbMode(bool on);
+  bool abMode() const;
+  /** @brief Average number of allocated bytes per sample. */
+  static constexpr uint32_t sampleBytes() { return CONFIG_HK_HEAP_PROFILER_SAMPLE_BYTES; }
+
+  /** @brief Attributes allocations made by the calling task to @p tag while in scope. */
+  class Scope {
+  public:
+    explicit Scope(Tag tag);
+    ~Scope();
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    uint8_t m_previous;
+  };
+
+  /** @brief Counts the calling task's allocations while in scope, as one NFC transaction. */
+  class TapWindow {
+  public:
+    TapWindow();
+    ~TapWindow();
+    TapWindow(const TapWindow &) = delete;
+    TapWindow &operator=(const TapWindow &) = delete;
+
+  private:
+    bool m_open = false;
+    bool m_arena = false;
+  };
+#else
+  void begin() {}
+  std::array<TagStats, TAG_COUNT> tags() const { return {}; }
+  std::vector<Site> topSites(size_t) const { return {}; }
+  std::array<TapArm, 2> taps() const { return {}; }
+  void setAbMode(bool) {}
+  bool abMode() const { return false; }
+  static constexpr uint32_t sampleBytes() { return 0; }
+
+  class Scope {
+  public:
+    explicit Scope(Tag) {}
+  };
+  class TapWindow {
+  public:
+    TapWindow() {}
+  };
+#endif
+
+private:
+  HeapProfiler() = default;
+};
@@ -0,0 +1,70 @@
+#pragma once
+#include "OtaSink.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @brief Streaming heatshrink (LZSS) decompressor stage for OTA images.
+ *
+ * Input is a 12-byte header followed by a raw heatshrink bitstream as produced by
+ * `heatshrink -e -w <window> -l <lookahead>`:
+ *
+ *     "HKHS" | u8 window bits | u8 lookahead bits | u8[2] reserved | u32 uncompressed size (LE)
+ *
+ * RAM use is the 2^window byte history plus a small output buffer, regardless of image
+ * size. Window sizes above MAX_WINDOW_BITS are rejected to keep that bound. The class has
+ * no ESP-IDF dependencies so it can be benchmarked and fuzzed on the host.
+ */
+class HeatshrinkDecoder : public OtaSink {
+public:
+  static constexpr size_t HEADER_SIZE = 12;
+  static constexpr uint8_t MIN_WINDOW_BITS = 4;
+  static constexpr uint8_t MAX_WINDOW_BITS = 13;
+
+  explicit HeatshrinkDecoder(OtaSink &next) : m_next(next) {}
+
+  bool write(const uint8_t *data, size_t len) override;
+
+  /** @brief Checks that the declared size was produced, then finishes the next sink. */
+  bool finish() override;
+
+  bool headerParsed() const { return m_state > State::Header; }
+  /** @brief Uncompressed size declared in the header; 0 until the header is parsed. */
+  size_t outputSize() const { return m_outputSize; }
+  size_t outputBytes() const { return m_output; }
+  /** @brief Reason for the last failure, or nullptr. */
+  const char *error() const { return m_error; }
+
+private:
+  enum class State : uint8_t { Header, Tag, Literal, Index, Count, Done, Failed };
+
+  bool parseHeader();
+  bool bits(uint8_t count, uint32_t &out);
+  bool emit(uint8_t byte);
+  bool flush();
+  bool fail(const char *reason);
+
+  OtaSink &m_next;
+  State m_state = State::Header;
+  std::array<uint8_t, HEADER_SIZE> m_header{};
+  size_t m_headerFill = 0;
+  uint8_t m_windowBits = 0;
+  uint8_t m_lookaheadBits = 0;
+  size_t m_outputSize = 0;
+  size_t m_output = 0;
+
+  std::unique_ptr<uint8_t[]> m_window;
+  size_t m_windowMask = 0;
+  uint32_t m_index = 0;
+
+  const uint8_t *m_in = nullptr;
+  size_t m_inLen = 0;
+  uint32_t m_bitBuffer = 0;
+  uint8_t m_bitCount = 0;
+
+  std::array<uint8_t, 256> m_out{};
+  size_t m_outFill = 0;
+  const char *m_error = nullptr;
+};
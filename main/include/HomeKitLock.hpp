@@ -1,4 +1,8 @@
 #pragma once
+#include <mutex>
+#include <optional>
+#include <vector>
+#include "DDKReaderData.h"
 #include "HomeSpan.h"
 #include "app_event_loop.hpp"
 
@@ -33,10 +37,23 @@ public:
     void updateBatteryStatus(uint8_t batteryLevel, bool isLow);
 
 private:
-    SpanCharacteristic* m_lockCurrentState;
-    SpanCharacteristic* m_lockTargetState;
-    SpanCharacteristic* m_statusLowBattery;
-    SpanCharacteristic* m_batteryLevel;
+    SpanCharacteristic* m_lockCurrentState = nullptr;
+    SpanCharacteristic* m_lockTargetState = nullptr;
+    SpanCharacteristic* m_statusLowBattery = nullptr;
+    SpanCharacteristic* m_batteryLevel = nullptr;
+
+    /**
+     * Characteristic values waiting for the end of the coalescing window. Only the last value
+     * queued for each characteristic is kept.
+     */
+    struct PendingUpdates {
+      std::optional<int> currentState;
+      std::optional<int> targetState;
+      std::optional<uint8_t> batteryLevel;
+      std::optional<bool> lowBattery;
+    };
+    std::mutex m_pendingMutex;
+    PendingUpdates m_pending;
 
     LockManager& m_lockManager;
     ConfigManager& m_configManager;
@@ -53,8 +70,11 @@ private:
     static void staticControllerCallback();
     void controllerCallback();
     void setupDebugCommands();
+    void queueUpdate(const PendingUpdates& update);
+    void applyPendingUpdates();
 
     static const char* TAG;
+    static constexpr uint16_t HAP_PORT = 1201;
     AppEventLoop::SubscriptionHandle m_lock_state_changed;
     AppEventLoop::SubscriptionHandle m_hk_event;
 
@@ -65,6 +85,7 @@ private:
       LockManagementService();
     };
     struct LockMechanismService : Service::LockMechanism {
+      HomeKitLock& m_bridge;
       LockManager& m_lockManager;
       SpanCharacteristic* m_lockTargetState;
       SpanCharacteristic* m_lockCurrentState;
@@ -74,6 +95,9 @@ private:
     struct NFCAccessService : Service::NFCAccess {
         ReaderDataManager& m_readerDataManager;
         SpanCharacteristic* m_nfcControlPoint;
+        std::vector<uint8_t> m_request;
+        readerData_t m_workingData;
+        std::optional<uint32_t> m_workingGeneration; ///< ReaderDataManager::generation() m_workingData matches.
         NFCAccessService(ReaderDataManager& readerDataManager);
         boolean update() override;
     };
@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <sys/select.h>
+#include "esp_event.h"
+#include "MetricsRegistry.hpp"
+
+/**
+ * @brief Services HomeSpan on the Arduino loop task, blocking until there is work.
+ *
+ * HomeSpan does all its work in homeSpan.poll(). Calling that every 50 ms meant a lock
+ * command from a controller could wait 50 ms before HomeSpan read it, and the loop task
+ * woke 20 times a second with nothing to do. run() polls once and then blocks in select()
+ * on:
+ *
+ * - every socket bound to the HAP port or the ArduinoOTA port. HomeSpan does not expose its
+ *   sockets, so they are found by their local port in the lwIP socket table;
+ * - an eventfd that wake() signals. schedule() signals it so its deadline is met; Wi-Fi and IP
+ *   events and edges on the HomeSpan control pin signal it too.
+ *
+ * After any wake, HomeSpan is polled every BUSY_POLL_MS for BUSY_WINDOW_MS: it handles one
+ * request per client per poll, and bytes already read into a client's buffer no longer make
+ * the socket readable. Otherwise select() gives up after CONFIG_HK_HOMESPAN_IDLE_POLL_MS,
+ * which bounds the delay of work nothing signals, such as serial console input and HomeSpan's
+ * Wi-Fi retry timers.
+ *
+ * With CONFIG_HK_HOMESPAN_FIXED_POLL, run() keeps the old 50 ms period but still watches the
+ * sockets, so hk_homekit_command_latency_us can be compared between the two.
+ */
+class HomeSpanLoop {
+public:
+  static HomeSpanLoop &instance() {
+    static HomeSpanLoop instance;
+    return instance;
+  }
+
+  /**
+   * @brief Set up the wake sources. Call from the loop task, after homeSpan.begin().
+   * @param hapPort The port HomeSpan serves HAP on.
+   * @param controlPin HomeSpan's control button GPIO, or 255 for none.
+   */
+  void begin(uint16_t hapPort, uint8_t controlPin);
+
+  /** @brief Poll HomeSpan once, then block until there is more for it to do. Called by loop(). */
+  void run();
+
+  /** @brief Make run() poll HomeSpan now. Safe from any task. */
+  void wake();
+
+  /** @brief Set the function that a schedule() runs on the loop task, just before a poll. */
+  void setBeforePoll(std::function<void()> fn) { m_beforePoll = std::move(fn); }
+  /**
+   * @brief Run the setBeforePoll() function @p delayMs from now. Safe from any task.
+   *
+   * An earlier deadline that is still pending is kept, so the function runs at most
+   * @p delayMs after the first schedule() since it last ran.
+   */
+  void schedule(uint32_t delayMs);
+
+  /**
+   * @brief Record how long a HomeKit command took from reaching the socket to being handled.
+   *
+   * Call from the characteristic's update(), which HomeSpan runs inside poll().
+   */
+  void commandHandled();
+
+private:
+  enum class Wake : uint8_t { Timeout, Socket, Signal };
+
+  struct Metrics {
+    MetricsRegistry::Counter &socketWakes;
+    MetricsRegistry::Counter &signalWakes;
+    MetricsRegistry::Counter &timeoutWakes;
+    MetricsRegistry::Histogram &pollTime;
+    MetricsRegistry::Histogram &commandLatency;
+  };
+
+  static constexpr uint16_t OTA_PORT = 3232;  ///< ArduinoOTA's default, which HomeSpan keeps.
+  static constexpr uint32_t FIXED_POLL_MS = 50;
+  static constexpr uint32_t BUSY_POLL_MS = 10;
+  static constexpr uint32_t BUSY_WINDOW_MS = 250;
+  static constexpr uint8_t NO_PIN = 255;
+
+  HomeSpanLoop();
+  static Metrics registerMetrics();
+  static void onNetworkEvent(void *self, esp_event_base_t base, int32_t id, void *data);
+  static void onControlPinEdge(void *self);
+
+  /** @brief Run m_beforePoll if its deadline has passed. */
+  void runDue(int64_t now);
+  /** @brief Block for up to @p timeoutUs on the HomeSpan sockets and the wake eventfd. */
+  Wake wait(int64_t timeoutUs);
+  /** @return The highest fd added to @p fds, or -1 if none. */
+  int addHomeSpanSockets(fd_set &fds) const;
+  bool controlPinHeld() const;
+
+  Metrics m_metrics;
+  std::function<void()> m_beforePoll;
+  std::atomic<int64_t> m_deadline{0};  ///< esp_timer time in us for m_beforePoll; 0 = none.
+  std::atomic<int> m_wakeFd{-1};
+  uint16_t m_hapPort = 0;
+  uint8_t m_controlPin = NO_PIN;
+  int64_t m_busyUntil = 0;
+  int64_t m_readyAt = 0;  ///< When select() last saw a HomeSpan socket readable; 0 once polled.
+};
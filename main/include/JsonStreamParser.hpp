@@ -0,0 +1,139 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @class JsonStreamParser
+ * @brief Incremental (SAX-style) JSON tokenizer that never builds a document tree.
+ *
+ * Input is fed in arbitrary chunks, e.g. straight from `httpd_req_recv`, and every
+ * structural element is reported to a Handler as soon as it is complete. Scalar
+ * tokens (keys, strings, numbers, literals) are assembled in a caller-provided
+ * buffer, so peak memory is bounded by the longest single token rather than the
+ * size of the document. Tokens spanning chunk boundaries are handled transparently.
+ */
+class JsonStreamParser {
+public:
+    enum class Event : uint8_t {
+        ObjectStart,
+        ObjectEnd,
+        ArrayStart,
+        ArrayEnd,
+        Key,
+        String,
+        Number,
+        Bool,
+        Null
+    };
+
+    enum class Error : uint8_t {
+        None,
+        Syntax,
+        TokenTooLong,
+        TooDeep,
+        Aborted,
+        Incomplete
+    };
+
+    /**
+     * @brief Receives parse events.
+     *
+     * `value` carries the decoded key/string, the raw number text, or "true"/"false"
+     * for Bool; it is empty for structural events and only valid during the call.
+     * `depth` is the number of containers enclosing the element, so members of the
+     * root object are reported with depth 1 and the root object itself with depth 0.
+     */
+    class Handler {
+    public:
+        virtual ~Handler() = default;
+        /**
+         * @return false to stop parsing; feed() then fails with Error::Aborted.
+         */
+        virtual bool onEvent(Event event, std::string_view value, uint8_t depth) = 0;
+    };
+
+    static constexpr uint8_t MAX_DEPTH = 16;
+
+    /**
+     * @param handler Receiver of parse events.
+     * @param tokenBuffer Scratch storage for the token being assembled.
+     * @param tokenCapacity Size of @p tokenBuffer; longer tokens fail with Error::TokenTooLong.
+     */
+    JsonStreamParser(Handler& handler, char* tokenBuffer, size_t tokenCapacity);
+
+    /**
+     * @brief Consume the next chunk of input.
+     * @return false once an error has occurred; see error().
+     */
+    bool feed(const char* data, size_t len);
+
+    /**
+     * @brief Signal end of input.
+     * @return true if exactly one complete JSON value was consumed.
+     */
+    bool finish();
+
+    void reset();
+
+    bool done() const { return m_state == State::Done; }
+    Error error() const { return m_error; }
+    const char* errorString() const;
+    /** @brief Number of input bytes consumed so far (points at the offending byte on error). */
+    size_t position() const { return m_position; }
+
+private:
+    enum class State : uint8_t {
+        Value,
+        ValueOrArrayEnd,
+        KeyOrObjectEnd,
+        Key,
+        Colon,
+        CommaOrEnd,
+        Done,
+        Failed
+    };
+
+    enum class Lexeme : uint8_t {
+        None,
+        String,
+        StringEscape,
+        StringUnicode,
+        Number,
+        Literal
+    };
+
+    bool step(char c);
+    bool structural(char c);
+    bool beginValue(char c);
+    bool lexString(char c);
+    bool lexNumber(char c);
+    bool lexLiteral(char c);
+    bool append(char c);
+    bool appendCodepoint(uint32_t cp);
+    bool emit(Event event, std::string_view value);
+    bool emitToken(Event event);
+    bool push(bool isObject);
+    bool pop(bool isObject);
+    bool afterValue();
+    bool fail(Error error);
+    bool inObject() const;
+    static bool validNumber(std::string_view text);
+
+    Handler& m_handler;
+    char* m_token;
+    size_t m_capacity;
+    size_t m_length = 0;
+    size_t m_position = 0;
+    State m_state = State::Value;
+    Lexeme m_lexeme = Lexeme::None;
+    Error m_error = Error::None;
+    bool m_stringIsKey = false;
+    const char* m_literal = nullptr;
+    uint8_t m_literalPos = 0;
+    uint8_t m_unicodeDigits = 0;
+    uint32_t m_unicode = 0;
+    uint32_t m_highSurrogate = 0;
+    uint8_t m_depth = 0;
+    uint16_t m_containers = 0; // bit n set => container at depth n is an object
+};
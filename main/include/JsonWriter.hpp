@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <charconv>
+#include <span>
+#include <string_view>
+
+namespace hex {
+/** @brief Two uppercase hex digits for every byte value, built at compile time. */
+inline constexpr auto UPPER_PAIRS = [] {
+    constexpr char digits[] = "0123456789ABCDEF";
+    std::array<char, 512> table{};
+    for (size_t i = 0; i < 256; i++) {
+        table[2 * i] = digits[i >> 4];
+        table[2 * i + 1] = digits[i & 0x0F];
+    }
+    return table;
+}();
+
+/**
+ * @brief Write @p bytes as uppercase hex into @p out, which must hold 2 * bytes.size() chars.
+ * @return Number of characters written. No terminator is added.
+ */
+inline size_t encode(std::span<const uint8_t> bytes, char *out) {
+    for (uint8_t b : bytes) {
+        memcpy(out, &UPPER_PAIRS[2 * b], 2);
+        out += 2;
+    }
+    return 2 * bytes.size();
+}
+} // namespace hex
+
+/**
+ * @brief Writes a flat JSON object into a caller-provided buffer.
+ *
+ * The counterpart of JsonBuilder for hot paths: same fluent style, but nothing is
+ * allocated. A builder on a stack buffer produces the finished text directly, with no
+ * cJSON tree or std::string in between. If the buffer runs out, the writer stops and
+ * finish() returns an empty view, so a truncated document is never published.
+ *
+ * Only the value types needed by event payloads are supported; nested objects and
+ * arrays are out of scope.
+ */
+class JsonWriter {
+public:
+    JsonWriter(char *buffer, size_t capacity) : m_buf(buffer), m_cap(capacity) { put('{'); }
+    template <size_t N> explicit JsonWriter(std::array<char, N> &buffer) : JsonWriter(buffer.data(), N) {}
+
+    JsonWriter &addString(const char *key, std::string_view value) {
+        if (!this->key(key)) return *this;
+        put('"');
+        for (char c : value) {
+            if (c == '"' || c == '\\') {
+                put('\\');
+                put(c);
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                const char esc[] = {'\\', 'u', '0', '0', hex::UPPER_PAIRS[2 * uint8_t(c)],
+                                    hex::UPPER_PAIRS[2 * uint8_t(c) + 1]};
+                append(esc, sizeof(esc));
+            } else {
+                put(c);
+            }
+        }
+        put('"');
+        return *this;
+    }
+
+    /** @brief Add @p bytes as an uppercase hex string, e.g. {0x0a, 0xff} -> "0AFF". */
+    JsonWriter &addHex(const char *key, std::span<const uint8_t> bytes) {
+        if (!this->key(key)) return *this;
+        put('"');
+        if (room(2 * bytes.size())) m_len += hex::encode(bytes, m_buf + m_len);
+        put('"');
+        return *this;
+    }
+
+    JsonWriter &addBool(const char *key, bool value) {
+        if (this->key(key)) value ? append("true", 4) : append("false", 5);
+        return *this;
+    }
+
+    JsonWriter &addNumber(const char *key, int32_t value) {
+        if (!this->key(key)) return *this;
+        char digits[12];
+        auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+        append(digits, end - digits);
+        return *this;
+    }
+
+    /**
+     * @brief Close the object.
+     * @return The document, or an empty view if it did not fit. Valid as long as the buffer.
+     */
+    std::string_view finish() {
+        put('}');
+        if (m_overflow) return {};
+        return {m_buf, m_len};
+    }
+
+private:
+    bool room(size_t n) {
+        if (m_overflow || m_len + n > m_cap) {
+            m_overflow = true;
+            return false;
+        }
+        return true;
+    }
+    void put(char c) {
+        if (room(1)) m_buf[m_len++] = c;
+    }
+    void append(const char *s, size_t n) {
+        if (room(n)) {
+            memcpy(m_buf + m_len, s, n);
+            m_len += n;
+        }
+    }
+    bool key(const char *name) {
+        if (m_fields++) put(',');
+        put('"');
+        append(name, strlen(name));
+        append("\":", 2);
+        return !m_overflow;
+    }
+
+    char *m_buf;
+    size_t m_cap;
+    size_t m_len = 0;
+    size_t m_fields = 0;
+    bool m_overflow = false;
+};
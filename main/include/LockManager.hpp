@@ -1,7 +1,9 @@
 #pragma once
 #include "config.hpp"
-#include "esp_timer.h"
 #include "app_event_loop.hpp"
+#include "Executor.hpp"
+#include <atomic>
+#include <optional>
 class HardwareManager;
 class ConfigManager;
 class LockApplication;
@@ -42,19 +44,10 @@ public:
     /**
      * @brief Releases LockManager resources and unsubscribes its event handlers.
      *
-     * Unsubscribes the manager's EventBus subscriber handles and cleans up the
-     * momentary state timer if present. Unsubscribe calls are safe when handles
-     * are null (no-op). If the timer exists, it is stopped if active and then
-     * deleted.
+     * Unsubscribes the manager's EventBus subscriber handles via their RAII cleanup and
+     * unregisters the momentary relock job, dropping a pending relock.
      */
-    ~LockManager() {
-      if(momentaryStateTimer) {
-        if(esp_timer_is_active(momentaryStateTimer)) {
-          esp_timer_stop(momentaryStateTimer);
-        }
-        esp_timer_delete(momentaryStateTimer);
-      }
-    }
+    ~LockManager() { Executor::instance().remove(m_momentaryJob); }
 
     /**
      * @brief Initializes the lock state to its default.
@@ -82,21 +75,36 @@ public:
      * @param source The origin of the override.
      */
     void overrideState(uint8_t cstate, uint8_t tstate, Source source);
+
+    /**
+     * @brief Decide what a successful HomeKey tap will do, ahead of its NFC event.
+     *
+     * Safe to call from the NFC task. The decision is remembered and applied by the
+     * NFC_TAP_EVENT handler, so the lock output driven early and the state published
+     * later always agree.
+     * @return The state the lock output should be driven to now, or std::nullopt if this
+     *         tap does not drive the hardware.
+     */
+    std::optional<uint8_t> prepareNfcAction();
 private:
     const espConfig::misc_config_t& m_miscConfig;
     const espConfig::actions_config_t& m_actionsConfig;
 
-    uint8_t m_currentState;
-    uint8_t m_targetState;
+    // Written on the event loop, read by prepareNfcAction() on the NFC task.
+    std::atomic<uint8_t> m_currentState;
+    std::atomic<uint8_t> m_targetState;
+    /// Target chosen by prepareNfcAction() for the tap in flight, MAX if none.
+    std::atomic<uint8_t> m_pendingNfcTarget{lockStates::MAX};
     AppEventLoop::SubscriptionHandle m_override_state_event;
     AppEventLoop::SubscriptionHandle m_target_state_event;
     AppEventLoop::SubscriptionHandle m_update_state_event;
     AppEventLoop::SubscriptionHandle m_nfc_event;
 
-    esp_timer_handle_t momentaryStateTimer = nullptr;
+    /// Relocks after a momentary unlock; scheduled on the shared Executor.
+    Executor::JobId m_momentaryJob = Executor::INVALID_JOB;
 
     static const char* TAG;
-    static void handleTimer(void* instance);
     void stopMomentaryTimer();
     void startMomentaryTimerIfNeeded(Source source);
+    uint8_t nfcTargetState() const;
 };
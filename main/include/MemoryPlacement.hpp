@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <new>
+#include <vector>
+
+/**
+ * @brief Decides which RAM a buffer lives in, from how it is used.
+ *
+ * Internal RAM is small, and it is what mbedTLS, lwIP and Wi-Fi allocate from. PSRAM is
+ * several megabytes but slower, and peripherals cannot DMA from it. Each large buffer
+ * names an allocation class instead of heap_caps flags:
+ *
+ * - Hot: touched on a latency-sensitive path. Internal RAM only.
+ * - Dma: handed to a peripheral's DMA. Internal, DMA-capable RAM only.
+ * - Bulk: large, and touched rarely or in sequence (backlogs, OTA buffers, JSON documents,
+ *   serialized NVS blobs). PSRAM when the board has it, otherwise internal RAM.
+ *
+ * On boards without PSRAM every class ends up in internal RAM, as before. Bulk allocations
+ * that had to fall back while PSRAM is present are counted in
+ * hk_mem_bulk_fallbacks_total.
+ */
+class MemoryPlacement {
+public:
+  enum class Class : uint8_t { Hot, Dma, Bulk };
+
+  /** @brief Log where Bulk buffers will go, and route cJSON documents to Bulk. */
+  static void begin();
+
+  /** @brief Whether PSRAM was found and added to the heap at boot. */
+  static bool psramAvailable();
+
+  /** @return nullptr if neither the class's region nor its fallback has room. */
+  static void *allocate(Class cls, size_t bytes);
+  /** @brief Free memory from allocate(); nullptr is ignored. */
+  static void release(void *p);
+
+  /**
+   * @brief Write callback for C serializers such as msgpack that appends to a BulkVector<uint8_t>.
+   * @param vector A BulkVector<uint8_t>*.
+   */
+  static int appendToBulk(void *vector, const char *data, size_t len);
+};
+
+/** @brief Standard allocator that places a container's storage by allocation class. */
+template <typename T, MemoryPlacement::Class C> class PlacementAllocator {
+public:
+  using value_type = T;
+
+  PlacementAllocator() noexcept = default;
+  template <typename U> PlacementAllocator(const PlacementAllocator<U, C> &) noexcept {}
+
+  T *allocate(size_t n) {
+    void *p = MemoryPlacement::allocate(C, n * sizeof(T));
+    if (!p) std::__throw_bad_alloc();
+    return static_cast<T *>(p);
+  }
+  void deallocate(T *p, size_t) noexcept { MemoryPlacement::release(p); }
+
+  template <typename U> struct rebind {
+    using other = PlacementAllocator<U, C>;
+  };
+  template <typename U> bool operator==(const PlacementAllocator<U, C> &) const noexcept { return true; }
+};
+
+template <typename T> using BulkVector = std::vector<T, PlacementAllocator<T, MemoryPlacement::Class::Bulk>>;
+template <typename T> using BulkDeque = std::deque<T, PlacementAllocator<T, MemoryPlacement::Class::Bulk>>;
@@ -0,0 +1,95 @@
+#pragma once
+#include "MetricsRegistry.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * @brief Fixed-size, multi-resolution history of a few device health series.
+ *
+ * One sample per second goes into a ring of 1 s points. The same samples are folded into
+ * 1 min and 1 h points as those periods complete. Each point keeps:
+ * - the lowest free heap and largest free block seen in the period, since dips matter more than averages;
+ * - the average WiFi RSSI;
+ * - the number of NFC taps;
+ * - tap latency p50/p90/p99, estimated from a per-period log-scale histogram.
+ *
+ * Memory is fixed at construction (a few KiB), so history survives without any browser
+ * attached and costs nothing on the network until someone asks for it.
+ *
+ * Apart from the caller supplying samples, the class has no ESP-IDF dependencies.
+ */
+class MetricsHistory {
+public:
+  struct Point {
+    uint32_t heapFree = 0;
+    uint32_t heapLargest = 0;
+    int8_t rssi = 0;
+    uint16_t taps = 0;
+    uint16_t latencyP50 = 0;
+    uint16_t latencyP90 = 0;
+    uint16_t latencyP99 = 0;
+  };
+
+  static MetricsHistory &instance() {
+    static MetricsHistory instance;
+    return instance;
+  }
+
+  /** @brief Record the processing time of one NFC tap. Safe to call from any task. */
+  void recordTap(uint32_t latencyMs);
+
+  /**
+   * @brief Add the once-per-second gauge sample.
+   * @param uptimeSeconds Time of the sample; used to label the newest point of each level.
+   */
+  void addSample(uint32_t uptimeSeconds, uint32_t heapFree, uint32_t heapLargest, int8_t rssi);
+
+  /**
+   * @brief Write all levels as one JSON document, one array per series, oldest point first.
+   *
+   * Each level is copied out under the lock and rendered without it, so a slow client
+   * never holds up sampling.
+   */
+  bool render(const MetricsRegistry::Sink &sink) const;
+
+private:
+  // Upper bounds in ms; the last bucket catches everything above.
+  static constexpr uint16_t LATENCY_BOUNDS_MS[] = {25,  50,  75,   100,  150,  200,  300,
+                                                   400, 500, 750, 1000, 1500, 2000, 3000, 5000};
+  static constexpr size_t LATENCY_BUCKETS = std::size(LATENCY_BOUNDS_MS) + 1;
+  static constexpr size_t MAX_POINTS = 60;
+
+  struct Accumulator {
+    uint32_t heapFree = UINT32_MAX;
+    uint32_t heapLargest = UINT32_MAX;
+    int32_t rssiSum = 0;
+    uint16_t samples = 0;
+    uint16_t taps = 0;
+    std::array<uint16_t, LATENCY_BUCKETS> latency{};
+  };
+
+  struct Level {
+    const char *name;
+    uint32_t periodSeconds;
+    size_t capacity;
+    std::array<Point, MAX_POINTS> points{};
+    size_t head = 0;
+    size_t count = 0;
+    uint32_t newestEnd = 0;
+    Accumulator acc;
+  };
+
+  MetricsHistory();
+  MetricsHistory(const MetricsHistory &) = delete;
+  MetricsHistory &operator=(const MetricsHistory &) = delete;
+
+  static void close(Level &level, uint32_t uptimeSeconds);
+  static uint16_t percentile(const Accumulator &acc, uint32_t per100);
+
+  mutable std::mutex m_mutex;
+  std::array<Level, 3> m_levels;
+  std::array<uint16_t, LATENCY_BUCKETS> m_pendingLatency{};
+  uint16_t m_pendingTaps = 0;
+};
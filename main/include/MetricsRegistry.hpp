@@ -0,0 +1,133 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+/**
+ * @brief Process-wide registry of counters, gauges and histograms, rendered in the
+ * Prometheus text exposition format (version 0.0.4).
+ *
+ * Managers register their series once (usually in begin()) and keep the returned
+ * reference; updating a series is a single relaxed atomic operation, so hot paths such
+ * as the NFC polling task pay nothing beyond that. Series with the same name form one
+ * family and share its HELP/TYPE lines; they are told apart by a label string such as
+ * `type="homekey"`. Names, help texts and labels must be string literals (or otherwise
+ * outlive the registry), they are not copied.
+ *
+ * Registering a name/label pair twice returns the existing series, so a manager that is
+ * torn down and rebuilt keeps counting where it left off. Rendering streams through a
+ * small fixed buffer into a caller-supplied sink, never materialising the whole page.
+ *
+ * The class has no ESP-IDF dependencies so the output can be checked on the host.
+ */
+class MetricsRegistry {
+public:
+  /** @brief Receives rendered output; returns false to abort rendering. */
+  using Sink = std::function<bool(const char *data, size_t len)>;
+  /** @brief Evaluated at scrape time with the registry locked; must not register metrics. */
+  using GaugeFn = std::function<double()>;
+
+  class Counter {
+  public:
+    void inc(uint32_t n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    uint32_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+  private:
+    std::atomic<uint32_t> m_value{0};
+  };
+
+  class Gauge {
+  public:
+    void set(int32_t v) { m_value.store(v, std::memory_order_relaxed); }
+    void add(int32_t n) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    int32_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+  private:
+    std::atomic<int32_t> m_value{0};
+  };
+
+  /** @brief Fixed-bucket histogram; bucket bounds are inclusive upper limits in ascending order. */
+  class Histogram {
+  public:
+    explicit Histogram(std::span<const uint32_t> bounds);
+    void observe(uint32_t value);
+    std::span<const uint32_t> bounds() const { return m_bounds; }
+    /** @brief Non-cumulative count of bucket @p i; index bounds().size() is the +Inf overflow bucket. */
+    uint32_t bucket(size_t i) const { return m_buckets[i].load(std::memory_order_relaxed); }
+    uint32_t count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return m_sum.load(std::memory_order_relaxed); }
+
+  private:
+    std::span<const uint32_t> m_bounds;
+    std::unique_ptr<std::atomic<uint32_t>[]> m_buckets;
+    std::atomic<uint32_t> m_count{0};
+    std::atomic<uint64_t> m_sum{0};
+  };
+
+  /** @brief Formats into a fixed buffer and hands it to a sink whenever the next line does not fit. */
+  class Writer {
+  public:
+    explicit Writer(const Sink &sink) : m_sink(sink) {}
+    /** @brief Append formatted text, flushing first if it does not fit. Text is never truncated. */
+    void printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+    /** @return false once the sink has rejected a chunk. */
+    bool flush();
+
+  private:
+    const Sink &m_sink;
+    char m_buffer[512];
+    size_t m_fill = 0;
+    bool m_failed = false;
+  };
+
+  static MetricsRegistry &instance() {
+    static MetricsRegistry instance;
+    return instance;
+  }
+
+  Counter &counter(const char *name, const char *help, const char *labels = nullptr);
+  Gauge &gauge(const char *name, const char *help, const char *labels = nullptr);
+  /** @brief Register a gauge computed on every scrape; re-registering replaces the callback. */
+  void gauge(const char *name, const char *help, const char *labels, GaugeFn fn);
+  Histogram &histogram(const char *name, const char *help, std::span<const uint32_t> bounds,
+                       const char *labels = nullptr);
+
+  /**
+   * @brief Render every family to @p sink.
+   * @return false if the sink rejected a chunk.
+   */
+  bool render(const Sink &sink) const;
+
+private:
+  enum class Type : uint8_t { Counter, Gauge, Histogram };
+
+  struct Series {
+    const char *labels;
+    std::unique_ptr<Counter> counter;
+    std::unique_ptr<Gauge> gauge;
+    std::unique_ptr<Histogram> histogram;
+    GaugeFn fn;
+  };
+
+  struct Family {
+    const char *name;
+    const char *help;
+    Type type;
+    std::vector<std::unique_ptr<Series>> series;
+  };
+
+  MetricsRegistry() = default;
+  MetricsRegistry(const MetricsRegistry &) = delete;
+  MetricsRegistry &operator=(const MetricsRegistry &) = delete;
+
+  Series &series(const char *name, const char *help, Type type, const char *labels);
+  static void renderSeries(Writer &out, const Family &family, const Series &series);
+
+  mutable std::mutex m_mutex;
+  std::vector<std::unique_ptr<Family>> m_families;
+};
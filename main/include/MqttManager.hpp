@@ -1,8 +1,17 @@
 #pragma once
 #include "app_event_loop.hpp"
+#include "MetricsRegistry.hpp"
+#include "MqttOutbox.hpp"
 #include "eventStructs.hpp"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "mqtt_client.h"
+#include <array>
+#include <atomic>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <vector>
 
 class LockManager;
@@ -92,27 +101,140 @@ private:
     static void mqttEventHandler(void* handler_args, esp_event_base_t base, int32_t event_id, void* event_data);
     void onMqttEvent(esp_event_base_t base, int32_t event_id, void* event_data);
     void onConnected();
-    void onData(const std::string& topic, const std::string& data);
+    void onData(const esp_mqtt_event_t& event);
+
+    // --- Command Dispatch ---
+    using CommandHandler = void (MqttManager::*)(uint8_t value);
+    using PayloadHandler = void (MqttManager::*)(const char* payload, size_t len);
+    struct CommandRoute {
+        uint32_t hash;
+        const std::string* topic;
+        CommandHandler handler;        ///< Receives the payload parsed as a number 0-255...
+        PayloadHandler payloadHandler; ///< ...unless this is set, which gets it raw.
+        const char* name;
+    };
+    static constexpr size_t MAX_COMMAND_ROUTES = 6;
+    static constexpr size_t MAX_COMMAND_PAYLOAD = 16;
+    static constexpr uint8_t NO_CUSTOM_STATE = 0xFF;
+
+    /**
+     * @brief Rebuild the topic dispatch table and the custom state lookup from the current config.
+     *
+     * Runs in onConnected(), on the MQTT task that also delivers data events, so the tables
+     * never change while a message is being dispatched.
+     */
+    void buildDispatchTable();
+    const CommandRoute* findRoute(const char* topic, size_t len) const;
+    void dispatch(const CommandRoute& route, const char* payload, size_t len);
+    void onLockStateCmd(uint8_t value);
+    void onTargetStateCmd(uint8_t value);
+    void onCurrentStateCmd(uint8_t value);
+    void onCustomStateCmd(uint8_t value);
+    void onBatteryLevelCmd(uint8_t value);
+    void onHassStatus(const char* payload, size_t len);
+
+    // --- Reconnect ---
+    static constexpr uint32_t RECONNECT_MIN_MS = 1000;
+    static constexpr uint32_t RECONNECT_BASE_MS = 2000;
+    static constexpr uint32_t RECONNECT_MAX_MS = 120000;
+    void scheduleReconnect();
+    static void reconnectTimerCallback(void* arg);
+    void deleteReconnectTimer();
 
     // --- Publishing Logic ---
-    void publish(const std::string& topic, const std::string& payload, int qos = 0, bool retain = false);
-    void publishHassDiscovery();
+    /**
+     * @brief Queue a message for the drain task; never blocks on the network.
+     *
+     * Access events queued while the broker is unreachable are moved to the LittleFS spool
+     * and replayed in order on reconnect. Other priorities wait in memory, coalesced per topic.
+     */
+    void publish(const std::string& topic, std::string_view payload, int qos = 0, bool retain = false,
+                 MqttOutbox::Priority priority = MqttOutbox::Priority::Telemetry);
+    bool publishNow(const MqttOutbox::Message& msg);
+    static void drainTaskEntry(void* arg);
+    void drainTask();
+    void spillAccessEvents();
+    void updateQueueMetrics();
+    void updateSpoolMetrics();
+    void renderHassDiscovery();
+    void publishHassDiscovery(bool force);
+    void onDiscoveryPublished(const MqttOutbox::Message& msg);
     void publishMqttStatus(bool connected, MqttErrorCode errorCode, const std::string& errorMessage = "");
 
     // --- SSL/TLS Configuration ---
     bool configureSSL(esp_mqtt_client_config_t& mqtt_cfg);
     void logSSLError(const char* operation, esp_err_t error);
 
+    // --- Metrics ---
+    struct Metrics {
+        MetricsRegistry::Counter& published;
+        MetricsRegistry::Counter& publishFailed;
+        MetricsRegistry::Counter& connects;
+        MetricsRegistry::Counter& disconnects;
+        MetricsRegistry::Gauge& connected;
+        MetricsRegistry::Gauge& depthAccess;
+        MetricsRegistry::Gauge& depthState;
+        MetricsRegistry::Gauge& depthTelemetry;
+        MetricsRegistry::Gauge& depthDiscovery;
+        MetricsRegistry::Counter& queueCoalesced;
+        MetricsRegistry::Counter& queueDropped;
+        MetricsRegistry::Counter& spooled;
+        MetricsRegistry::Counter& replayed;
+        MetricsRegistry::Counter& spoolDropped;
+        MetricsRegistry::Gauge& spoolBytes;
+        MetricsRegistry::Counter& commands;
+        MetricsRegistry::Histogram& commandDispatch;
+        MetricsRegistry::Histogram& commandRoundTrip;
+        MetricsRegistry::Histogram& outboxWait;
+    };
+    static Metrics registerMetrics();
+
     // --- Member Variables ---
     std::string deviceID;
     const espConfig::mqttConfig_t& m_mqttConfig;
     const espConfig::mqtt_ssl_t& m_mqttSslConfig;
     esp_mqtt_client_handle_t m_client;
     const std::string &device_name;
-    bool m_isConnected = false;
-    
+    std::atomic<bool> m_isConnected{false};
+    /// Receive time (esp_timer, us) of the oldest lock command not yet answered by a state publish; 0 if none.
+    std::atomic<int64_t> m_pendingCommandAt{0};
+
+    // Outbound queue; lock order is m_clientMutex before m_outboxMutex.
+    static constexpr size_t OUTBOX_CAPACITY = 24;
+    std::mutex m_clientMutex;   ///< Held while m_client is used by the drain task or torn down.
+    std::mutex m_outboxMutex;
+    MqttOutbox m_outbox{OUTBOX_CAPACITY};
+    MqttSpool m_spool;
+    uint32_t m_spoolDroppedSeen = 0;
+    TaskHandle_t m_drainTaskHandle = nullptr;
+
+    // Home Assistant discovery documents, rendered once in begin() and read-only afterwards.
+    struct DiscoveryDoc {
+        std::string topic;
+        std::string payload; ///< Empty when the entity is disabled; publishing it clears the entity.
+        uint32_t hash;       ///< FNV-1a of topic and payload; 0 when disabled.
+    };
+    static const std::string HASS_STATUS_TOPIC;
+    std::vector<DiscoveryDoc> m_discovery;
+
+    // Reconnect backoff. m_reconnectMutex is never held across an esp-mqtt call, so the
+    // MQTT event handler may take it; it must never take m_clientMutex.
+    std::mutex m_reconnectMutex;
+    esp_timer_handle_t m_reconnectTimer = nullptr;
+    uint32_t m_reconnectAttempt = 0;
+
+    // Incoming command dispatch; only touched on the MQTT task.
+    std::array<CommandRoute, MAX_COMMAND_ROUTES> m_routes{};
+    size_t m_routeCount = 0;
+    std::array<uint8_t, 256> m_customStateByValue{}; ///< Payload value -> CUSTOM_STATES index.
+    const CommandRoute* m_fragmentRoute = nullptr;   ///< Route of a multi-part message in progress.
+    std::array<char, MAX_COMMAND_PAYLOAD> m_fragmentBuf{};
+    size_t m_fragmentLen = 0;
+    bool m_fragmentOverflow = false;
+
     // SSL/TLS related members
     bool m_sslConfigured;
+    Metrics m_metrics;
     
     static const char* TAG;
     AppEventLoop::SubscriptionHandle m_lock_state_changed;
@@ -0,0 +1,131 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+#ifdef ESP_PLATFORM
+#include <FS.h>
+#endif
+
+/**
+ * @brief Bounded, prioritised queue of outbound MQTT messages.
+ *
+ * Messages are popped strictly by priority (access events first, discovery last) and in
+ * arrival order within a priority. Every class except access events is "latest value":
+ * queueing a message for a topic that is already waiting replaces the waiting payload in
+ * place, so a burst of lock state changes or a re-sent discovery document costs one slot.
+ *
+ * When the queue is full, the oldest message of the lowest waiting priority is evicted,
+ * as long as that priority is not above the new message's; otherwise the new message is
+ * rejected. The class is not thread-safe and has no ESP-IDF dependencies.
+ */
+class MqttOutbox {
+public:
+  enum class Priority : uint8_t { Access, State, Telemetry, Discovery, Count };
+
+  struct Message {
+    std::string topic;
+    std::string payload;
+    uint8_t qos = 0;
+    bool retain = false;
+    Priority priority = Priority::Telemetry;
+    /// Caller-supplied time the message was first queued; kept when a newer payload coalesces into it.
+    int64_t queuedAt = 0;
+  };
+
+  enum class PushResult : uint8_t {
+    Queued,
+    Coalesced, ///< Replaced the payload of a message already queued for the topic.
+    Evicted,   ///< Queued, but an older lower-priority message was dropped for it.
+    Rejected,  ///< Queue full of equal or higher priority messages; not queued.
+  };
+
+  explicit MqttOutbox(size_t capacity) : m_capacity(capacity) {}
+
+  PushResult push(Message &&msg);
+  /** @brief Put a message back at the head of its priority after a failed publish. */
+  void pushFront(Message &&msg);
+  /** @brief Remove the next message to send. */
+  std::optional<Message> pop();
+  /** @brief Remove and return every message of one priority, oldest first. */
+  std::vector<Message> take(Priority priority);
+
+  size_t size() const { return m_size; }
+  size_t size(Priority priority) const { return m_queues[index(priority)].size(); }
+  bool empty() const { return m_size == 0; }
+
+private:
+  static size_t index(Priority p) { return static_cast<size_t>(p); }
+  static bool coalesces(Priority p) { return p != Priority::Access; }
+  std::deque<Message>::iterator find(std::deque<Message> &queue, const std::string &topic);
+
+  size_t m_capacity;
+  size_t m_size = 0;
+  std::array<std::deque<Message>, static_cast<size_t>(Priority::Count)> m_queues;
+};
+
+#ifdef ESP_PLATFORM
+/**
+ * @brief Append-only, size-bounded ring of MQTT messages on a filesystem.
+ *
+ * Used to keep access events across a broker outage (and a reboot during one). The
+ * ring is a directory of numbered segment files. Records are appended to the newest
+ * segment, and a new segment is started once it reaches SEGMENT_BYTES. When more than
+ * MAX_SEGMENTS exist, the oldest is deleted, so the newest events survive a long outage.
+ *
+ * Each record is a 6-byte header (magic, flags, topic length, payload length) followed by
+ * the topic and payload. A record torn by a power loss ends the segment when read back.
+ * Replay is at-least-once. A segment is deleted only after every record in it has been
+ * published. Within one boot a partly replayed segment resumes where it stopped, but a
+ * reboot in the middle of replay sends that segment again from its start.
+ *
+ * Not thread-safe; the MQTT drain task is the only user.
+ */
+class MqttSpool {
+public:
+  using Publisher = std::function<bool(const MqttOutbox::Message &)>;
+
+  static constexpr size_t SEGMENT_BYTES = 4096;
+  static constexpr size_t MAX_SEGMENTS = 4;
+
+  MqttSpool(fs::FS &fs, const char *dir) : m_fs(fs), m_dir(dir) {}
+
+  /** @brief Append one message to the newest segment. @return false on a filesystem error. */
+  bool append(const MqttOutbox::Message &msg);
+
+  /**
+   * @brief Publish spooled messages oldest first until @p publish returns false.
+   * @return Number of messages published.
+   */
+  size_t replay(const Publisher &publish);
+
+  bool empty();
+  /** @brief Records lost because their segment was evicted to make room. */
+  uint32_t dropped() const { return m_dropped; }
+  /** @brief Total size of all segments, as last seen. */
+  size_t bytes() const { return m_bytes; }
+
+private:
+  static constexpr uint8_t RECORD_MAGIC = 0xA5;
+  static constexpr size_t HEADER_BYTES = 6;
+
+  bool scan();
+  std::string path(uint32_t seq) const;
+  size_t countRecords(uint32_t seq);
+  static bool readRecord(fs::File &file, MqttOutbox::Message &msg);
+
+  fs::FS &m_fs;
+  const char *m_dir;
+  bool m_scanned = false;
+  uint32_t m_first = 1; ///< Oldest segment present.
+  uint32_t m_last = 0;  ///< Newest segment; m_first > m_last means none.
+  size_t m_lastSize = 0;
+  size_t m_bytes = 0;
+  size_t m_resumeOffset = 0; ///< Bytes of segment m_first already replayed this boot.
+  uint32_t m_dropped = 0;
+};
+#endif
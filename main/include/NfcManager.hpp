@@ -13,6 +13,7 @@
 #include "app_event_loop.hpp"
 #include "NfcReader.hpp"
 #include "GPIOAllocator.hpp"
+#include "MetricsRegistry.hpp"
 
 class LockManager;
 class HardwareManager;
@@ -45,6 +46,17 @@ public:
     ~NfcManager() = default;
     bool begin();
 
+    /// Invoked on the NFC task the moment a HomeKey tap authenticates.
+    using AuthorizedHook = std::function<void()>;
+
+    /**
+     * @brief Register a hook to run when a HomeKey tap authenticates, before its event is published.
+     *
+     * The hook runs on the NFC polling task ahead of the NFC_TAP_EVENT, so it must be quick
+     * and thread-safe. Set it before begin().
+     */
+    void setAuthorizedHook(AuthorizedHook hook) { m_authorizedHook = std::move(hook); }
+
 private:
     std::atomic<bool> m_reconfigRequested{false};
     // --- Task Management ---
@@ -76,6 +88,18 @@ private:
     void handleGenericTag(const std::vector<uint8_t>& uid, const std::array<uint8_t,2>& atqa, const uint8_t& sak);
     void waitForTagRemoval();
 
+    // --- Metrics ---
+    struct Metrics {
+        MetricsRegistry::Counter& homekeyTaps;
+        MetricsRegistry::Counter& genericTaps;
+        MetricsRegistry::Counter& authSuccess;
+        MetricsRegistry::Counter& authFailure;
+        MetricsRegistry::Counter& authCacheHit;
+        MetricsRegistry::Counter& authCacheMiss;
+        MetricsRegistry::Histogram& tapDuration;
+    };
+    static Metrics registerMetrics();
+
     // --- Member Variables ---
     const std::array<uint8_t, 4> &nfcGpioPins;
     uint8_t m_nfcReaderType;
@@ -99,6 +123,8 @@ private:
     std::array<uint8_t, 18> m_ecpData;
 
     KeyFlow authFlow = KeyFlow::kFlowFAST;
+    Metrics m_metrics;
+    AuthorizedHook m_authorizedHook;
 
     static const char* TAG;
     AppEventLoop::SubscriptionHandle m_hk_event;
@@ -0,0 +1,175 @@
+#pragma once
+#include "DeltaPatcher.hpp"
+#include "OtaSink.hpp"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "mbedtls/sha256.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Two-stage OTA pipeline: network receive on the calling task, flash writes on a
+ * dedicated writer task.
+ *
+ * The receiver takes an empty buffer with acquire(), fills it and hands it over with
+ * submit(). The writer task drains filled buffers into the sink and returns them to the
+ * pool, so flash erase/write of one chunk overlaps with receiving the next. Time spent
+ * waiting on the other stage is accumulated per stage to show which side limits throughput.
+ */
+class OtaPipeline {
+public:
+  struct Stats {
+    size_t submittedBytes;
+    uint32_t receiveStallUs; // receiver waiting for a free buffer (flash is the bottleneck)
+    uint32_t writeStallUs;   // writer waiting for data (network is the bottleneck)
+  };
+
+  static const char *TAG;
+
+  static constexpr size_t DEFAULT_BUFFER_SIZE = 4096;
+  static constexpr size_t DEFAULT_BUFFER_COUNT = 3;
+
+  OtaPipeline(OtaSink &sink, size_t bufferSize = DEFAULT_BUFFER_SIZE, size_t bufferCount = DEFAULT_BUFFER_COUNT);
+  ~OtaPipeline();
+  OtaPipeline(const OtaPipeline &) = delete;
+  OtaPipeline &operator=(const OtaPipeline &) = delete;
+
+  /** @brief Allocate the buffer pool and start the writer task. */
+  bool start();
+
+  /**
+   * @brief Take an empty buffer of bufferSize() bytes, blocking until one is available.
+   * @return nullptr if the writer has failed; the update should be aborted.
+   */
+  uint8_t *acquire();
+
+  /** @brief Queue @p len bytes of a buffer obtained from acquire() for writing. */
+  void submit(uint8_t *buffer, size_t len);
+
+  /** @brief Return a buffer obtained from acquire() without writing it. */
+  void release(uint8_t *buffer);
+
+  /**
+   * @brief Wait for all queued data to be written and finish the sink.
+   * @return true if every write and OtaSink::finish() succeeded.
+   */
+  bool finish();
+
+  /** @brief Stop the writer without finishing the sink. Safe to call more than once. */
+  void abort();
+
+  bool failed() const { return m_failed; }
+  size_t bufferSize() const { return m_bufferSize; }
+  Stats stats() const;
+
+private:
+  struct Chunk {
+    uint8_t *data;
+    size_t len;
+  };
+
+  static void writerTaskEntry(void *arg);
+  void writerTask();
+  bool stop(bool finishSink);
+
+  OtaSink &m_sink;
+  const size_t m_bufferSize;
+  const size_t m_bufferCount;
+  uint8_t *m_pool = nullptr;
+  QueueHandle_t m_freeQueue = nullptr;
+  QueueHandle_t m_fullQueue = nullptr;
+  SemaphoreHandle_t m_done = nullptr;
+  bool m_running = false;
+  bool m_result = false;
+  std::atomic<bool> m_failed{false};
+  std::atomic<bool> m_finishSink{false};
+  std::atomic<size_t> m_submittedBytes{0};
+  std::atomic<uint32_t> m_receiveStallUs{0};
+  std::atomic<uint32_t> m_writeStallUs{0};
+};
+
+/**
+ * @brief Writes an application image to an OTA partition through esp_ota_*.
+ *
+ * Uses sequential-write mode so each flash sector is erased as the image reaches it, on
+ * whichever task calls write(), instead of erasing the whole image size up front.
+ */
+class OtaFirmwareSink : public OtaSink {
+public:
+  explicit OtaFirmwareSink(const esp_partition_t *partition) : m_partition(partition) {}
+  ~OtaFirmwareSink() override;
+
+  bool begin();
+  bool write(const uint8_t *data, size_t len) override;
+  bool finish() override;
+
+  size_t writtenBytes() const { return m_written; }
+
+private:
+  const esp_partition_t *m_partition;
+  esp_ota_handle_t m_handle = 0;
+  std::atomic<size_t> m_written{0};
+};
+
+/**
+ * @brief Writes a raw image (e.g. LittleFS) to a data partition.
+ *
+ * The partition is erased in 64 KiB blocks just ahead of the write offset, so only the
+ * region covered by the image is erased and erasing happens on the writer task.
+ */
+class OtaPartitionSink : public OtaSink {
+public:
+  explicit OtaPartitionSink(const esp_partition_t *partition) : m_partition(partition) {}
+
+  bool write(const uint8_t *data, size_t len) override;
+
+  size_t writtenBytes() const { return m_written; }
+
+private:
+  static constexpr size_t ERASE_BLOCK = 64 * 1024;
+
+  const esp_partition_t *m_partition;
+  size_t m_erasedEnd = 0;
+  std::atomic<size_t> m_written{0};
+};
+
+/**
+ * @brief DeltaPatcher source backed by a flash partition, normally the running app.
+ */
+class OtaPartitionSource : public DeltaPatcher::Source {
+public:
+  explicit OtaPartitionSource(const esp_partition_t *partition) : m_partition(partition) {}
+
+  /** @brief Hashes the first sourceSize bytes of the partition and compares them with the patch header. */
+  bool accept(const DeltaPatcher::Header &header) override;
+  bool read(size_t offset, uint8_t *out, size_t len) override;
+
+private:
+  const esp_partition_t *m_partition;
+};
+
+/**
+ * @brief Pass-through sink that computes the SHA-256 of everything written to the next sink.
+ */
+class OtaDigestSink : public OtaSink {
+public:
+  explicit OtaDigestSink(OtaSink &next);
+  ~OtaDigestSink() override;
+
+  bool write(const uint8_t *data, size_t len) override;
+  /** @brief Finalizes the digest, then finishes the next sink. */
+  bool finish() override;
+
+  bool matches(const std::array<uint8_t, 32> &expected) const { return m_finished && m_digest == expected; }
+
+private:
+  OtaSink &m_next;
+  mbedtls_sha256_context m_ctx;
+  std::array<uint8_t, 32> m_digest{};
+  bool m_finished = false;
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Consumer of an OTA byte stream.
+ *
+ * Sinks can be chained: a decoding stage implements OtaSink and forwards its output to
+ * another sink, the last of which writes to flash. Implementations must not depend on
+ * ESP-IDF headers unless they are flash writers, so decoders can be built and exercised
+ * on the host.
+ */
+class OtaSink {
+public:
+  virtual ~OtaSink() = default;
+
+  /**
+   * @brief Consume the next @p len bytes of the stream.
+   * @return false to abort the update.
+   */
+  virtual bool write(const uint8_t *data, size_t len) = 0;
+
+  /**
+   * @brief Called once after the last write().
+   * @return false if the stream was incomplete or failed verification.
+   */
+  virtual bool finish() { return true; }
+};
@@ -1,4 +1,6 @@
 #pragma once
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <mutex>
 #include <nvs.h>
@@ -44,6 +46,21 @@ public:
      */
     readerData_t getReaderDataCopy() const;
 
+    /**
+     * @brief Shared, immutable reader data.
+     *
+     * Unlike getReaderDataCopy(), taking a snapshot does not copy. The same object is handed out
+     * until the reader data next changes, and stays valid for as long as the caller holds it.
+     */
+    using Snapshot = std::shared_ptr<const readerData_t>;
+    Snapshot snapshot() const;
+
+    /**
+     * @brief Incremented on every change to the reader data.
+     * Lets a caller that keeps its own copy skip refreshing it when nothing changed.
+     */
+    uint32_t generation() const { return m_generation.load(std::memory_order_acquire); }
+
     /**
      * @brief Provides convenient read-only access to the reader group identifier.
      * @return A constant reference to the reader GID vector.
@@ -60,10 +77,11 @@ public:
      * @brief Replaces the current reader data with a new version and saves it to NVS.
      * This is used by the NFCAccess service during provisioning.
      * @param newData The complete new readerData_t structure to save.
+     * @param[out] generation If not null, receives the generation() that holds @p newData.
      * @return A constant pointer to the readerData_t object if successful
      * otherwise a nullptr
      */
-    const readerData_t* updateReaderData(const readerData_t& newData);
+    const readerData_t* updateReaderData(const readerData_t& newData, uint32_t* generation = nullptr);
 
     /**
      * @brief Erases reader's key and IDs from memory and NVS.
@@ -111,6 +129,9 @@ private:
      */
     void load();
 
+    /** @brief Drop the current snapshot and bump the generation. Call with m_readerDataMutex held. */
+    void changed();
+
     void unpack_readerData_t(msgpack_object obj, readerData_t& reader_data);
     void pack_readerData_t(msgpack_packer* pk, const readerData_t& reader_data);
     void unpack_hkIssuer_t(msgpack_object obj, hkIssuer_t& issuer);
@@ -119,6 +140,8 @@ private:
     void pack_hkEndpoint_t(msgpack_packer* pk, const hkEndpoint_t& endpoint);
     readerData_t m_readerData;
     mutable std::mutex m_readerDataMutex;
+    mutable Snapshot m_snapshot; ///< Built on the first snapshot() after a change.
+    std::atomic<uint32_t> m_generation{0};
     nvs_handle m_nvsHandle;
     bool m_isInitialized;
 
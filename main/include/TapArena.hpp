@@ -0,0 +1,107 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "MetricsRegistry.hpp"
+
+/**
+ * @brief Memory reserved at boot for the mbedTLS temporaries of one NFC transaction.
+ *
+ * A HomeKey tap runs P-256 ECDH, ECDSA and key derivation. mbedTLS allocates every bignum
+ * limb array and context for them with calloc, thousands of small blocks per tap, and
+ * over weeks that churn fragments the heap. While a Scope is open, mbedTLS allocations
+ * made by the task that opened it come from this arena instead. Closing the Scope
+ * returns the whole arena in O(1).
+ *
+ * Blocks are carved from the front of the arena. A freed block goes onto a free list for
+ * its size class and is reused by the next allocation of that class, because mbedTLS
+ * grows bignums by allocating a larger copy and freeing the old one. Requests above the
+ * largest class are carved but not reused. When the arena is full, or a request is
+ * larger than what is left, the allocation falls back to the heap and is counted as an
+ * overflow.
+ *
+ * Blocks still allocated when the Scope closes would become invalid on reset, so the
+ * arena is then left untouched ("pinned") and skipped until they have all been freed.
+ * Other tasks, including TLS in the MQTT and HTTPS clients, always use the heap.
+ */
+class TapArena {
+public:
+  static TapArena &instance() {
+    static TapArena instance;
+    return instance;
+  }
+
+  /**
+   * @brief Allocate the arena and route mbedTLS calloc/free through it.
+   * @param bytes Arena size; 0 leaves mbedTLS on the heap.
+   */
+  bool reserve(size_t bytes);
+
+  /** @brief Leave mbedTLS on the heap in later transactions, for comparing the two. */
+  void setBypass(bool bypass) { m_bypass.store(bypass, std::memory_order_relaxed); }
+  /** @brief Whether a Scope opened now would serve allocations from the arena. */
+  bool available() const {
+    return m_base && !m_bypass.load(std::memory_order_relaxed) && m_live.load(std::memory_order_relaxed) == 0;
+  }
+
+  /** @brief Serves the calling task's mbedTLS allocations from the arena while in scope. */
+  class Scope {
+  public:
+    explicit Scope(TapArena &arena) : m_arena(arena) { m_arena.activate(); }
+    ~Scope() { m_arena.deactivate(); }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    TapArena &m_arena;
+  };
+
+private:
+  struct Metrics {
+    MetricsRegistry::Gauge &capacity;
+    MetricsRegistry::Gauge &peak;
+    MetricsRegistry::Histogram &tapPeak;
+    MetricsRegistry::Counter &overflows;
+    MetricsRegistry::Counter &pinned;
+  };
+  static Metrics registerMetrics();
+
+  /// Block sizes, header included; the smallest fits a P-256 bignum.
+  static constexpr std::array<uint16_t, 7> CLASS_SIZES = {32, 64, 128, 256, 512, 1024, 2048};
+  static constexpr uint8_t LARGE_CLASS = CLASS_SIZES.size();
+  static constexpr size_t HEADER_BYTES = 8; ///< Keeps the payload 8-byte aligned.
+
+  struct Header {
+    uint8_t sizeClass; ///< Index into CLASS_SIZES, or LARGE_CLASS.
+  };
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+
+  TapArena() : m_metrics(registerMetrics()) {}
+  void activate();
+  void deactivate();
+  void reset();
+  bool owns(const void *p) const { return p >= m_base && p < m_base + m_capacity; }
+  void *allocate(size_t bytes);
+  void release(void *p);
+
+  static void *mbedtlsCalloc(size_t count, size_t size);
+  static void mbedtlsFree(void *p);
+  static void *heapCalloc(size_t count, size_t size);
+
+  Metrics m_metrics;
+  uint8_t *m_base = nullptr;
+  size_t m_capacity = 0;
+  size_t m_used = 0; ///< Bytes carved so far this tap.
+  size_t m_peak = 0; ///< Highest m_used of any tap.
+  std::array<FreeBlock *, CLASS_SIZES.size()> m_free{};
+  std::atomic<TaskHandle_t> m_owner{nullptr}; ///< Task whose allocations are served while active.
+  std::atomic<bool> m_active{false};
+  std::atomic<bool> m_bypass{false};
+  std::atomic<uint32_t> m_live{0}; ///< Arena blocks not yet freed; any task may free one.
+  bool m_pinnedLogged = false;
+};
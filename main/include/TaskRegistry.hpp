@@ -0,0 +1,103 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "Executor.hpp"
+
+/**
+ * @brief Bookkeeping for every FreeRTOS task on the device, for sizing stacks from field data.
+ *
+ * Firmware tasks are started through create() instead of xTaskCreate(), which records the
+ * stack size, priority and core they were given. A job on the Executor samples the
+ * scheduler every SAMPLE_INTERVAL_MS with uxTaskGetSystemState(). Each sample updates every
+ * task's stack high-water mark and its share of CPU time since the last sample. Tasks the
+ * firmware did not create (Wi-Fi, lwIP, HomeSpan, httpd and so on) are picked up by the
+ * sampler too. Their configured stack size is not known.
+ *
+ * A record is kept per task name and never freed, so its metric labels stay valid for the
+ * MetricsRegistry and a task that has exited still shows its last high-water mark. Names
+ * given to create() must therefore be unique and drawn from a fixed set.
+ *
+ * Needs CONFIG_FREERTOS_USE_TRACE_FACILITY for sampling and
+ * CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS for CPU shares; without them only the values
+ * recorded by create() are available.
+ */
+class TaskRegistry {
+public:
+  static constexpr uint32_t SAMPLE_INTERVAL_MS = 5000;
+
+  /** @brief Copy of one record, as of the last sample. */
+  struct Info {
+    std::string name;
+    int8_t core = -1;             ///< Pinned core; -1 if unpinned or unknown.
+    uint8_t priority = 0;
+    uint32_t stackBytes = 0;      ///< Configured stack size; 0 if not created through create().
+    uint32_t stackFreeBytes = 0;  ///< Least free stack seen so far.
+    float cpuPercent = 0;         ///< Share of all cores' time over the last interval.
+    bool running = false;         ///< Whether the task existed at the last sample.
+    bool firmware = false;        ///< Created through create().
+  };
+
+  static TaskRegistry &instance() {
+    static TaskRegistry instance;
+    return instance;
+  }
+
+  /**
+   * @brief xTaskCreatePinnedToCore() that records the task.
+   *
+   * A @p core outside the chip's cores (such as tskNO_AFFINITY, or 1 on a single-core
+   * part) leaves the task unpinned, like Arduino's xTaskCreateUniversal().
+   * @param handle Receives the task handle; may be nullptr.
+   * @return pdPASS on success.
+   */
+  BaseType_t create(TaskFunction_t fn, const char *name, uint32_t stackBytes, void *arg, UBaseType_t priority,
+                    TaskHandle_t *handle = nullptr, BaseType_t core = tskNO_AFFINITY);
+
+  /** @brief Take the first sample and start sampling periodically on the Executor. */
+  void begin();
+  /** @brief Sample all tasks now. Called by the periodic job. */
+  void sample();
+
+  /** @brief Every record, firmware tasks first, each group ordered by name. */
+  std::vector<Info> snapshot();
+
+private:
+  struct Task {
+    std::string taskName; ///< Name given to the kernel.
+    std::string name;     ///< taskName, numbered if another task already had it.
+    std::string labels; ///< `task="name"`; must not change once registered with MetricsRegistry.
+    TaskHandle_t handle = nullptr;
+    bool firmware = false;
+    bool seen = false; ///< Matched during the current sample.
+    configRUN_TIME_COUNTER_TYPE lastRunTime = 0;
+    bool hasRunTime = false;
+    std::atomic<int8_t> core{-1};
+    std::atomic<uint8_t> priority{0};
+    std::atomic<uint32_t> stackBytes{0};
+    std::atomic<uint32_t> stackFreeBytes{0};
+    std::atomic<uint32_t> cpuCentiPercent{0};
+  };
+
+  TaskRegistry() = default;
+  Task *find(const char *name);
+  Task *add(const char *name);
+  /**
+   * @brief Export @p task's gauges, plus its stack size and core if @p firmware.
+   *
+   * Called without m_mutex held, since the MetricsRegistry evaluates the gauges under its
+   * own lock. Registering again only replaces the callbacks.
+   */
+  static void registerMetrics(Task &task, bool firmware);
+
+  std::mutex m_mutex; ///< Guards m_tasks, m_status and the non-atomic Task fields.
+  std::vector<std::unique_ptr<Task>> m_tasks;
+  std::vector<TaskStatus_t> m_status;
+  configRUN_TIME_COUNTER_TYPE m_lastTotalRunTime = 0;
+  Executor::JobId m_sampleJob = Executor::INVALID_JOB;
+};
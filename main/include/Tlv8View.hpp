@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+/**
+ * @brief Read-only view of a TLV8-encoded buffer, for inspecting a response without unpacking it.
+ *
+ * HAP TLV8 splits values longer than 255 bytes into consecutive items with the same tag.
+ * Lookups join those fragments; nothing is copied or allocated.
+ */
+class Tlv8View {
+public:
+  explicit Tlv8View(std::span<const uint8_t> data) : m_data(data) {}
+
+  /** @return The total value length of the first item with @p tag; nullopt if there is none or the buffer is truncated. */
+  std::optional<size_t> length(uint8_t tag) const {
+    size_t pos = 0;
+    while (pos + 2 <= m_data.size()) {
+      const uint8_t itemTag = m_data[pos];
+      size_t itemLen = m_data[pos + 1];
+      if (pos + 2 + itemLen > m_data.size()) return std::nullopt;
+      if (itemTag != tag) {
+        pos += 2 + itemLen;
+        continue;
+      }
+      size_t total = itemLen;
+      pos += 2 + itemLen;
+      // A full 255-byte fragment continues in the next item if that has the same tag.
+      while (itemLen == 255 && pos < m_data.size() && m_data[pos] == tag) {
+        if (pos + 2 > m_data.size()) return std::nullopt;
+        itemLen = m_data[pos + 1];
+        if (pos + 2 + itemLen > m_data.size()) return std::nullopt;
+        total += itemLen;
+        pos += 2 + itemLen;
+      }
+      return total;
+    }
+    return std::nullopt;
+  }
+
+private:
+  std::span<const uint8_t> m_data;
+};
@@ -4,7 +4,12 @@
 #include "esp_ota_ops.h"
 #include "esp_partition.h"
 #include "esp_timer.h"
+#include "freertos/semphr.h"
 #include "app_event_loop.hpp"
+#include "Executor.hpp"
+#include "HeapAdmission.hpp"
+#include "MemoryPlacement.hpp"
+#include "MetricsRegistry.hpp"
 #include <cstdint>
 #include <deque>
 #include <memory>
@@ -21,6 +26,10 @@ class NfcManager;
 namespace loggable {
 class WebSocketLogSinker;
 }
+namespace espConfig::fields {
+template <typename Config> class ConfigPatch;
+template <typename Config> class ConfigPatchBuilder;
+}
 
 // ============================================================================
 // WebSocket Frame Structures
@@ -33,12 +42,14 @@ struct WsFrame {
   uint8_t *payload;
   static constexpr size_t INLINE_SIZE = 128;
   uint8_t inlinePayload[INLINE_SIZE];
+  /// Shared by the frames of one backlog replay; the heap stays reserved until the last is freed.
+  std::shared_ptr<HeapAdmission::Reservation> heap;
 };
 
 struct WsFrameDeleter {
   void operator()(WsFrame *frame) const {
     if (frame && frame->payload != frame->inlinePayload)
-      delete[] frame->payload;
+      MemoryPlacement::release(frame->payload);
     delete frame;
   }
 };
@@ -78,41 +89,86 @@ private:
   // Internal Types & Enums
   // ------------------------------------------------------------------------
 
+  // Metric groups a WebSocket client can subscribe to (bit mask).
+  enum MetricGroup : uint8_t {
+    METRICS_SYSTEM = 1 << 0, // uptime, free_heap, wifi_rssi
+    METRICS_NFC = 1 << 1,    // nfc_connected, nfc_reader_type
+    METRICS_MQTT = 1 << 2,   // mqtt_connected, mqtt_error_code, mqtt_error_message
+    METRICS_ALL = METRICS_SYSTEM | METRICS_NFC | METRICS_MQTT
+  };
+
+  struct MetricsSample {
+    uint64_t uptimeMs = 0;
+    uint32_t freeHeap = 0;
+    int8_t wifiRssi = 0;
+    bool nfcConnected = false;
+    uint8_t nfcReaderType = 0;
+    bool mqttConnected = false;
+    uint8_t mqttErrorCode = 0;
+    std::string mqttErrorMessage;
+  };
+
   struct WsClient {
     int fd;
     std::mutex mutex;
+    uint8_t metricGroups = METRICS_ALL;
+    uint8_t sentGroups = 0;  // groups whose values in lastSent are what the client holds
+    MetricsSample lastSent;
     WsClient(int file_descriptor) : fd(file_descriptor) {}
   };
 
-  enum class OTAUploadType { FIRMWARE, LITTLEFS };
+  enum class OTAUploadType { FIRMWARE, FIRMWARE_DELTA, LITTLEFS };
 
   struct OTAState {
-    esp_ota_handle_t handle = 0;
     const esp_partition_t *updatePartition = nullptr;
     const esp_partition_t *littlefsPartition = nullptr;
+    size_t receivedBytes = 0;
     size_t writtenBytes = 0;
     size_t totalBytes = 0;
+    size_t imageBytes = 0; // size of the image written to flash, once known
+    int64_t startTime = 0;
+    uint32_t receiveStallUs = 0;
+    uint32_t writeStallUs = 0;
     bool skipReboot = false;
+    bool compressed = false;
     bool inProgress = false;
     std::string error;
     OTAUploadType currentUploadType = OTAUploadType::FIRMWARE;
   };
 
+  /**
+   * @brief A route whose handler runs on the async worker pool instead of the httpd task.
+   */
+  struct AsyncRoute {
+    esp_err_t (*handler)(httpd_req_t *);
+    WebServerManager *instance;
+    uint8_t maxConcurrent;
+    std::atomic<uint8_t> active{0};
+  };
+
+  struct AsyncJob {
+    httpd_req_t *req;
+    AsyncRoute *route;
+  };
+
   struct OTAParams {
     httpd_req_t *req;
     WebServerManager *instance;
     OTAUploadType uploadType;
     bool skipReboot;
+    bool compressed;
     size_t contentLength;
     OTAState *state;
+    HeapAdmission::Reservation heap; // held until the task deletes its params
   };
 
   // ------------------------------------------------------------------------
   // Static Task Callbacks
   // ------------------------------------------------------------------------
-  static void ws_send_task(void *arg);
   static void otaTask(void *pvParameters);
+  static void asyncWorkerTask(void *arg);
   static void statusTimerCallback(void *arg);
+  static void historyTimerCallback(void *arg);
 
   // ------------------------------------------------------------------------
   // HTTP Route Handlers (Static)
@@ -133,11 +189,16 @@ private:
   static esp_err_t handleCertificateUpload(httpd_req_t *req);
   static esp_err_t handleCertificateStatus(httpd_req_t *req);
   static esp_err_t handleCertificateDelete(httpd_req_t *req);
+  static esp_err_t handleMetrics(httpd_req_t *req);
+  static esp_err_t handleMetricsHistory(httpd_req_t *req);
+  static esp_err_t handleMetricsTasks(httpd_req_t *req);
+  static esp_err_t handleMetricsHeap(httpd_req_t *req);
 
   static esp_err_t handleCaptivePortal(httpd_req_t *req);
   static esp_err_t handleGetCaptivePortalConfig(httpd_req_t *req);
   static esp_err_t handleSaveCaptivePortalConfig(httpd_req_t *req);
   static esp_err_t handleWifiScan(httpd_req_t *req);
+  static esp_err_t dispatchAsync(httpd_req_t *req);
 
   // ------------------------------------------------------------------------
   // Core Internal Methods
@@ -146,30 +207,58 @@ private:
   // Server setup
   void setupRoutes();
   void setupCaptivePortalRoutes();
+  bool startAsyncWorkers();
+  void stopAsyncWorkers();
+  void releaseAsyncWorkers();
+  void registerRoute(httpd_uri_t &uri, uint8_t asyncLimit);
 
   // WebSocket management
   void addWebSocketClient(int fd);
   void removeWebSocketClient(int fd);
   void queue_ws_frame(int fd, const uint8_t *payload, size_t len,
-                      httpd_ws_type_t type);
+                      httpd_ws_type_t type,
+                      std::shared_ptr<HeapAdmission::Reservation> heap = nullptr);
+  void sendQueuedWsFrames();
   esp_err_t handleWebSocketMessage(httpd_req_t *req,
                                    const std::string &message);
 
   // Device info/status
-  std::string getDeviceMetrics();
+  struct Metrics {
+    MetricsRegistry::Counter &wsDroppedQueueFull;
+    MetricsRegistry::Counter &wsDroppedBacklog;
+    MetricsRegistry::Counter &wsSendFailed;
+    MetricsRegistry::Counter &metricPushesSent;
+    MetricsRegistry::Counter &metricPushesSuppressed;
+  };
+  static Metrics registerMetrics();
+  MetricsSample sampleMetrics();
+  static std::string encodeMetrics(const MetricsSample &now, WsClient &client, uint8_t groups, bool full);
+  std::string metricsSnapshot(int fd, uint8_t groups, bool resubscribe);
+  void pushMetricDeltas();
+  void resetMetricBaseline(int fd);
   std::string getDeviceInfo();
   std::string getOTAInfo();
   // OTA management
   void broadcastOTAStatus(const OTAState& state);
 
+  // Config request parsing
+  template <typename ConfigType>
+  static esp_err_t saveConfigSection(httpd_req_t *req, WebServerManager *instance);
+  template <typename ConfigType>
+  static esp_err_t receiveConfigPatch(httpd_req_t *req,
+                                      espConfig::fields::ConfigPatchBuilder<ConfigType> &builder);
+  template <typename ConfigType>
+  static bool validatePatch(httpd_req_t *req, const ConfigType &current,
+                            const espConfig::fields::ConfigPatch<ConfigType> &patch);
+
   // Utility methods
-  static bool validateRequest(httpd_req_t *req, cJSON *currentData,
-                              cJSON *obj);
   static WebServerManager *getInstance(httpd_req_t *req);
   static esp_err_t sendAuthFailure(httpd_req_t *req);
   static esp_err_t ws_post_handshake_cb(httpd_req_t *req);
   static esp_err_t sendJsonError(httpd_req_t *req, const std::string &msg, 
                             const char *status = "400 Bad Request");
+  static esp_err_t sendBusy(httpd_req_t *req, const char *msg, uint8_t retryAfterSeconds = 2);
+  static HeapAdmission::Reservation admitOrBusy(httpd_req_t *req, HeapAdmission::Op op, uint32_t bytes = 0);
   static bool heapGuardOk(httpd_req_t *req, bool otherActive,
                                     const char *thisName, const char *otherName);
   bool shouldEnableHttps() const;
@@ -190,13 +279,24 @@ private:
   NfcManager *m_nfcManager;
 
   // WebSocket infrastructure
-  QueueHandle_t m_wsQueue;
-  TaskHandle_t m_wsTaskHandle;
+  QueueHandle_t m_wsQueue = nullptr;
+  Executor::JobId m_wsSendJob = Executor::INVALID_JOB;
+  static constexpr size_t WS_FRAMES_PER_RUN = 8;
+  static constexpr uint32_t WS_SEND_TIMEOUT_MS = 100; ///< SO_SNDTIMEO on WebSocket sockets.
   std::vector<std::unique_ptr<WsClient>> m_wsClients;
   std::mutex m_wsClientsMutex;
   esp_timer_handle_t m_statusTimer;
-  std::deque<std::vector<uint8_t>> m_wsBroadcastBuffer;
+  esp_timer_handle_t m_historyTimer = nullptr;
+  BulkDeque<BulkVector<uint8_t>> m_wsBroadcastBuffer;
   uint16_t wsBacklogSize = 0;
+  Metrics m_metrics;
+
+  // Async request workers
+  QueueHandle_t m_asyncQueue = nullptr;
+  SemaphoreHandle_t m_asyncWorkersDone = nullptr;
+  std::vector<std::unique_ptr<AsyncRoute>> m_asyncRoutes;
+  uint8_t m_asyncWorkerCount = 0;
+  std::atomic<bool> m_asyncAccepting{false};
 
   std::atomic<bool> m_otaInProgress{false};
   bool m_isInitialized{false};
@@ -54,4 +54,12 @@ SubscriptionHandle subscribe(esp_event_base_t base, int32_t id,
 
 esp_err_t publish(esp_event_base_t base, int32_t id, const void* data, size_t size);
 
+/**
+ * @brief Approximate number of published events not yet delivered to a subscriber.
+ *
+ * Derived from sequence numbers, so events nobody subscribes to are only accounted for
+ * once a later event is dispatched.
+ */
+uint32_t pendingEvents();
+
 } // namespace AppEventLoop
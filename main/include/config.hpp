@@ -225,5 +225,6 @@ namespace espConfig
     uint8_t hkAltActionInitPin = GPIO_HK_ALT_ACTION_INIT_PIN;
     uint8_t hkAltActionInitLedPin = GPIO_HK_ALT_ACTION_INIT_LED_PIN;
     uint16_t hkAltActionInitTimeout = GPIO_HK_ALT_ACTION_INIT_TIMEOUT;
+    std::string feedbackPatterns = ""; // Custom feedback patterns, see FeedbackPattern.hpp
   };
 } // namespace espConfig
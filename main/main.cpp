@@ -13,6 +13,11 @@
 #include "HardwareManager.hpp"
 #include "MqttManager.hpp"
 #include "WebServerManager.hpp"
+#include "Executor.hpp"
+#include "HeapProfiler.hpp"
+#include "HomeSpanLoop.hpp"
+#include "MemoryPlacement.hpp"
+#include "TaskRegistry.hpp"
 #include <functional>
 #include <sodium/crypto_sign.h>
 #include <sodium/crypto_box.h>
@@ -121,6 +126,7 @@ void setup() {
   #ifdef CONFIG_INIT_ARDU_SERIAL_LOGGING
   Serial.begin(115200);
   #endif
+  MemoryPlacement::begin();
   if(esp_err_t err = nvs_flash_init(); err != ESP_OK){
     ESP_LOGE("Main", "Failed to initialize NVS. Aborting. err=%d", err);
     return;
@@ -133,6 +139,8 @@ void setup() {
   if (err != ESP_OK) {
     ESP_LOGE("Main", "Failed to create default event loop: %d", err);
   }
+  Executor::instance().begin();
+  TaskRegistry::instance().begin();
   // Why did we just boot? Without this a crash-reboot is indistinguishable in
   // the logs from a hang: the log simply stops and later resumes. The reset
   // reason separates a software panic from a watchdog timeout from a brownout,
@@ -202,6 +210,18 @@ void setup() {
                               miscConfig.nfcVenPin,
                               miscConfig.hkAuthPrecomputeEnabled,
                               miscConfig.nfcFastPollingEnabled);
+  // Act on an authorized HomeKey tap from the NFC task itself. LockManager applies the same
+  // decision when the tap event reaches it, and the state notifications follow from there.
+  nfcManager->setAuthorizedHook([] {
+    const int64_t authorizedAt = esp_timer_get_time();
+    const std::optional<uint8_t> state = lockManager->prepareNfcAction();
+    if (!state) return;
+#if CONFIG_HK_NFC_DIRECT_ACTUATION
+    hardwareManager->driveLockOutputDirect(*state, authorizedAt);
+#else
+    hardwareManager->expectLockOutput(authorizedAt);
+#endif
+  });
   nfcManager->begin();
 
   webServerManager.setNfcManager(nfcManager.get());
@@ -209,17 +229,20 @@ void setup() {
   hardwareManager->begin();
   homekitLock->begin();
   lockManager->begin();
+  // Started last: the profiler is for steady-state churn, not what setup() keeps.
+  HeapProfiler::instance().begin();
   pollHS = true;
 }
 /**
- * @brief Run the main application loop: service HomeSpan events and yield to the RTOS.
-*
- * Polls HomeSpan to process HomeKit and internal events, then delays 50 ms to allow other
- * FreeRTOS tasks to run.
+ * @brief Run the main application loop: service HomeSpan and block until it has more work.
+ *
+ * HomeSpanLoop polls HomeSpan, then sleeps until a HomeKit socket has data, a characteristic
+ * is set from another task, or its idle interval passes.
  */
 
 void loop() {
   if(pollHS)
-    homeSpan.poll();
-  vTaskDelay(pdMS_TO_TICKS(50));
+    HomeSpanLoop::instance().run();
+  else
+    vTaskDelay(pdMS_TO_TICKS(50));
 }
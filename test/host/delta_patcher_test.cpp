@@ -0,0 +1,150 @@
+// Applies the fixture patch to its base image and checks the result, then feeds the patcher
+// corrupt and truncated patches. Usage: delta_patcher_test <fixtures/delta>
+#include "DeltaPatcher.hpp"
+#include "test_util.hpp"
+#include <cstring>
+
+namespace {
+
+class BufferSource : public DeltaPatcher::Source {
+public:
+  explicit BufferSource(const std::vector<uint8_t> &image) : m_image(image) {}
+
+  bool accept(const DeltaPatcher::Header &header) override { return header.sourceSize == m_image.size(); }
+  bool read(size_t offset, uint8_t *out, size_t len) override {
+    if (offset + len > m_image.size()) return false;
+    memcpy(out, m_image.data() + offset, len);
+    return true;
+  }
+
+private:
+  const std::vector<uint8_t> &m_image;
+};
+
+struct Result {
+  bool ok;
+  std::string error;
+  std::vector<uint8_t> output;
+};
+
+Result apply(const std::vector<uint8_t> &source, const std::vector<uint8_t> &patch, size_t chunk = 1460) {
+  BufferSource src(source);
+  VectorSink out;
+  DeltaPatcher patcher(src, out);
+  bool ok = writeChunked(patcher, patch, chunk) && patcher.finish();
+  CHECK(ok == out.finished);
+  return {ok, patcher.error() ? patcher.error() : "", std::move(out.bytes)};
+}
+
+void putVarint(std::vector<uint8_t> &v, uint32_t x) {
+  for (; x >= 0x80; x >>= 7) v.push_back(uint8_t(x | 0x80));
+  v.push_back(uint8_t(x));
+}
+
+void putLe32(std::vector<uint8_t> &v, uint32_t x) {
+  for (int i = 0; i < 4; i++) v.push_back(uint8_t(x >> (8 * i)));
+}
+
+/** @brief A header for a patch from a @p sourceSize image to a @p targetSize one, followed by @p ops. */
+std::vector<uint8_t> handPatch(uint32_t sourceSize, uint32_t targetSize, std::vector<uint8_t> ops) {
+  std::vector<uint8_t> p = {'H', 'K', 'D', 'P', DeltaPatcher::VERSION, 0, 0, 0};
+  putLe32(p, sourceSize);
+  putLe32(p, targetSize);
+  p.resize(DeltaPatcher::HEADER_SIZE);
+  p.insert(p.end(), ops.begin(), ops.end());
+  return p;
+}
+
+void appliesFixture(const std::vector<uint8_t> &source, const std::vector<uint8_t> &target,
+                    const std::vector<uint8_t> &patch) {
+  // Chunk sizes that split the header, varints and literal runs at every kind of boundary.
+  for (size_t chunk : {size_t(1), size_t(7), size_t(80), size_t(1460), patch.size()}) {
+    Result r = apply(source, patch, chunk);
+    CHECK(r.ok);
+    CHECK(r.output == target);
+  }
+}
+
+void rejectsTruncatedPatches(const std::vector<uint8_t> &source, const std::vector<uint8_t> &patch) {
+  for (size_t len : {size_t(0), size_t(10), DeltaPatcher::HEADER_SIZE, DeltaPatcher::HEADER_SIZE + 1,
+                     patch.size() / 2, patch.size() - 1}) {
+    Result r = apply(source, std::vector<uint8_t>(patch.begin(), patch.begin() + len));
+    CHECK(!r.ok);
+    CHECK(r.error == "Patch is truncated");
+  }
+}
+
+void rejectsCorruptPatches(const std::vector<uint8_t> &source, const std::vector<uint8_t> &patch) {
+  auto corrupt = [&](size_t offset, uint8_t value) {
+    std::vector<uint8_t> p = patch;
+    p[offset] = value;
+    return apply(source, p);
+  };
+  CHECK(corrupt(0, 'X').error == "Not a delta patch");
+  CHECK(corrupt(4, DeltaPatcher::VERSION + 1).error == "Unsupported delta patch version");
+  CHECK(corrupt(8, uint8_t(source.size() + 1)).error == "Patch does not match the running firmware");
+
+  std::vector<uint8_t> trailing = patch;
+  trailing.push_back(0);
+  CHECK(apply(source, trailing).error == "Trailing data after end of patch");
+
+  const uint32_t size = uint32_t(source.size());
+  CHECK(apply(source, handPatch(size, 4, {0x07})).error == "Unknown patch opcode");
+  // COPY 1 byte from one past the end of the source.
+  std::vector<uint8_t> copyPastEnd = {0x01};
+  putVarint(copyPastEnd, size);
+  putVarint(copyPastEnd, 1);
+  CHECK(apply(source, handPatch(size, 4, copyPastEnd)).error == "Patch reads outside the source image");
+  // INSERT 5 bytes into a 4-byte target.
+  CHECK(apply(source, handPatch(size, 4, {0x02, 5, 1, 2, 3, 4, 5, 0})).error == "Patch exceeds the target size");
+  CHECK(apply(source, handPatch(size, 4, {0x02, 0xff, 0xff, 0xff, 0xff, 0xff})).error == "Malformed varint");
+  CHECK(apply(source, handPatch(size, 4, {0x02, 3, 1, 2, 3, 0})).error == "Patch produced the wrong image size");
+
+  BufferSource src(source);
+  VectorSink out;
+  out.failWrites = true;
+  DeltaPatcher patcher(src, out);
+  CHECK(!writeChunked(patcher, patch, 1460));
+  CHECK(std::string(patcher.error()) == "Writing the patched image failed");
+}
+
+void survivesByteFlips(const std::vector<uint8_t> &source, const std::vector<uint8_t> &target,
+                       const std::vector<uint8_t> &patch) {
+  // Flipped data bytes can still yield a well-formed patch; the image hash catches those on the
+  // device. What must hold is that the patcher never overruns the declared target size.
+  uint32_t seed = 1;
+  for (int i = 0; i < 2000; i++) {
+    seed = seed * 1103515245 + 12345;
+    std::vector<uint8_t> p = patch;
+    size_t at = DeltaPatcher::HEADER_SIZE + (seed >> 8) % (p.size() - DeltaPatcher::HEADER_SIZE);
+    p[at] ^= uint8_t(1 << (seed % 8));
+    Result r = apply(source, p, 1 + seed % 512);
+    CHECK(r.output.size() <= target.size());
+    if (r.ok) CHECK(r.output.size() == target.size());
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    std::fprintf(stderr, "usage: %s <fixtures/delta>\n", argv[0]);
+    return 2;
+  }
+  const std::string dir = argv[1];
+  const auto source = readFile(dir + "/source.bin");
+  const auto target = readFile(dir + "/target.bin");
+  const auto patch = readFile(dir + "/patch.bin");
+
+  appliesFixture(source, target, patch);
+  rejectsTruncatedPatches(source, patch);
+  rejectsCorruptPatches(source, patch);
+  survivesByteFlips(source, target, patch);
+
+  if (g_failures) {
+    std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+    return 1;
+  }
+  std::printf("delta_patcher: all checks passed\n");
+  return 0;
+}
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""Regenerate the host test fixtures.
+
+    python3 make_fixtures.py
+
+Writes:
+  delta/source.bin, delta/target.bin  a base image and an edited build of it
+  delta/patch.bin                      HKDP patch from source to target (DeltaPatcher.hpp)
+  heatshrink/raw.bin                   uncompressed reference data
+  heatshrink/w<W>_l<L>.bin             raw.bin with the 12-byte HKHS header, encoded with
+                                       window W and lookahead L (HeatshrinkDecoder.hpp)
+
+The output is deterministic, so rerunning it must not change the committed files.
+"""
+import hashlib
+import os
+import random
+import struct
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def varint(n):
+    out = bytearray()
+    while True:
+        b = n & 0x7F
+        n >>= 7
+        if n:
+            out.append(b | 0x80)
+        else:
+            out.append(b)
+            return bytes(out)
+
+
+def make_patch(src, dst, block=16):
+    """Greedy HKDP encoder: COPY for matched blocks, ADD for in-place edits, INSERT past the source end."""
+    index = {}
+    for k in range(len(src) - block + 1):
+        index.setdefault(src[k:k + block], k)
+    ops = bytearray()
+    literal = bytearray()
+    i = 0
+
+    def flush():
+        start = i - len(literal)
+        if not literal:
+            return
+        if start + len(literal) <= len(src):
+            diff = bytes((d - s) & 0xFF for d, s in zip(literal, src[start:start + len(literal)]))
+            ops.extend(b"\x03" + varint(start) + varint(len(literal)) + diff)
+        else:
+            ops.extend(b"\x02" + varint(len(literal)) + bytes(literal))
+        literal.clear()
+
+    while i < len(dst):
+        k = index.get(dst[i:i + block])
+        if k is None:
+            literal.append(dst[i])
+            i += 1
+            continue
+        n = block
+        while i + n < len(dst) and k + n < len(src) and dst[i + n] == src[k + n]:
+            n += 1
+        flush()
+        ops.extend(b"\x01" + varint(k) + varint(n))
+        i += n
+    flush()
+    ops.append(0)
+    header = (b"HKDP" + bytes([1, 0, 0, 0]) + struct.pack("<II", len(src), len(dst)) +
+              hashlib.sha256(src).digest() + hashlib.sha256(dst).digest())
+    return header + bytes(ops)
+
+
+def heatshrink_encode(data, window, lookahead):
+    """LZSS in the heatshrink bitstream format, with the HKHS header."""
+    bits = []
+    max_count = 1 << lookahead
+    max_distance = 1 << window
+    index = {}
+
+    def put(value, count):
+        bits.extend((value >> k) & 1 for k in range(count - 1, -1, -1))
+
+    i = 0
+    while i < len(data):
+        best = distance = 0
+        for j in reversed(index.get(data[i:i + 3], [])[-32:]):
+            d = i - j
+            if d > max_distance:
+                continue
+            m = 0
+            while m < max_count and i + m < len(data) and data[j + m] == data[i + m]:
+                m += 1
+            if m > best:
+                best, distance = m, d
+        if best >= 3:
+            put(0, 1)
+            put(distance - 1, window)
+            put(best - 1, lookahead)
+            for k in range(i, i + best):
+                index.setdefault(data[k:k + 3], []).append(k)
+            i += best
+        else:
+            put(1, 1)
+            put(data[i], 8)
+            index.setdefault(data[i:i + 3], []).append(i)
+            i += 1
+    bits.extend([0] * (-len(bits) % 8))
+    body = bytes(int("".join(map(str, bits[k:k + 8])), 2) for k in range(0, len(bits), 8))
+    return b"HKHS" + bytes([window, lookahead, 0, 0]) + struct.pack("<I", len(data)) + body
+
+
+def firmware_like(rng, size):
+    """Repetitive instruction-like words with some string tables, so it compresses like an app image."""
+    words = [bytes(rng.getrandbits(8) for _ in range(rng.randint(2, 12))) for _ in range(200)]
+    strings = [b"HomeKey-ESP32 %d\x00" % n for n in range(40)]
+    out = bytearray()
+    while len(out) < size:
+        out += rng.choice(strings) if rng.random() < 0.05 else rng.choice(words)
+    return bytes(out[:size])
+
+
+def write(path, data):
+    full = os.path.join(HERE, path)
+    os.makedirs(os.path.dirname(full), exist_ok=True)
+    with open(full, "wb") as f:
+        f.write(data)
+
+
+def main():
+    rng = random.Random(28)
+    source = firmware_like(rng, 24 * 1024)
+    target = bytearray(source)
+    target[100:200] = bytes(100)                     # zeroed region
+    target[5000:5000] = b"inserted " * 150           # code inserted mid-image
+    for j in range(12000, 13000, 4):                 # relocated pointers
+        target[j] = (target[j] + 3) & 0xFF
+    target += b"tail" * 100                          # grown image
+    target = bytes(target)
+    write("delta/source.bin", source)
+    write("delta/target.bin", target)
+    write("delta/patch.bin", make_patch(source, target))
+
+    raw = firmware_like(random.Random(29), 32 * 1024)
+    write("heatshrink/raw.bin", raw)
+    for window, lookahead in [(8, 4), (11, 4), (13, 6)]:
+        write("heatshrink/w%d_l%d.bin" % (window, lookahead), heatshrink_encode(raw, window, lookahead))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,61 @@
+// Decodes the reference-encoded fixtures, checks the output against raw.bin and reports
+// throughput. Usage: heatshrink_bench <fixtures/heatshrink> [iterations]
+#include "HeatshrinkDecoder.hpp"
+#include "test_util.hpp"
+#include <chrono>
+
+namespace {
+
+/** @brief Sink that only counts bytes, so the timing covers the decoder alone. */
+class CountingSink : public OtaSink {
+public:
+  bool write(const uint8_t *, size_t len) override {
+    bytes += len;
+    return true;
+  }
+  size_t bytes = 0;
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    std::fprintf(stderr, "usage: %s <fixtures/heatshrink> [iterations]\n", argv[0]);
+    return 2;
+  }
+  const std::string dir = argv[1];
+  const int iterations = argc > 2 ? std::atoi(argv[2]) : 200;
+  const auto raw = readFile(dir + "/raw.bin");
+
+  for (const char *name : {"w8_l4", "w11_l4", "w13_l6"}) {
+    const auto encoded = readFile(dir + "/" + name + ".bin");
+
+    // Correctness first, at chunk sizes that split the header and the bitstream anywhere.
+    for (size_t chunk : {size_t(1), size_t(5), size_t(1460), encoded.size()}) {
+      VectorSink out;
+      HeatshrinkDecoder decoder(out);
+      CHECK(writeChunked(decoder, encoded, chunk) && decoder.finish());
+      CHECK(out.bytes == raw);
+    }
+
+    // 1460 bytes is one TCP segment, which is roughly what each httpd_req_recv() returns.
+    size_t produced = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+      CountingSink out;
+      HeatshrinkDecoder decoder(out);
+      writeChunked(decoder, encoded, 1460);
+      decoder.finish();
+      produced += out.bytes;
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-7s ratio %5.1f%%  %8.1f MiB/s decoded\n", name, 100.0 * encoded.size() / raw.size(),
+                produced / seconds / (1024 * 1024));
+  }
+
+  if (g_failures) {
+    std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,94 @@
+// Fuzz target for HeatshrinkDecoder on malformed streams.
+//
+// With -DHK_LIBFUZZER=ON (clang) this is a libFuzzer target:
+//   ./heatshrink_fuzz fixtures/heatshrink
+// Otherwise main() replays the fixtures and a fixed set of mutations of them, so ctest
+// covers the same invariants without a fuzzing toolchain.
+#include "HeatshrinkDecoder.hpp"
+#include "test_util.hpp"
+
+namespace {
+
+/** @brief Fails the run if the decoder writes more than the header declared or after a failure. */
+class CheckedSink : public OtaSink {
+public:
+  bool write(const uint8_t *, size_t len) override {
+    m_bytes += len;
+    if (m_bytes > decoder->outputSize()) std::abort();
+    return true;
+  }
+  bool finish() override {
+    if (m_bytes != decoder->outputSize()) std::abort();
+    return true;
+  }
+
+  const HeatshrinkDecoder *decoder = nullptr;
+
+private:
+  size_t m_bytes = 0;
+};
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  if (size == 0) return 0;
+  // The first byte picks the write size, so chunk boundaries get fuzzed too.
+  const size_t chunk = 1 + data[0] % 64;
+  data++;
+  size--;
+  // The declared size bounds the output; cap it at 64 KiB to keep each run short. Larger sizes
+  // exercise nothing new.
+  if (size >= HeatshrinkDecoder::HEADER_SIZE && (data[10] != 0 || data[11] != 0)) return 0;
+
+  CheckedSink sink;
+  HeatshrinkDecoder decoder(sink);
+  sink.decoder = &decoder;
+  bool ok = true;
+  for (size_t pos = 0; ok && pos < size; pos += chunk) ok = decoder.write(data + pos, std::min(chunk, size - pos));
+  if (ok) ok = decoder.finish();
+  if (!ok && !decoder.error()) std::abort();
+  return 0;
+}
+
+#ifndef HK_LIBFUZZER
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    std::fprintf(stderr, "usage: %s <fixtures/heatshrink>\n", argv[0]);
+    return 2;
+  }
+  const std::string dir = argv[1];
+  uint32_t seed = 29;
+  auto next = [&seed] { return seed = seed * 1103515245 + 12345; };
+  size_t runs = 0;
+
+  for (const char *name : {"w8_l4", "w11_l4", "w13_l6"}) {
+    const auto encoded = readFile(dir + "/" + name + ".bin");
+    auto run = [&](std::vector<uint8_t> input) {
+      input.insert(input.begin(), uint8_t(next() >> 16));
+      LLVMFuzzerTestOneInput(input.data(), input.size());
+      runs++;
+    };
+
+    run(encoded);
+    for (int i = 0; i < 300; i++) {
+      auto flipped = encoded;
+      flipped[next() % flipped.size()] ^= uint8_t(1 << (next() % 8));
+      run(flipped);
+    }
+    for (int i = 0; i < 100; i++) run({encoded.begin(), encoded.begin() + next() % encoded.size()});
+    for (int i = 0; i < 100; i++) {
+      auto header = encoded;
+      header[4 + next() % 8] = uint8_t(next() >> 16);  // window/lookahead bits, reserved and size bytes
+      header[10] = header[11] = 0;
+      run(header);
+    }
+    for (int i = 0; i < 100; i++) {
+      std::vector<uint8_t> garbage(encoded.begin(), encoded.begin() + HeatshrinkDecoder::HEADER_SIZE);
+      for (int j = next() % 2048; j > 0; j--) garbage.push_back(uint8_t(next() >> 16));
+      run(garbage);
+    }
+  }
+  std::printf("heatshrink_fuzz: %zu inputs, no invariant violations\n", runs);
+  return 0;
+}
+#endif
@@ -0,0 +1,121 @@
+// Encodes the MQTT tap payloads with JsonWriter and with a std::string encoder shaped like
+// the JsonBuilder/fmt path it replaced (one string per hex field, then the document),
+// checks both give the same text, and reports time and heap allocations per tap pair.
+// Usage: jsonwriter_bench [iterations]
+#include "JsonWriter.hpp"
+#include "test_util.hpp"
+#include <chrono>
+#include <new>
+
+namespace {
+
+size_t g_allocations = 0;
+
+// Same fields and order as encodeHomeKeyTap() and encodeUidTap() in MqttManager.cpp.
+constexpr size_t TAP_PAYLOAD_SIZE = 192;
+using TapBuffer = std::array<char, TAP_PAYLOAD_SIZE>;
+
+std::string_view writerHomeKey(TapBuffer &buf, std::span<const uint8_t> issuer, std::span<const uint8_t> endpoint,
+                               std::span<const uint8_t> reader) {
+  return JsonWriter(buf)
+      .addHex("issuerId", issuer)
+      .addHex("endpointId", endpoint)
+      .addHex("readerId", reader)
+      .addBool("homekey", true)
+      .finish();
+}
+
+std::string_view writerUid(TapBuffer &buf, std::span<const uint8_t> uid, std::span<const uint8_t> atqa, uint8_t sak,
+                           std::string_view reader) {
+  return JsonWriter(buf)
+      .addHex("uid", uid)
+      .addBool("homekey", false)
+      .addHex("atqa", atqa)
+      .addHex("sak", {&sak, 1})
+      .addString("readerId", reader)
+      .finish();
+}
+
+std::string hexString(std::span<const uint8_t> bytes) {
+  std::string out(2 * bytes.size(), '\0');
+  hex::encode(bytes, out.data());
+  return out;
+}
+
+std::string field(const char *key, const std::string &value) { return std::string("\"") + key + "\":\"" + value + '"'; }
+
+std::string stringHomeKey(std::span<const uint8_t> issuer, std::span<const uint8_t> endpoint,
+                          std::span<const uint8_t> reader) {
+  return '{' + field("issuerId", hexString(issuer)) + ',' + field("endpointId", hexString(endpoint)) + ',' +
+         field("readerId", hexString(reader)) + ",\"homekey\":true}";
+}
+
+std::string stringUid(std::span<const uint8_t> uid, std::span<const uint8_t> atqa, uint8_t sak,
+                      const std::string &reader) {
+  return '{' + field("uid", hexString(uid)) + ",\"homekey\":false," + field("atqa", hexString(atqa)) + ',' +
+         field("sak", hexString({&sak, 1})) + ',' + field("readerId", reader) + '}';
+}
+
+} // namespace
+
+void *operator new(size_t size) {
+  g_allocations++;
+  if (void *p = std::malloc(size ? size : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+int main(int argc, char **argv) {
+  const int iterations = argc > 1 ? std::atoi(argv[1]) : 100000;
+  const std::array<uint8_t, 8> issuer{0x3A, 0x91, 0x0C, 0x57, 0xE2, 0x44, 0x18, 0xB6};
+  const std::array<uint8_t, 6> endpoint{0x02, 0x7F, 0xA0, 0x11, 0xC3, 0x5D};
+  const std::array<uint8_t, 7> uid{0x04, 0xA2, 0x3B, 0x91, 0x6C, 0x5E, 0x80};
+  const std::array<uint8_t, 2> atqa{0x00, 0x44};
+  const uint8_t sak = 0x08;
+  const std::string reader = "ESP_1A2B3C4D\"\n";
+
+  {
+    TapBuffer hk, tag;
+    CHECK(writerHomeKey(hk, issuer, endpoint, issuer) ==
+          R"({"issuerId":"3A910C57E24418B6","endpointId":"027FA011C35D","readerId":"3A910C57E24418B6","homekey":true})");
+    CHECK(writerHomeKey(hk, issuer, endpoint, issuer) == stringHomeKey(issuer, endpoint, issuer));
+    CHECK(writerUid(tag, uid, atqa, sak, reader) ==
+          R"({"uid":"04A23B916C5E80","homekey":false,"atqa":"0044","sak":"08","readerId":"ESP_1A2B3C4D\"\u000A"})");
+    // A document that does not fit is dropped, never truncated.
+    std::array<char, 16> small;
+    CHECK(JsonWriter(small).addHex("uid", uid).finish().empty());
+  }
+
+  volatile size_t sink = 0;
+  size_t allocations = g_allocations;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    std::string hk = stringHomeKey(issuer, endpoint, issuer);
+    std::string tag = stringUid(uid, atqa, sak, reader);
+    sink = sink + hk.size() + tag.size();
+  }
+  const double stringNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  const size_t stringAllocs = g_allocations - allocations;
+
+  allocations = g_allocations;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    TapBuffer hk, tag;
+    sink = sink + writerHomeKey(hk, issuer, endpoint, issuer).size() + writerUid(tag, uid, atqa, sak, reader).size();
+  }
+  const double writerNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  const size_t writerAllocs = g_allocations - allocations;
+  CHECK(writerAllocs == 0);
+
+  std::printf("std::string  %7.1f ns/pair  %5.1f allocations/pair\n", stringNs / iterations,
+              double(stringAllocs) / iterations);
+  std::printf("JsonWriter   %7.1f ns/pair  %5.1f allocations/pair\n", writerNs / iterations,
+              double(writerAllocs) / iterations);
+
+  if (g_failures) {
+    std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+    return 1;
+  }
+  return 0;
+}
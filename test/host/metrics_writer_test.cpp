@@ -0,0 +1,93 @@
+// Checks that MetricsRegistry::Writer never truncates a line, wherever it falls in the buffer,
+// and that a full render of long HELP texts comes out as whole lines.
+#include "MetricsRegistry.hpp"
+#include "test_util.hpp"
+#include <sstream>
+
+namespace {
+
+static constexpr uint32_t BUCKETS[] = {100, 1000, 10000};
+
+} // namespace
+
+/** @brief Write a @p fill byte line and then @p line, at every fill level that matters. */
+void writerNeverTruncates(const std::string &line) {
+  for (size_t fill = 1; fill < 600; fill++) {
+    std::string out;
+    MetricsRegistry::Sink sink = [&](const char *data, size_t len) {
+      out.append(data, len);
+      return true;
+    };
+    MetricsRegistry::Writer writer(sink);
+    const std::string first(fill - 1, 'x');
+    writer.printf("%s\n", first.c_str());
+    writer.printf("%s", line.c_str());
+    writer.printf("%s", line.c_str());
+    CHECK(writer.flush());
+    CHECK(out == first + "\n" + line + line);
+  }
+}
+
+int main() {
+  // A HELP+TYPE header longer than the 160 bytes the writer used to reserve per call.
+  writerNeverTruncates("# HELP hk_heap_profile_dropped_samples_total Samples the heap profiler could not record "
+                       "because its table was full\n# TYPE hk_heap_profile_dropped_samples_total counter\n");
+  writerNeverTruncates(std::string(1000, 'y') + "\n");
+
+  auto &registry = MetricsRegistry::instance();
+  const std::string longHelp(600, 'h');
+  // Fill most of the buffer first so the next header straddles its end.
+  for (const char *name : {"filler_a_total", "filler_b_total", "filler_c_total", "filler_d_total"}) {
+    registry.counter(name, "Filler series that put the next header at the end of the buffer");
+  }
+  registry.counter("hk_heap_profile_dropped_samples_total",
+                   "Heap profiler samples dropped because the sample table was full or the profiler was busy",
+                   "subsystem=\"nfc\"").inc();
+  registry.histogram("hk_homekit_command_latency_us",
+                     "Time from a HomeKit lock command reaching the socket to HomeSpan handling it", BUCKETS)
+      .observe(250);
+  registry.counter("very_long_help_total", longHelp.c_str()).inc();
+
+  std::string text;
+  size_t chunks = 0;
+  CHECK(registry.render([&](const char *data, size_t len) {
+    CHECK(len > 0);
+    text.append(data, len);
+    chunks++;
+    return true;
+  }));
+  CHECK(chunks > 1);
+  CHECK(!text.empty() && text.back() == '\n');
+
+  std::istringstream lines(text);
+  std::string line;
+  size_t helpLines = 0;
+  while (std::getline(lines, line)) {
+    if (line.starts_with("# HELP ")) {
+      helpLines++;
+    } else if (line.starts_with("# TYPE ")) {
+      CHECK(line.ends_with(" counter") || line.ends_with(" gauge") || line.ends_with(" histogram"));
+    } else {
+      // A sample: name{labels} value.
+      CHECK(line.find(' ') != std::string::npos);
+      CHECK(line.find('#') == std::string::npos);
+    }
+  }
+  CHECK(helpLines == 7);
+  CHECK(text.find("# HELP hk_heap_profile_dropped_samples_total Heap profiler samples dropped because the sample "
+                  "table was full or the profiler was busy\n# TYPE hk_heap_profile_dropped_samples_total counter\n") !=
+        std::string::npos);
+  CHECK(text.find("hk_heap_profile_dropped_samples_total{subsystem=\"nfc\"} 1\n") != std::string::npos);
+  CHECK(text.find("# HELP very_long_help_total " + longHelp + "\n") != std::string::npos);
+  CHECK(text.find("hk_homekit_command_latency_us_bucket{le=\"1000\"} 1\n") != std::string::npos);
+
+  // A sink failure stops rendering.
+  CHECK(!registry.render([](const char *, size_t) { return false; }));
+
+  if (g_failures) {
+    std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+    return 1;
+  }
+  std::printf("metrics_writer: all checks passed\n");
+  return 0;
+}
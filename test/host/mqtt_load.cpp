@@ -0,0 +1,251 @@
+// MQTT command load generator. Publishes alternating lock/unlock commands to a device's
+// target state topic at a fixed rate through a broker, and times how long each command
+// takes to show up on the lock state topic. Needs a broker and a device, so it is built
+// but not run by ctest.
+//
+// Usage: mqtt_load <broker> <port> <command-topic> <state-topic> [commands/s] [seconds]
+//
+// A command counts as answered when the state topic reports its value, or a later
+// command's value. Commands the device coalesced are answered by the state that
+// superseded them, so the latency includes any time spent queued on the device.
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <netdb.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint8_t CONNECT = 0x10, CONNACK = 0x20, PUBLISH = 0x30, SUBSCRIBE = 0x82, SUBACK = 0x90,
+                  PINGREQ = 0xC0, DISCONNECT = 0xE0;
+constexpr uint16_t KEEPALIVE_S = 30;
+
+/** @brief Minimal MQTT 3.1.1 client: QoS 0 only, one subscription. */
+class Client {
+public:
+  ~Client() {
+    if (m_fd >= 0) close(m_fd);
+  }
+
+  bool connect(const char *host, const char *port, const std::string &clientId) {
+    addrinfo hints{}, *res = nullptr;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, port, &hints, &res) != 0) return false;
+    for (addrinfo *ai = res; ai && m_fd < 0; ai = ai->ai_next) {
+      m_fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+      if (m_fd >= 0 && ::connect(m_fd, ai->ai_addr, ai->ai_addrlen) != 0) {
+        close(m_fd);
+        m_fd = -1;
+      }
+    }
+    freeaddrinfo(res);
+    if (m_fd < 0) return false;
+
+    std::string body;
+    putString(body, "MQTT");
+    body += '\x04'; // Protocol level 3.1.1.
+    body += '\x02'; // Clean session.
+    body += char(KEEPALIVE_S >> 8);
+    body += char(KEEPALIVE_S & 0xFF);
+    putString(body, clientId);
+    if (!send(CONNECT, body)) return false;
+    uint8_t type;
+    std::string reply;
+    return read(type, reply, 5000) && type == CONNACK && reply.size() == 2 && reply[1] == 0;
+  }
+
+  bool subscribe(const std::string &topic) {
+    std::string body("\x00\x01", 2);
+    putString(body, topic);
+    body += '\x00';
+    if (!send(SUBSCRIBE, body)) return false;
+    uint8_t type;
+    std::string reply;
+    while (read(type, reply, 5000)) {
+      if (type == SUBACK) return reply.size() == 3 && uint8_t(reply[2]) != 0x80;
+    }
+    return false;
+  }
+
+  bool publish(const std::string &topic, const std::string &payload) {
+    std::string body;
+    putString(body, topic);
+    return send(PUBLISH, body + payload);
+  }
+
+  bool ping() { return send(PINGREQ, {}); }
+  void disconnect() { send(DISCONNECT, {}); }
+
+  /**
+   * @brief Read one packet, waiting at most @p timeoutMs for more data.
+   * @return false on timeout or a closed connection; closed() tells them apart.
+   */
+  bool read(uint8_t &type, std::string &body, int timeoutMs) {
+    type = 0;
+    while (true) {
+      if (m_buf.size() >= 2) {
+        size_t len = 0, pos = 1;
+        for (unsigned shift = 0; pos < m_buf.size() && shift <= 21; shift += 7) {
+          uint8_t b = m_buf[pos++];
+          len |= size_t(b & 0x7F) << shift;
+          if (b & 0x80) continue;
+          if (m_buf.size() - pos < len) break;
+          type = uint8_t(m_buf[0]);
+          body.assign(m_buf, pos, len);
+          m_buf.erase(0, pos + len);
+          return true;
+        }
+      }
+      pollfd pfd{m_fd, POLLIN, 0};
+      if (poll(&pfd, 1, timeoutMs) <= 0) return false;
+      char chunk[4096];
+      ssize_t n = recv(m_fd, chunk, sizeof(chunk), 0);
+      if (n <= 0) {
+        m_closed = true;
+        return false;
+      }
+      m_buf.append(chunk, size_t(n));
+    }
+  }
+
+  bool closed() const { return m_closed; }
+
+private:
+  static void putString(std::string &out, const std::string &s) {
+    out += char(s.size() >> 8);
+    out += char(s.size() & 0xFF);
+    out += s;
+  }
+
+  bool send(uint8_t type, const std::string &body) {
+    std::string packet(1, char(type));
+    size_t len = body.size();
+    do {
+      uint8_t b = len & 0x7F;
+      len >>= 7;
+      packet += char(len ? b | 0x80 : b);
+    } while (len);
+    packet += body;
+    return ::send(m_fd, packet.data(), packet.size(), MSG_NOSIGNAL) == ssize_t(packet.size());
+  }
+
+  int m_fd = -1;
+  bool m_closed = false;
+  std::string m_buf;
+};
+
+struct Pending {
+  char value;
+  Clock::time_point sentAt;
+};
+
+double percentile(std::vector<double> &sorted, double p) {
+  if (sorted.empty()) return 0;
+  return sorted[std::min(sorted.size() - 1, size_t(p * sorted.size()))];
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 5) {
+    std::fprintf(stderr, "usage: %s <broker> <port> <command-topic> <state-topic> [commands/s] [seconds]\n",
+                 argv[0]);
+    return 2;
+  }
+  const std::string commandTopic = argv[3], stateTopic = argv[4];
+  const double rate = argc > 5 ? std::atof(argv[5]) : 100;
+  const double seconds = argc > 6 ? std::atof(argv[6]) : 10;
+  if (rate <= 0 || seconds <= 0) {
+    std::fprintf(stderr, "rate and duration must be positive\n");
+    return 2;
+  }
+
+  Client client;
+  if (!client.connect(argv[1], argv[2], "hk-load-" + std::to_string(getpid())) || !client.subscribe(stateTopic)) {
+    std::fprintf(stderr, "Cannot connect and subscribe to %s:%s\n", argv[1], argv[2]);
+    return 1;
+  }
+  // The broker sends the retained state right after SUBACK; give it a moment and drop it.
+  uint8_t type;
+  std::string body;
+  while (client.read(type, body, 200)) {
+  }
+  if (client.closed()) {
+    std::fprintf(stderr, "Connection lost\n");
+    return 1;
+  }
+
+  const auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rate));
+  const auto start = Clock::now();
+  const auto sendUntil = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+  const auto waitUntil = sendUntil + std::chrono::seconds(5); // Let the backlog drain.
+  auto nextSend = start, nextPing = start + std::chrono::seconds(KEEPALIVE_S / 2);
+  std::deque<Pending> pending;
+  std::vector<double> latenciesMs;
+  size_t sent = 0, states = 0;
+  char nextValue = '1';
+
+  while (true) {
+    const auto now = Clock::now();
+    if (now >= waitUntil || (now >= sendUntil && pending.empty())) break;
+    while (now < sendUntil && nextSend <= now) {
+      if (!client.publish(commandTopic, std::string(1, nextValue))) {
+        std::fprintf(stderr, "Connection lost after %zu command(s)\n", sent);
+        return 1;
+      }
+      pending.push_back({nextValue, Clock::now()});
+      nextValue = nextValue == '1' ? '0' : '1';
+      nextSend += interval;
+      sent++;
+    }
+    if (nextPing <= now) {
+      client.ping();
+      nextPing = now + std::chrono::seconds(KEEPALIVE_S / 2);
+    }
+
+    const auto wake = now < sendUntil ? std::min(nextSend, nextPing) : std::min(waitUntil, nextPing);
+    const int timeoutMs = int(std::chrono::duration_cast<std::chrono::milliseconds>(wake - now).count());
+    if (!client.read(type, body, std::max(timeoutMs, 0))) {
+      if (!client.closed()) continue;
+      std::fprintf(stderr, "Connection lost\n");
+      return 1;
+    }
+    if ((type & 0xF0) != PUBLISH || body.size() < 2) continue;
+    const size_t topicLen = (uint8_t(body[0]) << 8) | uint8_t(body[1]);
+    const size_t payloadAt = 2 + topicLen + ((type & 0x06) ? 2 : 0);
+    if (body.compare(2, topicLen, stateTopic) != 0 || body.size() != payloadAt + 1) continue;
+    states++;
+    // The newest command asking for this state answers it and every command before it.
+    const char value = body[payloadAt];
+    auto last = std::find_if(pending.rbegin(), pending.rend(), [value](const Pending &p) { return p.value == value; });
+    if (last == pending.rend()) continue;
+    const auto received = Clock::now();
+    const size_t answered = pending.size() - size_t(last - pending.rbegin());
+    for (size_t i = 0; i < answered; i++) {
+      latenciesMs.push_back(std::chrono::duration<double, std::milli>(received - pending.front().sentAt).count());
+      pending.pop_front();
+    }
+  }
+  client.disconnect();
+
+  std::sort(latenciesMs.begin(), latenciesMs.end());
+  const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+  std::printf("sent %zu command(s) at %.0f/s, %zu state update(s), %zu unanswered\n", sent, rate, states,
+              pending.size());
+  std::printf("round trip ms: p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n", percentile(latenciesMs, 0.5),
+              percentile(latenciesMs, 0.9), percentile(latenciesMs, 0.99),
+              latenciesMs.empty() ? 0 : latenciesMs.back());
+  std::printf("answered %.1f command(s)/s over %.1f s\n", latenciesMs.size() / elapsed, elapsed);
+  return pending.empty() ? 0 : 1;
+}
@@ -0,0 +1,246 @@
+// Checks MqttOutbox ordering, coalescing and overflow, and MqttSpool append, replay,
+// eviction and recovery on an in-memory filesystem. Usage: mqtt_outbox_test
+#include "MqttOutbox.hpp"
+#include "test_util.hpp"
+
+namespace {
+
+using Message = MqttOutbox::Message;
+using Priority = MqttOutbox::Priority;
+using PushResult = MqttOutbox::PushResult;
+
+Message msg(Priority priority, std::string topic, std::string payload = "x", int64_t queuedAt = 0) {
+  return {std::move(topic), std::move(payload), 1, false, priority, queuedAt};
+}
+
+std::string fmtIndex(size_t i) {
+  char buf[8];
+  std::snprintf(buf, sizeof(buf), "%04zu", i);
+  return buf;
+}
+
+std::vector<std::string> drainTopics(MqttOutbox &outbox) {
+  std::vector<std::string> topics;
+  while (auto m = outbox.pop()) topics.push_back(m->topic);
+  return topics;
+}
+
+void popsByPriorityThenArrival() {
+  MqttOutbox outbox(8);
+  outbox.push(msg(Priority::Discovery, "disc"));
+  outbox.push(msg(Priority::Telemetry, "tele"));
+  outbox.push(msg(Priority::Access, "tap1"));
+  outbox.push(msg(Priority::State, "state"));
+  outbox.push(msg(Priority::Access, "tap2"));
+  CHECK(outbox.size() == 5);
+  CHECK(outbox.size(Priority::Access) == 2);
+  CHECK((drainTopics(outbox) == std::vector<std::string>{"tap1", "tap2", "state", "tele", "disc"}));
+  CHECK(outbox.empty());
+}
+
+void coalescesAllButAccess() {
+  MqttOutbox outbox(8);
+  CHECK(outbox.push(msg(Priority::State, "lock", "1", 100)) == PushResult::Queued);
+  CHECK(outbox.push(msg(Priority::State, "lock", "0", 200)) == PushResult::Coalesced);
+  CHECK(outbox.push(msg(Priority::Access, "tap", "a")) == PushResult::Queued);
+  CHECK(outbox.push(msg(Priority::Access, "tap", "b")) == PushResult::Queued);
+  CHECK(outbox.size() == 3);
+
+  auto first = outbox.pop();
+  CHECK(first && first->payload == "a");
+  outbox.pop();
+  auto state = outbox.pop();
+  // The newest payload goes out, but the wait is measured from the first one queued.
+  CHECK(state && state->payload == "0" && state->queuedAt == 100);
+}
+
+void overflowEvictsLowestPriority() {
+  MqttOutbox outbox(3);
+  outbox.push(msg(Priority::Discovery, "d1"));
+  outbox.push(msg(Priority::Discovery, "d2"));
+  outbox.push(msg(Priority::Telemetry, "t1"));
+  CHECK(outbox.push(msg(Priority::Access, "tap")) == PushResult::Evicted);
+  CHECK(outbox.size() == 3);
+  CHECK((drainTopics(outbox) == std::vector<std::string>{"tap", "t1", "d2"}));
+
+  // Nothing below the new message's priority is waiting, so it is refused.
+  outbox.push(msg(Priority::Access, "a1"));
+  outbox.push(msg(Priority::Access, "a2"));
+  outbox.push(msg(Priority::State, "s1"));
+  CHECK(outbox.push(msg(Priority::Discovery, "d3")) == PushResult::Rejected);
+  CHECK(outbox.push(msg(Priority::Telemetry, "t2")) == PushResult::Rejected);
+  // Equal priority evicts the oldest of that priority.
+  CHECK(outbox.push(msg(Priority::State, "s2")) == PushResult::Evicted);
+  CHECK((drainTopics(outbox) == std::vector<std::string>{"a1", "a2", "s2"}));
+}
+
+void pushFrontKeepsNewerValue() {
+  MqttOutbox outbox(4);
+  outbox.push(msg(Priority::State, "lock", "1"));
+  outbox.push(msg(Priority::Access, "tap"));
+  auto tap = outbox.pop();
+  auto inFlight = outbox.pop();
+  CHECK(outbox.empty());
+
+  // A failed publish goes back to the head of its priority.
+  outbox.push(msg(Priority::Access, "tap2"));
+  outbox.pushFront(std::move(*tap));
+  CHECK((drainTopics(outbox) == std::vector<std::string>{"tap", "tap2"}));
+
+  // But not over a newer value for the same topic queued meanwhile.
+  outbox.push(msg(Priority::State, "lock", "0"));
+  outbox.pushFront(std::move(*inFlight));
+  CHECK(outbox.size() == 1);
+  auto state = outbox.pop();
+  CHECK(state && state->payload == "0");
+}
+
+void takeRemovesOnePriority() {
+  MqttOutbox outbox(8);
+  outbox.push(msg(Priority::Access, "tap1"));
+  outbox.push(msg(Priority::State, "state"));
+  outbox.push(msg(Priority::Access, "tap2"));
+  auto taps = outbox.take(Priority::Access);
+  CHECK(taps.size() == 2 && taps[0].topic == "tap1" && taps[1].topic == "tap2");
+  CHECK(outbox.size() == 1 && outbox.size(Priority::Access) == 0);
+}
+
+std::vector<Message> replayAll(MqttSpool &spool) {
+  std::vector<Message> out;
+  spool.replay([&](const Message &m) {
+    out.push_back(m);
+    return true;
+  });
+  return out;
+}
+
+void spoolReplaysInOrder() {
+  fs::FS fs;
+  MqttSpool spool(fs, "/spool");
+  CHECK(spool.empty());
+  Message retained{"hk/state", "1", 2, true, Priority::State, 0};
+  CHECK(spool.append(msg(Priority::Access, "hk/tap", "first")));
+  CHECK(spool.append(retained));
+  CHECK(spool.append(msg(Priority::Access, "hk/tap", "")));
+  CHECK(!spool.empty());
+
+  auto replayed = replayAll(spool);
+  CHECK(replayed.size() == 3);
+  if (replayed.size() == 3) {
+    CHECK(replayed[0].payload == "first");
+    CHECK(replayed[1].topic == "hk/state" && replayed[1].qos == 2 && replayed[1].retain &&
+          replayed[1].priority == Priority::State);
+    CHECK(replayed[2].payload.empty());
+  }
+  CHECK(spool.empty());
+  CHECK(spool.bytes() == 0);
+  CHECK(fs.files.empty());
+}
+
+void spoolResumesAfterFailedPublish() {
+  fs::FS fs;
+  MqttSpool spool(fs, "/spool");
+  for (int i = 0; i < 5; i++) spool.append(msg(Priority::Access, "tap", std::to_string(i)));
+
+  int allowed = 2;
+  std::vector<std::string> sent;
+  auto publisher = [&](const Message &m) {
+    if (allowed-- <= 0) return false;
+    sent.push_back(m.payload);
+    return true;
+  };
+  CHECK(spool.replay(publisher) == 2);
+  CHECK(!spool.empty());
+  allowed = 100;
+  CHECK(spool.replay(publisher) == 3);
+  CHECK((sent == std::vector<std::string>{"0", "1", "2", "3", "4"}));
+  CHECK(spool.empty());
+}
+
+void spoolDropsOldestSegmentWhenFull() {
+  fs::FS fs;
+  MqttSpool spool(fs, "/spool");
+  // 6 + 3 + 200 = 209 bytes per record, 19 per segment.
+  const std::string payload(200, 'p');
+  const size_t total = 200;
+  for (size_t i = 0; i < total; i++) {
+    Message m = msg(Priority::Access, "tap", payload);
+    m.payload.replace(0, 4, fmtIndex(i));
+    CHECK(spool.append(m));
+  }
+  CHECK(spool.dropped() > 0);
+  CHECK(fs.files.size() <= MqttSpool::MAX_SEGMENTS);
+
+  auto replayed = replayAll(spool);
+  CHECK(replayed.size() + spool.dropped() == total);
+  // The newest events survive, still in order.
+  for (size_t i = 0; i < replayed.size(); i++) {
+    CHECK(replayed[i].payload.substr(0, 4) == fmtIndex(spool.dropped() + i));
+  }
+
+  Message huge = msg(Priority::Access, "tap", std::string(MqttSpool::SEGMENT_BYTES, 'h'));
+  CHECK(!spool.append(huge));
+}
+
+void spoolSurvivesRebootAndTornRecord() {
+  fs::FS fs;
+  {
+    MqttSpool spool(fs, "/spool");
+    for (int i = 0; i < 3; i++) spool.append(msg(Priority::Access, "tap", std::to_string(i)));
+  }
+  // A reset during the last write leaves part of a record behind.
+  CHECK(fs.files.size() == 1);
+  std::string &segment = fs.files.begin()->second;
+  segment.resize(segment.size() - 1);
+
+  MqttSpool spool(fs, "/spool");
+  CHECK(!spool.empty());
+  // Appends after a reboot start a new segment rather than following the torn record.
+  CHECK(spool.append(msg(Priority::Access, "tap", "3")));
+  CHECK(fs.files.size() == 2);
+
+  std::vector<std::string> payloads;
+  for (const auto &m : replayAll(spool)) payloads.push_back(m.payload);
+  CHECK((payloads == std::vector<std::string>{"0", "1", "3"}));
+  CHECK(spool.empty());
+}
+
+void offlineAccessEventsReachTheSpoolInOrder() {
+  // What the drain task does while disconnected: access events move to the spool, the
+  // rest stays queued, and on reconnect the spool goes out first.
+  fs::FS fs;
+  MqttSpool spool(fs, "/spool");
+  MqttOutbox outbox(8);
+  outbox.push(msg(Priority::Access, "tap", "a"));
+  outbox.push(msg(Priority::State, "lock", "1"));
+  outbox.push(msg(Priority::Access, "tap", "b"));
+  for (const auto &event : outbox.take(Priority::Access)) CHECK(spool.append(event));
+  outbox.push(msg(Priority::Access, "tap", "c"));
+  for (const auto &event : outbox.take(Priority::Access)) CHECK(spool.append(event));
+
+  std::vector<std::string> sent;
+  for (const auto &m : replayAll(spool)) sent.push_back(m.payload);
+  while (auto m = outbox.pop()) sent.push_back(m->payload);
+  CHECK((sent == std::vector<std::string>{"a", "b", "c", "1"}));
+}
+
+} // namespace
+
+int main() {
+  popsByPriorityThenArrival();
+  coalescesAllButAccess();
+  overflowEvictsLowestPriority();
+  pushFrontKeepsNewerValue();
+  takeRemovesOnePriority();
+  spoolReplaysInOrder();
+  spoolResumesAfterFailedPublish();
+  spoolDropsOldestSegmentWhenFull();
+  spoolSurvivesRebootAndTornRecord();
+  offlineAccessEventsReachTheSpoolInOrder();
+
+  if (g_failures) {
+    std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,95 @@
+// In-memory stand-in for the subset of the Arduino fs::FS API that MqttSpool uses.
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace fs {
+
+/** @brief File contents by full path. */
+using Storage = std::map<std::string, std::string>;
+
+class File {
+public:
+  File() = default;
+  File(Storage *storage, std::string path, bool directory)
+      : m_storage(storage), m_path(std::move(path)), m_directory(directory) {
+    if (m_directory) {
+      const std::string prefix = m_path + '/';
+      for (const auto &entry : *m_storage) {
+        if (entry.first.rfind(prefix, 0) == 0) m_children.push_back(entry.first);
+      }
+    }
+  }
+
+  explicit operator bool() const { return m_storage != nullptr; }
+  bool isDirectory() const { return m_directory; }
+  /** @brief Base name, as the esp32 Arduino core returns it. */
+  const char *name() const { return m_path.c_str() + m_path.rfind('/') + 1; }
+  size_t size() const { return m_storage ? data().size() : 0; }
+  size_t position() const { return m_pos; }
+  bool seek(uint32_t pos) {
+    m_pos = pos;
+    return pos <= size();
+  }
+
+  size_t read(uint8_t *buf, size_t len) {
+    const std::string &d = data();
+    const size_t n = m_pos < d.size() ? std::min(len, d.size() - m_pos) : 0;
+    memcpy(buf, d.data() + m_pos, n);
+    m_pos += n;
+    return n;
+  }
+  size_t write(const uint8_t *buf, size_t len) {
+    (*m_storage)[m_path].append(reinterpret_cast<const char *>(buf), len);
+    return len;
+  }
+
+  File openNextFile() {
+    if (m_next >= m_children.size()) return {};
+    return File(m_storage, m_children[m_next++], false);
+  }
+  void close() { m_storage = nullptr; }
+
+private:
+  const std::string &data() const { return m_storage->at(m_path); }
+
+  Storage *m_storage = nullptr;
+  std::string m_path;
+  bool m_directory = false;
+  size_t m_pos = 0;
+  std::vector<std::string> m_children;
+  size_t m_next = 0;
+};
+
+class FS {
+public:
+  File open(const char *path, const char *mode = "r") {
+    const std::string p(path);
+    if (m_dirs.count(p)) return File(&files, p, true);
+    if (mode[0] == 'a' || mode[0] == 'w') {
+      if (mode[0] == 'w' || !files.count(p)) files[p].clear();
+      return File(&files, p, false);
+    }
+    return files.count(p) ? File(&files, p, false) : File();
+  }
+  bool exists(const char *path) { return m_dirs.count(path) || files.count(path); }
+  bool mkdir(const char *path) {
+    m_dirs.insert(path);
+    return true;
+  }
+  bool remove(const char *path) { return files.erase(path) == 1; }
+
+  Storage files;
+
+private:
+  /// Directories created with mkdir(); listing one returns the files whose path starts with it.
+  std::set<std::string> m_dirs;
+};
+
+} // namespace fs
@@ -0,0 +1,55 @@
+#pragma once
+#include "OtaSink.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+inline int g_failures = 0;
+
+#define CHECK(cond)                                                      \
+  do {                                                                   \
+    if (!(cond)) {                                                       \
+      std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+      g_failures++;                                                      \
+    }                                                                    \
+  } while (0)
+
+inline std::vector<uint8_t> readFile(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    std::fprintf(stderr, "Cannot open fixture %s\n", path.c_str());
+    std::exit(2);
+  }
+  return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+/** @brief Sink that keeps everything written to it. */
+class VectorSink : public OtaSink {
+public:
+  bool write(const uint8_t *data, size_t len) override {
+    if (failWrites) return false;
+    bytes.insert(bytes.end(), data, data + len);
+    return true;
+  }
+  bool finish() override {
+    finished = true;
+    return true;
+  }
+
+  std::vector<uint8_t> bytes;
+  bool finished = false;
+  bool failWrites = false;
+};
+
+/** @brief Feed @p data to @p sink in @p chunk byte writes, as the OTA receive loop does. */
+inline bool writeChunked(OtaSink &sink, const std::vector<uint8_t> &data, size_t chunk) {
+  for (size_t pos = 0; pos < data.size(); pos += chunk) {
+    if (!sink.write(data.data() + pos, std::min(chunk, data.size() - pos))) return false;
+  }
+  return true;
+}
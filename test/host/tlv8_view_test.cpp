@@ -0,0 +1,118 @@
+// Checks Tlv8View::length on plain items, joined 255-byte fragments and truncated buffers.
+// Usage: tlv8_view_test
+#include "Tlv8View.hpp"
+#include "test_util.hpp"
+
+namespace {
+
+/** @brief Append one TLV8 item; @p len is written as given so tests can make truncated items. */
+void item(std::vector<uint8_t> &out, uint8_t tag, size_t len, uint8_t headerLen) {
+  out.push_back(tag);
+  out.push_back(headerLen);
+  out.insert(out.end(), len, uint8_t(tag ^ 0x5A));
+}
+
+void item(std::vector<uint8_t> &out, uint8_t tag, uint8_t len) { item(out, tag, len, len); }
+
+std::optional<size_t> length(const std::vector<uint8_t> &buf, uint8_t tag) { return Tlv8View(buf).length(tag); }
+
+void plainItems() {
+  std::vector<uint8_t> buf;
+  item(buf, 0x01, 4);
+  item(buf, 0x02, 0);
+  item(buf, 0x03, 17);
+  CHECK(length(buf, 0x01) == 4);
+  CHECK(length(buf, 0x02) == 0);
+  CHECK(length(buf, 0x03) == 17);
+  CHECK(!length(buf, 0x04));
+  CHECK(!length({}, 0x01));
+}
+
+void fragmentsAreJoined() {
+  std::vector<uint8_t> buf;
+  item(buf, 0x01, 2);
+  item(buf, 0x06, 255);
+  item(buf, 0x06, 10);
+  item(buf, 0x07, 1);
+  CHECK(length(buf, 0x06) == 265);
+  CHECK(length(buf, 0x07) == 1);
+
+  buf.clear();
+  item(buf, 0x06, 255);
+  item(buf, 0x06, 255);
+  item(buf, 0x06, 0);
+  CHECK(length(buf, 0x06) == 510);
+
+  // A shorter item ends the value; a following one with the same tag is a separate item.
+  buf.clear();
+  item(buf, 0x06, 200);
+  item(buf, 0x06, 10);
+  CHECK(length(buf, 0x06) == 200);
+}
+
+void fragmentEndsAtDifferentTag() {
+  std::vector<uint8_t> buf;
+  item(buf, 0x06, 255);
+  item(buf, 0x08, 3);
+  item(buf, 0x06, 10);
+  CHECK(length(buf, 0x06) == 255);
+  CHECK(length(buf, 0x08) == 3);
+
+  // A full fragment at the very end of the buffer is a complete value.
+  buf.clear();
+  item(buf, 0x06, 255);
+  CHECK(length(buf, 0x06) == 255);
+}
+
+void truncatedBuffers() {
+  std::vector<uint8_t> buf;
+  item(buf, 0x01, 9, 10);
+  CHECK(!length(buf, 0x01));
+  // A truncated item before the wanted one hides it too.
+  item(buf, 0x02, 1);
+  CHECK(!length(buf, 0x02));
+
+  buf.clear();
+  item(buf, 0x06, 255);
+  item(buf, 0x06, 5, 10);
+  CHECK(!length(buf, 0x06));
+
+  // A tag without its length byte.
+  buf.clear();
+  item(buf, 0x01, 3);
+  buf.push_back(0x02);
+  CHECK(length(buf, 0x01) == 3);
+  CHECK(!length(buf, 0x02));
+
+  // Cut anywhere, the buffer yields no value, except right after the first fragment, where
+  // the first fragment is the whole value. A continuation cut after its tag byte counts as cut.
+  buf.clear();
+  item(buf, 0x01, 3);
+  item(buf, 0x06, 255);
+  item(buf, 0x06, 20);
+  const size_t firstFragmentEnd = 5 + 2 + 255;
+  for (size_t n = 0; n < buf.size(); n++) {
+    auto len = Tlv8View(std::span(buf).first(n)).length(0x06);
+    if (n == firstFragmentEnd) {
+      CHECK(len == 255);
+    } else {
+      CHECK(!len);
+    }
+  }
+  CHECK(length(buf, 0x06) == 275);
+}
+
+} // namespace
+
+int main() {
+  plainItems();
+  fragmentsAreJoined();
+  fragmentEndsAtDifferentTag();
+  truncatedBuffers();
+
+  if (g_failures) {
+    std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+    return 1;
+  }
+  return 0;
+}